@@ -0,0 +1,470 @@
+/* iosched-replay.c
+ *
+ * Replay a block trace against a scratch device under one or more I/O
+ * schedulers and report per-direction completion latency for each.
+ *
+ * The trace is the text output of blkparse; only queue ("Q") events are
+ * replayed, at their recorded times.  Without a trace a synthetic load is
+ * generated instead: small random reads, as when an application starts,
+ * over a stream of large sequential writes, as from background writeback.
+ *
+ * Reads always use O_DIRECT.  Writes do too, unless -b is given, in which
+ * case they go through the page cache and reach the scheduler as async
+ * writeback, which is what the sync/async split of most schedulers is
+ * about.
+ *
+ * Each entry of the -s list names a scheduler, optionally followed by
+ * tunables to set in queue/iosched after switching to it, e.g.
+ *
+ *	# iosched-replay -d /dev/block/mmcblk0p4 -b \
+ *		-s noop,deadline,cfq,sio,sio:flash_aware=1
+ *
+ * If the scheduler exports read_latency and write_latency (sio does),
+ * they are cleared before and printed after its run.
+ *
+ * THE DEVICE IS OVERWRITTEN.  brd and loop devices do not go through an
+ * I/O scheduler in this kernel, so on the target use a spare partition
+ * of a request based device such as mmcblk.  On kernels where loop is
+ * request based, a loop device over a tmpfs file makes a ramdisk that
+ * does.
+ *
+ * Compile with
+ *	gcc -O2 -Wall iosched-replay.c -o iosched-replay -lpthread -lrt
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/sysmacros.h>
+#include <linux/fs.h>
+
+#define NSEC_PER_SEC	1000000000LL
+#define SECTOR_SIZE	512
+#define MAX_IO_BYTES	(1024 * 1024)
+#define MAX_THREADS	64
+
+struct io {
+	long long	time;		/* ns from the start of the trace */
+	unsigned long long offset;	/* bytes */
+	unsigned int	len;		/* bytes */
+	int		write;
+	long long	lat;		/* ns, filled in by the replay */
+};
+
+struct lat_stat {
+	long long	*lat;
+	unsigned long	nr;
+	unsigned long long bytes;
+};
+
+static struct io *ios;
+static unsigned long nr_ios, max_ios;
+static unsigned long next_io;
+static pthread_mutex_t next_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct timespec replay_start;
+
+static int rfd = -1, wfd = -1;
+static unsigned long long dev_size;
+static double speed = 1.0;
+static char queue_dir[256];
+
+#define err(code, fmt, arg...)			\
+	do {					\
+		fprintf(stderr, fmt, ##arg);	\
+		exit(code);			\
+	} while (0)
+
+static void usage(void)
+{
+	fprintf(stderr, "iosched-replay -d dev [-f trace] [-s sched[:k=v...],...] "
+			"[-b] [-t threads] [-x speed] [-T seconds]\n");
+	fprintf(stderr, "  -d: scratch block device, its contents are destroyed\n");
+	fprintf(stderr, "  -f: blkparse output to replay (default: synthetic load)\n");
+	fprintf(stderr, "  -s: schedulers to compare (default: the current one)\n");
+	fprintf(stderr, "  -b: buffered writes, so they reach the queue as writeback\n");
+	fprintf(stderr, "  -t: replay threads, the most I/O in flight (default 16)\n");
+	fprintf(stderr, "  -x: replay speed factor (default 1.0)\n");
+	fprintf(stderr, "  -T: length of the synthetic load in seconds (default 10)\n");
+	exit(1);
+}
+
+static void add_io(long long time, unsigned long long offset,
+		   unsigned int len, int write)
+{
+	if (nr_ios == max_ios) {
+		max_ios = max_ios ? max_ios * 2 : 4096;
+		ios = realloc(ios, max_ios * sizeof(*ios));
+		if (!ios)
+			err(1, "out of memory\n");
+	}
+
+	if (len > MAX_IO_BYTES)
+		len = MAX_IO_BYTES;
+	/* keep direct I/O aligned and inside the device */
+	offset &= ~4095ULL;
+	len = (len + 4095) & ~4095U;
+	if (dev_size > len)
+		offset %= dev_size - len;
+
+	ios[nr_ios].time = time;
+	ios[nr_ios].offset = offset;
+	ios[nr_ios].len = len;
+	ios[nr_ios].write = write;
+	ios[nr_ios].lat = 0;
+	nr_ios++;
+}
+
+/*
+ * blkparse default output:
+ *   8,0    3       11     0.009507758   697  Q   W 223490 + 8 [kjournald]
+ */
+static void load_trace(const char *path)
+{
+	char line[512], action[8], rwbs[8];
+	unsigned long long sector;
+	unsigned int nsect;
+	double t, first = -1;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f)
+		err(1, "%s: %s\n", path, strerror(errno));
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%*d,%*d %*d %*u %lf %*d %7s %7s %llu + %u",
+			   &t, action, rwbs, &sector, &nsect) != 5)
+			continue;
+		if (strcmp(action, "Q") || !nsect)
+			continue;
+		if (!strchr(rwbs, 'R') && !strchr(rwbs, 'W'))
+			continue;
+		if (first < 0)
+			first = t;
+		add_io((long long)((t - first) * NSEC_PER_SEC),
+		       sector * SECTOR_SIZE, nsect * SECTOR_SIZE,
+		       strchr(rwbs, 'W') != NULL);
+	}
+	fclose(f);
+
+	if (!nr_ios)
+		err(1, "%s: no queue events found\n", path);
+}
+
+static int cmp_io_time(const void *a, const void *b)
+{
+	const struct io *x = a, *y = b;
+
+	return x->time < y->time ? -1 : x->time > y->time;
+}
+
+/*
+ * Random 4-64KiB reads about every millisecond over 128KiB sequential
+ * writes every 2ms (64MiB/s), the same for every run.
+ */
+static void make_load(int seconds)
+{
+	unsigned int seed = 1;
+	unsigned long long wpos = dev_size / 2;
+	long long t, end = (long long)seconds * NSEC_PER_SEC;
+
+	for (t = 0; t < end; t += 2000000LL) {
+		add_io(t, wpos, 128 * 1024, 1);
+		wpos += 128 * 1024;
+		if (wpos + 128 * 1024 > dev_size)
+			wpos = dev_size / 2;
+	}
+
+	for (t = 0; t < end; t += 500000LL + rand_r(&seed) % 1000000LL)
+		add_io(t, ((unsigned long long)rand_r(&seed) << 12) %
+		       (dev_size / 2), 4096 << (rand_r(&seed) % 5), 0);
+}
+
+static long long ts_ns(struct timespec *ts)
+{
+	return ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static void *replay_thread(void *arg)
+{
+	struct timespec due, now;
+	struct io *io;
+	void *buf;
+	ssize_t ret;
+	long long t;
+
+	if (posix_memalign(&buf, 4096, MAX_IO_BYTES))
+		err(1, "out of memory\n");
+	memset(buf, 0x5a, MAX_IO_BYTES);
+
+	for (;;) {
+		pthread_mutex_lock(&next_lock);
+		io = next_io < nr_ios ? &ios[next_io++] : NULL;
+		pthread_mutex_unlock(&next_lock);
+		if (!io)
+			break;
+
+		t = ts_ns(&replay_start) + (long long)(io->time / speed);
+		due.tv_sec = t / NSEC_PER_SEC;
+		due.tv_nsec = t % NSEC_PER_SEC;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+				       &due, NULL) == EINTR)
+			;
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (io->write)
+			ret = pwrite(wfd, buf, io->len, io->offset);
+		else
+			ret = pread(rfd, buf, io->len, io->offset);
+		if (ret != (ssize_t)io->len)
+			fprintf(stderr, "%s of %u at %llu: %s\n",
+				io->write ? "write" : "read", io->len,
+				io->offset, ret < 0 ? strerror(errno) : "short");
+		clock_gettime(CLOCK_MONOTONIC, &due);
+		io->lat = ts_ns(&due) - ts_ns(&now);
+	}
+
+	free(buf);
+	return NULL;
+}
+
+static int write_attr(const char *file, const char *val)
+{
+	char path[512];
+	int fd, ret = 0;
+
+	snprintf(path, sizeof(path), "%s/%s", queue_dir, file);
+	fd = open(path, O_WRONLY);
+	if (fd < 0 || write(fd, val, strlen(val)) < 0) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		ret = -1;
+	}
+	if (fd >= 0)
+		close(fd);
+	return ret;
+}
+
+static void show_attr(const char *file)
+{
+	char path[512], buf[4096];
+	int fd, len;
+
+	snprintf(path, sizeof(path), "%s/%s", queue_dir, file);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return;
+	printf("  %s:\n", file);
+	while ((len = read(fd, buf, sizeof(buf))) > 0)
+		fwrite(buf, 1, len, stdout);
+	close(fd);
+}
+
+static int has_attr(const char *file)
+{
+	char path[512];
+
+	snprintf(path, sizeof(path), "%s/%s", queue_dir, file);
+	return access(path, F_OK) == 0;
+}
+
+/* find the queue directory of the device, or of the disk a partition is on */
+static void find_queue(const char *dev)
+{
+	struct stat st;
+
+	if (stat(dev, &st) || !S_ISBLK(st.st_mode))
+		err(1, "%s is not a block device\n", dev);
+
+	snprintf(queue_dir, sizeof(queue_dir), "/sys/dev/block/%u:%u/queue",
+		 major(st.st_rdev), minor(st.st_rdev));
+	if (access(queue_dir, F_OK))
+		snprintf(queue_dir, sizeof(queue_dir),
+			 "/sys/dev/block/%u:%u/../queue",
+			 major(st.st_rdev), minor(st.st_rdev));
+	if (access(queue_dir, F_OK))
+		err(1, "no queue directory for %s\n", dev);
+}
+
+static int cmp_ll(const void *a, const void *b)
+{
+	long long x = *(const long long *)a, y = *(const long long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void report(const char *name, int write, double secs)
+{
+	struct lat_stat st;
+	long long sum = 0;
+	unsigned long i;
+
+	memset(&st, 0, sizeof(st));
+	st.lat = malloc(nr_ios * sizeof(*st.lat));
+	if (!st.lat)
+		err(1, "out of memory\n");
+
+	for (i = 0; i < nr_ios; i++) {
+		if (ios[i].write != write)
+			continue;
+		st.lat[st.nr++] = ios[i].lat;
+		st.bytes += ios[i].len;
+		sum += ios[i].lat;
+	}
+
+	if (st.nr) {
+		qsort(st.lat, st.nr, sizeof(*st.lat), cmp_ll);
+		printf("%-24s %-5s %7lu %8.1f %8lld %8lld %8lld %8lld %8lld\n",
+		       name, write ? "write" : "read", st.nr,
+		       st.bytes / secs / (1024 * 1024),
+		       sum / (long long)st.nr / 1000,
+		       st.lat[st.nr / 2] / 1000,
+		       st.lat[st.nr * 95 / 100] / 1000,
+		       st.lat[st.nr * 99 / 100] / 1000,
+		       st.lat[st.nr - 1] / 1000);
+	}
+
+	free(st.lat);
+}
+
+static void run(char *spec, int threads)
+{
+	pthread_t tid[MAX_THREADS];
+	struct timespec end;
+	char *name = spec, *tun, *val;
+	char label[64], attr[256];
+	int sio_stats, i;
+
+	snprintf(label, sizeof(label), "%s", *spec ? spec : "(current)");
+
+	tun = strchr(spec, ':');
+	if (tun)
+		*tun++ = '\0';
+	if (*name && write_attr("scheduler", name))
+		err(1, "cannot select scheduler %s\n", name);
+
+	while (tun && *tun) {
+		char *next = strchr(tun, ':');
+
+		if (next)
+			*next++ = '\0';
+		val = strchr(tun, '=');
+		if (!val)
+			err(1, "tunable %s needs a value\n", tun);
+		*val++ = '\0';
+		snprintf(attr, sizeof(attr), "iosched/%s", tun);
+		if (write_attr(attr, val))
+			err(1, "cannot set %s\n", tun);
+		tun = next;
+	}
+
+	sio_stats = has_attr("iosched/read_latency");
+	if (sio_stats)
+		write_attr("iosched/read_latency", "0");
+
+	/* start every run from the same cache state */
+	fsync(wfd);
+	posix_fadvise(wfd, 0, 0, POSIX_FADV_DONTNEED);
+
+	next_io = 0;
+	clock_gettime(CLOCK_MONOTONIC, &replay_start);
+	replay_start.tv_sec++;		/* let the threads start */
+
+	for (i = 0; i < threads; i++)
+		if (pthread_create(&tid[i], NULL, replay_thread, NULL))
+			err(1, "pthread_create failed\n");
+	for (i = 0; i < threads; i++)
+		pthread_join(tid[i], NULL);
+	fsync(wfd);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	report(label, 0, (ts_ns(&end) - ts_ns(&replay_start)) / 1e9);
+	report(label, 1, (ts_ns(&end) - ts_ns(&replay_start)) / 1e9);
+
+	if (sio_stats) {
+		show_attr("iosched/read_latency");
+		show_attr("iosched/write_latency");
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	char *dev = NULL, *trace = NULL, *scheds = NULL, *spec, *save;
+	int threads = 16, seconds = 10, buffered = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:f:s:bt:x:T:")) != -1) {
+		switch (c) {
+		case 'd':
+			dev = optarg;
+			break;
+		case 'f':
+			trace = optarg;
+			break;
+		case 's':
+			scheds = optarg;
+			break;
+		case 'b':
+			buffered = 1;
+			break;
+		case 't':
+			threads = atoi(optarg);
+			break;
+		case 'x':
+			speed = atof(optarg);
+			break;
+		case 'T':
+			seconds = atoi(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (!dev || threads < 1 || threads > MAX_THREADS || speed <= 0 ||
+	    seconds < 1)
+		usage();
+
+	find_queue(dev);
+
+	rfd = open(dev, O_RDWR | O_DIRECT);
+	if (rfd < 0)
+		err(1, "%s: %s\n", dev, strerror(errno));
+	wfd = buffered ? open(dev, O_RDWR) : rfd;
+	if (wfd < 0)
+		err(1, "%s: %s\n", dev, strerror(errno));
+	if (ioctl(rfd, BLKGETSIZE64, &dev_size) || dev_size < 16 * MAX_IO_BYTES)
+		err(1, "%s: too small or size unknown\n", dev);
+
+	if (trace)
+		load_trace(trace);
+	else
+		make_load(seconds);
+	qsort(ios, nr_ios, sizeof(*ios), cmp_io_time);
+
+	printf("%lu I/Os over %.1f s, %d threads, %s writes\n", nr_ios,
+	       ios[nr_ios - 1].time / 1e9 / speed, threads,
+	       buffered ? "buffered" : "direct");
+	printf("%-24s %-5s %7s %8s %8s %8s %8s %8s %8s\n", "scheduler", "dir",
+	       "ios", "MiB/s", "avg_us", "p50_us", "p95_us", "p99_us",
+	       "max_us");
+
+	if (!scheds) {
+		char none[] = "";
+
+		run(none, threads);
+		return 0;
+	}
+
+	for (spec = strtok_r(scheds, ",", &save); spec;
+	     spec = strtok_r(NULL, ",", &save))
+		run(spec, threads);
+
+	return 0;
+}
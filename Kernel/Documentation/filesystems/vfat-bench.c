@@ -0,0 +1,379 @@
+/* vfat-bench.c
+ *
+ * Time VFAT cluster allocation on a large, mostly full loop image, with
+ * and without the free cluster bitmap (the "nofreemap" mount option).
+ *
+ * For every set of mount options given with -o the image is formatted
+ * afresh as FAT32.  The first part of it is then marked in use, with a
+ * free cluster left every few clusters, like a card that has been
+ * written and partly cleaned.  The FSINFO free count is left unknown so
+ * that the first statfs() has to find it.  The image is then attached
+ * to a loop device and mounted, and the program times:
+ *
+ *	mount		mount(2)
+ *	statfs		the first statfs(), as df or the media scanner does
+ *	write		creating -n files of -k KiB each
+ *	sync		sync(2) of the above
+ *
+ * e.g. on the device, with the image on the SD card:
+ *
+ *	# vfat-bench -i /sdcard/bench.img -o ,nofreemap
+ *
+ * runs once with the default options and once with nofreemap.  Each run
+ * starts from the same image, so the two are directly comparable.  The
+ * image is removed at the end.
+ *
+ * Compile with
+ *	gcc -O2 -Wall vfat-bench.c -o vfat-bench
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/vfs.h>
+#include <linux/loop.h>
+
+#define SECTOR		512
+#define RESERVED	32
+#define NR_FATS		2
+#define FAT32_EOC	0x0FFFFFFF
+
+static unsigned long long image_mb = 16384;
+static unsigned int cluster_kb = 16;
+static unsigned int fill = 90;		/* percent of clusters in use */
+static unsigned int hole = 16;		/* one free cluster every 'hole' */
+static unsigned int nr_files = 1000;
+static unsigned int file_kb = 256;
+static const char *mnt = "/mnt/vfat-bench";
+
+#define err(code, fmt, arg...)			\
+	do {					\
+		fprintf(stderr, fmt, ##arg);	\
+		exit(code);			\
+	} while (0)
+
+static void usage(void)
+{
+	fprintf(stderr, "vfat-bench -i image [-o opts[,opts...]] [-s MiB] "
+			"[-c cluster_KiB] [-f fill%%] [-n files] [-k file_KiB] "
+			"[-m mountpoint]\n");
+	fprintf(stderr, "  -o: mount option sets separated by ',', use ':' "
+			"within a set (default \",nofreemap\")\n");
+	fprintf(stderr, "  -s: image size in MiB (default 16384, sparse)\n");
+	fprintf(stderr, "  -c: cluster size in KiB (default 16)\n");
+	fprintf(stderr, "  -f: percent of clusters marked in use (default 90)\n");
+	fprintf(stderr, "  -n, -k: files to create and their size "
+			"(default 1000 x 256KiB)\n");
+	exit(1);
+}
+
+static void put16(unsigned char *p, unsigned int v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put32(unsigned char *p, uint32_t v)
+{
+	put16(p, v);
+	put16(p + 2, v >> 16);
+}
+
+static void pwrite_all(int fd, const void *buf, size_t len, off_t off)
+{
+	if (pwrite(fd, buf, len, off) != (ssize_t)len)
+		err(1, "image write failed: %s\n", strerror(errno));
+}
+
+/* lay out a FAT32 file system with clusters 3.. partly in use */
+static void format(const char *image)
+{
+	unsigned char bs[SECTOR], fsinfo[SECTOR];
+	uint32_t total = image_mb * 1024 * 1024 / SECTOR;
+	uint32_t spc = cluster_kb * 1024 / SECTOR;
+	uint32_t fatsz = 1, clusters, used, c;
+	uint32_t *fat;
+	void *zero;
+	static int shown;
+	int fd;
+
+	/* FAT size and cluster count depend on each other */
+	for (;;) {
+		clusters = (total - RESERVED - NR_FATS * fatsz) / spc;
+		if ((clusters + 2) * 4 <= fatsz * SECTOR)
+			break;
+		fatsz = ((clusters + 2) * 4 + SECTOR - 1) / SECTOR;
+	}
+	if (clusters < 65525)
+		err(1, "image too small for FAT32\n");
+
+	fd = open(image, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		err(1, "%s: %s\n", image, strerror(errno));
+	if (ftruncate(fd, (off_t)total * SECTOR))
+		err(1, "%s: %s\n", image, strerror(errno));
+
+	memset(bs, 0, sizeof(bs));
+	memcpy(bs, "\xeb\x58\x90" "MSWIN4.1", 11);
+	put16(bs + 11, SECTOR);
+	bs[13] = spc;
+	put16(bs + 14, RESERVED);
+	bs[16] = NR_FATS;
+	bs[21] = 0xf8;
+	put16(bs + 24, 63);
+	put16(bs + 26, 255);
+	put32(bs + 32, total);
+	put32(bs + 36, fatsz);
+	put32(bs + 44, 2);		/* root directory cluster */
+	put16(bs + 48, 1);		/* FSINFO sector */
+	put16(bs + 50, 6);		/* backup boot sector */
+	bs[64] = 0x80;
+	bs[66] = 0x29;
+	put32(bs + 67, 0x12345678);
+	memcpy(bs + 71, "NO NAME    FAT32   ", 19);
+	bs[510] = 0x55;
+	bs[511] = 0xaa;
+
+	memset(fsinfo, 0, sizeof(fsinfo));
+	put32(fsinfo, 0x41615252);
+	put32(fsinfo + 484, 0x61417272);
+	put32(fsinfo + 488, 0xffffffff);	/* free count unknown */
+	put32(fsinfo + 492, 0xffffffff);
+	put32(fsinfo + 508, 0xaa550000);
+
+	pwrite_all(fd, bs, SECTOR, 0);
+	pwrite_all(fd, fsinfo, SECTOR, SECTOR);
+	pwrite_all(fd, bs, SECTOR, 6 * SECTOR);
+	pwrite_all(fd, fsinfo, SECTOR, 7 * SECTOR);
+
+	fat = calloc(fatsz, SECTOR);
+	zero = calloc(spc, SECTOR);
+	if (!fat || !zero)
+		err(1, "out of memory\n");
+
+	fat[0] = 0x0ffffff8;
+	fat[1] = FAT32_EOC;
+	fat[2] = FAT32_EOC;		/* root directory */
+	used = (uint64_t)clusters * fill / 100;
+	for (c = 3; c < used + 2; c++)
+		if (c % hole)
+			fat[c] = FAT32_EOC;
+
+	for (c = 0; c < NR_FATS; c++)
+		pwrite_all(fd, fat, (size_t)fatsz * SECTOR,
+			   (off_t)(RESERVED + c * fatsz) * SECTOR);
+	pwrite_all(fd, zero, (size_t)spc * SECTOR,
+		   (off_t)(RESERVED + NR_FATS * fatsz) * SECTOR);
+
+	if (!shown++)
+		printf("%u clusters of %u KiB, FAT %u KiB, %u%% in use, "
+		       "%u files of %u KiB\n", clusters, cluster_kb,
+		       fatsz / 2, fill, nr_files, file_kb);
+
+	free(fat);
+	free(zero);
+	if (fsync(fd) || close(fd))
+		err(1, "%s: %s\n", image, strerror(errno));
+}
+
+/* attach the image to a free loop device; returns its fd */
+static int loop_attach(const char *image, char *dev, size_t size)
+{
+	static const char *fmt[] = { "/dev/loop%d", "/dev/block/loop%d" };
+	int ifd, lfd, i, n;
+
+	ifd = open(image, O_RDWR);
+	if (ifd < 0)
+		err(1, "%s: %s\n", image, strerror(errno));
+
+#ifdef LOOP_CTL_GET_FREE
+	lfd = open("/dev/loop-control", O_RDWR);
+	if (lfd >= 0) {
+		n = ioctl(lfd, LOOP_CTL_GET_FREE);
+		close(lfd);
+		if (n >= 0)
+			snprintf(dev, size, fmt[0], n);
+		lfd = n >= 0 ? open(dev, O_RDWR) : -1;
+		if (lfd >= 0 && !ioctl(lfd, LOOP_SET_FD, ifd))
+			goto out;
+		if (lfd >= 0)
+			close(lfd);
+	}
+#endif
+
+	for (n = 0; n < 256; n++) {
+		for (i = 0; i < 2; i++) {
+			snprintf(dev, size, fmt[i], n);
+			lfd = open(dev, O_RDWR);
+			if (lfd < 0)
+				continue;
+			if (!ioctl(lfd, LOOP_SET_FD, ifd))
+				goto out;
+			close(lfd);
+		}
+	}
+	err(1, "no free loop device\n");
+
+out:
+	close(ifd);
+	return lfd;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void write_files(void)
+{
+	char path[512], *buf;
+	unsigned int i, k;
+	int fd;
+
+	buf = malloc(64 * 1024);
+	if (!buf)
+		err(1, "out of memory\n");
+	memset(buf, 0xa5, 64 * 1024);
+
+	snprintf(path, sizeof(path), "%s/bench", mnt);
+	if (mkdir(path, 0755))
+		err(1, "%s: %s\n", path, strerror(errno));
+
+	for (i = 0; i < nr_files; i++) {
+		snprintf(path, sizeof(path), "%s/bench/f%05u.dat", mnt, i);
+		fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			err(1, "%s: %s\n", path, strerror(errno));
+		for (k = 0; k < file_kb; k += 64) {
+			size_t len = file_kb - k < 64 ? (file_kb - k) * 1024
+						      : 64 * 1024;
+
+			if (write(fd, buf, len) != (ssize_t)len)
+				err(1, "%s: %s\n", path, strerror(errno));
+		}
+		close(fd);
+	}
+
+	free(buf);
+}
+
+static void run(const char *image, char *opts)
+{
+	struct statfs st;
+	char dev[64], *p;
+	double t0, t_mount, t_statfs, t_write, t_sync;
+	int lfd;
+
+	/* ':' separates options within a set, mount(2) wants ',' */
+	for (p = opts; *p; p++)
+		if (*p == ':')
+			*p = ',';
+
+	format(image);
+	lfd = loop_attach(image, dev, sizeof(dev));
+
+	t0 = now();
+	if (mount(dev, mnt, "vfat", 0, opts)) {
+		fprintf(stderr, "mount %s on %s -o \"%s\": %s\n", dev, mnt,
+			opts, strerror(errno));
+		ioctl(lfd, LOOP_CLR_FD, 0);
+		unlink(image);
+		exit(1);
+	}
+	t_mount = now() - t0;
+
+	t0 = now();
+	if (statfs(mnt, &st))
+		err(1, "statfs: %s\n", strerror(errno));
+	t_statfs = now() - t0;
+
+	t0 = now();
+	write_files();
+	t_write = now() - t0;
+
+	t0 = now();
+	sync();
+	t_sync = now() - t0;
+
+	if (umount(mnt))
+		fprintf(stderr, "umount %s: %s\n", mnt, strerror(errno));
+	ioctl(lfd, LOOP_CLR_FD, 0);
+	close(lfd);
+
+	printf("%-16s %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+	       *opts ? opts : "(default)", t_mount * 1000, t_statfs * 1000,
+	       t_write * 1000, t_sync * 1000,
+	       (double)nr_files * file_kb / 1024 / (t_write + t_sync));
+}
+
+int main(int argc, char *argv[])
+{
+	char *image = NULL, *sets = NULL, *set, *p;
+	char def[] = ",nofreemap";
+	int c;
+
+	while ((c = getopt(argc, argv, "i:o:s:c:f:n:k:m:")) != -1) {
+		switch (c) {
+		case 'i':
+			image = optarg;
+			break;
+		case 'o':
+			sets = optarg;
+			break;
+		case 's':
+			image_mb = strtoull(optarg, NULL, 0);
+			break;
+		case 'c':
+			cluster_kb = atoi(optarg);
+			break;
+		case 'f':
+			fill = atoi(optarg);
+			break;
+		case 'n':
+			nr_files = atoi(optarg);
+			break;
+		case 'k':
+			file_kb = atoi(optarg);
+			break;
+		case 'm':
+			mnt = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (!image || !cluster_kb || cluster_kb > 64 ||
+	    (cluster_kb & (cluster_kb - 1)) || fill > 99 || !file_kb)
+		usage();
+	if (!sets)
+		sets = def;
+
+	mkdir(mnt, 0755);
+
+	printf("%-16s %9s %9s %9s %9s %9s\n", "options", "mount_ms",
+	       "statfs_ms", "write_ms", "sync_ms", "MiB/s");
+
+	/* split by hand, strtok would merge an empty first set */
+	for (set = sets; set; set = p) {
+		p = strchr(set, ',');
+		if (p)
+			*p++ = '\0';
+		run(image, set);
+	}
+
+	unlink(image);
+	return 0;
+}
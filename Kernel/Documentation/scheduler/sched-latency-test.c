@@ -0,0 +1,247 @@
+/* sched-latency-test.c
+ *
+ * Measure the wakeup latency of a periodic sleeper while a CPU hog runs
+ * in another cpu cgroup, and show the groups' cpu.latency_hist.
+ *
+ * Two groups, "lat_fg" and "lat_bg", are created under the cpu cgroup
+ * mount.  The hog is moved to lat_bg and the sleeper to lat_fg, and both
+ * are pinned to one CPU so that they compete.  The sleeper wakes up every
+ * period on an absolute CLOCK_MONOTONIC timer and records how late it
+ * ran, as cyclictest does.  At the end the lateness statistics and both
+ * groups' histograms are printed and the groups are removed.
+ *
+ * Run it once with the default latency target and once with -l to see
+ * the effect of cpu.latency_ns, e.g. on Android:
+ *
+ *	# sched-latency-test -m /dev/cpuctl
+ *	# sched-latency-test -m /dev/cpuctl -l 1000000 -L 20000000
+ *
+ * cpu.latency_hist is only present with CONFIG_SCHEDSTATS.
+ *
+ * Compile with
+ *	gcc -O2 sched-latency-test.c -o sched-latency-test -lrt
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define NSEC_PER_SEC	1000000000LL
+#define NSEC_PER_USEC	1000LL
+
+/* lateness buckets, in microseconds, the last one catches the rest */
+static const long long buckets[] = {
+	10, 50, 100, 500, 1000, 2000, 5000, 10000, 20000, 50000, -1
+};
+#define NR_BUCKETS	(sizeof(buckets) / sizeof(buckets[0]))
+
+static const char *mnt = "/dev/cpuctl";
+static char fg_path[256], bg_path[256];
+
+#define err(code, fmt, arg...)			\
+	do {					\
+		fprintf(stderr, fmt, ##arg);	\
+		exit(code);			\
+	} while (0)
+
+static void usage(void)
+{
+	fprintf(stderr, "sched-latency-test [-m mount] [-l fg_ns] [-L bg_ns] "
+			"[-p period_us] [-t seconds]\n");
+	fprintf(stderr, "  -m: cpu cgroup mount point (default /dev/cpuctl)\n");
+	fprintf(stderr, "  -l: cpu.latency_ns of the sleeper's group\n");
+	fprintf(stderr, "  -L: cpu.latency_ns of the hog's group\n");
+	fprintf(stderr, "  -p: sleeper period in microseconds (default 1000)\n");
+	fprintf(stderr, "  -t: run time in seconds (default 10)\n");
+	exit(1);
+}
+
+static int write_file(const char *dir, const char *file, long long val)
+{
+	char path[512], buf[32];
+	int fd, len, ret = 0;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	fd = open(path, O_WRONLY);
+	if (fd < 0) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	len = snprintf(buf, sizeof(buf), "%lld", val);
+	if (write(fd, buf, len) != len) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		ret = -1;
+	}
+	close(fd);
+	return ret;
+}
+
+static void show_file(const char *dir, const char *file)
+{
+	char path[512], buf[4096];
+	int fd, len;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		printf("%s: %s\n", path, strerror(errno));
+		return;
+	}
+	printf("%s:\n", path);
+	while ((len = read(fd, buf, sizeof(buf))) > 0)
+		fwrite(buf, 1, len, stdout);
+	close(fd);
+}
+
+static void move_task(const char *dir, pid_t pid)
+{
+	if (write_file(dir, "tasks", pid))
+		err(1, "cannot move %d to %s\n", pid, dir);
+}
+
+static void pin_cpu0(void)
+{
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(0, &set);
+	if (sched_setaffinity(0, sizeof(set), &set))
+		err(1, "sched_setaffinity: %s\n", strerror(errno));
+}
+
+static void make_group(char *path, size_t size, const char *name,
+		       long long latency)
+{
+	snprintf(path, size, "%s/%s", mnt, name);
+	if (mkdir(path, 0755) && errno != EEXIST)
+		err(1, "mkdir %s: %s\n", path, strerror(errno));
+	if (latency >= 0 && write_file(path, "cpu.latency_ns", latency))
+		err(1, "cannot set the latency target of %s\n", path);
+	/* reset the histogram, fails quietly without CONFIG_SCHEDSTATS */
+	write_file(path, "cpu.latency_hist", 0);
+}
+
+static long long ts_diff(struct timespec *a, struct timespec *b)
+{
+	return (a->tv_sec - b->tv_sec) * NSEC_PER_SEC +
+		(a->tv_nsec - b->tv_nsec);
+}
+
+static void ts_add(struct timespec *ts, long long ns)
+{
+	ts->tv_nsec += ns;
+	while (ts->tv_nsec >= NSEC_PER_SEC) {
+		ts->tv_nsec -= NSEC_PER_SEC;
+		ts->tv_sec++;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	long long fg_latency = -1, bg_latency = -1;
+	long long period = 1000, seconds = 10;
+	long long lat, min = -1, max = 0, sum = 0, count = 0;
+	unsigned long hist[NR_BUCKETS];
+	struct timespec next, now, end;
+	pid_t hog;
+	unsigned int i;
+	int c;
+
+	while ((c = getopt(argc, argv, "m:l:L:p:t:")) != -1) {
+		switch (c) {
+		case 'm':
+			mnt = optarg;
+			break;
+		case 'l':
+			fg_latency = atoll(optarg);
+			break;
+		case 'L':
+			bg_latency = atoll(optarg);
+			break;
+		case 'p':
+			period = atoll(optarg);
+			break;
+		case 't':
+			seconds = atoll(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (period <= 0 || seconds <= 0)
+		usage();
+
+	make_group(fg_path, sizeof(fg_path), "lat_fg", fg_latency);
+	make_group(bg_path, sizeof(bg_path), "lat_bg", bg_latency);
+
+	pin_cpu0();
+	hog = fork();
+	if (hog < 0)
+		err(1, "fork: %s\n", strerror(errno));
+	if (hog == 0) {
+		for (;;)
+			;
+	}
+	move_task(bg_path, hog);
+	move_task(fg_path, getpid());
+
+	memset(hist, 0, sizeof(hist));
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	end = next;
+	end.tv_sec += seconds;
+	period *= NSEC_PER_USEC;
+
+	for (;;) {
+		ts_add(&next, period);
+		if (ts_diff(&next, &end) > 0)
+			break;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+				       &next, NULL) == EINTR)
+			;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		lat = ts_diff(&now, &next);
+		if (min < 0 || lat < min)
+			min = lat;
+		if (lat > max)
+			max = lat;
+		sum += lat;
+		count++;
+		for (i = 0; i < NR_BUCKETS - 1; i++)
+			if (lat < buckets[i] * NSEC_PER_USEC)
+				break;
+		hist[i]++;
+	}
+
+	kill(hog, SIGKILL);
+	waitpid(hog, NULL, 0);
+
+	printf("%lld wakeups, lateness min %lld avg %lld max %lld us\n",
+	       count, min / NSEC_PER_USEC,
+	       count ? sum / count / NSEC_PER_USEC : 0, max / NSEC_PER_USEC);
+	for (i = 0; i < NR_BUCKETS; i++) {
+		if (buckets[i] < 0)
+			printf("   inf us: %lu\n", hist[i]);
+		else
+			printf("%6lld us: %lu\n", buckets[i], hist[i]);
+	}
+	show_file(fg_path, "cpu.latency_hist");
+	show_file(bg_path, "cpu.latency_hist");
+
+	/* hand ourselves back to the root group so lat_fg can go */
+	move_task(mnt, getpid());
+	if (rmdir(fg_path))
+		fprintf(stderr, "rmdir %s: %s\n", fg_path, strerror(errno));
+	if (rmdir(bg_path))
+		fprintf(stderr, "rmdir %s: %s\n", bg_path, strerror(errno));
+	return 0;
+}
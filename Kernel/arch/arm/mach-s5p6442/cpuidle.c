@@ -14,7 +14,12 @@
 #include <linux/init.h>
 #include <linux/platform_device.h>
 #include <linux/cpuidle.h>
+#include <linux/debugfs.h>
+#include <linux/hrtimer.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/seq_file.h>
 #include <asm/proc-fns.h>
 #include <asm/cacheflush.h>
 #include <linux/dma-mapping.h>
@@ -29,10 +34,38 @@
 #include <plat/regs-hsmmc.h>
 #include <plat/regs-gpio.h>
 
-#define S5P6442_MAX_STATES	1
+#define S5P6442_MAX_STATES	2
+
+/* Until idle2 has been measured, assume the worst seen on the bench */
+#define IDLE2_DEFAULT_LATENCY	300	/* uS */
+#define IDLE2_TARGET_RESIDENCY	5000	/* uS */
 
 int previous_idle_mode = NORMAL_MODE;
 
+/* idle2 is only entered in LPAUDIO_MODE, see s5p6442_setup_lpaudio() */
+static int s5p6442_idle_mode = NORMAL_MODE;
+
+/*
+ * Measured cost of idle2: entry is from the start of
+ * s5p6442_enter_idle2() up to WFI, exit from the wakeup back to the
+ * caller.  The maximum of entry + exit becomes the exit_latency of the
+ * cpuidle state.
+ */
+struct idle2_stats {
+	unsigned long	count;
+	unsigned long	demoted;	/* chosen, but idle2 not allowed */
+	u64		entry_ns_total;
+	u64		exit_ns_total;
+	u32		entry_ns_max;
+	u32		exit_ns_max;
+	u32		latency_ns_max;
+};
+
+static struct idle2_stats idle2_stats;
+
+/* Set just before WFI; kept in memory, registers come back from regs_save */
+static ktime_t idle2_wfi_time;
+
 /* For saving & restoring VIC register before entering
  * idle2 mode
  **/
@@ -145,6 +178,10 @@ static void s5p6442_enter_idle2(void)
 {
 	unsigned regs_save[16];
 	unsigned long tmp;
+	ktime_t t0, t2;
+	u32 entry_ns, exit_ns;
+
+	t0 = ktime_get();
 
 	/* store the physical address of the register recovery block */
 	s5p6442_sleep_save_phys = virt_to_phys(regs_save);
@@ -208,11 +245,13 @@ static void s5p6442_enter_idle2(void)
 	/* Entering idle2 mode with WFI instruction */
 	if (s5p6442_cpu_save(regs_save) == 0) {
 		flush_cache_all();
+		idle2_wfi_time = ktime_get();
 		pm_cpu_sleep();
 	}
 
 	/* restore the cpu state */
 	cpu_init();
+	t2 = ktime_get();
 
 	tmp = __raw_readl(S5P_IDLE_CFG);
 	tmp &= ~((3<<30)|(3<<28)|(1<<0));
@@ -237,7 +276,18 @@ static void s5p6442_enter_idle2(void)
 
 	tmp = __raw_readl(S5P_WAKEUP_STAT);
 	__raw_writel(tmp, S5P_WAKEUP_STAT);
-}	
+
+	entry_ns = ktime_to_ns(ktime_sub(idle2_wfi_time, t0));
+	exit_ns = ktime_to_ns(ktime_sub(ktime_get(), t2));
+
+	idle2_stats.count++;
+	idle2_stats.entry_ns_total += entry_ns;
+	idle2_stats.exit_ns_total += exit_ns;
+	idle2_stats.entry_ns_max = max(idle2_stats.entry_ns_max, entry_ns);
+	idle2_stats.exit_ns_max = max(idle2_stats.exit_ns_max, exit_ns);
+	idle2_stats.latency_ns_max = max(idle2_stats.latency_ns_max,
+					 entry_ns + exit_ns);
+}
 
 static struct cpuidle_driver s5p6442_idle_driver = {
 	.name =         "s5p6442_idle",
@@ -247,7 +297,8 @@ static struct cpuidle_driver s5p6442_idle_driver = {
 static DEFINE_PER_CPU(struct cpuidle_device, s5p6442_cpuidle_device);
 
 /* Actual code that puts the SoC in different idle states */
-static int s5p6442_enter_idle_normal(struct cpuidle_device *dev)
+static int s5p6442_enter_idle_normal(struct cpuidle_device *dev,
+				     struct cpuidle_state *state)
 {
 	struct timeval before, after;
 	int idle_time;
@@ -300,12 +351,24 @@ static int s5p6442_idle_bm_check(void)
 		return 0;
 }
 
-/* Actual code that puts the SoC in different idle states */
-static int s5p6442_enter_idle_lpaudio(struct cpuidle_device *dev)
+/*
+ * idle2 only wakes up on RTC tick, I2S and keypad, not on the system
+ * timer, so it is only safe while audio DMA is guaranteed to interrupt
+ * us: in LPAUDIO_MODE and with nothing holding the bus.  Otherwise the
+ * state demotes itself to WFI and tells the governor so.
+ */
+static int s5p6442_enter_idle_deep(struct cpuidle_device *dev,
+				   struct cpuidle_state *state)
 {
 	struct timeval before, after;
 	int idle_time;
 
+	if (s5p6442_idle_mode != LPAUDIO_MODE || s5p6442_idle_bm_check()) {
+		idle2_stats.demoted++;
+		dev->last_state = &dev->states[0];
+		return s5p6442_enter_idle_normal(dev, dev->last_state);
+	}
+
 	local_irq_disable();
 	do_gettimeofday(&before);
 
@@ -315,71 +378,65 @@ static int s5p6442_enter_idle_lpaudio(struct cpuidle_device *dev)
 	local_irq_enable();
 	idle_time = (after.tv_sec - before.tv_sec) * USEC_PER_SEC +
 			(after.tv_usec - before.tv_usec);
-	return idle_time;
-}
 
-static int s5p6442_enter_idle_bm(struct cpuidle_device *dev,
-				struct cpuidle_state *state)
-{
-	if (s5p6442_idle_bm_check())
-		return s5p6442_enter_idle_normal(dev);
-	else
-		return s5p6442_enter_idle_lpaudio(dev);
+	/* Charge the worst entry + exit seen so far to the governor */
+	state->exit_latency = DIV_ROUND_UP(idle2_stats.latency_ns_max,
+					   NSEC_PER_USEC);
+
+	return idle_time;
 }
 
+/*
+ * Both states stay registered; the mode only decides whether idle2 may
+ * really be entered, so the governor keeps its history across screen
+ * on/off transitions.
+ */
 int s5p6442_setup_lpaudio(unsigned int mode)
 {
-	struct cpuidle_device *device;
-
-	int ret = 0;
-
-	cpuidle_pause_and_lock();
-	device = &per_cpu(s5p6442_cpuidle_device, smp_processor_id());
-	cpuidle_disable_device(device);
-
-	switch (mode) {
-	case NORMAL_MODE:
-		device->state_count = 1;
-		/* Wait for interrupt state */
-		device->states[0].enter = s5p6442_enter_idle_normal;
-		device->states[0].exit_latency = 1;	/* uS */
-		device->states[0].target_residency = 10000;
-		device->states[0].flags = CPUIDLE_FLAG_TIME_VALID;
-		strcpy(device->states[0].name, "IDLE");
-		strcpy(device->states[0].desc, "ARM clock gating - WFI");
-		break;
-	case LPAUDIO_MODE:
-		device->state_count = 1;
-		/* Wait for interrupt state */
-		device->states[0].enter = s5p6442_enter_idle_bm;
-		device->states[0].exit_latency = 1;	/* uS */
-		device->states[0].target_residency = 5000;
-		device->states[0].flags = CPUIDLE_FLAG_TIME_VALID |
-						CPUIDLE_FLAG_CHECK_BM;
-		strcpy(device->states[0].name, "DEEP IDLE");
-		strcpy(device->states[0].desc, "S5P6442 idle2");
-
-		break;
-	default:
+	if (mode != NORMAL_MODE && mode != LPAUDIO_MODE) {
 		printk(KERN_ERR "Can't find cpuidle mode %d\n", mode);
-		device->state_count = 1;
-
-		/* Wait for interrupt state */
-		device->states[0].enter = s5p6442_enter_idle_normal;
-		device->states[0].exit_latency = 1;	/* uS */
-		device->states[0].target_residency = 10000;
-		device->states[0].flags = CPUIDLE_FLAG_TIME_VALID;
-		strcpy(device->states[0].name, "IDLE");
-		strcpy(device->states[0].desc, "ARM clock gating - WFI");
-		break;
+		mode = NORMAL_MODE;
 	}
-	cpuidle_enable_device(device);
+
+	cpuidle_pause_and_lock();
+	s5p6442_idle_mode = mode;
 	cpuidle_resume_and_unlock();
 
-	return ret;
+	return 0;
 }
 EXPORT_SYMBOL(s5p6442_setup_lpaudio);
 
+static int s5p6442_idle2_show(struct seq_file *s, void *unused)
+{
+	struct idle2_stats st = idle2_stats;
+	unsigned long n = max(st.count, 1UL);
+
+	seq_printf(s, "mode:          %s\n",
+		   s5p6442_idle_mode == LPAUDIO_MODE ? "lpaudio" : "normal");
+	seq_printf(s, "entered:       %lu\n", st.count);
+	seq_printf(s, "demoted:       %lu\n", st.demoted);
+	seq_printf(s, "entry_ns:      avg %llu max %u\n",
+		   div_u64(st.entry_ns_total, n), st.entry_ns_max);
+	seq_printf(s, "exit_ns:       avg %llu max %u\n",
+		   div_u64(st.exit_ns_total, n), st.exit_ns_max);
+	seq_printf(s, "exit_latency:  %u us\n",
+		   per_cpu(s5p6442_cpuidle_device, 0).states[1].exit_latency);
+
+	return 0;
+}
+
+static int s5p6442_idle2_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s5p6442_idle2_show, NULL);
+}
+
+static const struct file_operations s5p6442_idle2_fops = {
+	.open		= s5p6442_idle2_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 /* Initialize CPU idle by registering the idle states */
 static int s5p6442_init_cpuidle(void)
 {
@@ -388,22 +445,35 @@ static int s5p6442_init_cpuidle(void)
 	cpuidle_register_driver(&s5p6442_idle_driver);
 
 	device = &per_cpu(s5p6442_cpuidle_device, smp_processor_id());
-	device->state_count = 1;
+	device->state_count = S5P6442_MAX_STATES;
 
 	/* Wait for interrupt state */
 	device->states[0].enter = s5p6442_enter_idle_normal;
 	device->states[0].exit_latency = 1;	/* uS */
-	device->states[0].target_residency = 10000;
+	/* must stay below idle2's, governors stop at the first miss */
+	device->states[0].target_residency = 1;
 	device->states[0].flags = CPUIDLE_FLAG_TIME_VALID;
 	strcpy(device->states[0].name, "IDLE");
 	strcpy(device->states[0].desc, "ARM clock gating - WFI");
 
+	/* Deep idle: power gated, VIC and GPIO state saved */
+	device->states[1].enter = s5p6442_enter_idle_deep;
+	device->states[1].exit_latency = IDLE2_DEFAULT_LATENCY;
+	device->states[1].target_residency = IDLE2_TARGET_RESIDENCY;
+	device->states[1].flags = CPUIDLE_FLAG_TIME_VALID |
+					CPUIDLE_FLAG_CHECK_BM;
+	strcpy(device->states[1].name, "DEEP IDLE");
+	strcpy(device->states[1].desc, "S5P6442 idle2");
+
+	spin_lock_init(&idle2_lock);
+
 	if (cpuidle_register_device(device)) {
 		printk(KERN_ERR "s5p6442_init_cpuidle: Failed registering\n");
 		return -EIO;
 	}
 
-	spin_lock_init(&idle2_lock);
+	debugfs_create_file("s5p6442_idle2", S_IRUGO, NULL, NULL,
+			    &s5p6442_idle2_fops);
 
 	return 0;
 }
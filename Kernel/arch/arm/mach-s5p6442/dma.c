@@ -120,6 +120,15 @@ static struct s3c_dma_map __initdata s5p6442_dma_mappings[] = {
 		.sdma_sel       = 1 << S3C_DMA1_I2S0_TX,
 	}, 
 
+	/* memory to memory, any channel of the MDMA controller */
+	[DMACH_3D_M2M0] = { .name = "m2m0", .channels = MAP0(S3C_DMA_M2M), },
+	[DMACH_3D_M2M1] = { .name = "m2m1", .channels = MAP0(S3C_DMA_M2M), },
+	[DMACH_3D_M2M2] = { .name = "m2m2", .channels = MAP0(S3C_DMA_M2M), },
+	[DMACH_3D_M2M3] = { .name = "m2m3", .channels = MAP0(S3C_DMA_M2M), },
+	[DMACH_3D_M2M4] = { .name = "m2m4", .channels = MAP0(S3C_DMA_M2M), },
+	[DMACH_3D_M2M5] = { .name = "m2m5", .channels = MAP0(S3C_DMA_M2M), },
+	[DMACH_3D_M2M6] = { .name = "m2m6", .channels = MAP0(S3C_DMA_M2M), },
+	[DMACH_3D_M2M7] = { .name = "m2m7", .channels = MAP0(S3C_DMA_M2M), },
 };
 
 static void s5p6442_dma_select(struct s3c2410_dma_chan *chan,
@@ -1122,6 +1122,155 @@ int setup_DMA_channel_for_oneNAND(u8 * mbuf, pl330_DMA_parameters_t dma_param, i
 
 
 
+/* setup_DMA_channel_for_sg
+ * - set up a DMA channel for a scatter-gather job in one program
+ *
+ *	mbuf		the address of the buffer that will contain PL330 DMA micro codes,
+ *			at least nsegs*PL330_MAX_SEG_MCODE bytes long
+ *	dma_param	the parameter set for a DMA operation, addresses and size unused
+ *	segs		the segments, in order
+ *	nsegs		the number of segments
+ *	chanNum		the DMA channel number to be started
+ *
+ * Only the last segment sends the event and ends the program.
+ * Returns the size of the micro code, or 0 if a segment cannot be encoded.
+ */
+#define PL330_MAX_SEG_MCODE		80
+
+int setup_DMA_channel_for_sg(u8 * mbuf, pl330_DMA_parameters_t dma_param,
+			     const struct s3c_dma_seg *segs, int nsegs, int chanNum)
+{
+	int mcode_size = 0, lcSize = 0, i;
+
+	dma_debug("%s entered : Channel Num=%d, nsegs=%d\n", __FUNCTION__, chanNum, nsegs);
+
+	lcSize = (dma_param.mControl.uSBLength+1)*(1<<dma_param.mControl.uSBSize);
+
+	for(i=0; i<nsegs; i++) {
+		if(segs[i].len == 0 ||
+		   segs[i].len/lcSize >= (PL330_MAX_ITERATION_NUM+1)*PL330_MAX_ITERATION_NUM) {
+			print_warning("[%s] Segment %d has a bad size : %u\n", __FUNCTION__, i, segs[i].len);
+			return 0;
+		}
+
+		dma_param.mSrcAddr = segs[i].src;
+		dma_param.mDstAddr = segs[i].dst;
+		dma_param.mTrSize = segs[i].len;
+		dma_param.mLoop = 0;
+		dma_param.mIrqEnable = (i == nsegs-1);
+		dma_param.mLastReq = (i == nsegs-1);
+
+		mcode_size+= setup_DMA_channel(mbuf+mcode_size, dma_param, chanNum);
+	}
+
+	return mcode_size;
+}
+
+
+/* setup_DMA_channel_for_ring
+ * - set up a DMA channel that loops over a ring of equal periods forever
+ *   and sends an event at the end of every period
+ *
+ *	mbuf		the address of the buffer that will contain PL330 DMA micro codes
+ *	dma_param	the parameter set for a DMA operation, mTrSize being the ring size
+ *	period		the size of one period in bytes
+ *	chanNum		the DMA channel number to be started
+ *
+ * A period is one DMALP0 of bursts, so it may not exceed
+ * PL330_MAX_ITERATION_NUM bursts.  Periods are counted by DMALP1 in
+ * blocks of up to PL330_MAX_ITERATION_NUM, and the whole ring sits in a
+ * DMALPFE whose backward jump must stay below PL330_MAX_JUMPBACK_NUM.
+ * Returns the size of the micro code, or 0 if the ring cannot be encoded.
+ */
+int setup_DMA_channel_for_ring(u8 * mbuf, pl330_DMA_parameters_t dma_param, int period, int chanNum)
+{
+	int mcode_size = 0, msize = 0;
+	int lcSize = 0, bursts = 0, periods = 0, n = 0;
+	int mRingStart = 0, mLoopStart0 = 0, mLoopStart1 = 0;
+
+	dma_debug("%s entered : Channel Num=%d, period=%d\n", __FUNCTION__, chanNum, period);
+	print_dma_param_info(dma_param);
+
+	if(dma_param.mDirection != PL330_M2P_DMA && dma_param.mDirection != PL330_P2M_DMA) {
+		print_warning("[%s] Invaild DMA direction selected !\n", __FUNCTION__);
+		return 0;
+	}
+
+	lcSize = (dma_param.mControl.uSBLength+1)*(1<<dma_param.mControl.uSBSize);
+	bursts = period/lcSize;
+	periods = period ? dma_param.mTrSize/period : 0;
+
+	if(bursts == 0 || bursts > PL330_MAX_ITERATION_NUM || bursts*lcSize != period ||
+	   periods == 0 || periods*period != dma_param.mTrSize) {
+		print_warning("[%s] Unsupported ring : %lu bytes in periods of %d\n",
+				__FUNCTION__, dma_param.mTrSize, period);
+		return 0;
+	}
+
+	msize = config_DMA_control(mbuf+mcode_size, dma_param.mControl);
+	mcode_size+= msize;
+
+	mRingStart = mcode_size;
+
+	msize = config_DMA_start_address(mbuf+mcode_size, dma_param.mSrcAddr);
+	mcode_size+= msize;
+
+	msize = config_DMA_destination_address(mbuf+mcode_size, dma_param.mDstAddr);
+	mcode_size+= msize;
+
+	while(periods > 0) {
+		n = min(periods, PL330_MAX_ITERATION_NUM);
+
+		msize = encodeDmaLoop(mbuf+mcode_size, 1, n-1);
+		mcode_size+= msize;
+		mLoopStart1 = mcode_size;
+
+		msize = encodeDmaLoop(mbuf+mcode_size, 0, bursts-1);
+		mcode_size+= msize;
+		mLoopStart0 = mcode_size;
+
+		msize = encodeDmaWaitForPeri(mbuf+mcode_size, (u8)dma_param.mPeriNum);
+		mcode_size+= msize;
+
+		if(dma_param.mDirection == PL330_M2P_DMA) {
+			msize = encodeDmaLoad(mbuf+mcode_size);
+			mcode_size+= msize;
+			msize = encodeDmaStorePeri(mbuf+mcode_size, (u8)dma_param.mPeriNum, 1);
+			mcode_size+= msize;
+		} else {
+			msize = encodeDmaLoadPeri(mbuf+mcode_size, (u8)dma_param.mPeriNum, 1);
+			mcode_size+= msize;
+			msize = encodeDmaStore(mbuf+mcode_size);
+			mcode_size+= msize;
+		}
+
+		msize = encodeDmaFlushPeri(mbuf+mcode_size, (u8)dma_param.mPeriNum);
+		mcode_size+= msize;
+
+		msize = encodeDmaLoopEnd(mbuf+mcode_size, 0, (u8)(mcode_size-mLoopStart0));
+		mcode_size+= msize;
+
+		msize = register_irq_to_DMA_channel(mbuf+mcode_size, chanNum);
+		mcode_size+= msize;
+
+		msize = encodeDmaLoopEnd(mbuf+mcode_size, 1, (u8)(mcode_size-mLoopStart1));
+		mcode_size+= msize;
+
+		if(mcode_size-mRingStart >= PL330_MAX_JUMPBACK_NUM) {
+			print_warning("[%s] Too many periods in the ring !\n", __FUNCTION__);
+			return 0;
+		}
+
+		periods-= n;
+	}
+
+	msize = config_DMA_set_infinite_loop(mbuf+mcode_size, mcode_size-mRingStart);
+	mcode_size+= msize;
+
+	return mcode_size;
+}
+
+
 /* start_DMA_channel
  * - get the DMA channel started
  *
@@ -24,6 +24,7 @@
 #include <linux/slab.h>
 #include <linux/errno.h>
 #include <linux/delay.h>
+#include <linux/scatterlist.h>
 
 #include <asm/system.h>
 #include <asm/irq.h>
@@ -224,6 +225,8 @@ static int s3c_dma_waitforload(struct s3c2410_dma_chan *chan, int line)
 }
 
 static inline void s3c_dma_freebuf(struct s3c_dma_buf * buf);
+static int s3c_dma_queuebuf(struct s3c2410_dma_chan *chan, unsigned int channel,
+			    struct s3c_dma_buf *buf);
 
 /* s3c_dma_loadbuffer
  *
@@ -251,6 +254,13 @@ static inline int s3c_dma_loadbuffer(struct s3c2410_dma_chan *chan,
 	pr_debug("%s: DMA CCR - %08x\n", __FUNCTION__, chan->dcon);
 	pr_debug("%s: DMA Loop count - %08x\n", __FUNCTION__, (buf->size / chan->xfer_unit));
 
+	/* scatter-gather jobs were compiled when they were queued */
+	if (buf->nsegs) {
+		chan->next = buf->next;
+		dma_param.mIrqEnable = 1;
+		goto loaded;
+	}
+
 	firstbuf = buf;
 	last1buf = buf;
 	last2buf = buf;
@@ -298,8 +308,9 @@ static inline int s3c_dma_loadbuffer(struct s3c2410_dma_chan *chan,
 		chan->next = buf->next;
 		buf = chan->next;
 
-		if (buf == NULL) {
-			firstbuf->next = NULL;
+		/* stop merging at the end of the queue or at a job */
+		if (buf == NULL || buf->nsegs) {
+			firstbuf->next = buf;
 			dma_param.mLastReq = 1;
 			dma_param.mIrqEnable = 1;
 		} else {
@@ -313,11 +324,12 @@ static inline int s3c_dma_loadbuffer(struct s3c2410_dma_chan *chan,
 		if (last2buf != firstbuf)
 			s3c_dma_freebuf(last2buf);
 
-	} while (buf != NULL);
+	} while (!dma_param.mLastReq);
 
 	if (last1buf != firstbuf)
 		s3c_dma_freebuf(last1buf);
 
+loaded:
 	if (dma_param.mIrqEnable) {
 		tmp = dma_rdreg(chan->dma_con, S3C_DMAC_INTEN);
 		tmp |= (1 << chan->number);
@@ -396,6 +408,10 @@ static int s3c_dma_start(struct s3c2410_dma_chan *chan)
 	 * if we can find anything to load
 	 */
 
+	/* a stopped ring still has its micro code, start it over */
+	if (chan->ring && chan->curr != NULL)
+		chan->load_state = S3C_DMALOAD_1LOADED;
+
 	if (chan->load_state == S3C_DMALOAD_NONE) {
 		if (chan->next == NULL) {
 			printk(KERN_ERR "dma CH %d: dcon_num has nothing loaded\n", chan->number);
@@ -477,10 +493,15 @@ int s3c2410_dma_enqueue(unsigned int channel, void *id,
 {
 	struct s3c2410_dma_chan *chan = lookup_dma_channel(channel);
 	struct s3c_dma_buf *buf;
-	unsigned long flags;
 
 	pr_debug("%s: id=%p, data=%08x, size=%d\n", __FUNCTION__, id, (unsigned int) data, size);
 
+	if (chan->ring) {
+		printk(KERN_ERR "dma CH %d: %s: channel is looping over a ring\n",
+		       chan->number, __FUNCTION__);
+		return -EBUSY;
+	}
+
 	buf = kmem_cache_alloc(dma_kmem, GFP_ATOMIC);
 	if (buf == NULL) {
 		printk(KERN_ERR "dma <%d> no memory for buffer\n", channel);
@@ -494,16 +515,33 @@ int s3c2410_dma_enqueue(unsigned int channel, void *id,
 	buf->size = size;
 	buf->id = id;
 	buf->magic = BUF_MAGIC;
+	buf->nsegs = 0;
+	buf->mcsize = SIZE_OF_MICRO_CODES;
 
-	local_irq_save(flags);
-
-	buf->mcptr_cpu = dma_alloc_coherent(NULL, SIZE_OF_MICRO_CODES, &buf->mcptr, GFP_ATOMIC);
+	buf->mcptr_cpu = dma_alloc_coherent(NULL, buf->mcsize, &buf->mcptr, GFP_ATOMIC);
 
 	if (buf->mcptr_cpu == NULL) {
 		printk(KERN_ERR "%s: failed to allocate memory for micro codes\n", __FUNCTION__);
+		kmem_cache_free(dma_kmem, buf);
 		return -ENOMEM;
 	}
 
+	return s3c_dma_queuebuf(chan, channel, buf);
+}
+EXPORT_SYMBOL(s3c2410_dma_enqueue);
+
+/* s3c_dma_queuebuf
+ *
+ * add a buffer with its micro code buffer allocated to the channel's queue,
+ * and load or start it if possible
+ */
+static int s3c_dma_queuebuf(struct s3c2410_dma_chan *chan, unsigned int channel,
+			    struct s3c_dma_buf *buf)
+{
+	unsigned long flags;
+
+	local_irq_save(flags);
+
 	if (chan->curr == NULL) {
 		/* we've got nothing loaded... */
 		pr_debug("%s: buffer %p queued onto empty channel\n", __FUNCTION__, buf);
@@ -552,7 +590,229 @@ int s3c2410_dma_enqueue(unsigned int channel, void *id,
 
 	return 0;
 }
-EXPORT_SYMBOL(s3c2410_dma_enqueue);
+
+/* s3c2410_dma_enqueue_segs
+ *
+ * queue a scatter-gather job given as a list of segments.
+ *
+ * id         the device driver's id information for this job
+ * segs       the segments, source and destination physical addresses
+ * nsegs      the number of segments
+ *
+ * The segments are compiled into a single micro code program at once, so
+ * the job is loaded like one buffer and raises one interrupt when it is
+ * done. The buffer done callback gets the total size of the segments.
+ * Segment sizes must be multiples of the transfer unit.
+ */
+int s3c2410_dma_enqueue_segs(unsigned int channel, void *id,
+			     const struct s3c_dma_seg *segs, int nsegs)
+{
+	struct s3c2410_dma_chan *chan = lookup_dma_channel(channel);
+	pl330_DMA_parameters_t dma_param;
+	struct s3c_dma_buf *buf;
+	int i, size = 0;
+
+	pr_debug("%s: id=%p, nsegs=%d\n", __FUNCTION__, id, nsegs);
+
+	if (chan == NULL || nsegs <= 0)
+		return -EINVAL;
+
+	if (chan->ring)
+		return -EBUSY;
+
+	memset(&dma_param, 0, sizeof(pl330_DMA_parameters_t));
+	dma_param.mPeriNum = chan->config_flags;
+	dma_param.mControl = *(pl330_DMA_control_t *) &chan->dcon;
+
+	switch (chan->source) {
+	case S3C2410_DMASRC_MEM:
+	case S3C2410_DMASRC_HW:
+	case S3C_DMA_MEM2MEM:
+		dma_param.mDirection = chan->source;
+		break;
+
+	case S3C_DMA_MEM2MEM_SET:
+		dma_param.mDirection = S3C_DMA_MEM2MEM;
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	for (i = 0; i < nsegs; i++)
+		size += segs[i].len;
+
+	buf = kmem_cache_alloc(dma_kmem, GFP_ATOMIC);
+	if (buf == NULL) {
+		printk(KERN_ERR "dma <%d> no memory for buffer\n", channel);
+		return -ENOMEM;
+	}
+
+	buf->next = NULL;
+	buf->data = buf->ptr = segs[0].src;
+	buf->size = size;
+	buf->id = id;
+	buf->magic = BUF_MAGIC;
+	buf->nsegs = nsegs;
+	buf->mcsize = nsegs * PL330_MAX_SEG_MCODE;
+
+	buf->mcptr_cpu = dma_alloc_coherent(NULL, buf->mcsize, &buf->mcptr, GFP_ATOMIC);
+	if (buf->mcptr_cpu == NULL) {
+		printk(KERN_ERR "%s: failed to allocate memory for micro codes\n", __FUNCTION__);
+		kmem_cache_free(dma_kmem, buf);
+		return -ENOMEM;
+	}
+
+	if (setup_DMA_channel_for_sg((u8 *)buf->mcptr_cpu, dma_param, segs, nsegs,
+				     chan->number) == 0) {
+		dma_free_coherent(NULL, buf->mcsize, buf->mcptr_cpu, buf->mcptr);
+		kmem_cache_free(dma_kmem, buf);
+		return -EINVAL;
+	}
+
+	return s3c_dma_queuebuf(chan, channel, buf);
+}
+EXPORT_SYMBOL(s3c2410_dma_enqueue_segs);
+
+/* s3c2410_dma_enqueue_sglist
+ *
+ * queue a dma mapped scatterlist as one job, to or from the device address
+ * set with s3c2410_dma_devconfig()
+ */
+int s3c2410_dma_enqueue_sglist(unsigned int channel, void *id,
+			       struct scatterlist *sgl, int nents)
+{
+	struct s3c2410_dma_chan *chan = lookup_dma_channel(channel);
+	struct s3c_dma_seg *segs;
+	struct scatterlist *sg;
+	int i, ret;
+
+	if (chan == NULL || nents <= 0)
+		return -EINVAL;
+
+	segs = kmalloc(nents * sizeof(*segs), GFP_ATOMIC);
+	if (segs == NULL)
+		return -ENOMEM;
+
+	for_each_sg(sgl, sg, nents, i) {
+		if (chan->source == S3C2410_DMASRC_HW) {
+			segs[i].src = chan->dev_addr;
+			segs[i].dst = sg_dma_address(sg);
+		} else {
+			segs[i].src = sg_dma_address(sg);
+			segs[i].dst = chan->dev_addr;
+		}
+		segs[i].len = sg_dma_len(sg);
+	}
+
+	ret = s3c2410_dma_enqueue_segs(channel, id, segs, nents);
+	kfree(segs);
+
+	return ret;
+}
+EXPORT_SYMBOL(s3c2410_dma_enqueue_sglist);
+
+/* s3c2410_dma_enqueue_ring
+ *
+ * load a cyclic transfer over the whole buffer onto an empty channel.
+ *
+ * id         the device driver's id information for the ring
+ * data       the physical address of the buffer data
+ * size       the size of the buffer in bytes, a multiple of period
+ * period     the size of one period in bytes
+ *
+ * The micro code loops over the buffer until the channel is flushed and
+ * raises the channel interrupt at the end of every period, so the buffer
+ * done callback is called with the period size but nothing is ever
+ * reloaded.  Interrupts that are served late may cover several periods;
+ * use s3c2410_dma_getposition() to find out where the transfer really is.
+ * Stopping and restarting the channel starts over from the beginning.
+ */
+int s3c2410_dma_enqueue_ring(unsigned int channel, void *id,
+			     dma_addr_t data, int size, int period)
+{
+	struct s3c2410_dma_chan *chan = lookup_dma_channel(channel);
+	pl330_DMA_parameters_t dma_param;
+	struct s3c_dma_buf *buf;
+	unsigned long flags;
+	unsigned long tmp;
+
+	pr_debug("%s: id=%p, data=%08x, size=%d, period=%d\n", __FUNCTION__,
+		 id, (unsigned int) data, size, period);
+
+	if (chan == NULL)
+		return -EINVAL;
+
+	if (chan->source != S3C2410_DMASRC_MEM && chan->source != S3C2410_DMASRC_HW)
+		return -EINVAL;
+
+	buf = kmem_cache_alloc(dma_kmem, GFP_KERNEL);
+	if (buf == NULL) {
+		printk(KERN_ERR "dma <%d> no memory for buffer\n", channel);
+		return -ENOMEM;
+	}
+
+	buf->next = NULL;
+	buf->data = buf->ptr = data;
+	buf->size = period;
+	buf->id = id;
+	buf->magic = BUF_MAGIC;
+	buf->nsegs = 0;
+	buf->mcsize = SIZE_OF_MICRO_CODES;
+
+	buf->mcptr_cpu = dma_alloc_coherent(NULL, buf->mcsize, &buf->mcptr, GFP_KERNEL);
+	if (buf->mcptr_cpu == NULL) {
+		printk(KERN_ERR "%s: failed to allocate memory for micro codes\n", __FUNCTION__);
+		kmem_cache_free(dma_kmem, buf);
+		return -ENOMEM;
+	}
+
+	memset(&dma_param, 0, sizeof(pl330_DMA_parameters_t));
+	dma_param.mPeriNum = chan->config_flags;
+	dma_param.mDirection = chan->source;
+	if (chan->source == S3C2410_DMASRC_MEM) {
+		dma_param.mSrcAddr = data;
+		dma_param.mDstAddr = chan->dev_addr;
+	} else {
+		dma_param.mSrcAddr = chan->dev_addr;
+		dma_param.mDstAddr = data;
+	}
+	dma_param.mTrSize = size;
+	dma_param.mControl = *(pl330_DMA_control_t *) &chan->dcon;
+
+	if (setup_DMA_channel_for_ring((u8 *)buf->mcptr_cpu, dma_param, period, chan->number) == 0) {
+		dma_free_coherent(NULL, SIZE_OF_MICRO_CODES, buf->mcptr_cpu, buf->mcptr);
+		kmem_cache_free(dma_kmem, buf);
+		return -EINVAL;
+	}
+
+	local_irq_save(flags);
+
+	if (chan->curr != NULL || chan->next != NULL || chan->state != S3C_DMA_IDLE) {
+		local_irq_restore(flags);
+		printk(KERN_ERR "dma CH %d: %s: channel not empty\n", chan->number, __FUNCTION__);
+		dma_free_coherent(NULL, SIZE_OF_MICRO_CODES, buf->mcptr_cpu, buf->mcptr);
+		kmem_cache_free(dma_kmem, buf);
+		return -EBUSY;
+	}
+
+	chan->curr = chan->end = buf;
+	chan->next = NULL;
+	chan->ring = 1;
+	chan->load_state = S3C_DMALOAD_1LOADED;
+
+	tmp = dma_rdreg(chan->dma_con, S3C_DMAC_INTEN);
+	tmp |= (1 << chan->number);
+	dma_wrreg(chan->dma_con, S3C_DMAC_INTEN, tmp);
+
+	if (chan->flags & S3C2410_DMAF_AUTOSTART)
+		s3c2410_dma_ctrl(channel, S3C2410_DMAOP_START);
+
+	local_irq_restore(flags);
+
+	return 0;
+}
+EXPORT_SYMBOL(s3c2410_dma_enqueue_ring);
 
 static inline void s3c_dma_freebuf(struct s3c_dma_buf * buf)
 {
@@ -562,7 +822,7 @@ static inline void s3c_dma_freebuf(struct s3c_dma_buf * buf)
 
 	if (magicok) {
 		local_irq_enable();
-		dma_free_coherent(NULL, SIZE_OF_MICRO_CODES, buf->mcptr_cpu, buf->mcptr);
+		dma_free_coherent(NULL, buf->mcsize, buf->mcptr_cpu, buf->mcptr);
 		local_irq_disable();
 
 		kmem_cache_free(dma_kmem, buf);
@@ -631,6 +891,14 @@ static irqreturn_t s3c_dma_irq(int irq, void *devpw)
 
 			dbg_showchan(chan);
 
+			/* a ring keeps running, just report the period */
+			if (chan->ring) {
+				s3c_clear_interrupts(chan->dma_con->number, chan->number);
+				if (buf != NULL)
+					s3c_dma_buffdone(chan, buf, S3C2410_RES_OK);
+				goto next_channel;
+			}
+
 			/* modify the channel state */
 			switch (chan->load_state) {
 			case S3C_DMALOAD_1RUNNING:
@@ -879,6 +1147,10 @@ int s3c2410_dma_free(unsigned int channel, struct s3c2410_dma_client *client)
 		s3c2410_dma_ctrl(channel, S3C2410_DMAOP_STOP);
 	}
 
+	/* a ring is never consumed, so it would outlive the client */
+	if (chan->ring)
+		s3c2410_dma_ctrl(channel, S3C2410_DMAOP_FLUSH);
+
 	chan->client = NULL;
 	chan->in_use = 0;
 
@@ -957,6 +1229,7 @@ static int s3c_dma_flush(struct s3c2410_dma_chan *chan)
 
 	chan->curr = chan->next = chan->end = NULL;
 	chan->load_state = S3C_DMALOAD_NONE;
+	chan->ring = 0;
 
 	if (buf != NULL) {
 		for (; buf != NULL; buf = next) {
@@ -175,6 +175,19 @@ struct s3c_dma_buf {
 	void			*id;		/* client's id */
 	dma_addr_t		mcptr;		/* physical pointer to a set of micro codes */
 	unsigned long 		*mcptr_cpu;	/* virtual pointer to a set of micro codes */
+	int			mcsize;		/* size of the micro code buffer */
+	int			nsegs;		/* segments compiled in, 0 for one buffer */
+};
+
+/* s3c_dma_seg
+ *
+ * one segment of a scatter-gather job, see s3c2410_dma_enqueue_segs()
+*/
+
+struct s3c_dma_seg {
+	dma_addr_t		src;
+	dma_addr_t		dst;
+	unsigned int		len;		/* bytes, a multiple of the xfer unit */
 };
 
 /* [1] is this updated for both recv/send modes? */
@@ -244,6 +257,7 @@ struct s3c2410_dma_chan {
 	unsigned char		 irq_claimed; /* irq claimed for channel */
 	unsigned char		 irq_enabled; /* irq enabled for channel */
 	unsigned char		 xfer_unit;   /* size of an transfer */
+	unsigned char		 ring;        /* looping over a period ring */
 
 	/* channel state */
 
@@ -350,6 +364,49 @@ extern int s3c2410_dma_enqueue(unsigned int channel, void *id,
 extern int s3c2410_dma_enqueue_sg(unsigned int channel, void *id,
 			       dma_addr_t data, int size, struct s3c_sg_list *sg_list);
 
+/* s3c_dma_slave
+ *
+ * dmaengine slave description, to be put in dma_chan->private by the
+ * filter passed to dma_request_channel() for a DMA_SLAVE channel
+*/
+
+struct s3c_dma_slave {
+	unsigned int		channel;	/* DMACH_* of the peripheral */
+	dma_addr_t		fifo;		/* device FIFO address */
+	int			width;		/* FIFO access width in bytes */
+};
+
+/* s3c2410_dma_enqueue_segs
+ *
+ * queue a whole scatter-gather job. All segments are compiled into one
+ * micro code program and the buffer done callback is called once, with
+ * the total size, when the last segment has been transferred.
+*/
+
+extern int s3c2410_dma_enqueue_segs(unsigned int channel, void *id,
+				    const struct s3c_dma_seg *segs, int nsegs);
+
+/* s3c2410_dma_enqueue_sglist
+ *
+ * as s3c2410_dma_enqueue_segs(), for a dma mapped scatterlist moved to or
+ * from the device address given to s3c2410_dma_devconfig()
+*/
+
+struct scatterlist;
+
+extern int s3c2410_dma_enqueue_sglist(unsigned int channel, void *id,
+				      struct scatterlist *sgl, int nents);
+
+/* s3c2410_dma_enqueue_ring
+ *
+ * loop over the given buffer until the channel is flushed, calling the
+ * buffer done callback with the period size at the end of every period.
+ * The channel must be empty.
+*/
+
+extern int s3c2410_dma_enqueue_ring(unsigned int channel, void *id,
+				    dma_addr_t data, int size, int period);
+
 /* s3c2410_dma_config
  *
  * configure the dma channel
@@ -78,6 +78,7 @@ extern void s5p6442_pm_do_restore(struct sleep_save *ptr, int count);
 #ifdef CONFIG_PM
 extern int s3c64xx_irq_suspend(struct sys_device *dev, pm_message_t state);
 extern int s3c64xx_irq_resume(struct sys_device *dev);
+extern int s5p64xx_wakeup_irq(unsigned long wakeup_stat);
 #else
 #define s3c64xx_irq_suspend	NULL
 #define s3c64xx_irq_resume	NULL
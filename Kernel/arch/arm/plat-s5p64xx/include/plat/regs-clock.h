@@ -408,6 +408,9 @@
 #define S5P_CLAMP_STABLE 	S5P_CLKREG(0xC114)
 
 #define S5P_WAKEUP_STAT 	S5P_CLKREG(0xC200)
+#define S5P_WAKEUP_STAT_EINT		(1 << 0)
+#define S5P_WAKEUP_STAT_RTC_ALARM	(1 << 1)
+#define S5P_WAKEUP_STAT_RTC_TICK	(1 << 2)
 #define S5P_BLK_PWR_STAT 	S5P_CLKREG(0xC204)
 
 #define S5P_OTHERS 		S5P_CLKREG(0xE000)
@@ -30,6 +30,7 @@
 #include <mach/gpio.h>
 #include <mach/regs-irq.h>
 #include <plat/regs-gpio.h>
+#include <plat/regs-clock.h>
 
 #include <plat/gpio-cfg.h>
 
@@ -175,6 +176,34 @@ int s3c_irq_eint_set_wake(unsigned int irq, unsigned int on)
 
 	return 0;
 }
+
+/* s5p64xx_wakeup_irq
+ *
+ * Decode S5P_WAKEUP_STAT into the interrupt that woke us, or -1 if it
+ * cannot be told. Must run on resume before the EINT pending bits are
+ * cleared and before S5P_EINT_WAKEUP_MASK is put back for normal mode.
+*/
+int s5p64xx_wakeup_irq(unsigned long wakeup_stat)
+{
+	unsigned long pend = 0;
+	int reg, eint;
+
+	if (wakeup_stat & S5P_WAKEUP_STAT_RTC_ALARM)
+		return IRQ_RTC_ALARM;
+	if (wakeup_stat & S5P_WAKEUP_STAT_RTC_TICK)
+		return IRQ_RTC_TIC;
+	if (!(wakeup_stat & S5P_WAKEUP_STAT_EINT))
+		return -1;
+
+	for (reg = 0; reg < 4; reg++)
+		pend |= (__raw_readl(S5P64XX_EINTPEND(reg)) & 0xff) << (reg * 8);
+	pend &= ~__raw_readl(S5P_EINT_WAKEUP_MASK);
+	if (!pend)
+		return -1;
+
+	eint = __ffs(pend);
+	return eint < 16 ? IRQ_EINT0 + eint : IRQ_EINT(eint);
+}
 #else
 #define s3c_irq_eint_set_wake NULL
 #endif
@@ -927,6 +927,7 @@ static int s5p6442_pm_enter(suspend_state_t state)
 	unsigned long regs_save[16];
 	unsigned int tmp;
 	unsigned int eint_wakeup_mask;
+	u64 t0 = suspend_prof_now();
 #ifdef MUXD0D1_A2M
 	old_clk_src0 = __raw_readl(S5P_CLK_SRC0);
 	__raw_writel(0x00001111, S5P_CLK_SRC0);
@@ -1063,12 +1064,14 @@ static int s5p6442_pm_enter(suspend_state_t state)
 	 * code to differentiate return from save and return from sleep */
 
 	if (s5p6442_cpu_save(regs_save) == 0) {
+		suspend_prof_record(SUSPEND_PROF_PHASE, "platform_save", t0);
 		flush_cache_all();
 		pm_cpu_sleep();
 	}
 
 	/* restore the cpu state */
 	cpu_init();
+	t0 = suspend_prof_now();
 
 	/* restore the system state */
 	s5p6442_pm_do_restore(gpio_save, ARRAY_SIZE(gpio_save));
@@ -1123,6 +1126,7 @@ static int s5p6442_pm_enter(suspend_state_t state)
 	tmp = __raw_readl(S5P_WAKEUP_STAT);
 	DEBUG_WAKEUP("[PM] WAKEUP_STAT (0x%08x)\n", tmp);
 	__raw_writel(tmp, S5P_WAKEUP_STAT);
+	wake_lock_wakeup_irq(s5p64xx_wakeup_irq(tmp));
 
 	if( (__raw_readl(S5P64XX_GPA0_BASE+0xF40) & (1 << 7)) ||  // AP_PMIC_IRQ
 			(__raw_readl(S5P64XX_GPA0_BASE+0xF48) & (1 << 7)) )  // JACK_nINT
@@ -1159,6 +1163,7 @@ static int s5p6442_pm_enter(suspend_state_t state)
 #endif
 	/* ok, let's return from sleep */
 	DBG("S5P6442 PM Resume (post-restore)\n");
+	suspend_prof_record(SUSPEND_PROF_PHASE, "platform_restore", t0);
 	return 0;
 }
 
@@ -12,6 +12,19 @@
  * Asynchronous and synchronous requests are not treated separately, but
  * we relay on deadlines to ensure fairness.
  *
+ * Flash aware mode (flash_aware = 1) is meant for STL/OneNAND, where
+ * reads are cheap and writes pay for erases.  Reads get strict priority
+ * over writes, bounded by writes_starved: after that many reads have
+ * been dispatched while writes wait, or when the oldest write expired,
+ * a write group goes out.  A write group is the oldest write followed
+ * by the queued writes that continue it sector by sector, up to
+ * write_group_kb, so the STL sees one long sequential write.
+ *
+ * Dispatch to completion latency is kept in a histogram per direction,
+ * shown by the read_latency and write_latency attributes.  Writing to
+ * either attribute clears both.  Documentation/block/iosched-replay.c
+ * replays a blktrace under sio and the other schedulers and prints them.
+ *
  */
 #include <linux/blkdev.h>
 #include <linux/elevator.h>
@@ -19,6 +32,9 @@
 #include <linux/module.h>
 #include <linux/init.h>
 #include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/hrtimer.h>
+#include <linux/rbtree.h>
 
 enum {
 	ASYNC,
@@ -30,20 +46,85 @@ static const int sync_expire = HZ / 2;	/* max time before a sync is submitted. *
 static const int async_expire = 5 * HZ;	/* ditto for async, these limits are SOFT! */
 static const int fifo_batch = 2;	/* # of sequential requests treated as one
 					   by the above parameters. For throughput. */
+static const int flash_aware = 0;	/* read priority and write grouping */
+static const int writes_starved = 16;	/* max reads while writes wait */
+static const int write_group_kb = 512;	/* max size of a write group */
+
+/* Latency histogram: LAT_BUCKETS - 1 powers of two from 250us, + overflow */
+#define LAT_BUCKETS	11
+#define LAT_MIN_US	250
+
+struct sio_latency {
+	unsigned long count;
+	unsigned long long total_us;
+	unsigned long max_us;
+	unsigned long hist[LAT_BUCKETS];
+};
 
 /* Elevator data */
 struct sio_data {
 	/* Request queues */
 	struct list_head fifo_list[2];
 
+	/* Writes sorted by sector, to build write groups */
+	struct rb_root write_sort;
+
 	/* Attributes */
 	unsigned int batched;
+	unsigned int starved;
 
 	/* Settings */
 	int fifo_expire[2];
 	int fifo_batch;
+	int flash_aware;
+	int writes_starved;
+	int write_group_kb;
+
+	/* Statistics */
+	struct sio_latency latency[2];	/* READ, WRITE */
 };
 
+/*
+ * The fifo a request sits on: by sync/async normally, by read/write in
+ * flash aware mode.  It is remembered in elevator_private so that
+ * switching modes does not lose track of queued requests.
+ */
+static inline int
+sio_fifo_index(struct sio_data *sd, struct request *rq)
+{
+	if (sd->flash_aware)
+		return rq_data_dir(rq) == READ ? SYNC : ASYNC;
+
+	return rq_is_sync(rq);
+}
+
+static inline int
+sio_rq_fifo(struct request *rq)
+{
+	return (unsigned long)rq->elevator_private;
+}
+
+static inline void
+sio_add_rq_rb(struct sio_data *sd, struct request *rq)
+{
+	/* A second write at the same sector just stays out of the tree */
+	if (rq_data_dir(rq) == WRITE)
+		elv_rb_add(&sd->write_sort, rq);
+}
+
+static inline void
+sio_del_rq_rb(struct sio_data *sd, struct request *rq)
+{
+	if (!RB_EMPTY_NODE(&rq->rb_node))
+		elv_rb_del(&sd->write_sort, rq);
+}
+
+static inline unsigned long
+sio_now_us(void)
+{
+	return (unsigned long)ktime_to_us(ktime_get());
+}
+
 static void
 sio_merged_requests(struct request_queue *q, struct request *rq,
 		    struct request *next)
@@ -56,11 +137,13 @@ sio_merged_requests(struct request_queue *q, struct request *rq,
 		if (time_before(rq_fifo_time(next), rq_fifo_time(rq))) {
 			list_move(&rq->queuelist, &next->queuelist);
 			rq_set_fifo_time(rq, rq_fifo_time(next));
+			rq->elevator_private = next->elevator_private;
 		}
 	}
 
 	/* Delete next request */
 	rq_fifo_clear(next);
+	sio_del_rq_rb(q->elevator->elevator_data, next);
 }
 
 static void
@@ -68,13 +151,16 @@ sio_add_request(struct request_queue *q, struct request *rq)
 {
 	struct sio_data *sd = q->elevator->elevator_data;
 	const int sync = rq_is_sync(rq);
+	const int fifo = sio_fifo_index(sd, rq);
 
 	/*
 	 * Add request to the proper fifo list and set its
 	 * expire time.
 	 */
+	rq->elevator_private = (void *)(unsigned long)fifo;
 	rq_set_fifo_time(rq, jiffies + sd->fifo_expire[sync]);
-	list_add_tail(&rq->queuelist, &sd->fifo_list[sync]);
+	list_add_tail(&rq->queuelist, &sd->fifo_list[fifo]);
+	sio_add_rq_rb(sd, rq);
 }
 
 static int
@@ -148,17 +234,76 @@ sio_dispatch_request(struct sio_data *sd, struct request *rq)
 	 * and dispatch it.
 	 */
 	rq_fifo_clear(rq);
+	sio_del_rq_rb(sd, rq);
+	rq->elevator_private2 = (void *)sio_now_us();
 	elv_dispatch_add_tail(rq->q, rq);
 
 	sd->batched++;
 }
 
+/*
+ * Dispatch the oldest write and the queued writes that continue it, up
+ * to write_group_kb.
+ */
+static int
+sio_dispatch_write_group(struct sio_data *sd, struct request *rq)
+{
+	unsigned int max_sectors = sd->write_group_kb << 1;
+	unsigned int sectors = 0;
+	struct request *next;
+	int n = 0;
+
+	do {
+		next = NULL;
+		if (rq_data_dir(rq) == WRITE)
+			next = elv_rb_find(&sd->write_sort,
+					   blk_rq_pos(rq) + blk_rq_sectors(rq));
+
+		sectors += blk_rq_sectors(rq);
+		sio_dispatch_request(sd, rq);
+		n++;
+
+		rq = next;
+	} while (rq && sectors + blk_rq_sectors(rq) <= max_sectors);
+
+	return n;
+}
+
+static int
+sio_dispatch_flash(struct sio_data *sd)
+{
+	struct list_head *reads = &sd->fifo_list[SYNC];
+	struct list_head *writes = &sd->fifo_list[ASYNC];
+	struct request *rq;
+
+	if (!list_empty(writes) &&
+	    (list_empty(reads) || sd->starved >= sd->writes_starved ||
+	     sio_expired_request(sd, ASYNC))) {
+		sd->starved = 0;
+		return sio_dispatch_write_group(sd, rq_entry_fifo(writes->next));
+	}
+
+	if (list_empty(reads))
+		return 0;
+
+	/* Reads are cheap: plain FIFO order, strictly ahead of writes */
+	rq = rq_entry_fifo(reads->next);
+	sio_dispatch_request(sd, rq);
+	if (!list_empty(writes))
+		sd->starved++;
+
+	return 1;
+}
+
 static int
 sio_dispatch_requests(struct request_queue *q, int force)
 {
 	struct sio_data *sd = q->elevator->elevator_data;
 	struct request *rq = NULL;
 
+	if (sd->flash_aware)
+		return sio_dispatch_flash(sd);
+
 	/*
 	 * Retrieve any expired request after a batch of
 	 * sequential requests.
@@ -181,11 +326,30 @@ sio_dispatch_requests(struct request_queue *q, int force)
 	return 1;
 }
 
+static void
+sio_completed_request(struct request_queue *q, struct request *rq)
+{
+	struct sio_data *sd = q->elevator->elevator_data;
+	struct sio_latency *lat = &sd->latency[rq_data_dir(rq)];
+	unsigned long us = sio_now_us() - (unsigned long)rq->elevator_private2;
+	unsigned long limit = LAT_MIN_US;
+	int i;
+
+	for (i = 0; i < LAT_BUCKETS - 1 && us >= limit; i++)
+		limit <<= 1;
+
+	lat->hist[i]++;
+	lat->count++;
+	lat->total_us += us;
+	if (us > lat->max_us)
+		lat->max_us = us;
+}
+
 static struct request *
 sio_former_request(struct request_queue *q, struct request *rq)
 {
 	struct sio_data *sd = q->elevator->elevator_data;
-	const int sync = rq_is_sync(rq);
+	const int sync = sio_rq_fifo(rq);
 
 	if (rq->queuelist.prev == &sd->fifo_list[sync])
 		return NULL;
@@ -198,7 +362,7 @@ static struct request *
 sio_latter_request(struct request_queue *q, struct request *rq)
 {
 	struct sio_data *sd = q->elevator->elevator_data;
-	const int sync = rq_is_sync(rq);
+	const int sync = sio_rq_fifo(rq);
 
 	if (rq->queuelist.next == &sd->fifo_list[sync])
 		return NULL;
@@ -213,19 +377,24 @@ sio_init_queue(struct request_queue *q)
 	struct sio_data *sd;
 
 	/* Allocate structure */
-	sd = kmalloc_node(sizeof(*sd), GFP_KERNEL, q->node);
+	sd = kzalloc_node(sizeof(*sd), GFP_KERNEL, q->node);
 	if (!sd)
 		return NULL;
 
 	/* Initialize fifo lists */
 	INIT_LIST_HEAD(&sd->fifo_list[SYNC]);
 	INIT_LIST_HEAD(&sd->fifo_list[ASYNC]);
+	sd->write_sort = RB_ROOT;
 
 	/* Initialize data */
 	sd->batched = 0;
+	sd->starved = 0;
 	sd->fifo_expire[SYNC] = sync_expire;
 	sd->fifo_expire[ASYNC] = async_expire;
 	sd->fifo_batch = fifo_batch;
+	sd->flash_aware = flash_aware;
+	sd->writes_starved = writes_starved;
+	sd->write_group_kb = write_group_kb;
 
 	return sd;
 }
@@ -273,6 +442,9 @@ static ssize_t __FUNC(struct elevator_queue *e, char *page)		\
 SHOW_FUNCTION(sio_sync_expire_show, sd->fifo_expire[SYNC], 1);
 SHOW_FUNCTION(sio_async_expire_show, sd->fifo_expire[ASYNC], 1);
 SHOW_FUNCTION(sio_fifo_batch_show, sd->fifo_batch, 0);
+SHOW_FUNCTION(sio_flash_aware_show, sd->flash_aware, 0);
+SHOW_FUNCTION(sio_writes_starved_show, sd->writes_starved, 0);
+SHOW_FUNCTION(sio_write_group_kb_show, sd->write_group_kb, 0);
 #undef SHOW_FUNCTION
 
 #define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
@@ -294,8 +466,57 @@ static ssize_t __FUNC(struct elevator_queue *e, const char *page, size_t count)
 STORE_FUNCTION(sio_sync_expire_store, &sd->fifo_expire[SYNC], 0, INT_MAX, 1);
 STORE_FUNCTION(sio_async_expire_store, &sd->fifo_expire[ASYNC], 0, INT_MAX, 1);
 STORE_FUNCTION(sio_fifo_batch_store, &sd->fifo_batch, 0, INT_MAX, 0);
+STORE_FUNCTION(sio_flash_aware_store, &sd->flash_aware, 0, 1, 0);
+STORE_FUNCTION(sio_writes_starved_store, &sd->writes_starved, 0, INT_MAX, 0);
+STORE_FUNCTION(sio_write_group_kb_store, &sd->write_group_kb, 4, 65536, 0);
 #undef STORE_FUNCTION
 
+static ssize_t
+sio_latency_show(struct sio_latency *lat, char *page)
+{
+	unsigned long limit = LAT_MIN_US;
+	unsigned long avg = 0;
+	int i, len;
+
+	if (lat->count)
+		avg = div64_u64(lat->total_us, lat->count);
+
+	len = sprintf(page, "count %lu avg_us %lu max_us %lu\n",
+		      lat->count, avg, lat->max_us);
+	for (i = 0; i < LAT_BUCKETS - 1; i++, limit <<= 1)
+		len += sprintf(page + len, "<%lu %lu\n", limit, lat->hist[i]);
+	len += sprintf(page + len, ">=%lu %lu\n", limit >> 1, lat->hist[i]);
+
+	return len;
+}
+
+static ssize_t
+sio_read_latency_show(struct elevator_queue *e, char *page)
+{
+	struct sio_data *sd = e->elevator_data;
+
+	return sio_latency_show(&sd->latency[READ], page);
+}
+
+static ssize_t
+sio_write_latency_show(struct elevator_queue *e, char *page)
+{
+	struct sio_data *sd = e->elevator_data;
+
+	return sio_latency_show(&sd->latency[WRITE], page);
+}
+
+static ssize_t
+sio_latency_store(struct elevator_queue *e, const char *page, size_t count)
+{
+	struct sio_data *sd = e->elevator_data;
+
+	memset(sd->latency, 0, sizeof(sd->latency));
+	return count;
+}
+#define sio_read_latency_store	sio_latency_store
+#define sio_write_latency_store	sio_latency_store
+
 #define DD_ATTR(name) \
 	__ATTR(name, S_IRUGO|S_IWUSR, sio_##name##_show, \
 				      sio_##name##_store)
@@ -304,6 +525,11 @@ static struct elv_fs_entry sio_attrs[] = {
 	DD_ATTR(sync_expire),
 	DD_ATTR(async_expire),
 	DD_ATTR(fifo_batch),
+	DD_ATTR(flash_aware),
+	DD_ATTR(writes_starved),
+	DD_ATTR(write_group_kb),
+	DD_ATTR(read_latency),
+	DD_ATTR(write_latency),
 	__ATTR_NULL
 };
 
@@ -313,6 +539,7 @@ static struct elevator_type iosched_sio = {
 		.elevator_dispatch_fn		= sio_dispatch_requests,
 		.elevator_add_req_fn		= sio_add_request,
 		.elevator_queue_empty_fn	= sio_queue_empty,
+		.elevator_completed_req_fn	= sio_completed_request,
 		.elevator_former_req_fn		= sio_former_request,
 		.elevator_latter_req_fn		= sio_latter_request,
 		.elevator_init_fn		= sio_init_queue,
@@ -24,6 +24,7 @@
 #include <linux/pm_runtime.h>
 #include <linux/resume-trace.h>
 #include <linux/rwsem.h>
+#include <linux/suspend.h>
 #include <linux/interrupt.h>
 #include <linux/timer.h>
 
@@ -373,9 +374,12 @@ void dpm_resume_noirq(pm_message_t state)
 	list_for_each_entry(dev, &dpm_list, power.entry)
 		if (dev->power.status > DPM_OFF) {
 			int error;
+			u64 t0 = suspend_prof_now();
 
 			dev->power.status = DPM_OFF;
 			error = device_resume_noirq(dev, state);
+			suspend_prof_record(SUSPEND_PROF_DEV_RESUME_NOIRQ,
+					    dev_name(dev), t0);
 			if (error)
 				pm_dev_err(dev, state, " early", error);
 		}
@@ -493,11 +497,15 @@ static void dpm_resume(pm_message_t state)
 		get_device(dev);
 		if (dev->power.status >= DPM_OFF) {
 			int error;
+			u64 t0;
 
 			dev->power.status = DPM_RESUMING;
 			mutex_unlock(&dpm_list_mtx);
 
+			t0 = suspend_prof_now();
 			error = device_resume(dev, state);
+			suspend_prof_record(SUSPEND_PROF_DEV_RESUME,
+					    dev_name(dev), t0);
 
 			mutex_lock(&dpm_list_mtx);
 			if (error)
@@ -652,7 +660,11 @@ int dpm_suspend_noirq(pm_message_t state)
 	suspend_device_irqs();
 	mutex_lock(&dpm_list_mtx);
 	list_for_each_entry_reverse(dev, &dpm_list, power.entry) {
+		u64 t0 = suspend_prof_now();
+
 		error = device_suspend_noirq(dev, state);
+		suspend_prof_record(SUSPEND_PROF_DEV_SUSPEND_NOIRQ,
+				    dev_name(dev), t0);
 		if (error) {
 			pm_dev_err(dev, state, " late", error);
 			break;
@@ -728,12 +740,16 @@ static int dpm_suspend(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	while (!list_empty(&dpm_list)) {
 		struct device *dev = to_device(dpm_list.prev);
+		u64 t0;
 
 		get_device(dev);
 		mutex_unlock(&dpm_list_mtx);
 
 		dpm_drv_wdset(dev);
+		t0 = suspend_prof_now();
 		error = device_suspend(dev, state);
+		suspend_prof_record(SUSPEND_PROF_DEV_SUSPEND,
+				    dev_name(dev), t0);
 		dpm_drv_wdclr(dev);
 
 		mutex_lock(&dpm_list_mtx);
@@ -0,0 +1,398 @@
+/*
+ * predict.c - a residency predicting idle governor
+ *
+ * This code is licenced under the GPL version 2 as described
+ * in the COPYING file that acompanies the Linux Kernel.
+ */
+
+#include <linux/kernel.h>
+#include <linux/cpuidle.h>
+#include <linux/debugfs.h>
+#include <linux/pm_qos_params.h>
+#include <linux/seq_file.h>
+#include <linux/time.h>
+#include <linux/ktime.h>
+#include <linux/hrtimer.h>
+#include <linux/tick.h>
+#include <linux/sched.h>
+#include <linux/math64.h>
+#include <linux/uaccess.h>
+
+#define INTERVALS	8
+#define BUCKETS		6
+#define RESOLUTION	1024
+#define DECAY		8
+#define MAX_INTERESTING	50000
+#define MAX_INTERVAL	1000000	/* keeps the variance in 64 bits */
+
+/*
+ * The prediction is the smaller of two guesses:
+ *
+ * 1) The next timer event, scaled by a correction factor that tracks how
+ *    early we really woke up compared to that timer.  As in menu, the
+ *    factor is kept per order of magnitude of the timer distance, since
+ *    an interrupt is much more likely to cut a 500ms sleep short than a
+ *    50us one.
+ *
+ * 2) The typical interval of the last INTERVALS wakeups.  Periodic
+ *    interrupts that are not timers (audio DMA periods, touch reports,
+ *    MMC polling) show up as a run of similar residencies; when the
+ *    last intervals have a standard deviation below 1/4 of their
+ *    average, the average is used.  Outliers above the average are
+ *    dropped one at a time, up to INTERVALS / 2 of them, before giving
+ *    up.
+ *
+ * Each wakeup is then compared with the prediction that chose the
+ * state, and counted in a histogram of measured / predicted.  A wakeup
+ * is also counted as "too deep" when it came before the chosen state's
+ * target_residency, and "too shallow" when a deeper state's
+ * target_residency would have been reached.  The histogram is in
+ * debugfs as cpuidle_predict; writing to the file clears it.
+ */
+
+enum {
+	HIST_LT_25,
+	HIST_LT_50,
+	HIST_LT_75,
+	HIST_ACCURATE,	/* 75% - 125% */
+	HIST_LT_200,
+	HIST_LT_400,
+	HIST_GE_400,
+	HIST_MAX,
+};
+
+static const char *const hist_names[HIST_MAX] = {
+	"<25%", "25-50%", "50-75%", "75-125%", "125-200%", "200-400%", ">400%",
+};
+
+struct predict_stats {
+	unsigned long	hist[HIST_MAX];
+	unsigned long	too_deep;
+	unsigned long	too_shallow;
+	unsigned long	demoted;
+	unsigned long	typical;	/* predictions from the interval history */
+	unsigned long	samples;
+};
+
+struct predict_device {
+	int		last_state_idx;
+	int		needs_update;
+
+	unsigned int	next_timer_us;
+	unsigned int	predicted_us;
+	unsigned int	bucket;
+	u64		correction_factor[BUCKETS];
+
+	unsigned int	intervals[INTERVALS];
+	int		interval_ptr;
+
+	struct predict_stats stats;
+};
+
+static DEFINE_PER_CPU(struct predict_device, predict_devices);
+
+static inline int which_bucket(unsigned int duration)
+{
+	if (duration < 10)
+		return 0;
+	if (duration < 100)
+		return 1;
+	if (duration < 1000)
+		return 2;
+	if (duration < 10000)
+		return 3;
+	if (duration < 100000)
+		return 4;
+	return 5;
+}
+
+/*
+ * Return the average of the recent intervals if they are consistent,
+ * UINT_MAX otherwise.
+ */
+static unsigned int typical_interval(struct predict_device *data)
+{
+	unsigned int thresh = UINT_MAX;
+	unsigned int max, value;
+	u64 avg, variance, diff;
+	int i, divisor, pass;
+
+	for (pass = 0; pass <= INTERVALS / 2; pass++) {
+		avg = 0;
+		max = 0;
+		divisor = 0;
+		for (i = 0; i < INTERVALS; i++) {
+			value = data->intervals[i];
+			if (value > thresh)
+				continue;
+			avg += value;
+			divisor++;
+			if (value > max)
+				max = value;
+		}
+		if (!divisor)
+			break;
+		avg = div_u64(avg, divisor);
+
+		variance = 0;
+		for (i = 0; i < INTERVALS; i++) {
+			value = data->intervals[i];
+			if (value > thresh)
+				continue;
+			diff = value > avg ? value - avg : avg - value;
+			variance += diff * diff;
+		}
+		variance = div_u64(variance, divisor);
+
+		/* stddev <= avg / 4, i.e. variance * 16 <= avg^2 */
+		if (avg && avg < MAX_INTERESTING && variance * 16 <= avg * avg)
+			return avg;
+
+		/* drop the largest interval and try again */
+		thresh = max - 1;
+	}
+
+	return UINT_MAX;
+}
+
+static void predict_update(struct cpuidle_device *dev);
+
+/**
+ * predict_select - selects the next idle state to enter
+ * @dev: the CPU
+ */
+static int predict_select(struct cpuidle_device *dev)
+{
+	struct predict_device *data = &__get_cpu_var(predict_devices);
+	int latency_req = pm_qos_requirement(PM_QOS_CPU_DMA_LATENCY);
+	unsigned int typical;
+	int multiplier;
+	int i;
+
+	if (data->needs_update) {
+		predict_update(dev);
+		data->needs_update = 0;
+	}
+
+	data->last_state_idx = 0;
+
+	/* Special case when user has set very strict latency requirement */
+	if (unlikely(latency_req == 0))
+		return 0;
+
+	data->next_timer_us =
+	    DIV_ROUND_UP((u32)ktime_to_ns(tick_nohz_get_sleep_length()), 1000);
+	data->bucket = which_bucket(data->next_timer_us);
+
+	if (data->correction_factor[data->bucket] == 0)
+		data->correction_factor[data->bucket] = RESOLUTION * DECAY;
+
+	data->predicted_us = div_u64((u64)data->next_timer_us *
+				     data->correction_factor[data->bucket] +
+				     RESOLUTION * DECAY / 2, RESOLUTION * DECAY);
+
+	typical = typical_interval(data);
+	if (typical < data->predicted_us) {
+		data->predicted_us = typical;
+		data->stats.typical++;
+	}
+
+	/* the busier the CPU is with IO, the less exit latency we accept */
+	multiplier = 1 + 10 * nr_iowait_cpu();
+
+	if (data->next_timer_us > 5)
+		data->last_state_idx = CPUIDLE_DRIVER_STATE_START;
+
+	/* find the deepest idle state that satisfies our constraints */
+	for (i = CPUIDLE_DRIVER_STATE_START; i < dev->state_count; i++) {
+		struct cpuidle_state *s = &dev->states[i];
+
+		if (s->target_residency > data->predicted_us)
+			break;
+		if (s->exit_latency > latency_req)
+			break;
+		if (s->exit_latency * multiplier > data->predicted_us)
+			break;
+		data->last_state_idx = i;
+	}
+
+	return data->last_state_idx;
+}
+
+/**
+ * predict_reflect - records that data structures need update
+ * @dev: the CPU
+ *
+ * NOTE: it's important to be fast here because this operation will add to
+ *       the overall exit latency.
+ */
+static void predict_reflect(struct cpuidle_device *dev)
+{
+	struct predict_device *data = &__get_cpu_var(predict_devices);
+	data->needs_update = 1;
+}
+
+static int hist_bucket(unsigned int measured, unsigned int predicted)
+{
+	u64 pct = div_u64((u64)measured * 100, max(predicted, 1U));
+
+	if (pct < 25)
+		return HIST_LT_25;
+	if (pct < 50)
+		return HIST_LT_50;
+	if (pct < 75)
+		return HIST_LT_75;
+	if (pct <= 125)
+		return HIST_ACCURATE;
+	if (pct < 200)
+		return HIST_LT_200;
+	if (pct < 400)
+		return HIST_LT_400;
+	return HIST_GE_400;
+}
+
+/**
+ * predict_update - learns from the last idle period
+ * @dev: the CPU
+ */
+static void predict_update(struct cpuidle_device *dev)
+{
+	struct predict_device *data = &__get_cpu_var(predict_devices);
+	struct predict_stats *st = &data->stats;
+	int last_idx = data->last_state_idx;
+	struct cpuidle_state *target = &dev->states[last_idx];
+	unsigned int measured_us;
+	u64 new_factor;
+
+	/* the driver may have fallen back to a shallower state */
+	if (dev->last_state && dev->last_state != target) {
+		target = dev->last_state;
+		st->demoted++;
+	}
+
+	if (unlikely(!(target->flags & CPUIDLE_FLAG_TIME_VALID)))
+		measured_us = data->next_timer_us;
+	else
+		measured_us = cpuidle_get_last_residency(dev);
+
+	/* the exit latency happens after the event we're interested in */
+	if (measured_us > target->exit_latency)
+		measured_us -= target->exit_latency;
+
+	st->samples++;
+	st->hist[hist_bucket(measured_us, data->predicted_us)]++;
+	last_idx = target - dev->states;
+	if (measured_us < target->target_residency)
+		st->too_deep++;
+	else if (last_idx + 1 < dev->state_count &&
+		 measured_us >= dev->states[last_idx + 1].target_residency)
+		st->too_shallow++;
+
+	/* timer correction factor */
+	new_factor = data->correction_factor[data->bucket] * (DECAY - 1) / DECAY;
+	if (data->next_timer_us > 0 && measured_us < MAX_INTERESTING)
+		new_factor += RESOLUTION * measured_us / data->next_timer_us;
+	else
+		new_factor += RESOLUTION;
+	if (new_factor == 0)
+		new_factor = 1;
+	data->correction_factor[data->bucket] = new_factor;
+
+	/* wakeup history */
+	data->intervals[data->interval_ptr++] = min_t(unsigned int, measured_us, MAX_INTERVAL);
+	if (data->interval_ptr >= INTERVALS)
+		data->interval_ptr = 0;
+}
+
+/**
+ * predict_enable_device - scans a CPU's states and does setup
+ * @dev: the CPU
+ */
+static int predict_enable_device(struct cpuidle_device *dev)
+{
+	struct predict_device *data = &per_cpu(predict_devices, dev->cpu);
+
+	memset(data, 0, sizeof(struct predict_device));
+
+	return 0;
+}
+
+static int predict_stats_show(struct seq_file *s, void *unused)
+{
+	struct predict_stats *st;
+	int cpu, i;
+
+	for_each_online_cpu(cpu) {
+		st = &per_cpu(predict_devices, cpu).stats;
+
+		seq_printf(s, "cpu%d: %lu samples, %lu from history\n",
+			   cpu, st->samples, st->typical);
+		for (i = 0; i < HIST_MAX; i++)
+			seq_printf(s, "  %-9s %lu\n", hist_names[i], st->hist[i]);
+		seq_printf(s, "  too_deep    %lu\n", st->too_deep);
+		seq_printf(s, "  too_shallow %lu\n", st->too_shallow);
+		seq_printf(s, "  demoted     %lu\n", st->demoted);
+	}
+
+	return 0;
+}
+
+static int predict_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, predict_stats_show, NULL);
+}
+
+static ssize_t predict_stats_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		memset(&per_cpu(predict_devices, cpu).stats, 0,
+		       sizeof(struct predict_stats));
+
+	return count;
+}
+
+static const struct file_operations predict_stats_fops = {
+	.open		= predict_stats_open,
+	.read		= seq_read,
+	.write		= predict_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static struct cpuidle_governor predict_governor = {
+	.name =		"predict",
+	.rating =	25,
+	.enable =	predict_enable_device,
+	.select =	predict_select,
+	.reflect =	predict_reflect,
+	.owner =	THIS_MODULE,
+};
+
+static struct dentry *predict_debugfs;
+
+/**
+ * init_predict - initializes the governor
+ */
+static int __init init_predict(void)
+{
+	predict_debugfs = debugfs_create_file("cpuidle_predict", S_IRUGO | S_IWUSR,
+					      NULL, NULL, &predict_stats_fops);
+
+	return cpuidle_register_governor(&predict_governor);
+}
+
+/**
+ * exit_predict - exits the governor
+ */
+static void __exit exit_predict(void)
+{
+	cpuidle_unregister_governor(&predict_governor);
+	debugfs_remove(predict_debugfs);
+}
+
+MODULE_LICENSE("GPL");
+module_init(init_predict);
+module_exit(exit_predict);
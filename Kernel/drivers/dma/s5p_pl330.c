@@ -0,0 +1,754 @@
+/*
+ * drivers/dma/s5p_pl330.c - dmaengine front end for the S5P PL330 DMA core
+ *
+ * Every dmaengine channel sits on top of a channel of the s3c2410_dma
+ * API in arch/arm/plat-s5p/dma-pl330.c.  Descriptors are only queued by
+ * tx_submit; issue_pending compiles all the queued descriptors going the
+ * same way, up to PL330_MAX_BATCH segments, into one micro code program
+ * with s3c2410_dma_enqueue_segs().  A batch of copies or a whole
+ * scatterlist therefore costs a single interrupt.
+ *
+ * Memcpy channels are public and use the memory to memory channels
+ * (DMACH_3D_M2M*).  Slave channels are private: the client's filter for
+ * dma_request_channel() must set chan->private to a struct s3c_dma_slave.
+ *
+ * Reading "s5p_pl330_bench" in debugfs copies bench_size bytes in
+ * bench_chunk sized pieces with the CPU, with one legacy buffer per piece
+ * and with batched dmaengine descriptors, and shows the throughput.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/completion.h>
+#include <linux/debugfs.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/init.h>
+#include <linux/interrupt.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/platform_device.h>
+#include <linux/scatterlist.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#include <mach/dma.h>
+
+#define PL330_MEMCPY_CHANS	4
+#define PL330_SLAVE_CHANS	4
+#define PL330_MAX_BATCH		64		/* segments per job */
+
+/*
+ * setup_DMA_channel_for_sg() encodes a segment in two nested loops of up
+ * to 257 * 256 bursts.  The burst length of a slave is not known here,
+ * so segments are split at 65536 single transfers of the bus width.
+ */
+#define PL330_MAX_SEG_XFERS	65536
+#define PL330_MAX_SEG_LEN	(4 * PL330_MAX_SEG_XFERS)	/* memcpy */
+
+struct pl330_desc {
+	struct dma_async_tx_descriptor	txd;
+	struct list_head		node;
+	enum dma_data_direction		dir;	/* DMA_NONE for memcpy */
+	int				nsegs;
+	struct s3c_dma_seg		segs[0];
+};
+
+struct pl330_chan {
+	struct dma_chan		chan;
+	unsigned int		ch;		/* s3c2410_dma channel */
+	struct s3c_dma_slave	*slave;
+	enum dma_data_direction	dir;		/* direction ch is set up for */
+	struct s3c2410_dma_client client;
+
+	spinlock_t		lock;
+	dma_cookie_t		completed;
+	struct list_head	queue;		/* submitted, not issued */
+	struct list_head	active;		/* in the running job */
+	struct list_head	done;		/* completed, not acked yet */
+	struct tasklet_struct	tasklet;
+	bool			failed;		/* active job was not started */
+	dma_cookie_t		err_first;	/* cookies of the last failed job */
+	dma_cookie_t		err_last;
+
+	struct s3c_dma_seg	batch[PL330_MAX_BATCH];
+	unsigned long		jobs;
+};
+
+struct pl330_dma {
+	struct platform_device	*pdev;
+	struct dma_device	memcpy;
+	struct dma_device	slave;
+	struct pl330_chan	chans[PL330_MEMCPY_CHANS + PL330_SLAVE_CHANS];
+	struct dentry		*bench;
+};
+
+static struct pl330_dma pl330;
+
+static inline struct pl330_chan *to_pl330_chan(struct dma_chan *chan)
+{
+	return container_of(chan, struct pl330_chan, chan);
+}
+
+static inline struct pl330_desc *to_pl330_desc(struct dma_async_tx_descriptor *txd)
+{
+	return container_of(txd, struct pl330_desc, txd);
+}
+
+static inline bool pl330_is_slave(struct pl330_chan *pc)
+{
+	return pc->chan.device == &pl330.slave;
+}
+
+/* Called from pl330_run(), for one job at a time */
+static void pl330_configure(struct pl330_chan *pc, enum dma_data_direction dir)
+{
+	if (pc->dir == dir || !pc->slave)
+		return;
+
+	s3c2410_dma_devconfig(pc->ch, dir == DMA_TO_DEVICE ?
+			      S3C2410_DMASRC_MEM : S3C2410_DMASRC_HW,
+			      0, pc->slave->fifo);
+	s3c2410_dma_config(pc->ch, pc->slave->width, 0);
+	pc->dir = dir;
+}
+
+/*
+ * Move the next job from the queue to pc->active and gather its segments
+ * in pc->batch if the channel is idle.  Called with pc->lock held.
+ * Returns the number of segments, to be passed to pl330_run() once the
+ * lock is dropped, or 0 if there is nothing to start.
+ */
+static int pl330_start(struct pl330_chan *pc, enum dma_data_direction *dir)
+{
+	struct pl330_desc *desc, *tmp;
+	int n = 0;
+
+	if (!list_empty(&pc->active) || list_empty(&pc->queue))
+		return 0;
+
+	*dir = list_first_entry(&pc->queue, struct pl330_desc, node)->dir;
+
+	list_for_each_entry_safe(desc, tmp, &pc->queue, node) {
+		if (desc->dir != *dir || n + desc->nsegs > PL330_MAX_BATCH)
+			break;
+		memcpy(pc->batch + n, desc->segs, desc->nsegs * sizeof(desc->segs[0]));
+		n += desc->nsegs;
+		list_move_tail(&desc->node, &pc->active);
+	}
+
+	return n;
+}
+
+/*
+ * Hand the job gathered by pl330_start() to the legacy core.  This runs
+ * without pc->lock: s3c2410_dma_enqueue_segs() frees coherent memory on
+ * its error path, which must not happen with interrupts disabled.  The
+ * job sitting in pc->active keeps pl330_start() from gathering another
+ * one meanwhile.
+ */
+static void pl330_run(struct pl330_chan *pc, enum dma_data_direction dir, int n)
+{
+	unsigned long flags;
+	int ret;
+
+	if (!n)
+		return;
+
+	pl330_configure(pc, dir);
+
+	ret = s3c2410_dma_enqueue_segs(pc->ch, pc, pc->batch, n);
+	if (ret) {
+		/* the tasklet retires the job with DMA_ERROR status */
+		dev_err(pl330.memcpy.dev, "%s: job of %d segments failed: %d\n",
+			dma_chan_name(&pc->chan), n, ret);
+		spin_lock_irqsave(&pc->lock, flags);
+		pc->failed = true;
+		spin_unlock_irqrestore(&pc->lock, flags);
+		tasklet_schedule(&pc->tasklet);
+		return;
+	}
+
+	pc->jobs++;
+}
+
+static void pl330_buffdone(struct s3c2410_dma_chan *chan, void *id, int size,
+			   enum s3c2410_dma_buffresult result)
+{
+	struct pl330_chan *pc = id;
+
+	/* aborted jobs are cleaned up by pl330_terminate_all() */
+	if (result == S3C2410_RES_OK)
+		tasklet_schedule(&pc->tasklet);
+}
+
+static void pl330_free_acked(struct pl330_chan *pc, struct list_head *list)
+{
+	struct pl330_desc *desc, *tmp;
+
+	list_for_each_entry_safe(desc, tmp, list, node) {
+		if (async_tx_test_ack(&desc->txd)) {
+			list_del(&desc->node);
+			kfree(desc);
+		}
+	}
+}
+
+static void pl330_tasklet(unsigned long data)
+{
+	struct pl330_chan *pc = (struct pl330_chan *)data;
+	struct pl330_desc *desc;
+	enum dma_data_direction dir;
+	unsigned long flags;
+	bool failed;
+	int n;
+	LIST_HEAD(list);
+
+	spin_lock_irqsave(&pc->lock, flags);
+	list_splice_init(&pc->active, &list);
+	failed = pc->failed;
+	pc->failed = false;
+	if (!list_empty(&list)) {
+		pc->completed = list_entry(list.prev, struct pl330_desc, node)->txd.cookie;
+		if (failed) {
+			pc->err_first = list_first_entry(&list, struct pl330_desc,
+							 node)->txd.cookie;
+			pc->err_last = pc->completed;
+		}
+	}
+	n = pl330_start(pc, &dir);
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	pl330_run(pc, dir, n);
+
+	/* no data was moved for a failed job, do not report it done */
+	if (!failed)
+		list_for_each_entry(desc, &list, node)
+			if (desc->txd.callback)
+				desc->txd.callback(desc->txd.callback_param);
+
+	spin_lock_irqsave(&pc->lock, flags);
+	list_splice_tail_init(&list, &pc->done);
+	pl330_free_acked(pc, &pc->done);
+	spin_unlock_irqrestore(&pc->lock, flags);
+}
+
+static dma_cookie_t pl330_tx_submit(struct dma_async_tx_descriptor *txd)
+{
+	struct pl330_desc *desc = to_pl330_desc(txd);
+	struct pl330_chan *pc = to_pl330_chan(txd->chan);
+	dma_cookie_t cookie;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pc->lock, flags);
+	cookie = pc->chan.cookie;
+	if (++cookie < 0)
+		cookie = 1;
+	pc->chan.cookie = cookie;
+	txd->cookie = cookie;
+	list_add_tail(&desc->node, &pc->queue);
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	return cookie;
+}
+
+static struct pl330_desc *pl330_desc_alloc(struct pl330_chan *pc, int nsegs,
+					   unsigned long flags)
+{
+	struct pl330_desc *desc;
+
+	desc = kzalloc(sizeof(*desc) + nsegs * sizeof(desc->segs[0]), GFP_ATOMIC);
+	if (!desc)
+		return NULL;
+
+	dma_async_tx_descriptor_init(&desc->txd, &pc->chan);
+	desc->txd.tx_submit = pl330_tx_submit;
+	desc->txd.flags = flags;
+	desc->nsegs = nsegs;
+
+	return desc;
+}
+
+static struct dma_async_tx_descriptor *
+pl330_prep_dma_memcpy(struct dma_chan *chan, dma_addr_t dest, dma_addr_t src,
+		      size_t len, unsigned long flags)
+{
+	struct pl330_chan *pc = to_pl330_chan(chan);
+	struct pl330_desc *desc;
+	size_t seg;
+	int i, nsegs;
+
+	nsegs = DIV_ROUND_UP(len, PL330_MAX_SEG_LEN);
+	if (!len || nsegs > PL330_MAX_BATCH || ((src | dest | len) & 3))
+		return NULL;
+
+	desc = pl330_desc_alloc(pc, nsegs, flags);
+	if (!desc)
+		return NULL;
+
+	desc->dir = DMA_NONE;
+	for (i = 0; i < nsegs; i++) {
+		seg = min_t(size_t, len, PL330_MAX_SEG_LEN);
+		desc->segs[i].src = src;
+		desc->segs[i].dst = dest;
+		desc->segs[i].len = seg;
+		src += seg;
+		dest += seg;
+		len -= seg;
+	}
+
+	return &desc->txd;
+}
+
+static struct dma_async_tx_descriptor *
+pl330_prep_slave_sg(struct dma_chan *chan, struct scatterlist *sgl,
+		    unsigned int sg_len, enum dma_data_direction direction,
+		    unsigned long flags)
+{
+	struct pl330_chan *pc = to_pl330_chan(chan);
+	struct s3c_dma_slave *slave = pc->slave;
+	struct pl330_desc *desc;
+	struct scatterlist *sg;
+	struct s3c_dma_seg *seg;
+	dma_addr_t addr;
+	size_t len, max;
+	int i, nsegs = 0;
+
+	if (!slave || !sg_len ||
+	    (direction != DMA_TO_DEVICE && direction != DMA_FROM_DEVICE))
+		return NULL;
+
+	/* entries longer than the micro code can loop over are split */
+	max = slave->width * PL330_MAX_SEG_XFERS;
+	for_each_sg(sgl, sg, sg_len, i) {
+		if (!sg_dma_len(sg) || sg_dma_len(sg) % slave->width)
+			return NULL;
+		nsegs += DIV_ROUND_UP(sg_dma_len(sg), max);
+	}
+	if (nsegs > PL330_MAX_BATCH)
+		return NULL;
+
+	desc = pl330_desc_alloc(pc, nsegs, flags);
+	if (!desc)
+		return NULL;
+
+	desc->dir = direction;
+	seg = desc->segs;
+	for_each_sg(sgl, sg, sg_len, i) {
+		addr = sg_dma_address(sg);
+		for (len = sg_dma_len(sg); len; len -= seg->len, seg++) {
+			seg->len = min(len, max);
+			if (direction == DMA_TO_DEVICE) {
+				seg->src = addr;
+				seg->dst = slave->fifo;
+			} else {
+				seg->src = slave->fifo;
+				seg->dst = addr;
+			}
+			addr += seg->len;
+		}
+	}
+
+	return &desc->txd;
+}
+
+static void pl330_terminate_all(struct dma_chan *chan)
+{
+	struct pl330_chan *pc = to_pl330_chan(chan);
+	struct pl330_desc *desc, *tmp;
+	unsigned long flags;
+	LIST_HEAD(list);
+
+	spin_lock_irqsave(&pc->lock, flags);
+	list_splice_init(&pc->queue, &list);
+	list_splice_init(&pc->active, &list);
+	list_splice_init(&pc->done, &list);
+	pc->completed = pc->chan.cookie;
+	pc->failed = false;
+	pc->err_first = pc->err_last = 0;
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	/* the legacy core frees buffers with interrupts enabled */
+	s3c2410_dma_ctrl(pc->ch, S3C2410_DMAOP_FLUSH);
+
+	list_for_each_entry_safe(desc, tmp, &list, node)
+		kfree(desc);
+}
+
+static enum dma_status pl330_is_tx_complete(struct dma_chan *chan,
+					    dma_cookie_t cookie,
+					    dma_cookie_t *done, dma_cookie_t *used)
+{
+	struct pl330_chan *pc = to_pl330_chan(chan);
+	dma_cookie_t last_used, last_complete, first, last;
+	enum dma_status status;
+
+	last_complete = pc->completed;
+	last_used = chan->cookie;
+
+	if (done)
+		*done = last_complete;
+	if (used)
+		*used = last_used;
+
+	status = dma_async_is_complete(cookie, last_complete, last_used);
+	if (status != DMA_SUCCESS)
+		return status;
+
+	/* only the last failed job is remembered */
+	first = pc->err_first;
+	last = pc->err_last;
+	if (last && (first <= last ? cookie >= first && cookie <= last :
+				     cookie >= first || cookie <= last))
+		return DMA_ERROR;
+
+	return DMA_SUCCESS;
+}
+
+static void pl330_issue_pending(struct dma_chan *chan)
+{
+	struct pl330_chan *pc = to_pl330_chan(chan);
+	enum dma_data_direction dir;
+	unsigned long flags;
+	int n;
+
+	spin_lock_irqsave(&pc->lock, flags);
+	n = pl330_start(pc, &dir);
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	pl330_run(pc, dir, n);
+}
+
+static int pl330_alloc_chan_resources(struct dma_chan *chan)
+{
+	struct pl330_chan *pc = to_pl330_chan(chan);
+	int ret;
+
+	if (pl330_is_slave(pc)) {
+		pc->slave = chan->private;
+		if (!pc->slave)
+			return -EINVAL;
+		pc->ch = pc->slave->channel;
+	}
+
+	ret = s3c2410_dma_request(pc->ch, &pc->client, NULL);
+	if (ret)
+		return ret;
+
+	s3c2410_dma_set_buffdone_fn(pc->ch, pl330_buffdone);
+	s3c2410_dma_setflags(pc->ch, S3C2410_DMAF_AUTOSTART);
+
+	if (!pc->slave) {
+		s3c2410_dma_devconfig(pc->ch, S3C_DMA_MEM2MEM, 0, 0);
+		s3c2410_dma_config(pc->ch, 4, 0);
+	}
+
+	pc->dir = DMA_NONE;
+	pc->completed = chan->cookie = 1;
+	pc->failed = false;
+	pc->err_first = pc->err_last = 0;
+
+	return 1;
+}
+
+static void pl330_free_chan_resources(struct dma_chan *chan)
+{
+	struct pl330_chan *pc = to_pl330_chan(chan);
+
+	pl330_terminate_all(chan);
+	tasklet_kill(&pc->tasklet);
+	s3c2410_dma_free(pc->ch, &pc->client);
+	pc->slave = NULL;
+}
+
+static void pl330_init_device(struct dma_device *dd, struct pl330_chan *pc,
+			      int nr, enum dma_transaction_type cap)
+{
+	int i;
+
+	INIT_LIST_HEAD(&dd->channels);
+	dma_cap_set(cap, dd->cap_mask);
+	dd->dev = &pl330.pdev->dev;
+	dd->device_alloc_chan_resources = pl330_alloc_chan_resources;
+	dd->device_free_chan_resources = pl330_free_chan_resources;
+	dd->device_is_tx_complete = pl330_is_tx_complete;
+	dd->device_issue_pending = pl330_issue_pending;
+
+	for (i = 0; i < nr; i++, pc++) {
+		pc->chan.device = dd;
+		pc->client.name = "s5p-pl330-dma";
+		spin_lock_init(&pc->lock);
+		INIT_LIST_HEAD(&pc->queue);
+		INIT_LIST_HEAD(&pc->active);
+		INIT_LIST_HEAD(&pc->done);
+		tasklet_init(&pc->tasklet, pl330_tasklet, (unsigned long)pc);
+		list_add_tail(&pc->chan.device_node, &dd->channels);
+	}
+}
+
+/* Benchmark */
+
+static unsigned int bench_size = 1 << 20;
+module_param(bench_size, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(bench_size, "bytes copied by each benchmark run");
+
+static unsigned int bench_chunk = 4096;
+module_param(bench_chunk, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(bench_chunk, "bytes per copy in the benchmark");
+
+enum { BENCH_CPU, BENCH_LEGACY, BENCH_ENGINE };
+
+static const char *const bench_names[] = {
+	[BENCH_CPU]	= "cpu",
+	[BENCH_LEGACY]	= "legacy",
+	[BENCH_ENGINE]	= "dmaengine",
+};
+
+static struct s3c2410_dma_client bench_client = {
+	.name	= "s5p-pl330-bench",
+};
+
+static void bench_buffdone(struct s3c2410_dma_chan *chan, void *id, int size,
+			   enum s3c2410_dma_buffresult result)
+{
+	complete(id);
+}
+
+/* One s3c2410_dma_enqueue() and one interrupt per chunk, as legacy users do */
+static int bench_legacy(dma_addr_t dst, dma_addr_t src, unsigned long *irqs)
+{
+	DECLARE_COMPLETION_ONSTACK(done);
+	unsigned int off;
+	int ret;
+
+	ret = s3c2410_dma_request(DMACH_3D_M2M7, &bench_client, NULL);
+	if (ret)
+		return ret;
+
+	s3c2410_dma_set_buffdone_fn(DMACH_3D_M2M7, bench_buffdone);
+	s3c2410_dma_config(DMACH_3D_M2M7, 4, 0);
+	s3c2410_dma_setflags(DMACH_3D_M2M7, S3C2410_DMAF_AUTOSTART);
+
+	for (off = 0; off < bench_size; off += bench_chunk) {
+		INIT_COMPLETION(done);
+		s3c2410_dma_devconfig(DMACH_3D_M2M7, S3C_DMA_MEM2MEM, 0, src + off);
+		ret = s3c2410_dma_enqueue(DMACH_3D_M2M7, &done, dst + off, bench_chunk);
+		if (ret)
+			break;
+		if (!wait_for_completion_timeout(&done, HZ)) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+		(*irqs)++;
+	}
+
+	s3c2410_dma_ctrl(DMACH_3D_M2M7, S3C2410_DMAOP_FLUSH);
+	s3c2410_dma_free(DMACH_3D_M2M7, &bench_client);
+
+	return ret;
+}
+
+static bool bench_filter(struct dma_chan *chan, void *param)
+{
+	return chan->device == &pl330.memcpy;
+}
+
+/* One descriptor per chunk, all issued at once */
+static int bench_engine(dma_addr_t dst, dma_addr_t src, unsigned long *irqs)
+{
+	struct dma_async_tx_descriptor *txd;
+	struct pl330_chan *pc;
+	struct dma_chan *chan;
+	dma_cap_mask_t mask;
+	dma_cookie_t cookie = 0;
+	unsigned long jobs;
+	unsigned int off;
+	int ret = 0;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_MEMCPY, mask);
+	chan = dma_request_channel(mask, bench_filter, NULL);
+	if (!chan)
+		return -EBUSY;
+
+	pc = to_pl330_chan(chan);
+	jobs = pc->jobs;
+
+	for (off = 0; off < bench_size; off += bench_chunk) {
+		txd = chan->device->device_prep_dma_memcpy(chan, dst + off, src + off,
+							  bench_chunk, DMA_CTRL_ACK);
+		if (!txd) {
+			ret = -ENOMEM;
+			break;
+		}
+		cookie = txd->tx_submit(txd);
+	}
+
+	if (cookie > 0 && dma_sync_wait(chan, cookie) != DMA_SUCCESS)
+		ret = -ETIMEDOUT;
+
+	*irqs = pc->jobs - jobs;
+	dma_release_channel(chan);
+
+	return ret;
+}
+
+static int bench_run(struct seq_file *s, int kind, void *dst, void *src)
+{
+	struct device *dev = &pl330.pdev->dev;
+	dma_addr_t dst_dma = 0, src_dma = 0;
+	unsigned long irqs = 0;
+	unsigned int off;
+	ktime_t start;
+	s64 us;
+	int ret = 0;
+
+	memset(dst, 0, bench_size);
+
+	if (kind != BENCH_CPU) {
+		src_dma = dma_map_single(dev, src, bench_size, DMA_TO_DEVICE);
+		dst_dma = dma_map_single(dev, dst, bench_size, DMA_FROM_DEVICE);
+	}
+
+	start = ktime_get();
+	switch (kind) {
+	case BENCH_CPU:
+		for (off = 0; off < bench_size; off += bench_chunk)
+			memcpy(dst + off, src + off, bench_chunk);
+		break;
+	case BENCH_LEGACY:
+		ret = bench_legacy(dst_dma, src_dma, &irqs);
+		break;
+	case BENCH_ENGINE:
+		ret = bench_engine(dst_dma, src_dma, &irqs);
+		break;
+	}
+	us = max_t(s64, ktime_us_delta(ktime_get(), start), 1);
+
+	if (kind != BENCH_CPU) {
+		dma_unmap_single(dev, src_dma, bench_size, DMA_TO_DEVICE);
+		dma_unmap_single(dev, dst_dma, bench_size, DMA_FROM_DEVICE);
+	}
+
+	if (ret) {
+		seq_printf(s, "%-10s error %d\n", bench_names[kind], ret);
+		return ret;
+	}
+
+	seq_printf(s, "%-10s %8llu KB/s %8lld us %6lu irqs %s\n", bench_names[kind],
+		   div64_u64((u64)bench_size * USEC_PER_SEC, (u64)us * 1024),
+		   us, irqs, memcmp(dst, src, bench_size) ? "MISMATCH" : "ok");
+
+	return 0;
+}
+
+static int bench_show(struct seq_file *s, void *unused)
+{
+	unsigned int order;
+	unsigned long src, dst;
+	int kind;
+
+	if (!bench_chunk || bench_chunk & 3 || bench_chunk > PL330_MAX_SEG_LEN ||
+	    bench_size < bench_chunk || bench_size % bench_chunk)
+		return -EINVAL;
+
+	order = get_order(bench_size);
+	src = __get_free_pages(GFP_KERNEL, order);
+	dst = __get_free_pages(GFP_KERNEL, order);
+	if (!src || !dst) {
+		free_pages(src, order);
+		free_pages(dst, order);
+		return -ENOMEM;
+	}
+
+	for (kind = 0; kind < bench_size / sizeof(u32); kind++)
+		((u32 *)src)[kind] = kind * 2654435761U;
+
+	seq_printf(s, "%u bytes in %u byte copies\n", bench_size, bench_chunk);
+	for (kind = BENCH_CPU; kind <= BENCH_ENGINE; kind++)
+		bench_run(s, kind, (void *)dst, (void *)src);
+
+	free_pages(src, order);
+	free_pages(dst, order);
+
+	return 0;
+}
+
+static int bench_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, bench_show, NULL);
+}
+
+static const struct file_operations bench_fops = {
+	.open		= bench_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static u64 pl330_dmamask = DMA_BIT_MASK(32);
+
+static int __init pl330_dmaengine_init(void)
+{
+	struct pl330_chan *pc = pl330.chans;
+	int i, ret;
+
+	pl330.pdev = platform_device_register_simple("s5p-pl330-dma", -1, NULL, 0);
+	if (IS_ERR(pl330.pdev))
+		return PTR_ERR(pl330.pdev);
+
+	pl330.pdev->dev.dma_mask = &pl330_dmamask;
+	pl330.pdev->dev.coherent_dma_mask = DMA_BIT_MASK(32);
+
+	for (i = 0; i < PL330_MEMCPY_CHANS; i++)
+		pc[i].ch = DMACH_3D_M2M0 + i;
+
+	pl330_init_device(&pl330.memcpy, pc, PL330_MEMCPY_CHANS, DMA_MEMCPY);
+	pl330.memcpy.device_prep_dma_memcpy = pl330_prep_dma_memcpy;
+	pl330.memcpy.copy_align = 2;
+
+	pl330_init_device(&pl330.slave, pc + PL330_MEMCPY_CHANS,
+			  PL330_SLAVE_CHANS, DMA_SLAVE);
+	dma_cap_set(DMA_PRIVATE, pl330.slave.cap_mask);
+	pl330.slave.device_prep_slave_sg = pl330_prep_slave_sg;
+	pl330.slave.device_terminate_all = pl330_terminate_all;
+
+	ret = dma_async_device_register(&pl330.memcpy);
+	if (ret)
+		goto err_memcpy;
+
+	ret = dma_async_device_register(&pl330.slave);
+	if (ret)
+		goto err_slave;
+
+	pl330.bench = debugfs_create_file("s5p_pl330_bench", S_IRUSR, NULL, NULL,
+					  &bench_fops);
+
+	return 0;
+
+err_slave:
+	dma_async_device_unregister(&pl330.memcpy);
+err_memcpy:
+	platform_device_unregister(pl330.pdev);
+	return ret;
+}
+subsys_initcall(pl330_dmaengine_init);
+
+static void __exit pl330_dmaengine_exit(void)
+{
+	debugfs_remove(pl330.bench);
+	dma_async_device_unregister(&pl330.slave);
+	dma_async_device_unregister(&pl330.memcpy);
+	platform_device_unregister(pl330.pdev);
+}
+module_exit(pl330_dmaengine_exit);
+
+MODULE_DESCRIPTION("dmaengine front end for the S5P PL330 DMA controller");
+MODULE_LICENSE("GPL");
@@ -34,6 +34,9 @@
 #include <linux/platform_device.h>
 #include <linux/clk.h>
 #include <linux/cpufreq.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/moduleparam.h>
 
 #include <asm/irq.h>
 #include <asm/io.h>
@@ -56,10 +59,30 @@ enum s3c24xx_i2c_type {
 	TYPE_S3C2440,
 };
 
+/* transfers of up to this many bytes are polled instead of using the IRQ */
+static unsigned int fast_xfer_max = 4;
+module_param(fast_xfer_max, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(fast_xfer_max, "largest transfer (bytes) to poll, 0 disables");
+
+#define S3C24XX_I2C_HIST	12	/* <16us, <32us, ... >=16ms */
+#define S3C24XX_I2C_CLIENTS	16
+
+struct s3c24xx_i2c_stat {
+	u16			addr;
+	unsigned int		xfers;
+	unsigned int		polled;
+	unsigned int		errors;
+	unsigned int		bytes;
+	u64			total_us;
+	unsigned int		max_us;
+	unsigned int		hist[S3C24XX_I2C_HIST];
+};
+
 struct s3c24xx_i2c {
 	spinlock_t		lock;
 	wait_queue_head_t	wait;
 	unsigned int		suspended:1;
+	unsigned int		polled:1;
 
 	struct i2c_msg		*msg;
 	unsigned int		msg_num;
@@ -71,6 +94,7 @@ struct s3c24xx_i2c {
 
 	enum s3c24xx_i2c_state	state;
 	unsigned long		clkrate;
+	unsigned int		bus_khz;
 
 	void __iomem		*regs;
 	struct clk		*clk;
@@ -78,6 +102,10 @@ struct s3c24xx_i2c {
 	struct resource		*ioarea;
 	struct i2c_adapter	adap;
 
+	/* whole adapter, then per slave address */
+	struct s3c24xx_i2c_stat	stats;
+	struct s3c24xx_i2c_stat	client_stats[S3C24XX_I2C_CLIENTS];
+
 #ifdef CONFIG_CPU_FREQ
 	struct notifier_block	freq_transition;
 #endif
@@ -414,14 +442,14 @@ static int i2c_s3c_irq_nextbyte(struct s3c24xx_i2c *i2c, unsigned long iicstat)
 	return ret;
 }
 
-/* s3c24xx_i2c_irq
+/* s3c24xx_i2c_service
  *
- * top level IRQ servicing routine
+ * handle one IRQPEND event, from the IRQ handler or the poll loop.
+ * called with i2c->lock held.
 */
 
-static irqreturn_t s3c24xx_i2c_irq(int irqno, void *dev_id)
+static void s3c24xx_i2c_service(struct s3c24xx_i2c *i2c)
 {
-	struct s3c24xx_i2c *i2c = dev_id;
 	unsigned long status;
 	unsigned long tmp;
 
@@ -438,15 +466,28 @@ static irqreturn_t s3c24xx_i2c_irq(int irqno, void *dev_id)
 		tmp = readl(i2c->regs + S3C2410_IICCON);
 		tmp &= ~S3C2410_IICCON_IRQPEND;
 		writel(tmp, i2c->regs +  S3C2410_IICCON);
-		goto out;
+		return;
 	}
 
 	/* pretty much this leaves us with the fact that we've
 	 * transmitted or received whatever byte we last sent */
 
 	i2c_s3c_irq_nextbyte(i2c, status);
+}
+
+/* s3c24xx_i2c_irq
+ *
+ * top level IRQ servicing routine
+*/
+
+static irqreturn_t s3c24xx_i2c_irq(int irqno, void *dev_id)
+{
+	struct s3c24xx_i2c *i2c = dev_id;
+
+	spin_lock(&i2c->lock);
+	s3c24xx_i2c_service(i2c);
+	spin_unlock(&i2c->lock);
 
- out:
 	return IRQ_HANDLED;
 }
 
@@ -477,6 +518,67 @@ static int s3c24xx_i2c_set_master(struct s3c24xx_i2c *i2c)
 	return -ETIMEDOUT;
 }
 
+/* s3c24xx_i2c_can_poll
+ *
+ * return true if the transfer is short enough to poll for completion.
+ * The controller holds SCL low until IRQPEND is cleared, so polling from
+ * process context cannot violate the bus timing, it only stretches it.
+*/
+
+static inline int s3c24xx_i2c_can_poll(struct i2c_msg *msgs, int num)
+{
+	unsigned int bytes = 0;
+	int i;
+
+	if (num > 2)
+		return 0;
+
+	for (i = 0; i < num; i++)
+		bytes += msgs[i].len;
+
+	return bytes <= fast_xfer_max;
+}
+
+/* s3c24xx_i2c_poll
+ *
+ * drive a transfer by polling IRQPEND while the IRQ line is masked at
+ * the interrupt controller. IRQEN stays set, as IRQPEND is not reliable
+ * without it. If a byte takes much longer than the bus rate allows
+ * (slave clock stretching), return and let the caller unmask the line
+ * so the interrupt finishes the transfer.
+ *
+ * returns 0 when the transfer has completed.
+*/
+
+static int s3c24xx_i2c_poll(struct s3c24xx_i2c *i2c)
+{
+	unsigned long flags;
+	unsigned int budget, us;
+
+	/* ten byte times (9 clocks each) plus some slack */
+	budget = 90000 / max(i2c->bus_khz, 1U) + 20;
+
+	while (i2c->msg_num != 0) {
+		for (us = 0; us < budget; us++) {
+			if (readl(i2c->regs + S3C2410_IICCON) &
+			    S3C2410_IICCON_IRQPEND)
+				break;
+			udelay(1);
+		}
+
+		if (us == budget) {
+			dev_dbg(i2c->dev, "poll timeout, using IRQ\n");
+			return -EBUSY;
+		}
+
+		spin_lock_irqsave(&i2c->lock, flags);
+		s3c24xx_i2c_service(i2c);
+		spin_unlock_irqrestore(&i2c->lock, flags);
+	}
+
+	return 0;
+}
+
 /* s3c24xx_i2c_doxfer
  *
  * this starts an i2c transfer
@@ -486,6 +588,7 @@ static int s3c24xx_i2c_doxfer(struct s3c24xx_i2c *i2c,
 			      struct i2c_msg *msgs, int num)
 {
 	unsigned long timeout;
+	int polled;
 	int ret;
 
 	if (i2c->suspended)
@@ -498,6 +601,11 @@ static int s3c24xx_i2c_doxfer(struct s3c24xx_i2c *i2c,
 		goto out;
 	}
 
+	/* a polled transfer masks the line, not IRQEN */
+	polled = s3c24xx_i2c_can_poll(msgs, num);
+	if (polled)
+		disable_irq_nosync(i2c->irq);
+
 	spin_lock_irq(&i2c->lock);
 
 	i2c->msg     = msgs;
@@ -505,12 +613,22 @@ static int s3c24xx_i2c_doxfer(struct s3c24xx_i2c *i2c,
 	i2c->msg_ptr = 0;
 	i2c->msg_idx = 0;
 	i2c->state   = STATE_START;
+	i2c->polled  = polled;
 
 	s3c24xx_i2c_enable_irq(i2c);
 	s3c24xx_i2c_message_start(i2c, msgs);
 	spin_unlock_irq(&i2c->lock);
 
-	timeout = wait_event_timeout(i2c->wait, i2c->msg_num == 0, HZ * 5);
+	timeout = 0;
+	if (polled) {
+		if (s3c24xx_i2c_poll(i2c) == 0)
+			timeout = 1;
+		enable_irq(i2c->irq);
+	}
+
+	if (!timeout)
+		timeout = wait_event_timeout(i2c->wait, i2c->msg_num == 0,
+					     HZ * 5);
 
 	ret = i2c->msg_idx;
 
@@ -530,6 +648,67 @@ static int s3c24xx_i2c_doxfer(struct s3c24xx_i2c *i2c,
 	return ret;
 }
 
+/* s3c24xx_i2c_account
+ *
+ * add a finished transfer to the adapter and per-client statistics
+*/
+
+static void s3c24xx_i2c_account_one(struct s3c24xx_i2c_stat *st,
+				    unsigned int us, unsigned int bytes,
+				    int ok, int polled)
+{
+	int bucket = fls(us >> 4);
+
+	st->xfers++;
+	st->bytes += bytes;
+	st->total_us += us;
+	if (us > st->max_us)
+		st->max_us = us;
+	if (!ok)
+		st->errors++;
+	if (polled)
+		st->polled++;
+	st->hist[min(bucket, S3C24XX_I2C_HIST - 1)]++;
+}
+
+static void s3c24xx_i2c_account(struct s3c24xx_i2c *i2c,
+				struct i2c_msg *msgs, int num,
+				ktime_t start, int ret)
+{
+	struct s3c24xx_i2c_stat *st = NULL;
+	unsigned long flags;
+	unsigned int bytes = 0;
+	unsigned int us;
+	s64 delta;
+	int i;
+
+	for (i = 0; i < num; i++)
+		bytes += msgs[i].len;
+
+	delta = ktime_us_delta(ktime_get(), start);
+	us = delta > UINT_MAX ? UINT_MAX : (unsigned int)delta;
+
+	spin_lock_irqsave(&i2c->lock, flags);
+
+	s3c24xx_i2c_account_one(&i2c->stats, us, bytes, ret == num,
+				i2c->polled);
+
+	/* slots are claimed in order, an unused one ends the search */
+	for (i = 0; i < S3C24XX_I2C_CLIENTS; i++) {
+		if (!i2c->client_stats[i].xfers ||
+		    i2c->client_stats[i].addr == msgs[0].addr) {
+			st = &i2c->client_stats[i];
+			st->addr = msgs[0].addr;
+			break;
+		}
+	}
+	if (st)
+		s3c24xx_i2c_account_one(st, us, bytes, ret == num,
+					i2c->polled);
+
+	spin_unlock_irqrestore(&i2c->lock, flags);
+}
+
 /* s3c24xx_i2c_xfer
  *
  * first port of call from the i2c bus code when an message needs
@@ -540,6 +719,7 @@ static int s3c24xx_i2c_xfer(struct i2c_adapter *adap,
 			struct i2c_msg *msgs, int num)
 {
 	struct s3c24xx_i2c *i2c = (struct s3c24xx_i2c *)adap->algo_data;
+	ktime_t start = ktime_get();
 	int retry;
 	int ret;
 
@@ -548,14 +728,17 @@ static int s3c24xx_i2c_xfer(struct i2c_adapter *adap,
 		ret = s3c24xx_i2c_doxfer(i2c, msgs, num);
 
 		if (ret != -EAGAIN)
-			return ret;
+			goto out;
 
 		dev_dbg(i2c->dev, "Retrying transmission (%d)\n", retry);
 
 		udelay(100);
 	}
 
-	return -EREMOTEIO;
+	ret = -EREMOTEIO;
+ out:
+	s3c24xx_i2c_account(i2c, msgs, num, start, ret);
+	return ret;
 }
 
 /* declare our i2c functionality */
@@ -636,6 +819,7 @@ static int s3c24xx_i2c_clockrate(struct s3c24xx_i2c *i2c, unsigned int *got)
 	}
 
 	*got = freq;
+	i2c->bus_khz = freq;
 
 	iiccon = readl(i2c->regs + S3C2410_IICCON);
 	iiccon &= ~(S3C2410_IICCON_SCALEMASK | S3C2410_IICCON_TXDIV_512);
@@ -756,6 +940,70 @@ static int s3c24xx_i2c_init(struct s3c24xx_i2c *i2c)
 	return 0;
 }
 
+/* transfer statistics, in sysfs as xfer_stats (write to reset) */
+
+static int s3c24xx_i2c_show_stat(char *buf, int len, const char *name,
+				 struct s3c24xx_i2c_stat *st)
+{
+	u64 avg = st->total_us;
+	int i;
+
+	if (st->xfers)
+		do_div(avg, st->xfers);
+
+	len += scnprintf(buf + len, PAGE_SIZE - len,
+			 "%-6s %8u %8u %6u %9u %7llu %8u ", name, st->xfers,
+			 st->polled, st->errors, st->bytes, avg, st->max_us);
+	for (i = 0; i < S3C24XX_I2C_HIST; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, " %u",
+				 st->hist[i]);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	return len;
+}
+
+static ssize_t s3c24xx_i2c_stats_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct s3c24xx_i2c *i2c = platform_get_drvdata(to_platform_device(dev));
+	struct s3c24xx_i2c_stat *st;
+	char name[8];
+	int len;
+
+	len = scnprintf(buf, PAGE_SIZE, "%-6s %8s %8s %6s %9s %7s %8s  "
+			"hist(us): <16 <32 <64 ... >=16384\n", "addr",
+			"xfers", "polled", "errors", "bytes", "avg_us",
+			"max_us");
+
+	spin_lock_irq(&i2c->lock);
+	len = s3c24xx_i2c_show_stat(buf, len, "all", &i2c->stats);
+	for (st = i2c->client_stats;
+	     st < i2c->client_stats + S3C24XX_I2C_CLIENTS && st->xfers; st++) {
+		snprintf(name, sizeof(name), "0x%02x", st->addr);
+		len = s3c24xx_i2c_show_stat(buf, len, name, st);
+	}
+	spin_unlock_irq(&i2c->lock);
+
+	return len;
+}
+
+static ssize_t s3c24xx_i2c_stats_store(struct device *dev,
+				       struct device_attribute *attr,
+				       const char *buf, size_t count)
+{
+	struct s3c24xx_i2c *i2c = platform_get_drvdata(to_platform_device(dev));
+
+	spin_lock_irq(&i2c->lock);
+	memset(&i2c->stats, 0, sizeof(i2c->stats));
+	memset(i2c->client_stats, 0, sizeof(i2c->client_stats));
+	spin_unlock_irq(&i2c->lock);
+
+	return count;
+}
+
+static DEVICE_ATTR(xfer_stats, S_IRUGO | S_IWUSR,
+		   s3c24xx_i2c_stats_show, s3c24xx_i2c_stats_store);
+
 /* s3c24xx_i2c_probe
  *
  * called by the bus driver when a suitable device is found
@@ -885,6 +1133,9 @@ static int s3c24xx_i2c_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, i2c);
 
+	if (device_create_file(&pdev->dev, &dev_attr_xfer_stats))
+		dev_warn(&pdev->dev, "failed to create xfer_stats\n");
+
 	dev_info(&pdev->dev, "%s: S3C I2C adapter\n", dev_name(&i2c->adap.dev));
 	return 0;
 
@@ -919,6 +1170,7 @@ static int s3c24xx_i2c_remove(struct platform_device *pdev)
 {
 	struct s3c24xx_i2c *i2c = platform_get_drvdata(pdev);
 
+	device_remove_file(&pdev->dev, &dev_attr_xfer_stats);
 	s3c24xx_i2c_deregister_cpufreq(i2c);
 
 	i2c_del_adapter(&i2c->adap);
@@ -23,6 +23,8 @@
 #include <mach/hardware.h>
 #include <linux/i2c/max8998.h>
 #include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
 
 #ifdef CONFIG_CPU_FREQ
 #include <plat/s5p6442-dvfs.h>
@@ -167,14 +169,42 @@ unsigned char firmware_602240[] = {
 struct i2c_driver qt602240_i2c_driver;
 struct workqueue_struct *qt602240_wq;
 
+/* Messages fetched per I2C transaction, and transactions per interrupt */
+#define QT_MSG_BATCH		10
+#define QT_MSG_MAX_ROUNDS	4
+#define QT_MSG_NONE		0xFF	/* report id of an empty T5 read */
+
+/* IRQ to last input_sync latency histogram, bucket n < (250us << n) */
+#define QT_LAT_BUCKETS		8
+
+struct qt602240_stats {
+	unsigned long	irqs;
+	unsigned long	reads;
+	unsigned long	messages;
+	unsigned int	max_batch;
+	unsigned long	lat_count;
+	u64		lat_sum_us;
+	u32		lat_min_us;
+	u32		lat_max_us;
+	unsigned long	lat_hist[QT_LAT_BUCKETS];
+};
+
 struct i2c_ts_driver {
 	struct i2c_client *client;
 	struct input_dev *input_dev;
-	struct work_struct work;
 	struct early_suspend	early_suspend;
+	ktime_t irq_time;		/* hard irq (or poll) time of this batch */
+	uint8_t *msg_buf;		/* QT_MSG_BATCH messages */
+	struct delayed_work poll_work;	/* no irq wired: poll the chip */
+	atomic_t poll_depth;
+	struct qt602240_stats stats;
 };
 struct i2c_ts_driver *qt602240 = NULL;
 
+/* Poll interval used when the client has no interrupt (replay adapter) */
+static int poll_ms = 10;
+module_param(poll_ms, int, S_IRUGO | S_IWUSR);
+
 #ifdef CONFIG_HAS_EARLYSUSPEND
 static void qt602240_early_suspend(struct early_suspend *);
 static void qt602240_late_resume(struct early_suspend *);
@@ -805,6 +835,10 @@ int set_all_config( all_config_setting config );
 U8 read_changeline(void);
 uint8_t write_keyarray_config(uint8_t instance, touch_keyarray_t15_config_t cfg);
 void get_message(void);
+static void process_message(void);
+static void qt602240_account_latency(void);
+static void qt602240_disable_irq(void);
+static void qt602240_enable_irq(void);
 U8 init_I2C(U8 I2C_address_arg);
 uint8_t read_id_block(info_id_t *id);
 U8 read_mem(U16 start, U8 size, U8 *mem);
@@ -1743,10 +1777,74 @@ void process_key_event(uint8_t qt_msg)
  */
 void get_message(void)
 {
+	struct i2c_msg rmsg[2];
+	unsigned char data[2];
+	unsigned int stride = max_message_length - 1;	/* no checksum byte */
+	unsigned int round, n, count = 0;
+	uint8_t *msg;
+	int ret;
+
 #ifdef CONFIG_CPU_FREQ
 	set_dvfs_perf_level();
 #endif
 
+	/*
+	 * Drain the message processor in batches: one T5 read of
+	 * QT_MSG_BATCH messages returns all that are pending, followed by
+	 * QT_MSG_NONE fillers.  A full batch means there may be more.
+	 */
+	data[0] = message_processor_address & 0x00ff;
+	data[1] = message_processor_address >> 8;
+	rmsg[0].addr = qt602240->client->addr;
+	rmsg[0].flags = I2C_M_WR;
+	rmsg[0].len = 2;
+	rmsg[0].buf = data;
+	rmsg[1].addr = qt602240->client->addr;
+	rmsg[1].flags = I2C_M_RD;
+	rmsg[1].len = QT_MSG_BATCH * stride;
+	rmsg[1].buf = qt602240->msg_buf;
+
+	for (round = 0; round < QT_MSG_MAX_ROUNDS; round++) {
+		ret = i2c_transfer(qt602240->client->adapter, rmsg, 2);
+		qt602240->stats.reads++;
+		if (ret < 0) {
+			printk("[TSP] Error code : %d\n", __LINE__ );
+			touch_hw_rst( 2 );  // TOUCH HW RESET No.2
+			break;
+		}
+
+		for (n = 0; n < QT_MSG_BATCH; n++) {
+			msg = qt602240->msg_buf + n * stride;
+			if (msg[0] == QT_MSG_NONE)
+				break;
+			memcpy(quantum_msg, msg, READ_MESSAGE_LENGTH);
+			if (disable_event_in_force) {
+			#if DEBUG_CHJ
+				printk("[TSP] ignore event\n"); 
+			#endif
+				continue;
+			}
+			process_message();
+		}
+		count += n;
+		if (n < QT_MSG_BATCH)
+			break;
+	}
+
+	__raw_writel(0x1<<2, S5P64XX_GROUP13_INT_PEND);		//for level trigger
+
+	qt602240->stats.messages += count;
+	if (count > qt602240->stats.max_batch)
+		qt602240->stats.max_batch = count;
+	if (count)
+		qt602240_account_latency();
+}
+
+/*
+ * Handle the message in quantum_msg.
+ */
+static void process_message(void)
+{
 	unsigned int x, y, size ;
 
 	int i;
@@ -1766,89 +1864,6 @@ void get_message(void)
 	 * quantum_msg[7] : Touch vector
 	 */
 
-	//	memset( quantum_msg ,0xFF, READ_MESSAGE_LENGTH);
-
-	//	if( qt602240_i2c_read( message_processor_address, quantum_msg , READ_MESSAGE_LENGTH) <= 0 )
-	//		return ;
-
-	quantum_msg[0]= 0;  // clear
-
-	/**********************************************************/	
-#if 0
-	/*************** i2c read function - start ****************/	
-	struct i2c_msg rmsg;
-	size=-1;   // size is used as result value temporarily
-	unsigned char data[2];
-
-	rmsg.addr = qt602240->client->addr;
-	rmsg.flags = I2C_M_WR;
-	rmsg.len = 2;
-	rmsg.buf = data;
-	data[0] = message_processor_address & 0x00ff;
-	data[1] = message_processor_address >> 8;
-	size = i2c_transfer(qt602240->client->adapter, &rmsg, 1);
-
-	if( size > 0 ) {
-		rmsg.flags = I2C_M_RD;
-		rmsg.len = READ_MESSAGE_LENGTH;
-		rmsg.buf = quantum_msg;
-		size = i2c_transfer(qt602240->client->adapter, &rmsg, 1);
-
-		if ( size <= 0 )
-		{
-			printk("[TSP] Error code : %d\n", __LINE__ );
-			touch_hw_rst( 2 );  // TOUCH HW RESET No.2
-			enable_irq(qt602240->client->irq);
-			return ;
-		}
-	}
-	else
-	{
-		printk("[TSP] Error code : %d\n", __LINE__ );
-		touch_hw_rst( 3 );  // TOUCH HW RESET No.3
-		enable_irq(qt602240->client->irq);
-		return ;
-	}
-
-	/*************** i2c read function - end ******************/	
-#else
-	/*************** i2c read function - start ****************/	
-	struct i2c_msg rmsg[2];
-	size=-1;   // size is used as result value temporarily
-	unsigned char data[2];
-
-	rmsg[0].addr = qt602240->client->addr;
-	rmsg[0].flags = I2C_M_WR;
-	rmsg[0].len = 2;
-	rmsg[0].buf = data;
-	data[0] = message_processor_address & 0x00ff;
-	data[1] = message_processor_address >> 8;
-	rmsg[1].addr = qt602240->client->addr;
-	rmsg[1].flags = I2C_M_RD;
-	rmsg[1].len = READ_MESSAGE_LENGTH;
-	rmsg[1].buf = quantum_msg;
-	size = i2c_transfer(qt602240->client->adapter, &rmsg[0], 2);
-
-	// Must be fixed, "size < 0" is ok???
-	if( size < 0 )
-	{
-		printk("[TSP] Error code : %d\n", __LINE__ );
-		touch_hw_rst( 2 );  // TOUCH HW RESET No.2
-		enable_irq(qt602240->client->irq);
-		return ;
-	}
-	/*************** i2c read function - end ******************/	
-#endif
-	/**********************************************************/	
-
-	if(disable_event_in_force)
-		{
-	#if DEBUG_CHJ
-		printk("[TSP] ignore event\n"); 
-	#endif
-		goto int_clear;
-		}
-
 	/* Call the main application to handle the message. */
 	/* x is real y, y is real x. Should change two of them */	
 	y = quantum_msg[2]; 
@@ -2003,12 +2018,6 @@ void get_message(void)
 		check_chip_calibration();
 	}
 	//	msleep(2);
-
-int_clear:
-	__raw_writel(0x1<<2, S5P64XX_GROUP13_INT_PEND);		//for level trigger
-	enable_irq(qt602240->client->irq);
-
-
 }
 
 /*!
@@ -3499,17 +3508,73 @@ uint32_t CRC_24(uint32_t crc, uint8_t byte1, uint8_t byte2)
 	return(result);
 }
 
+/* Hard irq: note when the chip asserted CHANGE, the thread does the rest */
 irqreturn_t qt602240_irq_handler(int irq, void *dev_id)
 {
-	disable_irq_nosync (qt602240->client->irq);
+	qt602240->irq_time = ktime_get();
+	qt602240->stats.irqs++;
+	return IRQ_WAKE_THREAD;
+}
 
+static irqreturn_t qt602240_irq_thread(int irq, void *dev_id)
+{
+	get_message();
+	return IRQ_HANDLED;
+}
 
-#if 0 //def  CONFIG_CPU_FREQ
-	set_dvfs_perf_level();
-#endif
+static void qt602240_poll_work(struct work_struct *work)
+{
+	if (atomic_read(&qt602240->poll_depth))
+		return;
+	qt602240->irq_time = ktime_get();
+	qt602240->stats.irqs++;
+	get_message();
+	queue_delayed_work(qt602240_wq, &qt602240->poll_work,
+			   msecs_to_jiffies(poll_ms));
+}
 
-	queue_work(qt602240_wq, &qt602240->work);
-	return IRQ_HANDLED;
+/*
+ * Without an interrupt line (e.g. on the replay adapter) the chip is
+ * polled; these stand in for disable_irq()/enable_irq() in both cases.
+ */
+static void qt602240_disable_irq(void)
+{
+	if (qt602240->client->irq > 0) {
+		disable_irq(qt602240->client->irq);
+		return;
+	}
+	atomic_inc(&qt602240->poll_depth);
+	cancel_delayed_work_sync(&qt602240->poll_work);
+}
+
+static void qt602240_enable_irq(void)
+{
+	if (qt602240->client->irq > 0) {
+		enable_irq(qt602240->client->irq);
+		return;
+	}
+	if (atomic_dec_and_test(&qt602240->poll_depth))
+		queue_delayed_work(qt602240_wq, &qt602240->poll_work,
+				   msecs_to_jiffies(poll_ms));
+}
+
+static void qt602240_account_latency(void)
+{
+	struct qt602240_stats *st = &qt602240->stats;
+	s64 us = ktime_us_delta(ktime_get(), qt602240->irq_time);
+	u32 lat = us < 0 ? 0 : (us > UINT_MAX ? UINT_MAX : (u32)us);
+	int b;
+
+	for (b = 0; b < QT_LAT_BUCKETS - 1; b++)
+		if (lat < (250U << b))
+			break;
+	st->lat_hist[b]++;
+	if (!st->lat_count || lat < st->lat_min_us)
+		st->lat_min_us = lat;
+	if (lat > st->lat_max_us)
+		st->lat_max_us = lat;
+	st->lat_sum_us += lat;
+	st->lat_count++;
 }
 
 void touch_hw_rst( int point)
@@ -3592,7 +3657,7 @@ int qt602240_probe(void)
 	printk("|  Quantrm Touch Driver Probe!            |\n");
 	printk("+-----------------------------------------+\n");
 
-	INIT_WORK(&qt602240->work, get_message );
+	INIT_DELAYED_WORK(&qt602240->poll_work, qt602240_poll_work);
 #ifdef __CHECK_TSP_TEMP_NOTIFICATION__
 	INIT_WORK(&work_temp, set_tsp_for_temp );
 #endif
@@ -3692,8 +3757,10 @@ int qt602240_probe(void)
 	{
 		printk("[TSP] Error:DRIVER_SETUP fail!!!\n");
 		quantum_touch_probe();
-		if (driver_setup != DRIVER_SETUP_OK)
-			return -1;
+		if (driver_setup != DRIVER_SETUP_OK) {
+			ret = -ENODEV;
+			goto err_setup_failed;
+		}
 		printk("[TSP] DRIVER_SETUP success!!!\n");
 	}
 
@@ -3716,12 +3783,30 @@ int qt602240_probe(void)
 			}
 		}
 
-	ret = request_irq(qt602240->client->irq, qt602240_irq_handler, IRQF_DISABLED, "qt602240 irq", 0);
-	if (ret == 0) {
-		printk("[TSP] request touchscreen irq i- %s\n", qt602240->input_dev->name);
+	qt602240->msg_buf = kmalloc(QT_MSG_BATCH * max_message_length, GFP_KERNEL);
+	if (!qt602240->msg_buf) {
+		ret = -ENOMEM;
+		goto err_setup_failed;
 	}
-	else {
-		printk("request_irq failed\n");
+
+	if (qt602240->client->irq > 0) {
+		ret = request_threaded_irq(qt602240->client->irq,
+				qt602240_irq_handler, qt602240_irq_thread,
+				IRQF_ONESHOT, "qt602240 irq", 0);
+		if (ret == 0) {
+			printk("[TSP] request touchscreen irq i- %s\n", qt602240->input_dev->name);
+		}
+		else {
+			/* everything else keys off client->irq, so this selects polling */
+			printk("[TSP] request_irq failed (%d)\n", ret);
+			qt602240->client->irq = 0;
+			ret = 0;
+		}
+	}
+	if (qt602240->client->irq <= 0) {
+		printk("[TSP] no irq, polling every %d ms\n", poll_ms);
+		queue_delayed_work(qt602240_wq, &qt602240->poll_work,
+				   msecs_to_jiffies(poll_ms));
 	}
 
 #ifdef CONFIG_HAS_EARLYSUSPEND
@@ -3741,6 +3826,10 @@ int qt602240_probe(void)
 
 	return 0;
 
+err_setup_failed:
+	input_unregister_device(qt602240->input_dev);
+	qt602240->input_dev = NULL;	/* unregister dropped the last reference */
+
 err_input_register_device_failed:
 	input_free_device(qt602240->input_dev);
 
@@ -3755,8 +3844,12 @@ static int qt602240_remove(struct platform_device *aDevice)
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	unregister_early_suspend(&qt602240->early_suspend);
 #endif	/* CONFIG_HAS_EARLYSUSPEND */
-	free_irq(qt602240->client->irq, 0);
+	if (qt602240->client->irq > 0)
+		free_irq(qt602240->client->irq, 0);
+	else
+		qt602240_disable_irq();
 	input_unregister_device(qt602240->input_dev);
+	kfree(qt602240->msg_buf);
 	kfree(qt602240);
 
 	return 0;
@@ -3809,7 +3902,7 @@ static int set_tsp_for_low_temp(int state)
 	uint8_t *tmp;
 	uint8_t status;
 
-	disable_irq(qt602240->client->irq);
+	qt602240_disable_irq();
 
 	switch(state)
 		{
@@ -3835,7 +3928,7 @@ static int set_tsp_for_low_temp(int state)
 	if (object_address == 0)
 		{
 		printk("\n[TSP][ERROR] TOUCH_MULTITOUCHSCREEN_T9 object_address : %d\n", __LINE__);
-		enable_irq(qt602240->client->irq);
+		qt602240_enable_irq();
 		return -1;
 		}
 	tmp= &config_normal.touchscreen_config.tchthr;
@@ -3846,7 +3939,7 @@ static int set_tsp_for_low_temp(int state)
 		printk("\n[TSP][ERROR] TOUCH_MULTITOUCHSCREEN_T9 write_mem : %d\n", __LINE__);
 		}
 
-	enable_irq(qt602240->client->irq);
+	qt602240_enable_irq();
 	return 1;
 }
 
@@ -3897,7 +3990,7 @@ static int qt602240_suspend(pm_message_t mesg)
 	int key;
 
 	ENTER_FUNC;
-	disable_irq(qt602240->client->irq);
+	qt602240_disable_irq();
 
 	config_set_enable = 0; // 0 for disable, 1 for enable
 
@@ -4040,7 +4133,7 @@ static int qt602240_resume(void)
 	//		rst_cnt[0],rst_cnt[1],rst_cnt[2],rst_cnt[3],rst_cnt[4],rst_cnt[5],
 	//		rst_cnt[6],rst_cnt[7],rst_cnt[8],rst_cnt[9],rst_cnt[10],rst_cnt[11] );
 
-	enable_irq(qt602240->client->irq);
+	qt602240_enable_irq();
 	INT_clear( );
 
 	LEAVE_FUNC;
@@ -4082,7 +4175,10 @@ static int __devexit qt602240_i2c_remove(struct i2c_client *client)
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	    unregister_early_suspend(&qt602240->early_suspend);
 #endif  /* CONFIG_HAS_EARLYSUSPEND */
-	    free_irq(qt602240->client->irq, 0);
+	    if (qt602240->client->irq > 0)
+		    free_irq(qt602240->client->irq, 0);
+	    else
+		    qt602240_disable_irq();
 	    input_unregister_device(qt602240->input_dev);
 
 	    qt602240 = i2c_get_clientdata(client);
@@ -4329,6 +4425,36 @@ static ssize_t key_threshold_store(
 
 static DEVICE_ATTR(key_threshold, S_IRUGO | S_IWUSR | S_IWOTH | S_IXOTH, key_threshold_show, key_threshold_store);
 
+/* Touch IRQ to input_sync latency, write anything to reset */
+static ssize_t latency_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct qt602240_stats st = qt602240->stats;
+	u64 avg = st.lat_sum_us;
+	int len, b;
+
+	if (st.lat_count)
+		do_div(avg, st.lat_count);
+	len = sprintf(buf, "irqs %lu reads %lu messages %lu max_batch %u\n"
+			"latency_us count %lu min %u avg %llu max %u\n",
+			st.irqs, st.reads, st.messages, st.max_batch,
+			st.lat_count, st.lat_min_us, avg, st.lat_max_us);
+	for (b = 0; b < QT_LAT_BUCKETS - 1; b++)
+		len += sprintf(buf + len, "<%u\t%lu\n", 250U << b, st.lat_hist[b]);
+	len += sprintf(buf + len, ">=%u\t%lu\n", 250U << (QT_LAT_BUCKETS - 2),
+		       st.lat_hist[QT_LAT_BUCKETS - 1]);
+	return len;
+}
+
+static ssize_t latency_store(
+		struct device *dev, struct device_attribute *attr,
+		const char *buf, size_t size)
+{
+	memset(&qt602240->stats, 0, sizeof(qt602240->stats));
+	return size;
+}
+
+static DEVICE_ATTR(latency, S_IRUGO | S_IWUSR, latency_show, latency_store);
+
 static ssize_t enable_disable_show(struct device *dev, struct device_attribute *attr, char *buf)
 {	
 	printk("QT602240 %s!\n", __func__);
@@ -5609,6 +5735,8 @@ int __init qt602240_init(void)
 		pr_err("Failed to create device file(%s)!\n", dev_attr_firmware_ret.attr.name);
 	if (device_create_file(ts_dev, &dev_attr_key_threshold) < 0)
 		pr_err("Failed to create device file(%s)!\n", dev_attr_key_threshold.attr.name);
+	if (device_create_file(ts_dev, &dev_attr_latency) < 0)
+		pr_err("Failed to create device file(%s)!\n", dev_attr_latency.attr.name);
 	printk("[QT] %s/%d, platform_driver_register!!\n",__func__,__LINE__);
 
 	/*------------------------------ for tunning ATmel - start ----------------------------*/
@@ -5790,7 +5918,7 @@ uint8_t QT_Boot(uint8_t qt_firmup)
 	firmware_ret_val = -1;
 
 	// disable_irq for firmware update
-	disable_irq(qt602240->client->irq);
+	qt602240_disable_irq();
 
 	// pointer 
 	unsigned char *firmware_data ;
@@ -5939,7 +6067,7 @@ uint8_t QT_Boot(uint8_t qt_firmup)
 							printk("[TSP] QT602240 Firmware Ver.\n");
 							printk("[TSP] version = %x\n", info_block->info_id.version);
 
-							enable_irq(qt602240->client->irq);
+							qt602240_enable_irq();
 
 							return 1;
 						}	
@@ -0,0 +1,448 @@
+/* drivers/input/touchscreen/qt602240_replay.c
+ *
+ * Recorded message replay for the QT602240 touch driver.
+ *
+ * Registers an I2C adapter that plays the part of the touch controller and
+ * a "qt602240_ts" client on it without an interrupt, so qt602240.c binds
+ * to it and polls.  The chip memory (info block, object table, config) is
+ * served from a recorded image, config writes land in it, and reads of the
+ * message processor (T5) return recorded messages as their frames come
+ * due, then 0xFF like an empty chip.  Load this module before the touch
+ * driver.
+ *
+ * The recording is fetched with request_firmware(), little endian:
+ *
+ *	struct qt_replay_header
+ *	u8 mem[mem_len]				chip memory from address 0
+ *	nr_frames times:
+ *		struct qt_replay_frame
+ *		u8 msg[nr_msgs][msg_len]	report id first
+ *
+ * A frame is queued delay_us after the previous one.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/i2c.h>
+#include <linux/firmware.h>
+#include <linux/hrtimer.h>
+#include <linux/spinlock.h>
+#include <linux/slab.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+
+#define QT_REPLAY_MAGIC		"QTRP"
+#define QT_REPLAY_VERSION	1
+#define QT_REPLAY_ADDR		0x4A
+#define QT_REPLAY_MEM_MIN	4096
+#define QT_REPLAY_MEM_MAX	65536
+#define QT_REPLAY_QUEUE		64	/* pending messages, power of 2 */
+#define QT_REPLAY_MSG_MAX	16
+#define QT_T5			5	/* GEN_MESSAGEPROCESSOR_T5 */
+
+struct qt_replay_header {
+	char	magic[4];
+	__le16	version;
+	__le16	msg_len;
+	__le32	mem_len;
+	__le32	nr_frames;
+} __attribute__((packed));
+
+struct qt_replay_frame {
+	__le32	delay_us;
+	__le16	nr_msgs;
+	__le16	reserved;
+} __attribute__((packed));
+
+static char *file = "qt602240_replay.bin";
+module_param(file, charp, S_IRUGO);
+MODULE_PARM_DESC(file, "recording to load through request_firmware");
+
+static int loop;
+module_param(loop, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(loop, "restart the recording when it ends");
+
+struct qt_replay {
+	struct i2c_adapter	adap;
+	struct i2c_client	*client;
+	const struct firmware	*fw;
+	spinlock_t		lock;
+
+	u8			*mem;
+	unsigned int		mem_size;
+	u16			ptr;		/* address pointer */
+	u16			t5_addr;
+	unsigned int		t5_stride;	/* message size, no checksum */
+
+	unsigned int		msg_len;
+	unsigned int		nr_frames;
+	const u8		*frames;
+	size_t			frames_len;
+	unsigned int		frame;		/* next frame */
+	size_t			pos;		/* its offset in frames */
+	struct hrtimer		timer;
+
+	u8			queue[QT_REPLAY_QUEUE][QT_REPLAY_MSG_MAX];
+	unsigned int		head, tail;
+
+	unsigned long		frames_played;
+	unsigned long		msgs_queued;
+	unsigned long		msgs_read;
+	unsigned long		msgs_dropped;
+	unsigned long		t5_reads;
+	unsigned long		writes;
+
+	struct dentry		*debugfs;
+};
+
+static struct qt_replay *replay;
+
+static const struct qt_replay_frame *qt_replay_frame_at(struct qt_replay *r,
+							 size_t pos)
+{
+	return (const struct qt_replay_frame *)(r->frames + pos);
+}
+
+/* Caller holds r->lock */
+static void qt_replay_arm(struct qt_replay *r)
+{
+	const struct qt_replay_frame *f;
+
+	if (r->frame >= r->nr_frames) {
+		if (!loop || !r->nr_frames)
+			return;
+		r->frame = 0;
+		r->pos = 0;
+	}
+	f = qt_replay_frame_at(r, r->pos);
+	hrtimer_start(&r->timer, ns_to_ktime(le32_to_cpu(f->delay_us) * 1000ULL),
+		      HRTIMER_MODE_REL);
+}
+
+static enum hrtimer_restart qt_replay_timer(struct hrtimer *t)
+{
+	struct qt_replay *r = container_of(t, struct qt_replay, timer);
+	const struct qt_replay_frame *f;
+	const u8 *msg;
+	unsigned long flags;
+	unsigned int i, n;
+
+	spin_lock_irqsave(&r->lock, flags);
+	f = qt_replay_frame_at(r, r->pos);
+	n = le16_to_cpu(f->nr_msgs);
+	msg = (const u8 *)(f + 1);
+	for (i = 0; i < n; i++, msg += r->msg_len) {
+		if (r->head - r->tail >= QT_REPLAY_QUEUE) {
+			r->msgs_dropped++;
+			continue;
+		}
+		memset(r->queue[r->head % QT_REPLAY_QUEUE], 0xFF, QT_REPLAY_MSG_MAX);
+		memcpy(r->queue[r->head % QT_REPLAY_QUEUE], msg,
+		       min(r->msg_len, (unsigned int)QT_REPLAY_MSG_MAX));
+		r->head++;
+		r->msgs_queued++;
+	}
+	r->pos += sizeof(*f) + n * r->msg_len;
+	r->frame++;
+	r->frames_played++;
+	qt_replay_arm(r);
+	spin_unlock_irqrestore(&r->lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Caller holds r->lock */
+static void qt_replay_read(struct qt_replay *r, u8 *buf, unsigned int len)
+{
+	unsigned int off, n;
+
+	if (r->t5_stride && r->ptr == r->t5_addr) {
+		/* Every message read pops one, like the chip's FIFO */
+		r->t5_reads++;
+		for (off = 0; off < len; off += r->t5_stride) {
+			n = min(r->t5_stride, len - off);
+			memset(buf + off, 0xFF, n);
+			if (r->head == r->tail)
+				continue;
+			memcpy(buf + off, r->queue[r->tail % QT_REPLAY_QUEUE],
+			       min(n, (unsigned int)QT_REPLAY_MSG_MAX));
+			r->tail++;
+			r->msgs_read++;
+		}
+		return;
+	}
+
+	for (off = 0; off < len; off++) {
+		unsigned int a = r->ptr + off;
+
+		buf[off] = a < r->mem_size ? r->mem[a] : 0xFF;
+	}
+}
+
+static int qt_replay_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs,
+			  int num)
+{
+	struct qt_replay *r = i2c_get_adapdata(adap);
+	unsigned long flags;
+	unsigned int i, n;
+
+	for (i = 0; i < num; i++)
+		if (msgs[i].addr != QT_REPLAY_ADDR)
+			return -EREMOTEIO;
+
+	spin_lock_irqsave(&r->lock, flags);
+	for (i = 0; i < num; i++) {
+		struct i2c_msg *m = &msgs[i];
+
+		if (m->flags & I2C_M_RD) {
+			qt_replay_read(r, m->buf, m->len);
+			continue;
+		}
+		if (m->len < 2)
+			continue;
+		r->ptr = m->buf[0] | (m->buf[1] << 8);
+		if (m->len > 2 && r->ptr < r->mem_size) {
+			n = min((unsigned int)m->len - 2, r->mem_size - r->ptr);
+			memcpy(r->mem + r->ptr, m->buf + 2, n);
+			r->writes++;
+		}
+	}
+	spin_unlock_irqrestore(&r->lock, flags);
+
+	return num;
+}
+
+static u32 qt_replay_func(struct i2c_adapter *adap)
+{
+	return I2C_FUNC_I2C;
+}
+
+static const struct i2c_algorithm qt_replay_algo = {
+	.master_xfer	= qt_replay_xfer,
+	.functionality	= qt_replay_func,
+};
+
+/* Find the message processor in the recorded object table */
+static void qt_replay_find_t5(struct qt_replay *r)
+{
+	unsigned int i, nobj, e;
+
+	if (r->mem_size < 7)
+		return;
+	nobj = r->mem[6];
+	for (i = 0; i < nobj; i++) {
+		e = 7 + i * 6;
+		if (e + 6 > r->mem_size)
+			break;
+		if (r->mem[e] == QT_T5) {
+			r->t5_addr = r->mem[e + 1] | (r->mem[e + 2] << 8);
+			/* size byte is size - 1; drop the checksum byte */
+			r->t5_stride = r->mem[e + 3];
+			return;
+		}
+	}
+}
+
+static int qt_replay_parse(struct qt_replay *r)
+{
+	const struct qt_replay_header *h;
+	const struct qt_replay_frame *f;
+	size_t len = r->fw->size, pos;
+	unsigned int mem_len, i;
+
+	if (len < sizeof(*h))
+		return -EINVAL;
+	h = (const struct qt_replay_header *)r->fw->data;
+	if (memcmp(h->magic, QT_REPLAY_MAGIC, 4) ||
+	    le16_to_cpu(h->version) != QT_REPLAY_VERSION)
+		return -EINVAL;
+
+	r->msg_len = le16_to_cpu(h->msg_len);
+	mem_len = le32_to_cpu(h->mem_len);
+	r->nr_frames = le32_to_cpu(h->nr_frames);
+	if (!r->msg_len || mem_len > QT_REPLAY_MEM_MAX ||
+	    sizeof(*h) + mem_len > len)
+		return -EINVAL;
+
+	r->mem_size = max(mem_len, (unsigned int)QT_REPLAY_MEM_MIN);
+	r->mem = kzalloc(r->mem_size, GFP_KERNEL);
+	if (!r->mem)
+		return -ENOMEM;
+	memcpy(r->mem, h + 1, mem_len);
+	qt_replay_find_t5(r);
+	if (!r->t5_stride)
+		printk(KERN_WARNING "qt602240_replay: no T5 in memory image\n");
+
+	r->frames = r->fw->data + sizeof(*h) + mem_len;
+	r->frames_len = len - sizeof(*h) - mem_len;
+	for (i = 0, pos = 0; i < r->nr_frames; i++) {
+		if (pos + sizeof(*f) > r->frames_len)
+			break;
+		f = qt_replay_frame_at(r, pos);
+		pos += sizeof(*f) + le16_to_cpu(f->nr_msgs) * r->msg_len;
+		if (pos > r->frames_len)
+			break;
+	}
+	if (i < r->nr_frames) {
+		printk(KERN_WARNING "qt602240_replay: truncated after %u of %u "
+		       "frames\n", i, r->nr_frames);
+		r->nr_frames = i;
+	}
+
+	return 0;
+}
+
+static void qt_replay_restart(struct qt_replay *r)
+{
+	unsigned long flags;
+
+	hrtimer_cancel(&r->timer);
+	spin_lock_irqsave(&r->lock, flags);
+	r->frame = 0;
+	r->pos = 0;
+	r->head = r->tail = 0;
+	if (r->nr_frames)
+		qt_replay_arm(r);
+	spin_unlock_irqrestore(&r->lock, flags);
+}
+
+static int qt_replay_stats_show(struct seq_file *s, void *unused)
+{
+	struct qt_replay *r = s->private;
+	unsigned long flags;
+
+	spin_lock_irqsave(&r->lock, flags);
+	seq_printf(s, "frame %u/%u\nplayed %lu\nqueued %lu\nread %lu\n"
+		   "dropped %lu\npending %u\nt5_reads %lu\nwrites %lu\n",
+		   r->frame, r->nr_frames, r->frames_played, r->msgs_queued,
+		   r->msgs_read, r->msgs_dropped, r->head - r->tail,
+		   r->t5_reads, r->writes);
+	spin_unlock_irqrestore(&r->lock, flags);
+	return 0;
+}
+
+static int qt_replay_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, qt_replay_stats_show, inode->i_private);
+}
+
+static const struct file_operations qt_replay_stats_fops = {
+	.open		= qt_replay_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static ssize_t qt_replay_restart_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	qt_replay_restart(file->private_data);
+	return count;
+}
+
+static int qt_replay_restart_open(struct inode *inode, struct file *file)
+{
+	file->private_data = inode->i_private;
+	return 0;
+}
+
+static const struct file_operations qt_replay_restart_fops = {
+	.open		= qt_replay_restart_open,
+	.write		= qt_replay_restart_write,
+};
+
+static int __init qt_replay_init(void)
+{
+	struct i2c_board_info info = {
+		I2C_BOARD_INFO("qt602240_ts", QT_REPLAY_ADDR),
+	};
+	struct qt_replay *r;
+	int ret;
+
+	r = kzalloc(sizeof(*r), GFP_KERNEL);
+	if (!r)
+		return -ENOMEM;
+
+	spin_lock_init(&r->lock);
+	hrtimer_init(&r->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	r->timer.function = qt_replay_timer;
+
+	r->adap.owner = THIS_MODULE;
+	r->adap.algo = &qt_replay_algo;
+	r->adap.nr = -1;
+	strlcpy(r->adap.name, "qt602240-replay", sizeof(r->adap.name));
+	i2c_set_adapdata(&r->adap, r);
+	ret = i2c_add_adapter(&r->adap);
+	if (ret)
+		goto err_free;
+
+	ret = request_firmware(&r->fw, file, &r->adap.dev);
+	if (ret) {
+		printk(KERN_ERR "qt602240_replay: can't load %s (%d)\n",
+		       file, ret);
+		goto err_del_adapter;
+	}
+	ret = qt_replay_parse(r);
+	if (ret) {
+		printk(KERN_ERR "qt602240_replay: bad recording %s (%d)\n",
+		       file, ret);
+		goto err_release_fw;
+	}
+
+	r->client = i2c_new_device(&r->adap, &info);
+	if (!r->client) {
+		ret = -ENODEV;
+		goto err_release_fw;
+	}
+
+	r->debugfs = debugfs_create_dir("qt602240_replay", NULL);
+	if (IS_ERR(r->debugfs))
+		r->debugfs = NULL;
+	if (r->debugfs) {
+		debugfs_create_file("stats", S_IRUGO, r->debugfs, r,
+				    &qt_replay_stats_fops);
+		debugfs_create_file("restart", S_IWUSR, r->debugfs, r,
+				    &qt_replay_restart_fops);
+	}
+
+	replay = r;
+	printk(KERN_INFO "qt602240_replay: %s, %u frames, T5 at 0x%x\n",
+	       file, r->nr_frames, r->t5_addr);
+	qt_replay_restart(r);
+
+	return 0;
+
+err_release_fw:
+	kfree(r->mem);
+	release_firmware(r->fw);
+err_del_adapter:
+	i2c_del_adapter(&r->adap);
+err_free:
+	kfree(r);
+	return ret;
+}
+
+static void __exit qt_replay_exit(void)
+{
+	struct qt_replay *r = replay;
+
+	debugfs_remove_recursive(r->debugfs);
+	hrtimer_cancel(&r->timer);
+	i2c_unregister_device(r->client);
+	i2c_del_adapter(&r->adap);
+	release_firmware(r->fw);
+	kfree(r->mem);
+	kfree(r);
+}
+
+module_init(qt_replay_init);
+module_exit(qt_replay_exit);
+
+MODULE_DESCRIPTION("QT602240 recorded message replay adapter");
+MODULE_LICENSE("GPL");
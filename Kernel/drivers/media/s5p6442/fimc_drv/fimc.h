@@ -100,6 +100,13 @@ enum fimc_autoload {
 	FIMC_ONE_SHOT,
 };
 
+enum fimc_import {
+	FIMC_IMPORT_NONE,
+	FIMC_IMPORT_PMEM,
+	FIMC_IMPORT_FB,
+	FIMC_IMPORT_SHARED,	/* repeats another slot's import */
+};
+
 enum fimc_pixel_format_type{
 	FIMC_RGB,
 	FIMC_YUV420,
@@ -124,6 +131,21 @@ struct fimc_buf {
  	size_t		length[3];
 };
 
+/*
+ * V4L2_MEMORY_USERPTR buffer imported by file descriptor.
+ * Set FIMC_BUF_FLAG_IMPORT in v4l2_buffer.flags and point m.userptr
+ * at this structure. The fd may be a pmem region or a framebuffer window.
+ * Offsets are in bytes from the start of the region, and every plane of
+ * the current format must fit inside it. A zero CB/CR offset places the
+ * plane right after the previous one; NV12T needs an explicit CbCr offset.
+ */
+#define FIMC_BUF_FLAG_IMPORT	0x00010000
+
+struct fimc_buf_fd {
+	int		fd;
+	u32		offset[3];
+};
+
 /* general buffer */
 struct fimc_buf_set {
 	int			id;
@@ -134,6 +156,10 @@ struct fimc_buf_set {
 	u32			flags;
 	atomic_t		mapped_cnt;
 	struct list_head	list;
+
+	/* set while the buffer memory belongs to an imported fd */
+	enum fimc_import	import;
+	struct file		*file;
 };
 
 /* for capture device */
@@ -147,6 +173,7 @@ struct fimc_capinfo {
 	int			nr_bufs;
 	int			irq;
 	int			lastirq;
+	enum v4l2_memory	memory;
 	
 	/* flip: V4L2_CID_xFLIP, rotate: 90, 180, 270 */
 	u32			flip;
@@ -247,6 +274,15 @@ struct fimc_limit {
 };
 
 /* fimc controller abstration */
+/* frames written or read in place, instead of copied by userspace */
+struct fimc_stats {
+	u32		frames;
+	u32		copies_avoided;
+	u64		bytes_avoided;
+	u32		imports;
+	u32		import_errors;
+};
+
 struct fimc_control {
 	int				id;		/* controller id */
 	char				name[16];
@@ -274,6 +310,7 @@ struct fimc_control {
 	struct fimc_outinfo		*out;		/* output dev info */
 	struct fimc_fbinfo		fb;		/* fimd info */
 	struct fimc_scaler		sc;		/* scaler info */
+	struct fimc_stats		stats;
 
 	enum fimc_status		status;
 };
@@ -305,6 +342,9 @@ extern int s3cfb_close_fifo(int id, int (*do_priv)(void *), void *param, int sle
 extern void s3c_csis_start(int lanes, int settle, int align, int width, int height);
 extern int fimc_dma_alloc(struct fimc_control *ctrl, struct fimc_buf_set *bs, int i, int align);
 extern void fimc_dma_free(struct fimc_control *ctrl, struct fimc_buf_set *bs, int i);
+extern int fimc_import_buf(struct fimc_control *ctrl, struct fimc_buf_set *bs, unsigned long userptr, struct v4l2_pix_format *pix);
+extern void fimc_share_buf(struct fimc_control *ctrl, struct fimc_buf_set *dst, struct fimc_buf_set *src);
+extern void fimc_release_buf(struct fimc_control *ctrl, struct fimc_buf_set *bs);
 extern u32 fimc_mapping_rot_flip(u32 rot, u32 flip);
 extern int fimc_get_scaler_factor(u32 src, u32 tar, u32 *ratio, u32 *shift);
 
@@ -442,5 +482,16 @@ static inline struct fimc_control *get_fimc_ctrl(int id)
 	return &fimc_dev->ctrl[id];
 }
 
+static inline void fimc_stats_frame(struct fimc_control *ctrl,
+				    struct fimc_buf_set *bs, size_t bytes)
+{
+	ctrl->stats.frames++;
+
+	if (bs->import != FIMC_IMPORT_NONE) {
+		ctrl->stats.copies_avoided++;
+		ctrl->stats.bytes_avoided += bytes;
+	}
+}
+
 #endif /* _FIMC_H */
 
@@ -563,7 +563,7 @@ int fimc_s_fmt_vid_capture(struct file *file, void *fh, struct v4l2_format *f)
 {
 	struct fimc_control *ctrl = fh;
 	struct fimc_capinfo *cap = ctrl->cap;
-	int ret = 0;
+	int ret = 0, i;
 #ifdef VIEW_FUNCTION_CALL
 	printk("[FIMC_CAPTURE] %s(%d)\n", __func__, __LINE__);
 #endif
@@ -586,9 +586,14 @@ int fimc_s_fmt_vid_capture(struct file *file, void *fh, struct v4l2_format *f)
 		/* assign to ctrl */
 		ctrl->cap = cap;
 	} else {
+		for (i = 0; i < FIMC_CAPBUFS; i++)
+			fimc_release_buf(ctrl, &cap->bufs[i]);
+
 		memset(cap, 0, sizeof(*cap));
 	}
 
+	cap->memory = V4L2_MEMORY_MMAP;
+
 	mutex_lock(&ctrl->v4l2_lock);
 
 	memset(&cap->fmt, 0, sizeof(cap->fmt));
@@ -709,6 +714,7 @@ int fimc_reqbufs_capture(void *fh, struct v4l2_requestbuffers *b)
 	INIT_LIST_HEAD(&cap->inq);
 	for (i = 0; i < FIMC_CAPBUFS; i++) {
 		/* free previous buffers */
+		fimc_release_buf(ctrl, &cap->bufs[i]);
 		fimc_dma_free(ctrl, &cap->bufs[i], 0);
 		cap->bufs[i].id = i;
 		cap->bufs[i].state = VIDEOBUF_NEEDS_INIT;
@@ -735,6 +741,13 @@ int fimc_reqbufs_capture(void *fh, struct v4l2_requestbuffers *b)
 //	if(cap->nr_bufs == 1)
 //	    ctrl->mem.curr = ctrl->mem.base + RESERVED_PMEM_PREVIEW;
 
+	/* imported buffers are attached one by one in VIDIOC_QBUF */
+	cap->memory = b->memory;
+	if (b->memory == V4L2_MEMORY_USERPTR) {
+		mutex_unlock(&ctrl->v4l2_lock);
+		return 0;
+	}
+
 	switch (cap->fmt.pixelformat) {
 	case V4L2_PIX_FMT_RGB32:	/* fall through */
 	case V4L2_PIX_FMT_RGB565:	/* fall through */
@@ -1212,6 +1225,18 @@ int fimc_streamon_capture(void *fh)
 		return 0;
 	}
 
+	if (cap->memory == V4L2_MEMORY_USERPTR &&
+	    cap->nr_bufs <= FIMC_PHYBUFS) {
+		for (i = 0; i < cap->nr_bufs; i++) {
+			if (cap->bufs[i].import == FIMC_IMPORT_NONE) {
+				dev_err(ctrl->dev, "%s: buffer %d not queued\n",
+					__func__, i);
+				mutex_unlock(&fimc_hardware);
+				return -EINVAL;
+			}
+		}
+	}
+
 	ctrl->status = FIMC_READY_ON;
 	cap->irq = 0;
 
@@ -1291,25 +1316,72 @@ int fimc_streamoff_capture(void *fh)
 	return 0;
 }
 
+static int fimc_import_capture(struct fimc_control *ctrl, struct v4l2_buffer *b)
+{
+	struct fimc_capinfo *cap = ctrl->cap;
+	struct fimc_buf_set *bs = &cap->bufs[b->index];
+	int ret, i;
+
+	if (b->index >= cap->nr_bufs)
+		return -EINVAL;
+
+	if (!(b->flags & FIMC_BUF_FLAG_IMPORT)) {
+		dev_err(ctrl->dev, "%s: userptr needs an fd to import\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	ret = fimc_import_buf(ctrl, bs, b->m.userptr, &cap->fmt);
+	if (ret)
+		return ret;
+
+	bs->state = VIDEOBUF_PREPARED;
+
+	if (cap->nr_bufs > FIMC_PHYBUFS)
+		return 0;
+
+	/* fewer buffers than hardware slots: they repeat across the slots */
+	for (i = b->index; i < FIMC_PHYBUFS; i += cap->nr_bufs) {
+		if (i != b->index)
+			fimc_share_buf(ctrl, &cap->bufs[i], bs);
+
+		if (ctrl->status == FIMC_STREAMON)
+			fimc_hwset_output_address(ctrl, bs, i);
+	}
+
+	return 0;
+}
+
 int fimc_qbuf_capture(void *fh, struct v4l2_buffer *b)
 {
 	struct fimc_control *ctrl = fh;
+	int ret = 0;
 #ifdef VIEW_FUNCTION_CALL
 	printk("[FIMC_CAPTURE] %s(%d)\n", __func__, __LINE__);
 #endif
 
-	if (b->memory != V4L2_MEMORY_MMAP) {
+	if (b->memory != ctrl->cap->memory) {
 		dev_err(ctrl->dev, "%s: invalid memory type\n", __func__);
 		return -EINVAL;
 	}
 
-	if (ctrl->cap->nr_bufs > FIMC_PHYBUFS) {
-		mutex_lock(&ctrl->v4l2_lock);
-		fimc_add_inqueue(ctrl, b->index);
-		mutex_unlock(&ctrl->v4l2_lock);
+	if (b->index >= FIMC_CAPBUFS) {
+		dev_err(ctrl->dev, "%s: invalid index %d\n", __func__,
+			b->index);
+		return -EINVAL;
 	}
 
-	return 0;
+	mutex_lock(&ctrl->v4l2_lock);
+
+	if (b->memory == V4L2_MEMORY_USERPTR)
+		ret = fimc_import_capture(ctrl, b);
+
+	if (!ret && ctrl->cap->nr_bufs > FIMC_PHYBUFS)
+		fimc_add_inqueue(ctrl, b->index);
+
+	mutex_unlock(&ctrl->v4l2_lock);
+
+	return ret;
 }
 
 int fimc_dqbuf_capture(void *fh, struct v4l2_buffer *b)
@@ -1321,7 +1393,7 @@ int fimc_dqbuf_capture(void *fh, struct v4l2_buffer *b)
 	printk("[FIMC_CAPTURE] %s(%d)\n", __func__, __LINE__);
 #endif
 
-	if (b->memory != V4L2_MEMORY_MMAP) {
+	if (b->memory != cap->memory) {
 		dev_err(ctrl->dev, "%s: invalid memory type\n", __func__);
 		return -EINVAL;
 	}
@@ -1346,6 +1418,10 @@ int fimc_dqbuf_capture(void *fh, struct v4l2_buffer *b)
 		b->index = pp;
 	}
 
+	if (!ret)
+		fimc_stats_frame(ctrl, &cap->bufs[b->index],
+				 cap->fmt.sizeimage);
+
 	mutex_unlock(&ctrl->v4l2_lock);
 
 	return ret;
@@ -30,7 +30,12 @@
 #include <linux/irq.h>
 #include <linux/mm.h>
 #include <linux/interrupt.h>
+#include <linux/file.h>
+#include <linux/major.h>
+#include <linux/uaccess.h>
+#include <linux/android_pmem.h>
 #include <media/v4l2-device.h>
+#include <linux/videodev2_samsung.h>
 #include <linux/io.h>
 #include <linux/memory.h>
 #include <plat/clock.h>
@@ -137,6 +142,215 @@ void fimc_dma_free(struct fimc_control *ctrl, struct fimc_buf_set *bs, int i)
 	mutex_unlock(&ctrl->lock);
 }
 
+static int fimc_get_fb_file(int fd, unsigned long *start, unsigned long *len,
+			    struct file **filp)
+{
+	struct file *file;
+	struct inode *inode;
+	struct fb_info *info;
+
+	file = fget(fd);
+	if (!file)
+		return -EBADF;
+
+	inode = file->f_path.dentry->d_inode;
+	if (!S_ISCHR(inode->i_mode) || imajor(inode) != FB_MAJOR ||
+	    iminor(inode) >= FB_MAX)
+		goto not_fb;
+
+	info = registered_fb[iminor(inode)];
+	if (!info || !info->fix.smem_start)
+		goto not_fb;
+
+	*start = info->fix.smem_start;
+	*len = info->fix.smem_len;
+	*filp = file;
+
+	return 0;
+
+not_fb:
+	fput(file);
+	return -EINVAL;
+}
+
+/*
+ * Size of each plane of a w x h frame, laid out as the MMAP paths do.
+ * Returns the number of planes, or 0 for an unknown format.
+ */
+static int fimc_plane_sizes(struct v4l2_pix_format *pix, u32 size[3])
+{
+	u32 w = pix->width, h = pix->height;
+
+	size[FIMC_ADDR_CB] = 0;
+	size[FIMC_ADDR_CR] = 0;
+
+	switch (pix->pixelformat) {
+	case V4L2_PIX_FMT_RGB32:
+		size[FIMC_ADDR_Y] = w * h * 4;
+		return 1;
+	case V4L2_PIX_FMT_RGB565:	/* fall through */
+	case V4L2_PIX_FMT_YUYV:		/* fall through */
+	case V4L2_PIX_FMT_UYVY:		/* fall through */
+	case V4L2_PIX_FMT_VYUY:		/* fall through */
+	case V4L2_PIX_FMT_YVYU:
+		size[FIMC_ADDR_Y] = w * h * 2;
+		return 1;
+	case V4L2_PIX_FMT_NV12:		/* fall through */
+	case V4L2_PIX_FMT_NV21:
+		size[FIMC_ADDR_Y] = w * h;
+		size[FIMC_ADDR_CB] = (w * h) >> 1;
+		return 2;
+	case V4L2_PIX_FMT_NV12T:
+		size[FIMC_ADDR_Y] = ALIGN(ALIGN(w, 128) * ALIGN(h, 32), SZ_8K);
+		size[FIMC_ADDR_CB] = ALIGN(ALIGN(w, 128) * ALIGN(h / 2, 32),
+					   SZ_8K);
+		return 2;
+	case V4L2_PIX_FMT_NV16:		/* fall through */
+	case V4L2_PIX_FMT_NV61:
+		size[FIMC_ADDR_Y] = w * h;
+		size[FIMC_ADDR_CB] = w * h;
+		return 2;
+	case V4L2_PIX_FMT_YUV420:
+		size[FIMC_ADDR_Y] = w * h;
+		size[FIMC_ADDR_CB] = (w * h) >> 2;
+		size[FIMC_ADDR_CR] = (w * h) >> 2;
+		return 3;
+	case V4L2_PIX_FMT_YUV422P:
+		size[FIMC_ADDR_Y] = w * h;
+		size[FIMC_ADDR_CB] = (w * h) >> 1;
+		size[FIMC_ADDR_CR] = (w * h) >> 1;
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Point a buffer set at the memory behind a pmem or framebuffer fd so
+ * the hardware reads or writes it in place. Every plane of the format
+ * must fit inside the region; a plane without an offset follows the
+ * previous one. The file reference is held until the buffer is
+ * imported again or released.
+ */
+int fimc_import_buf(struct fimc_control *ctrl, struct fimc_buf_set *bs,
+		    unsigned long userptr, struct v4l2_pix_format *pix)
+{
+	struct fimc_buf_fd req;
+	struct file *file = NULL;
+	unsigned long start = 0, vstart, len = 0;
+	enum fimc_import import;
+	u32 size[3], offset = 0;
+	int i, planes;
+
+	if (copy_from_user(&req, (void __user *)userptr, sizeof(req)))
+		return -EFAULT;
+
+	planes = fimc_plane_sizes(pix, size);
+	if (!planes) {
+		dev_err(ctrl->dev, "%s: cannot import format 0x%08x\n",
+			__func__, pix->pixelformat);
+		ctrl->stats.import_errors++;
+		return -EINVAL;
+	}
+
+	/* tiled chroma has its own alignment, it cannot be derived */
+	if (pix->pixelformat == V4L2_PIX_FMT_NV12T && !req.offset[FIMC_ADDR_CB]) {
+		dev_err(ctrl->dev, "%s: NV12T needs a CbCr offset\n", __func__);
+		ctrl->stats.import_errors++;
+		return -EINVAL;
+	}
+
+	fimc_release_buf(ctrl, bs);
+
+	if (!fimc_get_fb_file(req.fd, &start, &len, &file)) {
+		import = FIMC_IMPORT_FB;
+	} else if (!get_pmem_file(req.fd, &start, &vstart, &len, &file)) {
+		import = FIMC_IMPORT_PMEM;
+	} else {
+		dev_err(ctrl->dev, "%s: fd %d is neither pmem nor fb\n",
+			__func__, req.fd);
+		ctrl->stats.import_errors++;
+		return -EINVAL;
+	}
+
+	for (i = 0; i < 3; i++) {
+		if (i >= planes) {
+			bs->base[i] = 0;
+			continue;
+		}
+
+		if (i == FIMC_ADDR_Y || req.offset[i])
+			offset = req.offset[i];
+
+		if (offset > len || size[i] > len - offset)
+			goto err_range;
+
+		bs->base[i] = start + offset;
+		offset += size[i];
+	}
+
+	bs->import = import;
+	bs->file = file;
+	ctrl->stats.imports++;
+
+	return 0;
+
+err_range:
+	dev_err(ctrl->dev, "%s: fd %d holds %lu bytes, plane %d needs %u at %u\n",
+		__func__, req.fd, len, i, size[i], offset);
+
+	if (import == FIMC_IMPORT_PMEM)
+		put_pmem_file(file);
+	else
+		fput(file);
+
+	bs->base[FIMC_ADDR_Y] = 0;
+	bs->base[FIMC_ADDR_CB] = 0;
+	bs->base[FIMC_ADDR_CR] = 0;
+	ctrl->stats.import_errors++;
+
+	return -EINVAL;
+}
+
+/*
+ * Repeat an imported buffer in another hardware slot. The slot takes
+ * its own file reference so either may be released first.
+ */
+void fimc_share_buf(struct fimc_control *ctrl, struct fimc_buf_set *dst,
+		    struct fimc_buf_set *src)
+{
+	fimc_release_buf(ctrl, dst);
+
+	memcpy(dst->base, src->base, sizeof(src->base));
+	if (src->import == FIMC_IMPORT_NONE)
+		return;
+
+	get_file(src->file);
+	dst->file = src->file;
+	dst->import = FIMC_IMPORT_SHARED;
+}
+
+void fimc_release_buf(struct fimc_control *ctrl, struct fimc_buf_set *bs)
+{
+	switch (bs->import) {
+	case FIMC_IMPORT_PMEM:
+		put_pmem_file(bs->file);
+		break;
+	case FIMC_IMPORT_FB:		/* fall through */
+	case FIMC_IMPORT_SHARED:
+		fput(bs->file);
+		break;
+	default:
+		return;
+	}
+
+	bs->base[FIMC_ADDR_Y] = 0;
+	bs->base[FIMC_ADDR_CB] = 0;
+	bs->base[FIMC_ADDR_CR] = 0;
+	bs->import = FIMC_IMPORT_NONE;
+	bs->file = NULL;
+}
+
 static inline u32 fimc_irq_out_dma(struct fimc_control *ctrl)
 {
 	u32 next = 0, wakeup = 1;
@@ -149,6 +363,9 @@ static inline u32 fimc_irq_out_dma(struct fimc_control *ctrl)
 	ret = fimc_attach_out_queue(ctrl, ctrl->out->idx.active);
 	if (ret < 0)
 		dev_err(ctrl->dev, "Failed: fimc_attach_out_queue\n");
+	else
+		fimc_stats_frame(ctrl, &ctrl->out->buf[ctrl->out->idx.active],
+				 ctrl->out->pix.sizeimage);
 
 	if (ctrl->status == FIMC_READY_OFF) {
 		ctrl->out->idx.active = -1;
@@ -188,6 +405,9 @@ static inline u32 fimc_irq_out_fimd(struct fimc_control *ctrl)
 			dev_err(ctrl->dev,
 				"Failed: fimc_attach_out_queue\n");
 		} else {
+			fimc_stats_frame(ctrl,
+					 &ctrl->out->buf[ctrl->out->idx.prev],
+					 ctrl->out->pix.sizeimage);
 			ctrl->out->idx.prev = -1;
 			wakeup = 1; /* To wake up fimc_v4l2_dqbuf(). */
 		}
@@ -925,6 +1145,7 @@ static int fimc_release(struct file *filp)
 
 	if (ctrl->cap) {
 		for (i = 0; i < FIMC_CAPBUFS; i++) {
+			fimc_release_buf(ctrl, &ctrl->cap->bufs[i]);
 			fimc_dma_free(ctrl, &ctrl->cap->bufs[i], 0);
 			fimc_dma_free(ctrl, &ctrl->cap->bufs[i], 1);
 		}
@@ -942,6 +1163,9 @@ static int fimc_release(struct file *filp)
 			ctrl->status = FIMC_STREAMOFF;
 		}
 
+		for (i = 0; i < FIMC_OUTBUFS; i++)
+			fimc_release_buf(ctrl, &ctrl->out->buf[i]);
+
 		kfree(ctrl->out);
 		ctrl->out = NULL;
 	}
@@ -1135,6 +1359,30 @@ static int fimc_configure_subdev(struct platform_device *pdev, int id)
 	return 0;
 }
 
+static ssize_t fimc_show_stats(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct fimc_control *ctrl = get_fimc_ctrl(to_platform_device(dev)->id);
+	struct fimc_stats *st = &ctrl->stats;
+	u32 per_frame = 0;
+
+	if (st->frames)
+		per_frame = (u32)div_u64((u64)st->copies_avoided * 100,
+					 st->frames);
+
+	return sprintf(buf, "frames:          %u\n"
+			    "copies avoided:  %u (%u.%02u per frame)\n"
+			    "bytes avoided:   %llu\n"
+			    "imports:         %u\n"
+			    "import errors:   %u\n",
+		       st->frames, st->copies_avoided,
+		       per_frame / 100, per_frame % 100,
+		       (unsigned long long)st->bytes_avoided,
+		       st->imports, st->import_errors);
+}
+
+static DEVICE_ATTR(stats, S_IRUGO, fimc_show_stats, NULL);
+
 static int __devinit fimc_probe(struct platform_device *pdev)
 {
 	struct s3c_platform_fimc *pdata;
@@ -1206,6 +1454,10 @@ static int __devinit fimc_probe(struct platform_device *pdev)
 	}
 
 	video_set_drvdata(ctrl->vd, ctrl);
+
+	if (device_create_file(&pdev->dev, &dev_attr_stats))
+		dev_warn(&pdev->dev, "%s: cannot create stats file\n",
+			__func__);
     
     if (ctrl->id == 1)
 			pdata->hw_ver = 0x50;
@@ -1265,6 +1517,7 @@ err_fimc:
 
 static int fimc_remove(struct platform_device *pdev)
 {
+	device_remove_file(&pdev->dev, &dev_attr_stats);
 	fimc_unregister_controller(pdev);
 #ifdef VIEW_FUNCTION_CALL
 	printk("[FIMC_DEV] %s(%d)\n", __func__, __LINE__);
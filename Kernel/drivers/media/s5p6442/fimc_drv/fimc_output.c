@@ -1014,7 +1014,7 @@ static int fimc_start_fifo(struct fimc_control *ctrl)
 int fimc_reqbufs_output(void *fh, struct v4l2_requestbuffers *b)
 {
 	struct fimc_control *ctrl = (struct fimc_control *) fh;
-	int ret = -1;
+	int ret = -1, i;
 
 //	dev_info(ctrl->dev, "%s: called\n", __func__);
 
@@ -1035,6 +1035,9 @@ int fimc_reqbufs_output(void *fh, struct v4l2_requestbuffers *b)
 		b->count = FIMC_OUTBUFS;
 	}
 
+	for (i = 0; i < FIMC_OUTBUFS; i++)
+		fimc_release_buf(ctrl, &ctrl->out->buf[i]);
+
 	/* Validation check & Initialize all buffers */
 	ret = fimc_init_out_buf(ctrl, b->memory);
 	if (ret)
@@ -1395,6 +1398,8 @@ static int fimc_update_in_queue_addr(struct fimc_control *ctrl, u32 index, dma_a
 		dev_err(ctrl->dev, "%s: Failed \n", __func__);
 		return -EINVAL;
 	}
+
+	fimc_release_buf(ctrl, &ctrl->out->buf[index]);
 	
 	ctrl->out->buf[index].base[FIMC_ADDR_Y] = addr[FIMC_ADDR_Y];
 	ctrl->out->buf[index].base[FIMC_ADDR_CB] = addr[FIMC_ADDR_CB];
@@ -1408,7 +1413,7 @@ int fimc_qbuf_output(void *fh, struct v4l2_buffer *b)
 	struct fimc_control *ctrl = (struct fimc_control *) fh;
 	dma_addr_t dst_base = 0;
 	int ret = -1;
-	struct fimc_buf *buf = (struct fimc_buf *)b->m.userptr;
+	struct fimc_buf buf;
 
 //	dev_info(ctrl->dev, "%s: queued idx = %d\n", __func__, b->index);
 
@@ -1428,8 +1433,21 @@ int fimc_qbuf_output(void *fh, struct v4l2_buffer *b)
 		return -EINVAL;
 	}
 
-	if (b->memory == V4L2_MEMORY_USERPTR) {
-		ret = fimc_update_in_queue_addr(ctrl, b->index, buf->base);
+	if (b->memory == V4L2_MEMORY_USERPTR &&
+	    (b->flags & FIMC_BUF_FLAG_IMPORT)) {
+		if (b->index >= FIMC_OUTBUFS)
+			return -EINVAL;
+
+		ret = fimc_import_buf(ctrl, &ctrl->out->buf[b->index],
+				      b->m.userptr, &ctrl->out->pix);
+		if (ret < 0)
+			return ret;
+	} else if (b->memory == V4L2_MEMORY_USERPTR) {
+		if (copy_from_user(&buf, (void __user *)b->m.userptr,
+				   sizeof(buf)))
+			return -EFAULT;
+
+		ret = fimc_update_in_queue_addr(ctrl, b->index, buf.base);
 		if (ret < 0)
 			return ret;
 	}
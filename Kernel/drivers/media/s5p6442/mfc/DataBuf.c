@@ -50,15 +50,6 @@ volatile unsigned char* GetDataBufVirAddr()
 	return pDataBuf;	
 }
 
-volatile unsigned char* GetFramBufVirAddr()
-{
-	volatile unsigned char	*pFramBuf;
-
-	pFramBuf	= vir_pDATA_BUF + MFC_STRM_BUF_SIZE;
-
-	return pFramBuf;	
-}
-
 
 /*
  * virtual address of DBK_BUF is returned
@@ -69,7 +60,7 @@ volatile unsigned char *GetDbkBufVirAddr()
 {
 	volatile unsigned char	*pDbkBuf;
 
-	pDbkBuf	= vir_pDATA_BUF + MFC_STRM_BUF_SIZE + MFC_FRAM_BUF_SIZE;
+	pDbkBuf	= vir_pDATA_BUF + MFC_DATA_POOL_SIZE;
 
 	return pDbkBuf;	
 }
@@ -83,15 +74,6 @@ unsigned int GetDataBufPhyAddr()
 	return phyDataBuf;
 }
 
-unsigned int GetFramBufPhyAddr()
-{
-	unsigned int	phyFramBuf;
-
-	phyFramBuf = phyDATA_BUF + MFC_STRM_BUF_SIZE;
-
-	return phyFramBuf;
-}
-
 /*
  * physical address of DBK_BUF is returned
  *
@@ -101,7 +83,7 @@ unsigned int GetDbkBufPhyAddr()
 {
 	unsigned int	phyDbkBuf;
 
-	phyDbkBuf = phyDATA_BUF + MFC_STRM_BUF_SIZE + MFC_FRAM_BUF_SIZE;
+	phyDbkBuf = phyDATA_BUF + MFC_DATA_POOL_SIZE;
 
 	return phyDbkBuf;	
 }
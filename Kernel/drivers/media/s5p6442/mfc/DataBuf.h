@@ -21,9 +21,7 @@ extern "C" {
 BOOL MfcDataBufMemMapping(void);
 volatile unsigned char* GetDbkBufVirAddr(void);
 volatile unsigned char* GetDataBufVirAddr(void);
-volatile unsigned char* GetFramBufVirAddr(void);
 unsigned int GetDataBufPhyAddr(void);
-unsigned int GetFramBufPhyAddr(void);
 unsigned int GetDbkBufPhyAddr(void);
 
 
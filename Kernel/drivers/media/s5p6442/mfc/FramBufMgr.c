@@ -317,6 +317,34 @@ int FramBufMgrGetBufSize(int idx_commit)
 }
 
 
+//
+// int FramBufMgrGetFreeSize()
+//
+// Description
+//		This function obtains the number of bytes which are not committed.
+// Parameters
+//		None
+// Return Value
+//		Size in bytes of all the free segments (not necessarily contiguous).
+//
+int FramBufMgrGetFreeSize()
+{
+	int	i;
+	int	num_free_seg = 0;
+
+	if (_p_segment_info == NULL || _p_commit_info == NULL)
+		return 0;
+
+	for (i=0; i<_nNumSegs; i++) 
+	{
+		if (_p_segment_info[i].idx_commit == 0)
+			num_free_seg++;
+	}
+
+	return (num_free_seg * BUF_SEGMENT_SIZE);
+}
+
+
 //
 // void FramBufMgrPrintCommitInfo()
 //
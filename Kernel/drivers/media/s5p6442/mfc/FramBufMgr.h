@@ -26,6 +26,7 @@ unsigned char* FramBufMgrCommit(int idx_commit, int commit_size);
 void FramBufMgrFree(int idx_commit);
 unsigned char* FramBufMgrGetBuf(int idx_commit);
 int FramBufMgrGetBufSize(int idx_commit);
+int FramBufMgrGetFreeSize(void);
 void FramBufMgrPrintCommitInfo(void);
 
 
@@ -49,8 +49,9 @@ BOOL MFC_MemorySetup(void)
 	}
 
 	// FramBufMgr Module Initialization
+	// (STRM_BUF and FRAM_BUF of all the instances are committed from DATA_POOL)
 	pDataBuf = (unsigned char *)GetDataBufVirAddr();
-	FramBufMgrInit(pDataBuf + MFC_STRM_BUF_SIZE, MFC_FRAM_BUF_SIZE);
+	FramBufMgrInit(pDataBuf, MFC_DATA_POOL_SIZE);
 
 	return TRUE;
 }
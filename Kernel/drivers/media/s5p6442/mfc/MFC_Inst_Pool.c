@@ -67,38 +67,3 @@ int MfcInstPool_Release(int instance_no)
 
 	return instance_no;
 }
-
-
-void MfcInstPool_OccupyAll(void)
-{
-	int  i;
-
-	if (_num_inst_avail == 0)
-		return;
-
-	for (i=0; i<MFC_NUM_INSTANCES_MAX; i++) 
-	{
-		if (_inst_status[i] == 0) 
-		{
-			_num_inst_avail--;
-			_inst_status[i] = 1;
-		}
-	}
-}
-
-void MfcInstPool_ReleaseAll(void)
-{
-	int  i;
-
-	if (_num_inst_avail == MFC_NUM_INSTANCES_MAX)
-		return;
-
-	for (i=0; i<MFC_NUM_INSTANCES_MAX; i++) 
-	{
-		if (_inst_status[i] == 1) 
-		{
-			_num_inst_avail++;
-			_inst_status[i] = 0;
-		}
-	}
-}
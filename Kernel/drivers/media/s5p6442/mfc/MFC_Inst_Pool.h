@@ -22,9 +22,6 @@ int MfcInstPool_NumAvail(void);
 int MfcInstPool_Occupy(void);
 int MfcInstPool_Release(int instance_no);
 
-void MfcInstPool_OccupyAll(void);
-void MfcInstPool_ReleaseAll(void);
-
 #ifdef __cplusplus
 }
 #endif
@@ -18,6 +18,7 @@
 #include "MfcSfr.h"
 #include "BitProcBuf.h"
 #include "MFC_Inst_Pool.h"
+#include "MfcSched.h"
 
 #include <asm/io.h>
 #include <linux/slab.h>
@@ -44,30 +45,51 @@ MFCInstCtx* MFCInst_GetCtx(int inst_no)
 		return NULL;
 }
 
+// FramBufMgr commit indices.
+// FRAM_BUF and STRM_BUF of an instance are committed from the same DATA_POOL.
+#define MFC_COMMIT_IDX_FRAM(ctx)	((ctx)->inst_no)
+#define MFC_COMMIT_IDX_STRM(ctx)	((ctx)->inst_no + MFC_NUM_INSTANCES_MAX)
+
 // Filling the pStrmBuf and phyadrStrmBuf variables of the MfcInstCtx structure
 // (pStrmBuf and phyadrStrmBuf are the virtual and physical address of STRM_BUF(stream buffer) respectively.)
-static void Get_MfcStrmBufAddr(MFCInstCtx *ctx, int isLineBuf)
+// STRM_BUF is committed once. Its size can not change afterwards,
+// since the user process keeps the size returned by GET_LINE_BUF/GET_RING_BUF.
+static BOOL Get_MfcStrmBufAddr(MFCInstCtx *ctx, int buf_size)
 {
-	// LINE BUF
-	if (isLineBuf) 
-	{
-		ctx->pStrmBuf		= (unsigned char *) ( GetDataBufVirAddr() + (ctx->inst_no * MFC_LINE_BUF_SIZE_PER_INSTANCE) );
-		ctx->phyadrStrmBuf	= (PHYADDR_VAL) ( GetDataBufPhyAddr() + (ctx->inst_no * MFC_LINE_BUF_SIZE_PER_INSTANCE) );
-		ctx->nStrmBufSize   = MFC_LINE_BUF_SIZE_PER_INSTANCE;
-	}
-	// RING BUF
-	else 
+	unsigned char	*pInstStrmBuf;
+
+	if (ctx->pStrmBuf != NULL)
+		return TRUE;
+
+	pInstStrmBuf	= FramBufMgrCommit(MFC_COMMIT_IDX_STRM(ctx), buf_size);
+	if (pInstStrmBuf == NULL) 
 	{
-#if (MFC_LINE_RING_SHARE == 1)
-		ctx->pStrmBuf		= (unsigned char *) GetDataBufVirAddr();
-		ctx->phyadrStrmBuf	= (PHYADDR_VAL) GetDataBufPhyAddr();
-#elif (MFC_LINE_RING_SHARE == 0)
-		ctx->pStrmBuf		= (unsigned char *) ( GetDataBufVirAddr() + MFC_LINE_BUF_SIZE);
-		ctx->phyadrStrmBuf	= (PHYADDR_VAL) ( GetDataBufPhyAddr() + MFC_LINE_BUF_SIZE);
-#endif
-		ctx->nStrmBufSize   = MFC_RING_BUF_SIZE;
+		LOG_MSG(LOG_ERROR, "Get_MfcStrmBufAddr", "Stream buffer allocation was failed! (size = %d)\r\n", buf_size);
+		return FALSE;
 	}
 
+	ctx->pStrmBuf		= pInstStrmBuf;
+	ctx->phyadrStrmBuf	= (PHYADDR_VAL) ( GetDataBufPhyAddr() + ( (int)pInstStrmBuf - (int)GetDataBufVirAddr() ) );
+	ctx->nStrmBufSize	= buf_size;
+
+	LOG_MSG(LOG_TRACE, "Get_MfcStrmBufAddr", "ctx->inst_no : %d, ctx->phyadrStrmBuf : 0x%X, size : %d\r\n", ctx->inst_no, ctx->phyadrStrmBuf, buf_size);
+
+	return TRUE;
+}
+
+// LINE_BUF size for encoding.
+// One YUV420 source frame is the upper bound of an encoded picture in practice.
+static int Get_MfcEncStrmBufSize(int width, int height)
+{
+	int	size;
+
+	size = (((width * height * 3) >> 1) + 0x3FF) & ~0x3FF;
+	if (size < MFC_LINE_BUF_SIZE_MIN)
+		size = MFC_LINE_BUF_SIZE_MIN;
+	if (size > MFC_LINE_BUF_SIZE_MAX)
+		size = MFC_LINE_BUF_SIZE_MAX;
+
+	return size;
 }
 
 // Filling the pFramBuf and phyadrFramBuf variables of the MfcInstCtx structure
@@ -76,7 +98,7 @@ static BOOL Get_MfcFramBufAddr(MFCInstCtx *ctx, int buf_size)
 {
 	unsigned char	*pInstFramBuf;
 
-	pInstFramBuf	= FramBufMgrCommit(ctx->inst_no, buf_size);
+	pInstFramBuf	= FramBufMgrCommit(MFC_COMMIT_IDX_FRAM(ctx), buf_size);
 	if (pInstFramBuf == NULL) 
 	{
 		LOG_MSG(LOG_ERROR, "Get_MfcFramBufAddr", "Frame buffer allocation was failed!\r\n");
@@ -100,13 +122,6 @@ static BOOL Get_MfcFramBufAddr(MFCInstCtx *ctx, int buf_size)
 }
 
 
-void MFCInst_RingBufAddrCorrection(MFCInstCtx *ctx)
-{
-	Get_MfcStrmBufAddr(ctx, 0);
-}
-
-
-
 int MFCInst_GetLineBuf(MFCInstCtx *ctx, unsigned char **ppBuf, int *size)
 {
 	///////////////////////////
@@ -123,8 +138,13 @@ int MFCInst_GetLineBuf(MFCInstCtx *ctx, unsigned char **ppBuf, int *size)
 	else if (ctx->inbuf_type == DEC_INBUF_RING_BUF)
 		return MFCINST_ERR_ETC;
 
+	// LINE_BUF is committed at the first request.
+	// (Encoders have committed it in MFCInst_Enc_Init already.)
+	if (Get_MfcStrmBufAddr(ctx, ctx->nStrmBufReq ? ctx->nStrmBufReq : MFC_LINE_BUF_SIZE_DEFAULT) == FALSE)
+		return MFCINST_ERR_ETC;
+
 	*ppBuf = ctx->pStrmBuf;
-	*size  = MFC_LINE_BUF_SIZE_PER_INSTANCE;
+	*size  = ctx->nStrmBufSize;
 
 	return MFCINST_RET_OK;
 }
@@ -134,11 +154,6 @@ int MFCInst_GetRingBuf(MFCInstCtx *ctx, unsigned char **ppBuf, int *size)
 	unsigned char  *pRD_PTR, *pWR_PTR;
 	int             num_bytes_strm_buf;	// Number of bytes in STRM_BUF (used in IOCTL_MFC_GET_RING_BUF_ADDR)
 
-#if (MFC_LINE_RING_SHARE == 0)
-	MFCInstCtx     *pMfcInstTmp;
-	int             inst_no = 0;
-#endif
-
 	///////////////////////////
 	///	STATE checking		///
 	///////////////////////////
@@ -156,46 +171,12 @@ int MFCInst_GetRingBuf(MFCInstCtx *ctx, unsigned char **ppBuf, int *size)
 		return MFCINST_ERR_ETC;
 
 
-	// state variable checking
+	// RING_BUF is committed from DATA_POOL like the LINE_BUF,
+	// so it does not need to keep the other instances out.
 	if (MFCINST_STATE_CHECK(ctx, MFCINST_STATE_CREATED)) 
 	{
-
-#if (MFC_LINE_RING_SHARE == 1)
-		// If LINE_BUF and RING_BUF are shared,
-		// there must be no instances other than itself.
-		if (MfcInstPool_NumAvail() != (MFC_NUM_INSTANCES_MAX-1))
+		if (Get_MfcStrmBufAddr(ctx, MFC_RING_BUF_SIZE) == FALSE)
 			return MFCINST_ERR_ETC;
-
-		// Occupy all the instances
-		// so that the other instances won't be activated
-		// until this VC-1 decode instance will be closed.
-		MfcInstPool_OccupyAll();
-
-#elif (MFC_LINE_RING_SHARE == 0)
-		// If LINE_BUF and RING_BUF are separated.
-		// there must be no other instances using the RING_BUF other than itself.
-		if (MfcInstPool_NumAvail() < (MFC_NUM_INSTANCES_MAX-1)) 
-		{
-			for (inst_no=0; inst_no<MFC_NUM_INSTANCES_MAX; inst_no++) 
-			{
-				if (inst_no == ctx->inst_no)
-					continue;
-
-				pMfcInstTmp = MFCInst_GetCtx(inst_no);
-				if (pMfcInstTmp == NULL)
-					continue;
-				if (pMfcInstTmp->inbuf_type == DEC_INBUF_RING_BUF) 
-				{
-					return MFCINST_ERR_ETC;
-				}
-			}
-		}
-
-		// If LINE_BUF & RING_BUF are not shared,
-		// the RING_BUF address must be different from the LINE_BUF.
-		// For this reason, the address needs correction at first.
-		MFCInst_RingBufAddrCorrection(ctx);
-#endif
 	}
 
 	// Get the current positions of RD_PTR and WR_PTR
@@ -397,6 +378,7 @@ MFCInstCtx *MFCInst_Create(void)
 	ctx = &(_mfcinst_ctx[inst_no]);
 
 	Mem_Set(ctx, 0, sizeof(MFCInstCtx));
+	MfcSched_ResetStats(ctx);
 
 	ctx->inst_no     = inst_no;
 	ctx->inbuf_type  = DEC_INBUF_NOT_SPECIFIED;
@@ -405,10 +387,8 @@ MFCInstCtx *MFCInst_Create(void)
 
 	MFCINST_STATE_TRANSITION(ctx, MFCINST_STATE_CREATED);
 
-	// At first, since it is not known whether it is LINE_BUF or RING_BUF,
-	// it assumes to be LINE_BUF.
-	// Later, if it turns out to be RING_BUF, correction will be made.
-	Get_MfcStrmBufAddr(ctx, 1);
+	// STRM_BUF is committed when it turns out whether it is LINE_BUF or RING_BUF,
+	// and (for encoding) how large the source picture is.
 
 	LOG_MSG(LOG_TRACE, "s3c_mfc_open", "state : %d\n", ctx->state_var);
 
@@ -435,8 +415,11 @@ void MFCInst_Delete(MFCInstCtx *ctx)
 	}
 
 	MfcInstPool_Release(ctx->inst_no);
-	FramBufMgrFree(ctx->inst_no);
-	FramBufMgrFree(ctx->inst_no + MFC_NUM_INSTANCES_MAX);
+	FramBufMgrFree(MFC_COMMIT_IDX_FRAM(ctx));
+	FramBufMgrFree(MFC_COMMIT_IDX_STRM(ctx));
+
+	ctx->pStrmBuf = NULL;
+	ctx->pFramBuf = NULL;
 
 	MFCINST_STATE_TRANSITION(ctx, MFCINST_STATE_DELETED);
 }
@@ -514,6 +497,11 @@ int MFCInst_Init(MFCInstCtx *ctx, MFC_CODECMODE codec_mode, unsigned long strm_l
 		LOG_MSG(LOG_ERROR, "MFCInst_Init", "Input buffer type is not specified.\r\n");
 		return MFCINST_ERR_ETC;
 	}
+	if (ctx->pStrmBuf == NULL) 
+	{
+		LOG_MSG(LOG_ERROR, "MFCInst_Init", "Stream buffer is not committed.\r\n");
+		return MFCINST_ERR_ETC;
+	}
 
 	//////////////////////////////////////////////
 	//											//
@@ -528,7 +516,7 @@ int MFCInst_Init(MFCInstCtx *ctx, MFC_CODECMODE codec_mode, unsigned long strm_l
 	mfc_sfr = (S3C6400_MFC_SFR *) GetMfcSfrVirAddr();
 	mfc_sfr->BIT_STR_BUF_RW_ADDR[ctx->inst_no].BITS_RD_PTR = ctx->phyadrStrmBuf;
 	if (ctx->inbuf_type == DEC_INBUF_LINE_BUF)	// In 'fileplay' mode, set the WR_PTR to the end of STRM_BUF
-		strm_leng = MFC_LINE_BUF_SIZE_PER_INSTANCE;
+		strm_leng = ctx->nStrmBufSize;
 	else if (ctx->inbuf_type == DEC_INBUF_RING_BUF) 
 	{
 		if (strm_leng < (MFC_RING_BUF_PARTUNIT_SIZE << 1)) 
@@ -571,7 +559,7 @@ int MFCInst_Init(MFCInstCtx *ctx, MFC_CODECMODE codec_mode, unsigned long strm_l
 	pPARAM_SEQ_INIT->DEC_SEQ_BIT_BUF_ADDR   = ctx->phyadrStrmBuf;
 	if (ctx->inbuf_type == DEC_INBUF_LINE_BUF) // Other than VC-1 decode
 	{	
-		pPARAM_SEQ_INIT->DEC_SEQ_BIT_BUF_SIZE   = MFC_LINE_BUF_SIZE_PER_INSTANCE / 1024;
+		pPARAM_SEQ_INIT->DEC_SEQ_BIT_BUF_SIZE   = ctx->nStrmBufSize / 1024;
 		
 		// yj: Enable 'Mp4DbkOn' bit
 		if(ctx->isMp4DbkOn == 1) 
@@ -829,6 +817,13 @@ int MFCInst_Enc_Init(MFCInstCtx *ctx, MFC_CODECMODE codec_mode, enc_info_t *enc_
 
 	// codec_mode
 	ctx->codec_mode = codec_mode;
+
+	// LINE_BUF for the encoded stream is sized from the source picture.
+	if (Get_MfcStrmBufAddr(ctx, Get_MfcEncStrmBufSize(ctx->width, ctx->height)) == FALSE) 
+	{
+		LOG_MSG(LOG_ERROR, "MFCInst_Enc_Init", "Stream buffer allocation was failed!\r\n");
+		return MFCINST_ERR_ETC;
+	}
 	
 	LOG_MSG(LOG_TRACE, "MFCInst_Enc_Init", "  ctx->inst_no = %d\n", ctx->inst_no);
 	LOG_MSG(LOG_TRACE, "MFCInst_Enc_Init", "  ctx->codec_mode = %d\n", ctx->codec_mode);
@@ -840,11 +835,11 @@ int MFCInst_Enc_Init(MFCInstCtx *ctx, MFC_CODECMODE codec_mode, enc_info_t *enc_
 	 
 	mfc_sfr = (S3C6400_MFC_SFR *) GetMfcSfrVirAddr();
 	mfc_sfr->BIT_STR_BUF_RW_ADDR[ctx->inst_no].BITS_WR_PTR = ctx->phyadrStrmBuf;
-	mfc_sfr->BIT_STR_BUF_RW_ADDR[ctx->inst_no].BITS_RD_PTR = ctx->phyadrStrmBuf  +  MFC_LINE_BUF_SIZE_PER_INSTANCE;
+	mfc_sfr->BIT_STR_BUF_RW_ADDR[ctx->inst_no].BITS_RD_PTR = ctx->phyadrStrmBuf  +  ctx->nStrmBufSize;
 	mfc_sfr->STRM_BUF_CTRL = 0x1C;	// bit stream buffer is reset at every picture encoding / decoding command
 
 	LOG_MSG(LOG_TRACE, "MFCInst_Enc_Init", "  ctx->phyadrStrmBuf = 0x%X\n", ctx->phyadrStrmBuf);
-	LOG_MSG(LOG_TRACE, "MFCInst_Enc_Init", "  ctx->phyadrStrmBuf + = 0x%X\n", ctx->phyadrStrmBuf + MFC_LINE_BUF_SIZE_PER_INSTANCE);
+	LOG_MSG(LOG_TRACE, "MFCInst_Enc_Init", "  ctx->phyadrStrmBuf + = 0x%X\n", ctx->phyadrStrmBuf + ctx->nStrmBufSize);
 
 	//////////////////////////////////////////////
 	//											//
@@ -858,7 +853,7 @@ int MFCInst_Enc_Init(MFCInstCtx *ctx, MFC_CODECMODE codec_mode, enc_info_t *enc_
 	memset(pPARAM_SEQ_INIT, 0, sizeof(S3C6400_MFC_PARAM_REG_ENC_SEQ_INIT));
 	
 	pPARAM_SEQ_INIT->ENC_SEQ_BIT_BUF_ADDR	= ctx->phyadrStrmBuf;
-	pPARAM_SEQ_INIT->ENC_SEQ_BIT_BUF_SIZE	= MFC_LINE_BUF_SIZE_PER_INSTANCE / 1024;
+	pPARAM_SEQ_INIT->ENC_SEQ_BIT_BUF_SIZE	= ctx->nStrmBufSize / 1024;
 	pPARAM_SEQ_INIT->ENC_SEQ_OPTION			= MB_BIT_REPORT_DISABLE | SLICE_INFO_REPORT_DISABLE | AUD_DISABLE;
 	pPARAM_SEQ_INIT->ENC_SEQ_SRC_SIZE		= (ctx->width << 10) | ctx->height;
 	pPARAM_SEQ_INIT->ENC_SEQ_SRC_F_RATE		= (ctx->frameRateDiv << 16) | ctx->frameRateRes;
@@ -84,6 +84,22 @@ typedef struct{
 #endif
 
 
+/*
+ * Per-instance statistics of the PIC_RUN commands.
+ * Engine time is measured by MfcSched from the grant to the release of the engine.
+ */
+typedef struct
+{
+	unsigned int		frames;			// number of DEC_EXE/ENC_EXE commands
+	unsigned long long	total_us;		// engine time in total
+	unsigned int		last_us;		// engine time of the last frame
+	unsigned int		min_us;
+	unsigned int		max_us;
+	unsigned long long	wait_us;		// time spent waiting for the engine in total
+	unsigned int		max_wait_us;
+} MFC_INST_STATS;
+
+
 typedef struct
 {
 	int	inst_no;
@@ -95,6 +111,7 @@ typedef struct
 	unsigned char		*pStrmBuf;			// STRM_BUF pointer (virtual address)
 	PHYADDR_VAL			phyadrStrmBuf;		// STRM_BUF physical address
 	unsigned int		nStrmBufSize;		// STRM_BUF size
+	unsigned int		nStrmBufReq;		// Requested LINE_BUF size for decoding (0: default)
 
 	unsigned char		*pFramBuf;			// FRAM_BUF pointer (virtual address)
 	PHYADDR_VAL			phyadrFramBuf;		// FRAM_BUF physical address
@@ -173,6 +190,12 @@ typedef struct
 
 	int	multiple_slice;
 
+	// MfcSched bookkeeping
+	unsigned long long	sched_vtime;	// engine time consumed (ns), the fairness key
+	int			sched_waiting;	// waiting for the engine
+
+	MFC_INST_STATS	stats;
+
 } MFCInstCtx;
 
 typedef struct {
@@ -207,7 +230,6 @@ extern "C" {
 MFCInstCtx *MFCInst_GetCtx(int inst_no);
 
 
-void MFCInst_RingBufAddrCorrection(MFCInstCtx *ctx);
 int MFCInst_GetInstNo(MFCInstCtx *ctx);
 BOOL MFCInst_GetStreamRWPtrs(MFCInstCtx *ctx, unsigned char **ppRD_PTR, unsigned char **ppWR_PTR);
 
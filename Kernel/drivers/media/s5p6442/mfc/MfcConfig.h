@@ -83,15 +83,12 @@
 #define MAX_HEIGHT	480
 #endif
 
-// MFC Driver supports 4 instances MAX.
-// yj : 4 -> 3 (It's because Linbuf size is changed from 200K to 300K for DMC request)
-// RainAde : 3->2 (It's because Linebuf size is changed from 300K to 500K for 864x600
-// RainAde : for test 6442 spec.
-#if 1
-#define MFC_NUM_INSTANCES_MAX	2
-#else
-#define MFC_NUM_INSTANCES_MAX	3
-#endif
+// Instances do not own a fixed slice of DATA_BUF. STRM_BUF and FRAM_BUF of
+// every instance are committed on demand from one shared pool, so the number
+// of concurrent instances is limited by the pool size. The only hard limit is
+// the firmware, which keeps RD_PTR/WR_PTR pairs for 8 instances
+// (BIT_STR_BUF_RW_ADDR[8]).
+#define MFC_NUM_INSTANCES_MAX	8
 
 
 // Determine if 'Post Rotate Mode' is enabled.
@@ -101,52 +98,34 @@
 //#define MFC_ROTATE_ENABLE		1
 #define MFC_ROTATE_ENABLE		0
 
-#define MFC_LINE_RING_SHARE		1	// Determine if the LINE_BUF is shared with RING_BUF
-
 /*
  * stream buffer size must be a multiple of 512bytes 
  * becasue minimun data transfer unit between stream buffer and internal bitstream handling block 
  * in MFC core is 512bytes
+ *
+ * LINE_BUF is committed per instance. Encoders size it from the source
+ * resolution at ENC_INIT, decoders use MFC_LINE_BUF_SIZE_DEFAULT unless a
+ * smaller size is requested with MFC_SET_CONFIG_DEC_STRM_BUF_SIZE.
+ * The sizes are multiples of 1KB since SEQ_BIT_BUF_SIZE is given in KB.
  */
-// RainAde : for test 6442 spec.
-#if 1
-#define MFC_LINE_BUF_SIZE_PER_INSTANCE		(512000)
-#else
-#define MFC_LINE_BUF_SIZE_PER_INSTANCE		(307200)
-#endif
-
-#define MFC_LINE_BUF_SIZE		(MFC_NUM_INSTANCES_MAX * MFC_LINE_BUF_SIZE_PER_INSTANCE)
-
-
-// RainAde : for test 6442 spec.
-#if 1
-//#define MFC_FRAM_BUF_SIZE		(MAX_WIDTH*MAX_HEIGHT*3*3)	// reference buffer count (usually, BP has 4 ref frame)
-#define MFC_FRAM_BUF_SIZE		(MAX_WIDTH*MAX_HEIGHT*3*9)	// reference buffer count 16 + current buffer 1 + display buffer 2 = 18 buffers
-#else
-#define MFC_FRAM_BUF_SIZE		(MAX_WIDTH*MAX_HEIGHT*3*4)
-#endif
+#define MFC_LINE_BUF_SIZE_MIN		(64 * 1024)
+#define MFC_LINE_BUF_SIZE_MAX		(512000)
+#define MFC_LINE_BUF_SIZE_DEFAULT	MFC_LINE_BUF_SIZE_MAX
 
 
 // RainAde : usually, ring buf take 3times of linebuf
-#if 1
-#define MFC_RING_BUF_SIZE		(MFC_LINE_BUF_SIZE_PER_INSTANCE  *  3)		// 768,000 Bytes
-#else
-#define MFC_RING_BUF_SIZE		((307200)  *  3)		// 768,000 Bytes
-#endif
+#define MFC_RING_BUF_SIZE		(MFC_LINE_BUF_SIZE_MAX  *  3)		// 1,536,000 Bytes
 
 #define MFC_RING_BUF_PARTUNIT_SIZE	(MFC_RING_BUF_SIZE / 3)	// RING_BUF consists of 3 PARTs.
 
 
-#if (MFC_LINE_RING_SHARE == 1)
-
-#define MFC_STRM_BUF_SIZE			(MFC_LINE_BUF_SIZE)
-
-#elif (MFC_LINE_RING_SHARE == 0)
-
-#define MFC_STRM_BUF_SIZE			(MFC_LINE_BUF_SIZE + MFC_RING_BUF_SIZE)
-
-#endif
-
+/*
+ * DATA_BUF = {DATA_POOL, DBK_BUF}
+ *
+ * The pool keeps the size of the former fixed layout
+ * (2 LINE_BUFs + 9 worst case frames) so the reserved memory is unchanged.
+ */
+#define MFC_DATA_POOL_SIZE		((MFC_LINE_BUF_SIZE_MAX * 2) + (MAX_WIDTH * MAX_HEIGHT * 3 * 9))
 
 /*
  * If Mp4DbkOn is enabled, the memory size of DATA_BUF is required more.
@@ -154,11 +133,15 @@
  * 2009.5.12 by yj (yunji.kim@samsung.com)
  */
 #define MFC_DBK_BUF_SIZE		((176*144*3) >> 1)
-#define MFC_DATA_BUF_SIZE		(MFC_STRM_BUF_SIZE + MFC_FRAM_BUF_SIZE + MFC_DBK_BUF_SIZE)	
+#define MFC_DATA_BUF_SIZE		(MFC_DATA_POOL_SIZE + MFC_DBK_BUF_SIZE)	
 
 
 #if (MFC_RING_BUF_PARTUNIT_SIZE & 0x1FF)
 #error "MFC_RING_BUF_PARTUNIT_SIZE value must be 512-byte aligned."
 #endif
 
+#if ((MFC_LINE_BUF_SIZE_MIN | MFC_LINE_BUF_SIZE_MAX) & 0x3FF)
+#error "MFC_LINE_BUF_SIZE_MIN/MAX must be 1KB aligned."
+#endif
+
 #endif /* __SAMSUNG_SYSLSI_APDEV_MFC_CONFIG_H__ */
@@ -129,6 +129,7 @@ typedef union {
 #define MFC_SET_CONFIG_DEC_OPTION					(0x0ABDE002)
 #define MFC_SET_PADDING_SIZE						(0x0ABDE003)
 #define MFC_SET_CONFIG_MP4_DBK_ON					(0x0ABDE004)
+#define MFC_SET_CONFIG_DEC_STRM_BUF_SIZE			(0x0ABDE005)
 
 #define MFC_SET_CONFIG_ENC_H263_PARAM				(0x0ABDC001)
 #define MFC_SET_CONFIG_ENC_SLICE_MODE				(0x0ABDC002)
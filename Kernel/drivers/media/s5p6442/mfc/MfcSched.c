@@ -0,0 +1,175 @@
+/*
+ *  drivers/media/s5p6442/mfc/MfcSched.c
+ *
+ *  Copyright 2010 Samsung Electronics Co.Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+#include <linux/ktime.h>
+#include <linux/string.h>
+
+#include "MfcConfig.h"
+#include "MfcMutex.h"
+#include "MfcSched.h"
+
+
+//
+// The MFC has a single engine which runs one PIC_RUN command at a time.
+// The instances are time-sliced on it frame by frame: among the instances
+// waiting for the engine, the one which has consumed the least engine time
+// (sched_vtime) gets it next. A newly waiting instance starts from the
+// smallest vtime granted so far, so an idle instance can not monopolize the
+// engine with the credit it has saved.
+//
+
+static DEFINE_SPINLOCK(_sched_lock);
+static DECLARE_WAIT_QUEUE_HEAD(_sched_wq);
+
+static int			_engine_busy = 0;
+static unsigned long long	_min_vtime = 0;
+
+static ktime_t			_run_start;
+
+
+// Returns 1 and takes the engine if ctx is the waiting instance with the
+// smallest sched_vtime. _sched_lock must be held.
+static int MfcSched_PickLocked(MFCInstCtx *ctx)
+{
+	MFCInstCtx	*pInst;
+	int		inst_no;
+
+	if (_engine_busy)
+		return 0;
+
+	for (inst_no = 0; inst_no < MFC_NUM_INSTANCES_MAX; inst_no++) 
+	{
+		pInst = MFCInst_GetCtx(inst_no);
+		if (pInst == NULL || pInst == ctx || !pInst->sched_waiting)
+			continue;
+
+		if (pInst->sched_vtime < ctx->sched_vtime)
+			return 0;
+		// ties are broken by the instance number to keep the order stable
+		if (pInst->sched_vtime == ctx->sched_vtime && pInst->inst_no < ctx->inst_no)
+			return 0;
+	}
+
+	_engine_busy = 1;
+	ctx->sched_waiting = 0;
+	if (ctx->sched_vtime > _min_vtime)
+		_min_vtime = ctx->sched_vtime;
+
+	return 1;
+}
+
+static int MfcSched_MyTurn(MFCInstCtx *ctx)
+{
+	unsigned long	flags;
+	int		ret;
+
+	spin_lock_irqsave(&_sched_lock, flags);
+	ret = MfcSched_PickLocked(ctx);
+	spin_unlock_irqrestore(&_sched_lock, flags);
+
+	return ret;
+}
+
+
+//
+// void MfcSched_Acquire(MFCInstCtx *ctx)
+//
+// Description
+//		This function waits until the engine is granted to the instance,
+//		and then locks the MFC mutex.
+// Parameters
+//		ctx [IN]: MFCInstCtx
+//
+void MfcSched_Acquire(MFCInstCtx *ctx)
+{
+	unsigned long	flags;
+	ktime_t		wait_start;
+	unsigned int	wait_us;
+
+	wait_start = ktime_get();
+
+	spin_lock_irqsave(&_sched_lock, flags);
+	if (ctx->sched_vtime < _min_vtime)
+		ctx->sched_vtime = _min_vtime;
+	ctx->sched_waiting = 1;
+	spin_unlock_irqrestore(&_sched_lock, flags);
+
+	wait_event(_sched_wq, MfcSched_MyTurn(ctx));
+
+	MFC_Mutex_Lock();
+
+	_run_start = ktime_get();
+
+	wait_us = (unsigned int)ktime_to_us(ktime_sub(_run_start, wait_start));
+	ctx->stats.wait_us += wait_us;
+	if (wait_us > ctx->stats.max_wait_us)
+		ctx->stats.max_wait_us = wait_us;
+}
+
+
+//
+// void MfcSched_Release(MFCInstCtx *ctx)
+//
+// Description
+//		This function charges the engine time to the instance,
+//		unlocks the MFC mutex and hands the engine over to the next instance.
+// Parameters
+//		ctx [IN]: MFCInstCtx
+//
+void MfcSched_Release(MFCInstCtx *ctx)
+{
+	unsigned long	flags;
+	ktime_t		elapsed;
+	unsigned int	run_us;
+
+	elapsed = ktime_sub(ktime_get(), _run_start);
+	run_us  = (unsigned int)ktime_to_us(elapsed);
+
+	ctx->stats.frames++;
+	ctx->stats.total_us += run_us;
+	ctx->stats.last_us   = run_us;
+	if (ctx->stats.min_us == 0 || run_us < ctx->stats.min_us)
+		ctx->stats.min_us = run_us;
+	if (run_us > ctx->stats.max_us)
+		ctx->stats.max_us = run_us;
+
+	MFC_Mutex_Release();
+
+	spin_lock_irqsave(&_sched_lock, flags);
+	ctx->sched_vtime += ktime_to_ns(elapsed);
+	_engine_busy = 0;
+	spin_unlock_irqrestore(&_sched_lock, flags);
+
+	wake_up_all(&_sched_wq);
+}
+
+
+//
+// void MfcSched_ResetStats(MFCInstCtx *ctx)
+//
+// Description
+//		This function clears the statistics of a newly created instance.
+// Parameters
+//		ctx [IN]: MFCInstCtx
+//
+void MfcSched_ResetStats(MFCInstCtx *ctx)
+{
+	unsigned long	flags;
+
+	spin_lock_irqsave(&_sched_lock, flags);
+	ctx->sched_vtime   = _min_vtime;
+	ctx->sched_waiting = 0;
+	spin_unlock_irqrestore(&_sched_lock, flags);
+
+	memset(&ctx->stats, 0, sizeof(MFC_INST_STATS));
+}
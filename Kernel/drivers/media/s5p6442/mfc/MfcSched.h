@@ -0,0 +1,32 @@
+/*
+ *  drivers/media/s5p6442/mfc/MfcSched.h
+ *
+ *  Copyright 2010 Samsung Electronics Co.Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef __SAMSUNG_SYSLSI_APDEV_MFC_SCHED_H__
+#define __SAMSUNG_SYSLSI_APDEV_MFC_SCHED_H__
+
+
+#include "MFC_Instance.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+void MfcSched_Acquire(MFCInstCtx *ctx);
+void MfcSched_Release(MFCInstCtx *ctx);
+void MfcSched_ResetStats(MFCInstCtx *ctx);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SAMSUNG_SYSLSI_APDEV_MFC_SCHED_H__ */
@@ -110,6 +110,28 @@ int MFC_SetConfigParams(MFCInstCtx *pMfcInst, MFC_ARGS *args)
 		ret = MFCINST_RET_OK;
 		break;
 
+	// LINE_BUF size for decoding, in bytes.
+	// It must be set before IOCTL_MFC_GET_LINE_BUF_ADDR commits the LINE_BUF.
+	case MFC_SET_CONFIG_DEC_STRM_BUF_SIZE:
+		args->set_config.out_config_value_old[0] = pMfcInst->nStrmBufReq;
+		if (pMfcInst->pStrmBuf != NULL) 
+		{
+			LOG_MSG(LOG_ERROR, "MFC_SetConfigParams", "Stream buffer is already committed.\r\n");
+			ret = MFCINST_ERR_STATE_CHK;
+			break;
+		}
+		if (args->set_config.in_config_value[0] <= 0 
+			|| args->set_config.in_config_value[0] > MFC_LINE_BUF_SIZE_MAX) 
+		{
+			ret = MFCINST_ERR_INVALID_PARAM;
+			break;
+		}
+		pMfcInst->nStrmBufReq = (args->set_config.in_config_value[0] + 0x3FF) & ~0x3FF;
+		if (pMfcInst->nStrmBufReq < MFC_LINE_BUF_SIZE_MIN)
+			pMfcInst->nStrmBufReq = MFC_LINE_BUF_SIZE_MIN;
+		ret = MFCINST_RET_OK;
+		break;
+
 	case MFC_SET_CONFIG_DEC_ROTATE:
 #if (MFC_ROTATE_ENABLE == 1)
 		args->set_config.out_config_value_old[0]
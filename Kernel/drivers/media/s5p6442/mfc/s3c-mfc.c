@@ -43,6 +43,8 @@
 
 #include <linux/mutex.h>
 #include <linux/wait.h>
+#include <linux/proc_fs.h>
+#include <asm/div64.h>
 
 #include <linux/version.h>
 #include <mach/irqs.h>
@@ -64,6 +66,7 @@
 #include "MFC_Inst_Pool.h"
 #include "LogMsg.h"
 #include "MfcMutex.h"
+#include "MfcSched.h"
 #include "s3c-mfc.h"
 #include "FramBufMgr.h"
 #include "MfcMemory.h"
@@ -342,7 +345,6 @@ no_err:
 static int s3c_mfc_release(struct inode *inode, struct file *file)
 {
 	MFC_HANDLE		*handle = NULL;
-	MFCINST_DEC_INBUF_TYPE	inbuf_type;
 	int			ret;
 
 	MFC_Mutex_Lock();
@@ -356,19 +358,8 @@ static int s3c_mfc_release(struct inode *inode, struct file *file)
 	
 	//printk("Exit MFC Linux Driver\n");
 
-	inbuf_type = handle->mfc_inst->inbuf_type;
-	
 	LOG_MSG(LOG_TRACE, "mfc_release", "delete inst no : %d\n", handle->mfc_inst->inst_no);
 
-#if (MFC_LINE_RING_SHARE == 1)
-	// In case of (MFC_LINE_RING_SHARE == 1), all the instances were reserved.
-	// Therefore the instances need to be released.
-	if (inbuf_type == DEC_INBUF_RING_BUF) 
-	{
-		MfcInstPool_ReleaseAll();
-	}
-#endif
-
 	MFCInst_Delete(handle->mfc_inst);
 
 	kfree(handle);
@@ -492,7 +483,7 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file, unsigned
 	case IOCTL_MFC_MPEG4_ENC_EXE:
 	case IOCTL_MFC_H264_ENC_EXE:
 	case IOCTL_MFC_H263_ENC_EXE:
-		MFC_Mutex_Lock();
+		MfcSched_Acquire(pMfcInst);
 
 		Copy_From_User(&args.enc_exe, (MFC_ENC_EXE_ARG *)arg, sizeof(MFC_ENC_EXE_ARG));
 
@@ -514,8 +505,8 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file, unsigned
 		ret = MFCInst_Encode(pMfcInst, &nStrmLen, &nHdrLen, &nHdr0Len, &nHdr1Len, &nHdr2Len);
 		
 		// from 2.8.5
-		//dmac_clean_range(pMfcInst->pStrmBuf, pMfcInst->pStrmBuf + MFC_LINE_BUF_SIZE_PER_INSTANCE);
-		//outer_clean_range(__pa(pMfcInst->pStrmBuf), __pa(pMfcInst->pStrmBuf + MFC_LINE_BUF_SIZE_PER_INSTANCE));
+		//dmac_clean_range(pMfcInst->pStrmBuf, pMfcInst->pStrmBuf + pMfcInst->nStrmBufSize);
+		//outer_clean_range(__pa(pMfcInst->pStrmBuf), __pa(pMfcInst->pStrmBuf + pMfcInst->nStrmBufSize));
 		
 		args.enc_exe.ret_code	= ret;
 		if (ret == MFCINST_RET_OK) {
@@ -530,9 +521,9 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file, unsigned
 		Copy_To_User((MFC_ENC_EXE_ARG *)arg, &args.enc_exe, sizeof(MFC_ENC_EXE_ARG));
 		
 		// added by RainAde for cache coherency
-		cpu_cache.dma_inv_range(pMfcInst->pStrmBuf, pMfcInst->pStrmBuf + MFC_LINE_BUF_SIZE_PER_INSTANCE);
+		cpu_cache.dma_inv_range(pMfcInst->pStrmBuf, pMfcInst->pStrmBuf + pMfcInst->nStrmBufSize);
 		
-		MFC_Mutex_Release();
+		MfcSched_Release(pMfcInst);
 		break;
 		
 	case IOCTL_MFC_MPEG4_DEC_INIT:
@@ -577,13 +568,13 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file, unsigned
 	case IOCTL_MFC_H264_DEC_EXE:
 	case IOCTL_MFC_H263_DEC_EXE:
 	case IOCTL_MFC_VC1_DEC_EXE:
-		MFC_Mutex_Lock();
+		MfcSched_Acquire(pMfcInst);
 
 		Copy_From_User(&args.dec_exe, (MFC_DEC_EXE_ARG *)arg, sizeof(MFC_DEC_EXE_ARG));
 
 		// from 2.8.5
-		//dmac_clean_range(pMfcInst->pStrmBuf, pMfcInst->pStrmBuf + MFC_LINE_BUF_SIZE_PER_INSTANCE);
-		//outer_clean_range(__pa(pMfcInst->pStrmBuf), __pa(pMfcInst->pStrmBuf + MFC_LINE_BUF_SIZE_PER_INSTANCE));
+		//dmac_clean_range(pMfcInst->pStrmBuf, pMfcInst->pStrmBuf + pMfcInst->nStrmBufSize);
+		//outer_clean_range(__pa(pMfcInst->pStrmBuf), __pa(pMfcInst->pStrmBuf + pMfcInst->nStrmBufSize));
 		// from 2.8.5 : cache flush
 		cpu_cache.flush_kern_all();
 		
@@ -598,7 +589,7 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file, unsigned
 		else 
 		{
 			LOG_MSG(LOG_ERROR, "s3c_mfc_ioctl", "Buffer type is not defined.\n");
-			MFC_Mutex_Release();
+			MfcSched_Release(pMfcInst);
 			args.dec_exe.ret_code = -1;
 			return -EINVAL;
 		}
@@ -610,7 +601,7 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file, unsigned
 		tmp = (pMfcInst->width * pMfcInst->height * 3) >> 1;
 		cpu_cache.dma_inv_range(pMfcInst->pFramBuf, pMfcInst->pFramBuf + tmp);
 
-		MFC_Mutex_Release();
+		MfcSched_Release(pMfcInst);
 		break;
 		
 	case IOCTL_MFC_GET_RING_BUF_ADDR:
@@ -755,12 +746,12 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file, unsigned
 		args.mpeg4_asp_param.mp4asp_nonb_time_last = pMfcInst->RET_DEC_PIC_RUN_BAK_MP4ASP_NONB_TIME_LAST;
 		args.mpeg4_asp_param.mp4asp_trd            = pMfcInst->RET_DEC_PIC_RUN_BAK_MP4ASP_MP4ASP_TRD;
 		
-		args.mpeg4_asp_param.mv_addr      = (args.mpeg4_asp_param.in_usr_mapped_addr + MFC_STRM_BUF_SIZE) + (pMfcInst->mv_mbyte_addr - pMfcInst->phyadrFramBuf);
+		args.mpeg4_asp_param.mv_addr      = args.mpeg4_asp_param.in_usr_mapped_addr + (pMfcInst->mv_mbyte_addr - GetDataBufPhyAddr());
 		args.mpeg4_asp_param.mb_type_addr = args.mpeg4_asp_param.mv_addr + 25920;	
 		args.mpeg4_asp_param.mv_size      = 25920;
 		args.mpeg4_asp_param.mb_type_size = 1620;
 	
-		vir_mv_addr = (unsigned int)((pMfcInst->pStrmBuf + MFC_STRM_BUF_SIZE) + (pMfcInst->mv_mbyte_addr - pMfcInst->phyadrFramBuf));
+		vir_mv_addr = (unsigned int)(GetDataBufVirAddr() + (pMfcInst->mv_mbyte_addr - GetDataBufPhyAddr()));
 		vir_mb_type_addr = vir_mv_addr + 25920;
 
 		Copy_To_User((MFC_GET_MPEG4ASP_ARG *)arg, &args.mpeg4_asp_param, sizeof(MFC_GET_MPEG4ASP_ARG));
@@ -858,6 +849,56 @@ int s3c_mfc_mmap(struct file *filp, struct vm_area_struct *vma)
 }
 
 
+#ifdef CONFIG_PROC_FS
+/*
+ * /proc/driver/s3c-mfc
+ * DATA_POOL usage and the per-instance engine time statistics.
+ */
+static int s3c_mfc_read_proc(char *page, char **start, off_t off,
+		int count, int *eof, void *data)
+{
+	MFCInstCtx		*pMfcInst;
+	int			inst_no;
+	int			len = 0;
+	unsigned long long	avg_us, avg_wait_us;
+
+	MFC_Mutex_Lock();
+
+	len += sprintf(page + len, "pool: %d KB free of %d KB\n",
+			FramBufMgrGetFreeSize() >> 10, MFC_DATA_POOL_SIZE >> 10);
+	len += sprintf(page + len, "inst codec  state   strm_kb fram_kb  frames  avg_us  min_us  max_us last_us wait_us maxwait\n");
+
+	for (inst_no = 0; inst_no < MFC_NUM_INSTANCES_MAX; inst_no++) 
+	{
+		pMfcInst = MFCInst_GetCtx(inst_no);
+		if (pMfcInst == NULL)
+			continue;
+
+		avg_us = pMfcInst->stats.total_us;
+		avg_wait_us = pMfcInst->stats.wait_us;
+		if (pMfcInst->stats.frames) 
+		{
+			do_div(avg_us, pMfcInst->stats.frames);
+			do_div(avg_wait_us, pMfcInst->stats.frames);
+		}
+
+		len += sprintf(page + len, "%4d %5d %#7x %7d %7d %7u %7llu %7u %7u %7u %7llu %7u\n",
+				inst_no, pMfcInst->codec_mode, pMfcInst->state_var,
+				pMfcInst->pStrmBuf ? pMfcInst->nStrmBufSize >> 10 : 0,
+				pMfcInst->pFramBuf ? pMfcInst->nFramBufSize >> 10 : 0,
+				pMfcInst->stats.frames, avg_us,
+				pMfcInst->stats.min_us, pMfcInst->stats.max_us, pMfcInst->stats.last_us,
+				avg_wait_us, pMfcInst->stats.max_wait_us);
+	}
+
+	MFC_Mutex_Release();
+
+	*eof = 1;
+	return len;
+}
+#endif /* CONFIG_PROC_FS */
+
+
 static struct file_operations s3c_mfc_fops = {
 			owner:		THIS_MODULE,
 			open:		s3c_mfc_open,
@@ -998,6 +1039,10 @@ static int s3c_mfc_probe(struct platform_device *pdev)
 	if (ret < 0)
 		goto err_misc_register;
 
+#ifdef CONFIG_PROC_FS
+	create_proc_read_entry("driver/s3c-mfc", 0, NULL, s3c_mfc_read_proc, NULL);
+#endif
+
 	ret = 0;
 	goto no_err;
 
@@ -1025,6 +1070,9 @@ no_err:
 
 static int s3c_mfc_remove(struct platform_device *pdev)
 {
+#ifdef CONFIG_PROC_FS
+	remove_proc_entry("driver/s3c-mfc", NULL);
+#endif
 	misc_deregister(&s3c_mfc_miscdev);
 	MFC_Mutex_Delete ();
 	free_irq (IRQ_MFC, pdev);
@@ -15,6 +15,7 @@
 #include <linux/mmc/mmc.h>
 
 #include <linux/scatterlist.h>
+#include <linux/time.h>
 
 #define RESULT_OK		0
 #define RESULT_FAIL		1
@@ -24,6 +25,8 @@
 #define BUFFER_ORDER		2
 #define BUFFER_SIZE		(PAGE_SIZE << BUFFER_ORDER)
 
+#define THROUGHPUT_BYTES	(4 * 1024 * 1024)
+
 struct mmc_test_card {
 	struct mmc_card	*card;
 
@@ -891,6 +894,93 @@ static int mmc_test_multi_read_high(struct mmc_test_card *test)
 
 #endif /* CONFIG_HIGHMEM */
 
+/*
+ * Time THROUGHPUT_BYTES worth of sequential transfers, each as large as
+ * the host will take in one request
+ */
+static int mmc_test_throughput(struct mmc_test_card *test, int write)
+{
+	struct mmc_host *host = test->card->host;
+	struct scatterlist *sg;
+	struct page *pages;
+	struct timespec ts1, ts2;
+	unsigned int size, segs, order, count, sector, i;
+	u64 usecs, rate;
+	int ret;
+
+	if (host->max_blk_count == 1)
+		return RESULT_UNSUP_HOST;
+
+	segs = min(host->max_hw_segs, host->max_phys_segs);
+	size = min(host->max_req_size, host->max_blk_count * 512);
+	size = min(size, host->max_seg_size * segs);
+
+	order = get_order(size);
+	while (!(pages = alloc_pages(GFP_KERNEL | __GFP_NOWARN, order))) {
+		if (!order)
+			return -ENOMEM;
+		order--;
+	}
+	size = min_t(unsigned int, size, PAGE_SIZE << order) & ~511;
+	segs = DIV_ROUND_UP(size, host->max_seg_size);
+
+	sg = kcalloc(segs, sizeof(struct scatterlist), GFP_KERNEL);
+	if (!sg) {
+		ret = -ENOMEM;
+		goto out_free_pages;
+	}
+
+	sg_init_table(sg, segs);
+	for (i = 0; i < segs; i++) {
+		unsigned int off = i * host->max_seg_size;
+
+		sg_set_page(&sg[i], pages + (off >> PAGE_SHIFT),
+			min(size - off, host->max_seg_size), 0);
+	}
+
+	ret = mmc_test_set_blksize(test, 512);
+	if (ret)
+		goto out_free_sg;
+
+	count = max_t(unsigned int, THROUGHPUT_BYTES / size, 1);
+
+	getnstimeofday(&ts1);
+	for (i = 0, sector = 0; i < count; i++, sector += size / 512) {
+		ret = mmc_test_simple_transfer(test, sg, segs,
+			mmc_card_blockaddr(test->card) ? sector : sector << 9,
+			size / 512, 512, write);
+		if (ret)
+			goto out_free_sg;
+	}
+	getnstimeofday(&ts2);
+
+	usecs = div_u64(timespec_to_ns(&ts2) - timespec_to_ns(&ts1),
+		NSEC_PER_USEC);
+	rate = div64_u64((u64)count * size * USEC_PER_SEC, usecs ? usecs : 1);
+
+	printk(KERN_INFO "%s: %s %u x %u bytes (%u segs) in %llu us, "
+		"%llu kB/s\n", mmc_hostname(host), write ? "Wrote" : "Read",
+		count, size, segs, (unsigned long long)usecs,
+		(unsigned long long)rate >> 10);
+
+out_free_sg:
+	kfree(sg);
+out_free_pages:
+	__free_pages(pages, order);
+
+	return ret;
+}
+
+static int mmc_test_throughput_write(struct mmc_test_card *test)
+{
+	return mmc_test_throughput(test, 1);
+}
+
+static int mmc_test_throughput_read(struct mmc_test_card *test)
+{
+	return mmc_test_throughput(test, 0);
+}
+
 static const struct mmc_test_case mmc_test_cases[] = {
 	{
 		.name = "Basic write (no data verification)",
@@ -1038,6 +1128,16 @@ static const struct mmc_test_case mmc_test_cases[] = {
 
 #endif /* CONFIG_HIGHMEM */
 
+	{
+		.name = "Sequential write throughput",
+		.run = mmc_test_throughput_write,
+	},
+
+	{
+		.name = "Sequential read throughput",
+		.run = mmc_test_throughput_read,
+	},
+
 };
 
 static DEFINE_MUTEX(mmc_test_lock);
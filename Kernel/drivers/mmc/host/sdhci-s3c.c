@@ -391,11 +391,11 @@ static int __devinit sdhci_s3c_probe(struct platform_device *pdev)
 
 #ifndef CONFIG_MMC_SDHCI_S3C_DMA
 
-	/* we currently see overruns on errors, so disable the SDMA
-	 * support as well. */
+	/* PIO only: keep the SDMA/ADMA engines off, and stay on single
+	 * blocks as PIO currently has problems with multi-block IO. With
+	 * DMA, errors are recovered by the data reset in sdhci_finish_data()
+	 * before the buffers are unmapped, so neither quirk is needed. */
 	host->quirks |= SDHCI_QUIRK_BROKEN_DMA;
-
-	/* PIO currently has problems with multi-block IO */
 	host->quirks |= SDHCI_QUIRK_NO_MULTIBLOCK;
 
 #endif /* CONFIG_MMC_SDHCI_S3C_DMA */
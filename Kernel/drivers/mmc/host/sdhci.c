@@ -868,6 +868,15 @@ static void sdhci_finish_data(struct sdhci_host *host)
 	data = host->data;
 	host->data = NULL;
 
+	/*
+	 * The controller needs a reset of its data state machine upon
+	 * error conditions. With DMA the engine may also still be running
+	 * and overrun the buffers we are about to hand back to the CPU,
+	 * so do it before unmapping.
+	 */
+	if (data->error)
+		sdhci_reset(host, SDHCI_RESET_DATA);
+
 	if (host->flags & SDHCI_REQ_USE_DMA) {
 		if (host->flags & SDHCI_USE_ADMA)
 			sdhci_adma_table_post(host, data);
@@ -892,13 +901,11 @@ static void sdhci_finish_data(struct sdhci_host *host)
 
 	if (data->stop) {
 		/*
-		 * The controller needs a reset of internal state machines
-		 * upon error conditions.
+		 * The command line needs a reset as well before the stop
+		 * command; the data line was reset above.
 		 */
-		if (data->error) {
+		if (data->error)
 			sdhci_reset(host, SDHCI_RESET_CMD);
-			sdhci_reset(host, SDHCI_RESET_DATA);
-		}
 
 		sdhci_send_command(host, data->stop);
 	} else
@@ -23,6 +23,7 @@
 #include <linux/platform_device.h>
 #include <linux/timer.h>
 #include <linux/jiffies.h>
+#include <linux/time.h>
 #include <linux/irq.h>
 #include <linux/wakelock.h>
 #include <linux/i2c/max8998.h>
@@ -94,6 +95,9 @@ void set_start_check_temp_adc_for_tsp() {start_noti_to_tsp=1;}
 #define ADC_DATA_ARR_SIZE	6
 #define ADC_TOTAL_COUNT		100 //
 #define POLLING_INTERVAL	4000 // 4000
+#define POLLING_INTERVAL_MAX	32000	/* discharging, nothing changing */
+#define POLLING_TEMP_DELTA	10	/* 1 degree C */
+#define POLLING_LOW_LEVEL	15	/* keep polling fast near power off */
 
 #ifdef __BATTERY_COMPENSATION__
 /* Offset Bit Value */
@@ -124,6 +128,15 @@ static struct timer_list cable_timer;
 static int cable_intr_cnt = 0;
 static int has_temp_adc_channel = 0;
 static int resume_from_sleep = 0;
+static unsigned long last_sample_sec;
+
+/* why the battery driver ran or kept the system awake */
+static struct {
+	unsigned int timer;	/* polling timer expired */
+	unsigned int irq;	/* charger or VBUS event */
+	unsigned int resume;	/* sample due when the system resumed */
+	unsigned int wake_lock;	/* wake locks taken */
+} bat_wakeups;
 extern int cable_status;
 extern int get_vdcin_status(void);
 
@@ -575,6 +588,7 @@ void set_low_batt_flag(void)
 
 	// Wait for 2 seconds
 	wake_lock_timeout(&wake_lock_for_off, 2 * HZ);
+	bat_wakeups.wake_lock++;
 }
 EXPORT_SYMBOL(set_low_batt_flag);
 
@@ -1132,6 +1146,7 @@ static struct device_attribute s3c_battery_attrs[] = {
 	SEC_BATTERY_ATTR(batt_chg_current),
 #endif /* __CHECK_CHG_CURRENT__ */
 	SEC_BATTERY_ATTR(charging_source),
+	SEC_BATTERY_ATTR(batt_wakeups),
 #ifdef __BATTERY_COMPENSATION__
 	SEC_BATTERY_ATTR(vibrator),
 	SEC_BATTERY_ATTR(camera),
@@ -1171,6 +1186,7 @@ enum {
 	BATT_CHG_CURRENT,
 #endif /* __CHECK_CHG_CURRENT__ */
 	BATT_CHARGING_SOURCE,
+	BATT_WAKEUPS,
 #ifdef __BATTERY_COMPENSATION__
 	BATT_VIBRATOR,
 	BATT_CAMERA,
@@ -1291,6 +1307,13 @@ static ssize_t s3c_bat_show_property(struct device *dev,
 		i += scnprintf(buf + i, PAGE_SIZE - i, "%d\n",
 			s3c_bat_info.bat_info.charging_source);
 		break;
+	case BATT_WAKEUPS:
+		i += scnprintf(buf + i, PAGE_SIZE - i,
+			"timer %u\nirq %u\nresume %u\nwake_lock %u\n"
+			"interval_ms %u\n", bat_wakeups.timer,
+			bat_wakeups.irq, bat_wakeups.resume,
+			bat_wakeups.wake_lock, s3c_bat_info.polling_interval);
+		break;
 #ifdef __BATTERY_COMPENSATION__
 	case BATT_DEV_STATE:
 		i += scnprintf(buf + i, PAGE_SIZE - i, "0x%08x\n",
@@ -1756,6 +1779,7 @@ static int s3c_cable_status_update(int status)
 {
 	int ret = 0;
 	charger_type_t source = CHARGER_BATTERY;
+	charger_type_t old_source = s3c_bat_info.bat_info.charging_source;
 
 	dev_dbg(dev, "%s\n", __func__);
 
@@ -1785,6 +1809,14 @@ static int s3c_cable_status_update(int status)
 	}
 	source = s3c_bat_info.bat_info.charging_source;
 
+	/*
+	 * This runs on every resume as well: only hold the system up and
+	 * notify userspace when the source really changed.
+	 */
+	if (source == old_source)
+		return ret;
+	bat_wakeups.wake_lock++;
+
 	if (source == CHARGER_USB || source == CHARGER_AC) {
 		wake_lock(&vbus_wake_lock);
 	}
@@ -1803,6 +1835,42 @@ static int s3c_cable_status_update(int status)
 }
 
 
+/*
+ * Poll every POLLING_INTERVAL while charging, near power off, or while
+ * level or temperature move; back off up to POLLING_INTERVAL_MAX while
+ * they stay put.
+ */
+static void s3c_bat_adapt_interval(int old_level, int old_temp)
+{
+	struct battery_info *bi = &s3c_bat_info.bat_info;
+	unsigned int interval = s3c_bat_info.polling_interval;
+
+#ifdef __TEST_MODE_INTERFACE__
+	if (bi->batt_test_mode)
+		return;
+#endif /* __TEST_MODE_INTERFACE__ */
+
+	if (bi->charging_enabled || bi->level != old_level ||
+	    abs(bi->batt_temp - old_temp) >= POLLING_TEMP_DELTA ||
+	    bi->level <= POLLING_LOW_LEVEL)
+		interval = POLLING_INTERVAL;
+	else
+		interval = min(interval * 2, (unsigned int)POLLING_INTERVAL_MAX);
+
+	s3c_bat_info.polling_interval = interval;
+}
+
+/* a charger or VBUS event: sample at the fast rate again */
+static void s3c_bat_event(void)
+{
+	bat_wakeups.irq++;
+#ifdef __TEST_MODE_INTERFACE__
+	if (s3c_bat_info.bat_info.batt_test_mode)
+		return;
+#endif /* __TEST_MODE_INTERFACE__ */
+	s3c_bat_info.polling_interval = POLLING_INTERVAL;
+}
+
 static void s3c_bat_status_update(struct power_supply *bat_ps)
 {
 	int old_level, old_temp, old_is_full;
@@ -1861,6 +1929,9 @@ static void s3c_bat_status_update(struct power_supply *bat_ps)
 	if(battery_cal_updated)
 		battery_cal_updated = 0;
 
+	s3c_bat_adapt_interval(old_level, old_temp);
+	last_sample_sec = get_seconds();
+
 	mutex_unlock(&work_lock);
 	dev_dbg(dev, "%s --\n", __func__);
 }
@@ -1957,6 +2028,11 @@ static void s3c_bat_work(struct work_struct *work)
 	dev_dbg(dev, "%s\n", __func__);
 
 	s3c_bat_status_update(&s3c_power_supplies[CHARGER_BATTERY]);
+
+	/* the interval may have changed: count it from this sample */
+	if (s3c_bat_info.polling)
+		mod_timer(&polling_timer,
+			  jiffies + msecs_to_jiffies(s3c_bat_info.polling_interval));
 }
 
 /*
@@ -1969,8 +2045,14 @@ static void s3c_cable_work(struct work_struct *work)
 
 void s3c_cable_work(struct work_struct *work)
 {
+	charger_type_t old_source = s3c_bat_info.bat_info.charging_source;
+
 	printk("%s OK!\n", __func__);
 	s3c_cable_check_status();
+
+	/* charger came or went: sample now rather than at the next poll */
+	if (s3c_bat_info.bat_info.charging_source != old_source)
+		schedule_work(&bat_work);
 }
 EXPORT_SYMBOL(s3c_cable_work);
 
@@ -2008,12 +2090,20 @@ static int s3c_bat_resume(struct platform_device *pdev)
 
 	resume_from_sleep = 1;  // set flag
 
-	schedule_work(&bat_work);
-	schedule_work(&cable_work);
-
-	if (s3c_bat_info.polling)
+	/*
+	 * Jiffies do not advance in suspend, so judge from the wall clock
+	 * whether a sample is due; otherwise just restart the poll.
+	 */
+	if (get_seconds() - last_sample_sec >=
+			s3c_bat_info.polling_interval / MSEC_PER_SEC) {
+		bat_wakeups.resume++;
+		schedule_work(&bat_work);
+	} else if (s3c_bat_info.polling) {
 		mod_timer(&polling_timer,
 			  jiffies + msecs_to_jiffies(s3c_bat_info.polling_interval));
+	}
+	schedule_work(&cable_work);
+
 	return 0;
 }
 #else
@@ -2022,13 +2112,14 @@ static int s3c_bat_resume(struct platform_device *pdev)
 #endif /* CONFIG_PM */
 
 
+/* deferrable: only runs when the CPU is awake for something else */
 static void polling_timer_func(unsigned long unused)
 {
 	dev_dbg(dev, "%s\n", __func__);
-	schedule_work(&bat_work);
+	bat_wakeups.timer++;
 
-	mod_timer(&polling_timer,
-		  jiffies + msecs_to_jiffies(s3c_bat_info.polling_interval));
+	/* s3c_bat_work() re-arms the timer */
+	schedule_work(&bat_work);
 }
 
 
@@ -2055,13 +2146,8 @@ void cable_status_changed(void)
 	cable_timer.expires = jiffies + msecs_to_jiffies(50);
 	add_timer(&cable_timer);
 
-	/*
-	 * Wait a bit before reading ac/usb line status and setting charger,
-	 * because ac/usb status readings may lag from irq.
-	 */
-	if (s3c_bat_info.polling)
-		mod_timer(&polling_timer,
-			  jiffies + msecs_to_jiffies(s3c_bat_info.polling_interval));
+	/* charge state is changing: poll at the fast rate again */
+	s3c_bat_event();
 
 	return ;
 }
@@ -2081,13 +2167,8 @@ void charging_status_changed(void)
 	}
 
 	schedule_work(&bat_work);
-	/*
-	 * Wait a bit before reading ac/usb line status and setting charger,
-	 * because ac/usb status readings may lag from irq.
-	 */
-	if (s3c_bat_info.polling)
-		mod_timer(&polling_timer,
-			  jiffies + msecs_to_jiffies(s3c_bat_info.polling_interval));
+	/* charge state is changing: poll at the fast rate again */
+	s3c_bat_event();
 
 	return ;
 }
@@ -2111,13 +2192,8 @@ static irqreturn_t s3c_cable_changed_isr(int irq, void *power_supply)
 	cable_timer.expires = jiffies + msecs_to_jiffies(50);
 	add_timer(&cable_timer);
 
-	/*
-	 * Wait a bit before reading ac/usb line status and setting charger,
-	 * because ac/usb status readings may lag from irq.
-	 */
-	if (s3c_bat_info.polling)
-		mod_timer(&polling_timer,
-			  jiffies + msecs_to_jiffies(s3c_bat_info.polling_interval));
+	/* charge state is changing: poll at the fast rate again */
+	s3c_bat_event();
 
 	return IRQ_HANDLED;
 }
@@ -2140,13 +2216,8 @@ static irqreturn_t s3c_cable_charging_isr(int irq, void *power_supply)
 	}
 
 	schedule_work(&bat_work);
-	/*
-	 * Wait a bit before reading ac/usb line status and setting charger,
-	 * because ac/usb status readings may lag from irq.
-	 */
-	if (s3c_bat_info.polling)
-		mod_timer(&polling_timer,
-			  jiffies + msecs_to_jiffies(s3c_bat_info.polling_interval));
+	/* charge state is changing: poll at the fast rate again */
+	s3c_bat_event();
 
 	return IRQ_HANDLED;
 }
@@ -2256,7 +2327,9 @@ static int __devinit s3c_bat_probe(struct platform_device *pdev)
 	if (s3c_bat_info.polling) {
 		dev_dbg(dev, "%s: will poll for status\n",
 				__func__);
-		setup_timer(&polling_timer, polling_timer_func, 0);
+		init_timer_deferrable(&polling_timer);
+		polling_timer.function = polling_timer_func;
+		polling_timer.data = 0;
 		mod_timer(&polling_timer,
 			  jiffies + msecs_to_jiffies(s3c_bat_info.polling_interval));
 	}
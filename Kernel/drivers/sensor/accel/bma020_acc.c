@@ -14,6 +14,7 @@
 #include <linux/interrupt.h>
 #include <linux/wakelock.h>
 #include <linux/input.h>
+#include <linux/sensor_batch.h>
 
 #include "bma020_acc.h"
 
@@ -89,6 +90,13 @@ static int bma020_proc_read(char *page, char **start, off_t off, int count, int
 
 struct class *acc_class;
 
+/* BMA020 has no FIFO of its own: batch the polled samples in the kernel */
+static struct sensor_batch bma020_batch = {
+	.name		= "bma020-accel",
+	.fifo_size	= 128,
+	.nvalues	= 3,
+};
+
 /* no use */
 //static int bma020_irq_num = NO_IRQ;
 
@@ -452,9 +460,16 @@ static struct attribute_group acc_attribute_group = {
 static void bma_work_func_acc(struct work_struct *work)
 {
 	bma020acc_t acc;
+	s32 values[3];
 	int err;
 		
 	err = bma020_read_accel_xyz(&acc);
+
+	values[0] = acc.x;
+	values[1] = acc.y;
+	values[2] = acc.z;
+	if (sensor_batch_push(&bma020_batch, values))
+		return;
 	
 	input_report_abs(bma020.acc_input_dev, ABS_X, acc.x);
 	input_report_abs(bma020.acc_input_dev, ABS_Y, acc.y);
@@ -598,6 +613,9 @@ int bma020_acc_start(void)
 
 	bma020_set_mode(BMA020_MODE_SLEEP);
 	gprintk("[BMA020] set_mode BMA020_MODE_SLEEP\n");
+
+	if (sensor_batch_register(&bma020_batch))
+		printk("[BMA020] sensor batching not available\n");
 	
 	return 0;
 error_device:
@@ -614,6 +632,7 @@ exit:
 
 void bma020_acc_end(void)
 {
+	sensor_batch_unregister(&bma020_batch);
 	unregister_chrdev( ACC_DEV_MAJOR, ACC_DEV_NAME);	
 	i2c_acc_bma020_exit();
 	device_destroy( acc_class, MKDEV(ACC_DEV_MAJOR, 0) );
@@ -22,6 +22,7 @@
 #include <linux/input.h>
 #include <linux/workqueue.h>
 #include <linux/freezer.h>
+#include <linux/sensor_batch.h>
 #include "ak8973b.h"
 
 
@@ -36,6 +37,8 @@ struct ak8973b_data {
 	struct i2c_client		*client;
 	struct input_dev *input_dev;
 	struct early_suspend	early_suspend;
+	struct sensor_batch	orientation_batch;
+	struct sensor_batch	magnetic_batch;
 };
 
 static DECLARE_WAIT_QUEUE_HEAD(open_wq);
@@ -166,10 +169,14 @@ static void AKECS_Report_Value(short *rbuf)
 	/*if flag is set, execute report */
 	/* Report magnetic sensor information */
 	if (atomic_read(&m_flag)) {
-		input_report_abs(data->input_dev, ABS_RX, rbuf[0]);
-		input_report_abs(data->input_dev, ABS_RY, rbuf[1]);
-		input_report_abs(data->input_dev, ABS_RZ, rbuf[2]);
-		input_report_abs(data->input_dev, ABS_RUDDER, rbuf[4]);
+		s32 ypr[4] = { rbuf[0], rbuf[1], rbuf[2], rbuf[4] };
+
+		if (!sensor_batch_push(&data->orientation_batch, ypr)) {
+			input_report_abs(data->input_dev, ABS_RX, rbuf[0]);
+			input_report_abs(data->input_dev, ABS_RY, rbuf[1]);
+			input_report_abs(data->input_dev, ABS_RZ, rbuf[2]);
+			input_report_abs(data->input_dev, ABS_RUDDER, rbuf[4]);
+		}
 	}
 
 	/* Report acceleration sensor information */
@@ -186,9 +193,13 @@ static void AKECS_Report_Value(short *rbuf)
 	}
 
 	if (atomic_read(&mv_flag)) {
-		input_report_abs(data->input_dev, ABS_HAT0X, rbuf[9]);
-		input_report_abs(data->input_dev, ABS_HAT0Y, rbuf[10]);
-		input_report_abs(data->input_dev, ABS_BRAKE, rbuf[11]);
+		s32 mag[3] = { rbuf[9], rbuf[10], rbuf[11] };
+
+		if (!sensor_batch_push(&data->magnetic_batch, mag)) {
+			input_report_abs(data->input_dev, ABS_HAT0X, rbuf[9]);
+			input_report_abs(data->input_dev, ABS_HAT0Y, rbuf[10]);
+			input_report_abs(data->input_dev, ABS_BRAKE, rbuf[11]);
+		}
 	}
 	
 	/* Report proximity information */
@@ -901,6 +912,15 @@ static int ak8973_probe(struct i2c_client *client,
 
 	AKECS_GetEEPROMData();
 
+	/* akmd reports at its own rate; batch yaw/pitch/roll/status and raw field */
+	akm->orientation_batch.name = "ak8973b-orientation";
+	akm->orientation_batch.nvalues = 4;
+	akm->magnetic_batch.name = "ak8973b-magnetic";
+	akm->magnetic_batch.nvalues = 3;
+	if (sensor_batch_register(&akm->orientation_batch) ||
+	    sensor_batch_register(&akm->magnetic_batch))
+		printk(KERN_WARNING "ak8973b: sensor batching not available\n");
+
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	akm->early_suspend.suspend = ak8973b_early_suspend;
 	akm->early_suspend.resume = ak8973b_early_resume;
@@ -927,6 +947,8 @@ static int __exit ak8973_remove(struct i2c_client *client)
 
 	printk("[%s] ak8973 removed...\n",__func__);
 	
+	sensor_batch_unregister(&akm->magnetic_batch);
+	sensor_batch_unregister(&akm->orientation_batch);
 	input_unregister_device(akm->input_dev);
 
 	misc_deregister(&akm_aot_device);
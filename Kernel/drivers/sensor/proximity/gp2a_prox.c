@@ -19,6 +19,7 @@
 #include <plat/gpio-cfg.h>
 #include <linux/i2c/pmic.h>
 #include <linux/wakelock.h>
+#include <linux/sensor_batch.h>
  
 #include "gp2a_prox.h"
 #include "prox_ioctls.h"
@@ -30,6 +31,14 @@ static struct file_operations gp2a_prox_fops = {
     .release 	= gp2a_prox_release,    
 };
 
+/* Proximity drives the screen during calls: never hold its samples back */
+static struct sensor_batch gp2a_batch = {
+	.name		= "gp2a-proximity",
+	.flags		= SENSOR_BATCH_F_WAKEUP,
+	.fifo_size	= 16,
+	.nvalues	= 1,
+};
+
 static struct miscdevice gp2a_prox_misc_device = {
     .minor  = MISC_DYNAMIC_MINOR,
     .name   = "proximity",
@@ -245,10 +254,14 @@ static void gp2a_chip_init(void)
 
 static void gp2a_prox_work_func(struct work_struct *work)
 {	
+	s32 value = gpio_get_value(GPIO_PS_OUT);
+
 	debug("Reporting to the input events");
-	debug("gpio_get_value of GPIO_PS_OUT is %d",gpio_get_value(GPIO_PS_OUT));   //test			
-	input_report_abs(gp2a_data->prox_input_dev,ABS_DISTANCE,gpio_get_value(GPIO_PS_OUT));
-	input_sync(gp2a_data->prox_input_dev);
+	debug("gpio_get_value of GPIO_PS_OUT is %d",value);   //test			
+	if (!sensor_batch_push(&gp2a_batch, &value)) {
+		input_report_abs(gp2a_data->prox_input_dev,ABS_DISTANCE,value);
+		input_sync(gp2a_data->prox_input_dev);
+	}
 	mdelay(1);
 	
 /* Reporting the value to a function in magnetic compass driver 
@@ -434,6 +447,9 @@ static int gp2a_prox_probe(struct i2c_client *client,const struct i2c_device_id
 	/*Setting the device into shutdown mode*/
 	gp2a_prox_mode(1);
 
+	if (sensor_batch_register(&gp2a_batch))
+		error("sensor batching not available");
+
 	printk("------ %s end\n", __func__);	
 	return ret;
 
@@ -454,6 +470,7 @@ static int __devexit gp2a_prox_remove(struct i2c_client *client)
 {	
   	debug("%s called",__func__); 
 	gp2a_prox_mode(0);
+	sensor_batch_unregister(&gp2a_batch);
 	gp2a_data->gp2a_prox_i2c_client = NULL;
 	free_irq(PROX_IRQ,NULL);
 	sysfs_remove_group(&client->dev.kobj, &gp2a_prox_attr_group);
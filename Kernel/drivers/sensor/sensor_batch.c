@@ -0,0 +1,420 @@
+/*
+ * drivers/sensor/sensor_batch.c - Sensor sample batching core
+ *
+ * Every registered sensor owns a FIFO of timestamped samples.  Once the
+ * sensor service has opened /dev/sensor_batch and enabled a sensor, the
+ * driver's samples go to the FIFO instead of its input device, and read()
+ * returns the queued samples of all sensors merged in timestamp order.
+ *
+ * With a maximum latency set, blocking readers are only woken when the
+ * oldest queued sample reaches that age, when a FIFO is three quarters
+ * full, or when a SENSOR_BATCH_F_WAKEUP sensor (proximity) reports.
+ * Samples are never held back with a latency of zero.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/fs.h>
+#include <linux/init.h>
+#include <linux/jiffies.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/miscdevice.h>
+#include <linux/module.h>
+#include <linux/poll.h>
+#include <linux/sched.h>
+#include <linux/sensor_batch.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/timer.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+
+#define BATCH_DEFAULT_FIFO	64
+#define BATCH_MAX_FIFO		1024
+#define BATCH_READ_CHUNK	8	/* samples copied per lock hold */
+
+static struct sensor_batch *batch_sensors[SENSOR_BATCH_MAX_SENSORS];
+static DEFINE_SPINLOCK(batch_lock);
+static DECLARE_WAIT_QUEUE_HEAD(batch_wait);
+
+static unsigned int batch_users;	/* opens of /dev/sensor_batch */
+static unsigned int batch_latency_ms;
+static unsigned int batch_queued;	/* samples in all FIFOs */
+static bool batch_ready;		/* readers may consume */
+
+static void batch_flush_timeout(unsigned long data);
+static DEFINE_TIMER(batch_timer, batch_flush_timeout, 0, 0);
+
+static inline unsigned int batch_count(struct sensor_batch *sb)
+{
+	return sb->head - sb->tail;
+}
+
+static void batch_discard_locked(struct sensor_batch *sb)
+{
+	batch_queued -= batch_count(sb);
+	sb->tail = sb->head;
+}
+
+static void batch_flush_timeout(unsigned long data)
+{
+	unsigned long flags;
+	bool wake = false;
+
+	spin_lock_irqsave(&batch_lock, flags);
+	if (batch_queued) {
+		batch_ready = true;
+		wake = true;
+	}
+	spin_unlock_irqrestore(&batch_lock, flags);
+
+	if (wake)
+		wake_up_interruptible(&batch_wait);
+}
+
+/**
+ * sensor_batch_register - add a sensor to the batching core
+ * @sb: sensor; name, flags, fifo_size and nvalues must be set
+ *
+ * Samples are only queued after userspace enables the sensor, so drivers
+ * may register unconditionally at probe time.
+ */
+int sensor_batch_register(struct sensor_batch *sb)
+{
+	unsigned long flags;
+	unsigned int size;
+	int i;
+
+	size = sb->fifo_size ? sb->fifo_size : BATCH_DEFAULT_FIFO;
+	size = roundup_pow_of_two(min_t(unsigned int, size, BATCH_MAX_FIFO));
+	if (sb->nvalues > SENSOR_BATCH_MAX_VALUES)
+		return -EINVAL;
+
+	sb->fifo = kcalloc(size, sizeof(*sb->fifo), GFP_KERNEL);
+	if (!sb->fifo)
+		return -ENOMEM;
+	sb->fifo_size = size;
+	sb->head = sb->tail = 0;
+	sb->dropped = 0;
+	sb->enabled = false;
+
+	spin_lock_irqsave(&batch_lock, flags);
+	for (i = 0; i < SENSOR_BATCH_MAX_SENSORS; i++)
+		if (!batch_sensors[i])
+			break;
+	if (i < SENSOR_BATCH_MAX_SENSORS) {
+		sb->id = i;
+		batch_sensors[i] = sb;
+	}
+	spin_unlock_irqrestore(&batch_lock, flags);
+
+	if (i == SENSOR_BATCH_MAX_SENSORS) {
+		kfree(sb->fifo);
+		sb->fifo = NULL;
+		return -ENOSPC;
+	}
+
+	pr_info("sensor_batch: %s registered as %d, fifo %u\n",
+		sb->name, sb->id, size);
+	return 0;
+}
+EXPORT_SYMBOL(sensor_batch_register);
+
+void sensor_batch_unregister(struct sensor_batch *sb)
+{
+	unsigned long flags;
+
+	if (!sb->fifo)
+		return;
+
+	spin_lock_irqsave(&batch_lock, flags);
+	batch_discard_locked(sb);
+	sb->enabled = false;
+	batch_sensors[sb->id] = NULL;
+	spin_unlock_irqrestore(&batch_lock, flags);
+
+	kfree(sb->fifo);
+	sb->fifo = NULL;
+}
+EXPORT_SYMBOL(sensor_batch_unregister);
+
+/**
+ * sensor_batch_push - queue one sample, timestamped now
+ * @sb: registered sensor
+ * @values: sb->nvalues values
+ *
+ * Returns true if the sample was queued.  Drivers report it through their
+ * input device otherwise.  May be called from any context.  A full FIFO
+ * drops its oldest sample.
+ */
+bool sensor_batch_push(struct sensor_batch *sb, const s32 *values)
+{
+	struct sensor_batch_sample *s;
+	unsigned long flags;
+	bool wake = false;
+	s64 now = ktime_to_ns(ktime_get());
+
+	if (!sb->fifo)
+		return false;
+
+	spin_lock_irqsave(&batch_lock, flags);
+	if (!sb->enabled) {
+		spin_unlock_irqrestore(&batch_lock, flags);
+		return false;
+	}
+
+	if (batch_count(sb) == sb->fifo_size) {
+		sb->tail++;
+		sb->dropped++;
+		batch_queued--;
+	}
+
+	s = &sb->fifo[sb->head & (sb->fifo_size - 1)];
+	s->timestamp = now;
+	s->sensor = sb->id;
+	s->nvalues = sb->nvalues;
+	s->reserved = 0;
+	memcpy(s->value, values, sb->nvalues * sizeof(s32));
+	sb->head++;
+	batch_queued++;
+
+	if ((sb->flags & SENSOR_BATCH_F_WAKEUP) || !batch_latency_ms ||
+	    batch_count(sb) >= sb->fifo_size - sb->fifo_size / 4) {
+		batch_ready = true;
+		wake = true;
+	} else if (batch_queued == 1) {
+		/* First sample since the last flush starts the clock */
+		mod_timer(&batch_timer, jiffies + msecs_to_jiffies(batch_latency_ms));
+	}
+	spin_unlock_irqrestore(&batch_lock, flags);
+
+	if (wake)
+		wake_up_interruptible(&batch_wait);
+	return true;
+}
+EXPORT_SYMBOL(sensor_batch_push);
+
+static struct sensor_batch *batch_oldest_locked(void)
+{
+	struct sensor_batch *sb, *oldest = NULL;
+	s64 ts = 0;
+	int i;
+
+	for (i = 0; i < SENSOR_BATCH_MAX_SENSORS; i++) {
+		sb = batch_sensors[i];
+		if (!sb || !batch_count(sb))
+			continue;
+		if (!oldest ||
+		    sb->fifo[sb->tail & (sb->fifo_size - 1)].timestamp < ts) {
+			oldest = sb;
+			ts = sb->fifo[sb->tail & (sb->fifo_size - 1)].timestamp;
+		}
+	}
+
+	return oldest;
+}
+
+static ssize_t sensor_batch_read(struct file *file, char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct sensor_batch_sample chunk[BATCH_READ_CHUNK];
+	struct sensor_batch *sb;
+	unsigned long flags;
+	size_t max = count / sizeof(chunk[0]);
+	size_t done = 0;
+	int n, ret;
+
+	if (!max)
+		return -EINVAL;
+
+again:
+	if (!(file->f_flags & O_NONBLOCK)) {
+		ret = wait_event_interruptible(batch_wait, batch_ready);
+		if (ret)
+			return ret;
+	}
+
+	while (done < max) {
+		spin_lock_irqsave(&batch_lock, flags);
+		for (n = 0; n < BATCH_READ_CHUNK && done + n < max; n++) {
+			sb = batch_oldest_locked();
+			if (!sb)
+				break;
+			chunk[n] = sb->fifo[sb->tail & (sb->fifo_size - 1)];
+			sb->tail++;
+			batch_queued--;
+		}
+		if (!batch_queued) {
+			batch_ready = false;
+			del_timer(&batch_timer);
+		}
+		spin_unlock_irqrestore(&batch_lock, flags);
+
+		if (!n)
+			break;
+		if (copy_to_user(buf + done * sizeof(chunk[0]), chunk,
+				 n * sizeof(chunk[0])))
+			return -EFAULT;
+		done += n;
+	}
+
+	if (!done) {
+		/* Another reader drained the FIFOs first */
+		if (!(file->f_flags & O_NONBLOCK))
+			goto again;
+		return -EAGAIN;
+	}
+	return done * sizeof(chunk[0]);
+}
+
+static unsigned int sensor_batch_poll(struct file *file, poll_table *wait)
+{
+	poll_wait(file, &batch_wait, wait);
+	return batch_ready ? POLLIN | POLLRDNORM : 0;
+}
+
+static int sensor_batch_get_info(void __user *arg)
+{
+	struct sensor_batch_info info;
+	struct sensor_batch *sb;
+	unsigned long flags;
+
+	if (copy_from_user(&info, arg, sizeof(info)))
+		return -EFAULT;
+	if (info.id >= SENSOR_BATCH_MAX_SENSORS)
+		return -EINVAL;
+
+	spin_lock_irqsave(&batch_lock, flags);
+	sb = batch_sensors[info.id];
+	if (sb) {
+		strlcpy(info.name, sb->name, sizeof(info.name));
+		info.flags = sb->flags;
+		info.fifo_size = sb->fifo_size;
+		info.enabled = sb->enabled;
+		info.queued = batch_count(sb);
+		info.dropped = sb->dropped;
+	}
+	spin_unlock_irqrestore(&batch_lock, flags);
+
+	if (!sb)
+		return -ENODEV;
+	return copy_to_user(arg, &info, sizeof(info)) ? -EFAULT : 0;
+}
+
+static int sensor_batch_enable(void __user *arg)
+{
+	struct sensor_batch_enable en;
+	struct sensor_batch *sb;
+	unsigned long flags;
+
+	if (copy_from_user(&en, arg, sizeof(en)))
+		return -EFAULT;
+	if (en.id >= SENSOR_BATCH_MAX_SENSORS)
+		return -EINVAL;
+
+	spin_lock_irqsave(&batch_lock, flags);
+	sb = batch_sensors[en.id];
+	if (sb) {
+		if (!en.enable)
+			batch_discard_locked(sb);
+		sb->enabled = !!en.enable;
+	}
+	spin_unlock_irqrestore(&batch_lock, flags);
+
+	return sb ? 0 : -ENODEV;
+}
+
+static long sensor_batch_ioctl(struct file *file, unsigned int cmd,
+			       unsigned long arg)
+{
+	void __user *argp = (void __user *)arg;
+	unsigned long flags;
+	u32 ms;
+
+	switch (cmd) {
+	case SENSOR_BATCH_IOC_GET_INFO:
+		return sensor_batch_get_info(argp);
+	case SENSOR_BATCH_IOC_ENABLE:
+		return sensor_batch_enable(argp);
+	case SENSOR_BATCH_IOC_SET_LATENCY:
+		if (get_user(ms, (u32 __user *)argp))
+			return -EFAULT;
+		spin_lock_irqsave(&batch_lock, flags);
+		batch_latency_ms = ms;
+		spin_unlock_irqrestore(&batch_lock, flags);
+		/* Apply the new latency to what is already queued */
+		batch_flush_timeout(0);
+		return 0;
+	case SENSOR_BATCH_IOC_FLUSH:
+		batch_flush_timeout(0);
+		return 0;
+	}
+
+	return -ENOTTY;
+}
+
+static int sensor_batch_open(struct inode *inode, struct file *file)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&batch_lock, flags);
+	batch_users++;
+	spin_unlock_irqrestore(&batch_lock, flags);
+
+	return nonseekable_open(inode, file);
+}
+
+static int sensor_batch_release(struct inode *inode, struct file *file)
+{
+	unsigned long flags;
+	bool last;
+	int i;
+
+	spin_lock_irqsave(&batch_lock, flags);
+	last = !--batch_users;
+	if (last) {
+		/* Nobody left to read: hand samples back to the input devices */
+		for (i = 0; i < SENSOR_BATCH_MAX_SENSORS; i++) {
+			if (!batch_sensors[i])
+				continue;
+			batch_discard_locked(batch_sensors[i]);
+			batch_sensors[i]->enabled = false;
+		}
+		batch_latency_ms = 0;
+		batch_ready = false;
+	}
+	spin_unlock_irqrestore(&batch_lock, flags);
+
+	if (last)
+		del_timer_sync(&batch_timer);
+	return 0;
+}
+
+static const struct file_operations sensor_batch_fops = {
+	.owner		= THIS_MODULE,
+	.read		= sensor_batch_read,
+	.poll		= sensor_batch_poll,
+	.unlocked_ioctl	= sensor_batch_ioctl,
+	.open		= sensor_batch_open,
+	.release	= sensor_batch_release,
+};
+
+static struct miscdevice sensor_batch_device = {
+	.minor	= MISC_DYNAMIC_MINOR,
+	.name	= "sensor_batch",
+	.fops	= &sensor_batch_fops,
+};
+
+static int __init sensor_batch_init(void)
+{
+	return misc_register(&sensor_batch_device);
+}
+module_init(sensor_batch_init);
+
+MODULE_DESCRIPTION("Sensor sample batching core");
+MODULE_LICENSE("GPL");
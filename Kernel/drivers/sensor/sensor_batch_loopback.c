@@ -0,0 +1,116 @@
+/*
+ * drivers/sensor/sensor_batch_loopback.c - Fake sensors for sensor_batch
+ *
+ * Registers "loopback0".."loopbackN" with the batching core and pushes a
+ * sample from an hrtimer every period_us.  value[0] is a per-sensor
+ * sequence number, value[1] the sensor index, and value[2..] a sawtooth,
+ * so a test reading /dev/sensor_batch can check ordering, gaps (dropped
+ * samples) and wakeup counts without any hardware.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/hrtimer.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/sensor_batch.h>
+
+#define LOOPBACK_MAX		4
+
+static unsigned int nr_sensors = 2;
+module_param(nr_sensors, uint, S_IRUGO);
+MODULE_PARM_DESC(nr_sensors, "number of fake sensors (1-4)");
+
+static unsigned int period_us = 10000;
+module_param(period_us, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(period_us, "sample period of each fake sensor");
+
+static unsigned int fifo_size = 64;
+module_param(fifo_size, uint, S_IRUGO);
+MODULE_PARM_DESC(fifo_size, "FIFO size of each fake sensor, in samples");
+
+struct loopback_sensor {
+	struct sensor_batch	batch;
+	struct hrtimer		timer;
+	char			name[16];
+	unsigned int		index;
+	u32			seq;
+};
+
+static struct loopback_sensor loopback[LOOPBACK_MAX];
+
+static ktime_t loopback_period(void)
+{
+	return ns_to_ktime((u64)max(period_us, 100U) * NSEC_PER_USEC);
+}
+
+static enum hrtimer_restart loopback_timer_func(struct hrtimer *timer)
+{
+	struct loopback_sensor *ls =
+		container_of(timer, struct loopback_sensor, timer);
+	s32 v[SENSOR_BATCH_MAX_VALUES];
+	int i;
+
+	v[0] = ls->seq++;
+	v[1] = ls->index;
+	for (i = 2; i < SENSOR_BATCH_MAX_VALUES; i++)
+		v[i] = (ls->seq * i) & 0x3ff;
+	sensor_batch_push(&ls->batch, v);
+
+	hrtimer_forward_now(timer, loopback_period());
+	return HRTIMER_RESTART;
+}
+
+static void loopback_cleanup(unsigned int n)
+{
+	while (n--) {
+		hrtimer_cancel(&loopback[n].timer);
+		sensor_batch_unregister(&loopback[n].batch);
+	}
+}
+
+static int __init loopback_init(void)
+{
+	struct loopback_sensor *ls;
+	unsigned int i;
+	int ret;
+
+	nr_sensors = clamp(nr_sensors, 1U, (unsigned int)LOOPBACK_MAX);
+
+	for (i = 0; i < nr_sensors; i++) {
+		ls = &loopback[i];
+		snprintf(ls->name, sizeof(ls->name), "loopback%u", i);
+		ls->index = i;
+		ls->batch.name = ls->name;
+		ls->batch.fifo_size = fifo_size;
+		ls->batch.nvalues = SENSOR_BATCH_MAX_VALUES;
+
+		ret = sensor_batch_register(&ls->batch);
+		if (ret) {
+			loopback_cleanup(i);
+			return ret;
+		}
+
+		hrtimer_init(&ls->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+		ls->timer.function = loopback_timer_func;
+		hrtimer_start(&ls->timer, loopback_period(), HRTIMER_MODE_REL);
+	}
+
+	return 0;
+}
+
+static void __exit loopback_exit(void)
+{
+	loopback_cleanup(nr_sensors);
+}
+
+module_init(loopback_init);
+module_exit(loopback_exit);
+
+MODULE_DESCRIPTION("Loopback fake sensors for the sensor batching core");
+MODULE_LICENSE("GPL");
@@ -14,6 +14,7 @@
  */
 
 #include <linux/console.h>
+#include <linux/crc32.h>
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
@@ -23,7 +24,13 @@
 #include <linux/io.h>
 
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
+#include <linux/bitops.h>
+#include <linux/notifier.h>
+#include <linux/reboot.h>
 #include <linux/rslib.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 #endif
 
 struct ram_console_buffer {
@@ -33,7 +40,27 @@ struct ram_console_buffer {
 	uint8_t     data[0];
 };
 
-#define RAM_CONSOLE_SIG (0x43474244) /* DBGC */
+#define RAM_CONSOLE_SIG (0x52474244) /* DBGR */
+
+/*
+ * The data area is a ring of records, each console write being one or
+ * more of them.  A record never wraps: when it does not fit before the
+ * end of the ring, the tail is cleared and the record starts at offset
+ * 0.  Records are 4 byte aligned so recovery can resync on the magic
+ * after a corrupted record, and the crc covers the record header and
+ * text, so a record torn by a reset or hit by a bit flip is dropped
+ * instead of garbling last_kmsg.
+ */
+struct ram_console_record {
+	uint16_t    magic;
+	uint16_t    len;
+	uint32_t    seq;
+	uint32_t    crc;
+	uint8_t     data[0];
+};
+
+#define RAM_CONSOLE_REC_MAGIC (0x4b4c) /* LK */
+#define RAM_CONSOLE_REC_MAX (0xffff & ~3)
 
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_EARLY_INIT
 static char __initdata
@@ -44,6 +71,9 @@ static size_t ram_console_old_log_size;
 
 static struct ram_console_buffer *ram_console_buffer;
 static size_t ram_console_buffer_size;
+static size_t ram_console_rec_max;
+static uint32_t ram_console_seq;
+static unsigned int ram_console_lost_records;
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
 static char *ram_console_par_buffer;
 static struct rs_control *ram_console_rs_decoder;
@@ -53,6 +83,23 @@ static int ram_console_bad_blocks;
 #define ECC_SIZE CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION_ECC_SIZE
 #define ECC_SYMSIZE CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION_SYMBOL_SIZE
 #define ECC_POLY CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION_POLYNOMIAL
+#define ECC_FLUSH_DELAY HZ
+
+/*
+ * Parity is not computed in the console write path.  Writes mark the
+ * blocks they touch in ram_console_ecc_dirty, and the parity of the
+ * dirty blocks is computed from a deferrable work, before suspend, on
+ * reboot and on panic.  The block after the last data block stands for
+ * the header.  ram_console_ecc_stale is a byte per block kept in the
+ * persistent buffer, set before a block is written and cleared once its
+ * parity is current, so recovery does not "correct" a block with stale
+ * parity.
+ */
+static int ram_console_ecc_blocks;
+static unsigned long *ram_console_ecc_dirty;
+static uint8_t *ram_console_ecc_stale;
+static DEFINE_SPINLOCK(ram_console_ecc_lock);
+static struct delayed_work ram_console_ecc_work;
 #endif
 
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
@@ -78,65 +125,151 @@ static int ram_console_decode_rs8(void *data, size_t len, uint8_t *ecc)
 }
 #endif
 
-static void ram_console_update(const char *s, unsigned int count)
+#ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
+static void ram_console_encode_block(int blk)
 {
 	struct ram_console_buffer *buffer = ram_console_buffer;
-#ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
-	uint8_t *buffer_end = buffer->data + ram_console_buffer_size;
-	uint8_t *block;
-	uint8_t *par;
-	int size = ECC_BLOCK_SIZE;
+	uint8_t *par = ram_console_par_buffer + blk * ECC_SIZE;
+	size_t offset;
+
+	if (blk == ram_console_ecc_blocks) {
+		ram_console_encode_rs8((uint8_t *)buffer, sizeof(*buffer), par);
+		return;
+	}
+	offset = blk * ECC_BLOCK_SIZE;
+	ram_console_encode_rs8(buffer->data + offset,
+			       min_t(size_t, ECC_BLOCK_SIZE,
+				     ram_console_buffer_size - offset), par);
+}
+
+static void ram_console_ecc_flush(void)
+{
+	unsigned long flags;
+	int blk = 0;
+
+	if (ram_console_ecc_dirty == NULL)
+		return;
+	while ((blk = find_next_bit(ram_console_ecc_dirty,
+				    ram_console_ecc_blocks + 1, blk)) <=
+	       ram_console_ecc_blocks) {
+		spin_lock_irqsave(&ram_console_ecc_lock, flags);
+		if (test_and_clear_bit(blk, ram_console_ecc_dirty)) {
+			ram_console_encode_block(blk);
+			/* rewritten while encoding, still stale */
+			ram_console_ecc_stale[blk] =
+				test_bit(blk, ram_console_ecc_dirty);
+		}
+		spin_unlock_irqrestore(&ram_console_ecc_lock, flags);
+		blk++;
+	}
+}
+
+static void ram_console_ecc_work_func(struct work_struct *work)
+{
+	ram_console_ecc_flush();
+	schedule_delayed_work(&ram_console_ecc_work, ECC_FLUSH_DELAY);
+}
+
+static int ram_console_ecc_notify(struct notifier_block *nb,
+				  unsigned long event, void *unused)
+{
+	ram_console_ecc_flush();
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block ram_console_panic_nb = {
+	.notifier_call = ram_console_ecc_notify,
+};
+
+static struct notifier_block ram_console_reboot_nb = {
+	.notifier_call = ram_console_ecc_notify,
+};
 #endif
-	memcpy(buffer->data + buffer->start, s, count);
+
+/*
+ * Mark the blocks backing data[start, end) and the header.  Called
+ * before the write to flag the parity stale in the persistent buffer
+ * and after it to queue the blocks for encoding.
+ */
+static inline void
+ram_console_mark(size_t start, size_t end, int written)
+{
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
-	block = buffer->data + (buffer->start & ~(ECC_BLOCK_SIZE - 1));
-	par = ram_console_par_buffer +
-	      (buffer->start / ECC_BLOCK_SIZE) * ECC_SIZE;
-	do {
-		if (block + ECC_BLOCK_SIZE > buffer_end)
-			size = buffer_end - block;
-		ram_console_encode_rs8(block, size, par);
-		block += ECC_BLOCK_SIZE;
-		par += ECC_SIZE;
-	} while (block < buffer->data + buffer->start + count);
+	int blk;
+
+	for (blk = start / ECC_BLOCK_SIZE; blk * ECC_BLOCK_SIZE < end; blk++) {
+		if (written)
+			set_bit(blk, ram_console_ecc_dirty);
+		else
+			ram_console_ecc_stale[blk] = 1;
+	}
+	if (written)
+		set_bit(ram_console_ecc_blocks, ram_console_ecc_dirty);
+	else
+		ram_console_ecc_stale[ram_console_ecc_blocks] = 1;
 #endif
 }
 
-static void ram_console_update_header(void)
+static uint32_t ram_console_record_crc(struct ram_console_record *rec,
+				       const void *data)
+{
+	uint32_t crc;
+
+	crc = crc32_le(~0, (uint8_t *)rec,
+		       offsetof(struct ram_console_record, crc));
+	return crc32_le(crc, data, rec->len);
+}
+
+static void ram_console_append(const char *s, unsigned int count)
 {
-#ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
 	struct ram_console_buffer *buffer = ram_console_buffer;
-	uint8_t *par;
-	par = ram_console_par_buffer +
-	      DIV_ROUND_UP(ram_console_buffer_size, ECC_BLOCK_SIZE) * ECC_SIZE;
-	ram_console_encode_rs8((uint8_t *)buffer, sizeof(*buffer), par);
-#endif
+	struct ram_console_record rec;
+	size_t rec_size = sizeof(rec) + ALIGN(count, 4);
+	size_t start = buffer->start;
+	uint8_t *p;
+
+	if (start + rec_size > ram_console_buffer_size) {
+		ram_console_mark(start, ram_console_buffer_size, 0);
+		memset(buffer->data + start, 0,
+		       ram_console_buffer_size - start);
+		ram_console_mark(start, ram_console_buffer_size, 1);
+		start = 0;
+		buffer->size = ram_console_buffer_size;
+	}
+
+	rec.magic = RAM_CONSOLE_REC_MAGIC;
+	rec.len = count;
+	rec.seq = ram_console_seq++;
+	rec.crc = ram_console_record_crc(&rec, s);
+
+	ram_console_mark(start, start + rec_size, 0);
+	p = buffer->data + start;
+	memcpy(p, &rec, sizeof(rec));
+	memcpy(p + sizeof(rec), s, count);
+	if (count & 3)
+		memset(p + sizeof(rec) + count, 0, ALIGN(count, 4) - count);
+
+	buffer->start = start + rec_size;
+	if (buffer->size < buffer->start)
+		buffer->size = buffer->start;
+	ram_console_mark(start, start + rec_size, 1);
 }
 
 static void
 ram_console_write(struct console *console, const char *s, unsigned int count)
 {
-	int rem;
-	struct ram_console_buffer *buffer = ram_console_buffer;
+	unsigned int len;
 
-	if (count > ram_console_buffer_size) {
-		s += count - ram_console_buffer_size;
-		count = ram_console_buffer_size;
+	if (count > ram_console_rec_max) {
+		s += count - ram_console_rec_max;
+		count = ram_console_rec_max;
 	}
-	rem = ram_console_buffer_size - buffer->start;
-	if (rem < count) {
-		ram_console_update(s, rem);
-		s += rem;
-		count -= rem;
-		buffer->start = 0;
-		buffer->size = ram_console_buffer_size;
+	while (count) {
+		len = min_t(unsigned int, count, RAM_CONSOLE_REC_MAX);
+		ram_console_append(s, len);
+		s += len;
+		count -= len;
 	}
-	ram_console_update(s, count);
-
-	buffer->start += count;
-	if (buffer->size < ram_console_buffer_size)
-		buffer->size += count;
-	ram_console_update_header();
 }
 
 static struct console ram_console = {
@@ -154,51 +287,138 @@ void ram_console_enable_console(int enabled)
 		ram_console.flags &= ~CON_ENABLED;
 }
 
+static struct ram_console_record * __init
+ram_console_next_record(uint8_t *data, size_t size, size_t *pos)
+{
+	struct ram_console_record *rec;
+
+	for (; *pos + sizeof(*rec) <= size; *pos += 4) {
+		rec = (struct ram_console_record *)(data + *pos);
+		if (rec->magic != RAM_CONSOLE_REC_MAGIC ||
+		    rec->len > size - *pos - sizeof(*rec) ||
+		    rec->crc != ram_console_record_crc(rec, rec->data))
+			continue;
+		*pos += sizeof(*rec) + ALIGN(rec->len, 4);
+		return rec;
+	}
+	return NULL;
+}
+
+static size_t __init ram_console_copy(char *dest, size_t dest_size,
+				      size_t offset, const void *src, size_t len)
+{
+	if (dest && offset < dest_size)
+		memcpy(dest + offset, src, min(len, dest_size - offset));
+	return len;
+}
+
+/*
+ * Copy the valid records of the old buffer to dest in sequence order,
+ * noting where records were lost, and return the length of the whole
+ * log even if it did not fit in dest_size.  The header is not trusted:
+ * the ring is scanned for the oldest record and read on from there.
+ */
+static size_t __init
+ram_console_copy_old(uint8_t *data, char *dest, size_t dest_size)
+{
+	struct ram_console_record *rec;
+	size_t size = ram_console_buffer_size;
+	size_t first = 0;
+	size_t pos;
+	size_t end;
+	size_t len = 0;
+	uint32_t seq = 0;
+	char strbuf[40];
+	int found = 0;
+	int pass;
+
+	pos = 0;
+	while ((rec = ram_console_next_record(data, size, &pos))) {
+		if (!found++ || (int32_t)(rec->seq - seq) < 0) {
+			seq = rec->seq;
+			first = (uint8_t *)rec - data;
+		}
+	}
+
+	ram_console_lost_records = 0;
+	for (pass = 0; found && pass < 2; pass++) {
+		pos = pass ? 0 : first;
+		end = pass ? first : size;
+		while ((rec = ram_console_next_record(data, end, &pos))) {
+			if ((int32_t)(rec->seq - seq) > 0) {
+				ram_console_lost_records += rec->seq - seq;
+				len += ram_console_copy(dest, dest_size, len,
+					strbuf, scnprintf(strbuf, sizeof(strbuf),
+					"\n[%u records lost]\n", rec->seq - seq));
+			}
+			len += ram_console_copy(dest, dest_size, len,
+						rec->data, rec->len);
+			seq = rec->seq + 1;
+		}
+	}
+	return len;
+}
+
 static void __init
-ram_console_save_old(struct ram_console_buffer *buffer, char *dest)
+ram_console_save_old(struct ram_console_buffer *buffer, char *dest,
+		     size_t dest_size)
 {
-	size_t old_log_size = buffer->size;
-#ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
-	uint8_t *block;
-	uint8_t *par;
+	size_t old_log_size;
 	char strbuf[80];
-	int strbuf_len;
+	int strbuf_len = 0;
+#ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
+	size_t offset;
+	int blk;
 
-	block = buffer->data;
-	par = ram_console_par_buffer;
-	while (block < buffer->data + buffer->size) {
+	for (blk = 0; blk < ram_console_ecc_blocks; blk++) {
 		int numerr;
-		int size = ECC_BLOCK_SIZE;
-		if (block + size > buffer->data + ram_console_buffer_size)
-			size = buffer->data + ram_console_buffer_size - block;
-		numerr = ram_console_decode_rs8(block, size, par);
+
+		/* written after its parity was last computed */
+		if (ram_console_ecc_stale[blk])
+			continue;
+		offset = blk * ECC_BLOCK_SIZE;
+		numerr = ram_console_decode_rs8(buffer->data + offset,
+				min_t(size_t, ECC_BLOCK_SIZE,
+				      ram_console_buffer_size - offset),
+				ram_console_par_buffer + blk * ECC_SIZE);
 		if (numerr > 0) {
 #if 0
-			printk(KERN_INFO "ram_console: error in block %p, %d\n",
-			       block, numerr);
+			printk(KERN_INFO "ram_console: error in block %d, %d\n",
+			       blk, numerr);
 #endif
 			ram_console_corrected_bytes += numerr;
 		} else if (numerr < 0) {
 #if 0
 			printk(KERN_INFO "ram_console: uncorrectable error in "
-			       "block %p\n", block);
+			       "block %d\n", blk);
 #endif
 			ram_console_bad_blocks++;
 		}
-		block += ECC_BLOCK_SIZE;
-		par += ECC_SIZE;
 	}
+#endif
+
+	old_log_size = ram_console_copy_old(buffer->data, NULL, 0);
+	if (old_log_size == 0) {
+		printk(KERN_INFO "ram_console: no valid records in buffer\n");
+		return;
+	}
+
+#ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
 	if (ram_console_corrected_bytes || ram_console_bad_blocks)
-		strbuf_len = snprintf(strbuf, sizeof(strbuf),
+		strbuf_len = scnprintf(strbuf, sizeof(strbuf),
 			"\n%d Corrected bytes, %d unrecoverable blocks\n",
 			ram_console_corrected_bytes, ram_console_bad_blocks);
 	else
-		strbuf_len = snprintf(strbuf, sizeof(strbuf),
-				      "\nNo errors detected\n");
-	if (strbuf_len >= sizeof(strbuf))
-		strbuf_len = sizeof(strbuf) - 1;
-	old_log_size += strbuf_len;
+		strbuf_len = scnprintf(strbuf, sizeof(strbuf),
+				       "\nNo errors detected\n");
 #endif
+	if (ram_console_lost_records)
+		strbuf_len += scnprintf(strbuf + strbuf_len,
+					sizeof(strbuf) - strbuf_len,
+					"%s%u records lost\n",
+					strbuf_len ? "" : "\n",
+					ram_console_lost_records);
+	old_log_size += strbuf_len;
 
 	if (dest == NULL) {
 		dest = kmalloc(old_log_size, GFP_KERNEL);
@@ -207,18 +427,17 @@ ram_console_save_old(struct ram_console_buffer *buffer, char *dest)
 			       "ram_console: failed to allocate buffer\n");
 			return;
 		}
+		dest_size = old_log_size;
+	} else if (dest_size < strbuf_len) {
+		return;
 	}
 
+	old_log_size = min(ram_console_copy_old(buffer->data, dest,
+						dest_size - strbuf_len),
+			   dest_size - strbuf_len);
+	memcpy(dest + old_log_size, strbuf, strbuf_len);
 	ram_console_old_log = dest;
-	ram_console_old_log_size = old_log_size;
-	memcpy(ram_console_old_log,
-	       &buffer->data[buffer->start], buffer->size - buffer->start);
-	memcpy(ram_console_old_log + buffer->size - buffer->start,
-	       &buffer->data[0], buffer->start);
-#ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
-	memcpy(ram_console_old_log + old_log_size - strbuf_len,
-	       strbuf, strbuf_len);
-#endif
+	ram_console_old_log_size = old_log_size + strbuf_len;
 }
 
 static int __init ram_console_init(struct ram_console_buffer *buffer,
@@ -227,10 +446,11 @@ static int __init ram_console_init(struct ram_console_buffer *buffer,
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
 	int numerr;
 	uint8_t *par;
+	size_t blocks;
 #endif
 	ram_console_buffer = buffer;
 	ram_console_buffer_size =
-		buffer_size - sizeof(struct ram_console_buffer);
+		(buffer_size - sizeof(struct ram_console_buffer)) & ~3;
 
 	if (ram_console_buffer_size > buffer_size) {
 		pr_err("ram_console: buffer %p, invalid size %zu, "
@@ -240,8 +460,10 @@ static int __init ram_console_init(struct ram_console_buffer *buffer,
 	}
 
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
-	ram_console_buffer_size -= (DIV_ROUND_UP(ram_console_buffer_size,
-						ECC_BLOCK_SIZE) + 1) * ECC_SIZE;
+	/* parity and a stale flag for each block and the header */
+	blocks = DIV_ROUND_UP(ram_console_buffer_size, ECC_BLOCK_SIZE);
+	ram_console_buffer_size -= (blocks + 1) * (ECC_SIZE + 1);
+	ram_console_buffer_size &= ~3;
 
 	if (ram_console_buffer_size > buffer_size) {
 		pr_err("ram_console: buffer %p, invalid size %zu, "
@@ -250,8 +472,17 @@ static int __init ram_console_init(struct ram_console_buffer *buffer,
 		return 0;
 	}
 
+	ram_console_ecc_blocks = DIV_ROUND_UP(ram_console_buffer_size,
+					      ECC_BLOCK_SIZE);
 	ram_console_par_buffer = buffer->data + ram_console_buffer_size;
-
+	ram_console_ecc_stale = ram_console_par_buffer +
+				(ram_console_ecc_blocks + 1) * ECC_SIZE;
+	ram_console_ecc_dirty = kzalloc(BITS_TO_LONGS(ram_console_ecc_blocks
+					+ 1) * sizeof(long), GFP_KERNEL);
+	if (ram_console_ecc_dirty == NULL) {
+		printk(KERN_ERR "ram_console: failed to allocate ecc map\n");
+		return 0;
+	}
 
 	/* first consecutive root is 0
 	 * primitive element to generate roots = 1
@@ -259,16 +490,18 @@ static int __init ram_console_init(struct ram_console_buffer *buffer,
 	ram_console_rs_decoder = init_rs(ECC_SYMSIZE, ECC_POLY, 0, 1, ECC_SIZE);
 	if (ram_console_rs_decoder == NULL) {
 		printk(KERN_INFO "ram_console: init_rs failed\n");
+		kfree(ram_console_ecc_dirty);
+		ram_console_ecc_dirty = NULL;
 		return 0;
 	}
 
 	ram_console_corrected_bytes = 0;
 	ram_console_bad_blocks = 0;
 
-	par = ram_console_par_buffer +
-	      DIV_ROUND_UP(ram_console_buffer_size, ECC_BLOCK_SIZE) * ECC_SIZE;
+	par = ram_console_par_buffer + ram_console_ecc_blocks * ECC_SIZE;
 
-	numerr = ram_console_decode_rs8(buffer, sizeof(*buffer), par);
+	numerr = ram_console_ecc_stale[ram_console_ecc_blocks] ? 0 :
+		 ram_console_decode_rs8(buffer, sizeof(*buffer), par);
 	if (numerr > 0) {
 		printk(KERN_INFO "ram_console: error in header, %d\n", numerr);
 		ram_console_corrected_bytes += numerr;
@@ -279,26 +512,41 @@ static int __init ram_console_init(struct ram_console_buffer *buffer,
 	}
 #endif
 
-	if (buffer->sig == RAM_CONSOLE_SIG) {
-		if (buffer->size > ram_console_buffer_size
-		    || buffer->start > buffer->size)
-			printk(KERN_INFO "ram_console: found existing invalid "
-			       "buffer, size %d, start %d\n",
-			       buffer->size, buffer->start);
-		else {
-			printk(KERN_INFO "ram_console: found existing buffer, "
-			       "size %d, start %d\n",
-			       buffer->size, buffer->start);
-			ram_console_save_old(buffer, old_buf);
-		}
-	} else {
-		printk(KERN_INFO "ram_console: no valid data in buffer "
-		       "(sig = 0x%08x)\n", buffer->sig);
+	if (ram_console_buffer_size <= sizeof(struct ram_console_record)) {
+		pr_err("ram_console: buffer %p, size %zu too small\n",
+		       buffer, buffer_size);
+		return 0;
 	}
+	ram_console_rec_max = min_t(size_t, RAM_CONSOLE_REC_MAX,
+			ram_console_buffer_size -
+			sizeof(struct ram_console_record)) & ~3;
+
+	if (buffer->sig == RAM_CONSOLE_SIG)
+		printk(KERN_INFO "ram_console: found existing buffer, "
+		       "size %d, start %d\n",
+		       buffer->size, buffer->start);
+	else
+		printk(KERN_INFO "ram_console: no valid header in buffer "
+		       "(sig = 0x%08x), scanning for records\n", buffer->sig);
+	ram_console_save_old(buffer, old_buf, buffer_size);
 
 	buffer->sig = RAM_CONSOLE_SIG;
 	buffer->start = 0;
 	buffer->size = 0;
+	/* drop the old records so they are not mistaken for this boot's */
+	memset(buffer->data, 0, ram_console_buffer_size);
+
+#ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
+	ram_console_mark(0, ram_console_buffer_size, 0);
+	ram_console_mark(0, ram_console_buffer_size, 1);
+	ram_console_ecc_flush();
+	INIT_DELAYED_WORK_DEFERRABLE(&ram_console_ecc_work,
+				     ram_console_ecc_work_func);
+	schedule_delayed_work(&ram_console_ecc_work, ECC_FLUSH_DELAY);
+	atomic_notifier_chain_register(&panic_notifier_list,
+				       &ram_console_panic_nb);
+	register_reboot_notifier(&ram_console_reboot_nb);
+#endif
 
 	register_console(&ram_console);
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_ENABLE_VERBOSE
@@ -342,8 +590,20 @@ static int ram_console_driver_probe(struct platform_device *pdev)
 	return ram_console_init(buffer, buffer_size, NULL/* allocate */);
 }
 
+#ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
+static int ram_console_driver_suspend(struct platform_device *pdev,
+				      pm_message_t state)
+{
+	ram_console_ecc_flush();
+	return 0;
+}
+#else
+#define ram_console_driver_suspend NULL
+#endif
+
 static struct platform_driver ram_console_driver = {
 	.probe = ram_console_driver_probe,
+	.suspend = ram_console_driver_suspend,
 	.driver		= {
 		.name	= "ram_console",
 	},
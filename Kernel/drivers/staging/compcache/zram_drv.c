@@ -546,6 +546,15 @@ int zram_init_device(struct zram *zram)
 	/* zram devices sort of resembles non-rotational disks */
 	queue_flag_set_unlocked(QUEUE_FLAG_NONROT, zram->disk->queue);
 
+	/*
+	 * Reads are decompressed in zram_make_request(), so there is no
+	 * latency for swap readahead to hide: it should only read pages
+	 * that turn out to be used.
+	 */
+#ifdef QUEUE_FLAG_SYNCIO
+	queue_flag_set_unlocked(QUEUE_FLAG_SYNCIO, zram->disk->queue);
+#endif
+
 	zram->mem_pool = xv_create_pool();
 	if (!zram->mem_pool) {
 		pr_err("Error creating memory pool\n");
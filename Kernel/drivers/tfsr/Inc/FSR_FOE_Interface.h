@@ -0,0 +1,136 @@
+/**
+ *   @mainpage   Flex Sector Remapper : LinuStoreIII_1.2.0_b038-FSR_1.2.1p1_b139_RTM
+ *
+ *   @section Intro Intro
+ *       Flash Translation Layer for Flex-OneNAND and OneNAND
+ *
+ *
+ *
+ *     @MULTI_BEGIN@ @COPYRIGHT_GPL
+ *     @section Copyright COPYRIGHT_GPL
+ *            COPYRIGHT. SAMSUNG ELECTRONICS CO., LTD.
+ *                                    ALL RIGHTS RESERVED
+ *     This program is free software; you can redistribute it and/or modify it
+ *     under the terms of the GNU General Public License version 2
+ *     as published by the Free Software Foundation.
+ *     @MULTI_END@
+ *
+ *     @section Description
+ *
+ */
+
+/**
+ * @file      FSR_FOE_Interface.h
+ * @brief     Interface of the OneNAND emulator (FOE)
+ * @remark
+ *            When FSR_ONENAND_EMULATOR is defined, the OneNAND LLD accesses
+ *            the register window and DataRAM through FSR_FOE_Read(),
+ *            FSR_FOE_Write() and FSR_FOE_Transfer*DataRAM() instead of
+ *            dereferencing the memory mapped device. The emulator keeps the
+ *            NAND array in RAM, so BML and the block driver can run without
+ *            a OneNAND device.
+ *
+ */
+
+#ifndef _FSR_FOE_INTERFACE_H_
+#define _FSR_FOE_INTERFACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*****************************************************************************/
+/* Return values of FSR_FOE_XXX()                                            */
+/*****************************************************************************/
+#define     FSR_FOE_SUCCESS             (0)
+#define     FSR_FOE_INVALID_PARAM       (-1)
+#define     FSR_FOE_UNSUPPORTED_DEVICE  (-2)
+#define     FSR_FOE_MALLOC_FAIL         (-3)
+
+/*****************************************************************************/
+/* Geometry of the emulated 2KB page OneNAND                                 */
+/*****************************************************************************/
+#define     FSR_FOE_PGS_PER_BLK         (64)
+#define     FSR_FOE_MAIN_PER_PG         (2048)
+#define     FSR_FOE_SPARE_PER_PG        (64)
+#define     FSR_FOE_RAW_PG_SIZE         (FSR_FOE_MAIN_PER_PG + FSR_FOE_SPARE_PER_PG)
+
+/*****************************************************************************/
+/* Fault types of FSR_FOE_SetFault()                                         */
+/*****************************************************************************/
+#define     FSR_FOE_FAULT_BAD           (0x01)  /* factory bad block:
+                                                   bad mark in page 0 and 1  */
+#define     FSR_FOE_FAULT_WEAR          (0x02)  /* every program and erase of
+                                                   the block fails            */
+#define     FSR_FOE_FAULT_ECC           (0x04)  /* loads with ECC on report an
+                                                   uncorrectable error        */
+
+/**
+ * @brief  configuration of an emulated device
+ */
+typedef struct
+{
+    UINT32  nDID;           /**< device ID to emulate, selects the geometry  */
+    UINT32  nLatencyPct;    /**< tR/tPROG/tBERS in percent of the datasheet
+                                 values, 0 completes every command at once   */
+    UINT32  nWordNs;        /**< host bus time per 16 bit word of DataRAM
+                                 transfer in nano seconds, 0 for none        */
+    UINT32  nFailRate;      /**< 1 out of nFailRate programs and erases
+                                 fails and wears the block out, 0 for never  */
+} FOEConfig;
+
+/**
+ * @brief  statistics of an emulated device
+ */
+typedef struct
+{
+    UINT32  nNumOfBlks;     /**< blocks of the emulated device               */
+    UINT32  nNumOfPlanes;   /**< planes of the emulated device               */
+    UINT32  nAllocBlks;     /**< blocks which are not erased (hold RAM)      */
+    UINT32  nLoads;         /**< load commands                               */
+    UINT32  nPgms;          /**< pages programmed (2x program counts 2)      */
+    UINT32  nErases;        /**< erase commands                              */
+    UINT32  nPgmFails;      /**< programs which reported an error            */
+    UINT32  nEraseFails;    /**< erases which reported an error              */
+    UINT32  nEccFails;      /**< loads which reported uncorrectable ECC      */
+    UINT32  nLockErrs;      /**< programs and erases of locked blocks        */
+    UINT32  nBusyUs;        /**< time the array was busy in micro seconds    */
+    UINT32  nBusyPolls;     /**< status reads while the device was busy      */
+    UINT32  nTransBytes;    /**< bytes moved between host and DataRAM        */
+} FOEStat;
+
+/*****************************************************************************/
+/* Exported Function Prototype of FOE                                        */
+/*****************************************************************************/
+INT32   FSR_FOE_Open                (UINT32             nDev,
+                                     FOEConfig         *pstConfig,
+                                     UINT32            *pnBaseAddr);
+VOID    FSR_FOE_Close               (UINT32             nDev);
+INT32   FSR_FOE_LoadPage            (UINT32             nDev,
+                                     UINT32             nPbn,
+                                     UINT32             nPgOffset,
+                                     UINT8             *pRawPage);
+INT32   FSR_FOE_SetFault            (UINT32             nDev,
+                                     UINT32             nPbn,
+                                     UINT32             nFault);
+INT32   FSR_FOE_GetStat             (UINT32             nDev,
+                                     FOEStat           *pstStat);
+
+VOID    FSR_FOE_Write               (UINT32             nAddr,
+                                     UINT16             nDQ);
+UINT16  FSR_FOE_Read                (UINT32             nAddr);
+VOID    FSR_FOE_TransferToDataRAM   (volatile VOID     *pDst,
+                                     VOID              *pSrc,
+                                     UINT32             nSize);
+VOID    FSR_FOE_TransferFromDataRAM (VOID              *pDst,
+                                     volatile VOID     *pSrc,
+                                     UINT32             nSize);
+VOID    FSR_FOE_MemsetDataRAM       (volatile VOID     *pDst,
+                                     UINT8              nVal,
+                                     UINT32             nSize);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _FSR_FOE_INTERFACE_H_ */
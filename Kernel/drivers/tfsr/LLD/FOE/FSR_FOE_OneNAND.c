@@ -0,0 +1,1207 @@
+/**
+ *   @mainpage   Flex Sector Remapper : LinuStoreIII_1.2.0_b038-FSR_1.2.1p1_b139_RTM
+ *
+ *   @section Intro
+ *       Flash Translation Layer for Flex-OneNAND and OneNAND
+ *
+ *    @section  Copyright
+ *---------------------------------------------------------------------------*
+ *                                                                           *
+ * Copyright (C) 2003-2010 Samsung Electronics                               *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License version 2 as         *
+ * published by the Free Software Foundation.                                *
+ *                                                                           *
+ *---------------------------------------------------------------------------*
+ *
+ *     @section Description
+ *
+ */
+
+/**
+ * @file      FSR_FOE_OneNAND.c
+ * @brief     RAM backed emulator of a 2KB page OneNAND (FOE)
+ * @remark
+ *            The OneNAND LLD built with FSR_ONENAND_EMULATOR accesses the
+ *            device only through FSR_FOE_Read(), FSR_FOE_Write() and the
+ *            DataRAM transfer functions below. This file backs that register
+ *            window with RAM and executes the commands written to the
+ *            command register against a NAND array kept in RAM, so the real
+ *            LLD, BML and block driver code run unchanged without a device.
+ *
+ *            - geometry follows the emulated device ID (see gstFOESpec)
+ *            - blocks are allocated on their first program and freed on
+ *              erase, so only blocks holding data cost memory
+ *            - program ANDs data into the page, like NAND does
+ *            - tR, tPROG and tBERS keep the device busy in the interrupt
+ *              status register, so the LLD polls as it does on hardware
+ *            - block lock state, OTP access and factory bad marks behave as
+ *              the LLD expects; program, erase and ECC faults can be injected
+ *
+ */
+
+/*****************************************************************************/
+/* Header file inclusions                                                    */
+/*****************************************************************************/
+#define     FSR_NO_INCLUDE_BML_HEADER
+#define     FSR_NO_INCLUDE_STL_HEADER
+
+#if defined(FSR_LINUX_OAM)
+#include    <linux/ktime.h>
+#include    <linux/hrtimer.h>
+#include    <linux/delay.h>
+#endif
+
+#include    "FSR.h"
+#include    "FSR_LLD_OneNAND.h"
+#include    "FSR_FOE_Interface.h"
+
+/*****************************************************************************/
+/* Local #defines                                                            */
+/*****************************************************************************/
+#define     FOE_MAX_DEVS                FSR_MAX_DEVS
+
+#define     FOE_SCTS_PER_PG             (4)
+#define     FOE_SCT_SIZE                (512)
+#define     FOE_SPARE_PER_SCT           (16)
+#define     FOE_BLK_SIZE                (FSR_FOE_PGS_PER_BLK * FSR_FOE_RAW_PG_SIZE)
+#define     FOE_BAD_MARK_PAGES          (2)
+
+/* byte offset of a register in the OneNAND address map */
+#define     FOE_REG_OFFSET(x)           ((UINT32) &(((OneNANDReg *) 0)->x))
+#define     FOE_REG(pCxt, x)            (*(volatile UINT16 *) ((pCxt)->pRegs + FOE_REG_OFFSET(x)))
+
+/* interrupt status register */
+#define     FOE_INT_READY               (0x8000)
+#define     FOE_INT_READ                (0x0080)
+#define     FOE_INT_WRITE               (0x0040)
+#define     FOE_INT_ERASE               (0x0020)
+#define     FOE_INT_RESET               (0x0010)
+
+/* controller status register */
+#define     FOE_CTRL_ONGO               (0x8000)
+#define     FOE_CTRL_ERROR              (0x0400)
+#define     FOE_CTRL_ERROR_CURR1        (0x0008)
+#define     FOE_CTRL_ERROR_CURR2        (0x0002)
+
+#define     FOE_CONF1_ECC_OFF           (0x0100)
+#define     FOE_CONF1_DEFAULT           (0x40C0)
+#define     FOE_ECC_UNCORRECTABLE       (0xAAAA)
+#define     FOE_DID_DDP                 (0x0008)
+
+/* commands */
+#define     FOE_CMD_LOAD                (0x0000)
+#define     FOE_CMD_PROGRAM             (0x0080)
+#define     FOE_CMD_2X_PROGRAM          (0x007D)
+#define     FOE_CMD_2X_CACHEPGM         (0x007F)
+#define     FOE_CMD_UNLOCK              (0x0023)
+#define     FOE_CMD_ALLBLK_UNLOCK       (0x0027)
+#define     FOE_CMD_LOCK                (0x002A)
+#define     FOE_CMD_LOCK_TIGHT          (0x002C)
+#define     FOE_CMD_OTPACCESS           (0x0065)
+#define     FOE_CMD_ERASE               (0x0094)
+#define     FOE_CMD_CORE_RESET          (0x00F0)
+#define     FOE_CMD_HOT_RESET           (0x00F3)
+
+/* start buffer register : BSA[11:8], BSC[1:0] */
+#define     FOE_BSA_SHIFT               (8)
+#define     FOE_BSA_DATARAM             (0x8)
+
+/* per block state : lock state in [2:0], faults from FOE_FAULT_SHIFT */
+#define     FOE_FAULT_SHIFT             (4)
+
+#if defined(FSR_LINUX_OAM)
+    #define FOE_GET_USEC()              ((UINT32) ktime_to_us(ktime_get()))
+    #define FOE_DELAY_USEC(n)           udelay(n)
+#else
+    #define FOE_GET_USEC()              (0)
+    #define FOE_DELAY_USEC(n)
+#endif
+
+/*****************************************************************************/
+/* Local typedefs                                                            */
+/*****************************************************************************/
+typedef struct
+{
+    UINT16          nDID;
+    UINT16          nNumOfBlks;
+    UINT16          nNumOfPlanes;
+    UINT16          nTLoadUs;
+    UINT16          nTProgUs;
+    UINT16          nTEraseUs;
+} FOESpec;
+
+typedef struct
+{
+    UINT8          *pRegs;          /**< register window handed to the LLD   */
+    const FOESpec  *pstSpec;
+    FOEConfig       stConfig;
+
+    UINT8         **ppBlk;          /**< nNumOfBlks + OTP block,
+                                         NULL while the block is erased      */
+    UINT8          *pBlkStat;       /**< lock state and faults per block     */
+
+    BOOL32          bOTPMode;
+    BOOL32          bBusy;
+    UINT16          nPendInt;       /**< interrupt bits raised when ready    */
+    UINT32          nBusyUntil;     /**< usec time stamp                     */
+    UINT32          nTransNs;       /**< bus time not delayed yet            */
+    UINT32          nSeed;
+
+    FOEStat         stStat;
+} FOEDevCxt;
+
+/*****************************************************************************/
+/* Static variables definitions                                              */
+/*****************************************************************************/
+
+/* Timings are the same as gstONDSpec of the OneNAND LLD.
+ * DDP devices are not emulated : each die has its own registers and DataRAM.
+ */
+PRIVATE const FOESpec gstFOESpec[] = {
+    /* nDID   nNumOfBlks nNumOfPlanes tR  tPROG tBERS */
+    { 0x0030, 1024,      1,           30, 220,  2000 },    /* KFG1G16Q2M */
+    { 0x0034, 1024,      1,           30, 250,  2000 },    /* KFG1G16Q2D */
+    { 0x0035, 1024,      1,           30, 250,  2000 },    /* KFG1G16U2D */
+    { 0x0040, 2048,      2,           30, 220,  2000 },    /* KFM2G16Q2M */
+    { 0x0044, 2048,      2,           30, 220,  2000 },    /* KFG2G16Q2M */
+    { 0x0000,    0,      0,            0,   0,     0 },
+};
+
+PRIVATE FOEDevCxt      *gpstFOECxt[FOE_MAX_DEVS];
+
+/*****************************************************************************/
+/* Function Implementation                                                   */
+/*****************************************************************************/
+
+/**
+ * @brief           This function finds the device which owns an address
+ *
+ * @param[in]       nAddr    : address in a register window
+ * @param[out]     *pnOffset : offset of nAddr in that window
+ *
+ * @return          device context, or NULL
+ *
+ */
+PRIVATE FOEDevCxt *
+_FindDev(UINT32  nAddr,
+         UINT32 *pnOffset)
+{
+    FOEDevCxt  *pstCxt;
+    UINT32      nDev;
+
+    for (nDev = 0; nDev < FOE_MAX_DEVS; nDev++)
+    {
+        pstCxt = gpstFOECxt[nDev];
+        if ((pstCxt != NULL) &&
+            (nAddr >= (UINT32) pstCxt->pRegs) &&
+            (nAddr <  (UINT32) pstCxt->pRegs + sizeof(OneNANDReg)))
+        {
+            *pnOffset = nAddr - (UINT32) pstCxt->pRegs;
+            return pstCxt;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief           This function returns the block addressed by start address 1
+ *
+ * @param[in]      *pstCxt : device context
+ *
+ * @return          block number, or the OTP block in OTP access mode
+ *
+ */
+PRIVATE UINT32
+_CurBlk(FOEDevCxt *pstCxt)
+{
+    if (pstCxt->bOTPMode == TRUE32)
+    {
+        return pstCxt->pstSpec->nNumOfBlks;
+    }
+
+    return FOE_REG(pstCxt, nStartAddr1) & (pstCxt->pstSpec->nNumOfBlks - 1);
+}
+
+/**
+ * @brief           This function returns the storage of a block
+ *
+ * @param[in]      *pstCxt : device context
+ * @param[in]       nBlk   : block number
+ * @param[in]       bAlloc : allocate an erased block if it has no storage
+ *
+ * @return          storage of the block, NULL if it is erased (or no memory)
+ *
+ */
+PRIVATE UINT8 *
+_GetBlk(FOEDevCxt *pstCxt,
+        UINT32     nBlk,
+        BOOL32     bAlloc)
+{
+    UINT8      *pBlk = pstCxt->ppBlk[nBlk];
+
+    if ((pBlk == NULL) && (bAlloc == TRUE32))
+    {
+        pBlk = (UINT8 *) FSR_OAM_Malloc(FOE_BLK_SIZE);
+        if (pBlk != NULL)
+        {
+            FSR_OAM_MEMSET(pBlk, 0xFF, FOE_BLK_SIZE);
+            pstCxt->ppBlk[nBlk] = pBlk;
+            pstCxt->stStat.nAllocBlks++;
+        }
+    }
+
+    return pBlk;
+}
+
+/**
+ * @brief           This function decides whether a program or an erase fails
+ *
+ * @param[in]      *pstCxt : device context
+ * @param[in]       nBlk   : block number
+ *
+ * @return          TRUE32 if the operation has to fail
+ *
+ * @remark          a block which failed randomly is worn out from then on
+ *
+ */
+PRIVATE BOOL32
+_Fail(FOEDevCxt *pstCxt,
+      UINT32     nBlk)
+{
+    if (pstCxt->pBlkStat[nBlk] & (FSR_FOE_FAULT_WEAR << FOE_FAULT_SHIFT))
+    {
+        return TRUE32;
+    }
+
+    if (pstCxt->stConfig.nFailRate != 0)
+    {
+        pstCxt->nSeed = pstCxt->nSeed * 1103515245 + 12345;
+        if (((pstCxt->nSeed >> 16) % pstCxt->stConfig.nFailRate) == 0)
+        {
+            pstCxt->pBlkStat[nBlk] |= (FSR_FOE_FAULT_WEAR << FOE_FAULT_SHIFT);
+            return TRUE32;
+        }
+    }
+
+    return FALSE32;
+}
+
+/**
+ * @brief           This function makes the device busy for an array operation
+ *
+ * @param[in]      *pstCxt : device context
+ * @param[in]       nUs    : datasheet time of the operation
+ * @param[in]       nInt   : interrupt bits to raise when the device is ready
+ *
+ * @return          none
+ *
+ */
+PRIVATE VOID
+_StartBusy(FOEDevCxt *pstCxt,
+           UINT32     nUs,
+           UINT16     nInt)
+{
+    nUs = nUs * pstCxt->stConfig.nLatencyPct / 100;
+
+    FOE_REG(pstCxt, nInt) = 0;
+
+    if (nUs == 0)
+    {
+        FOE_REG(pstCxt, nInt) = FOE_INT_READY | nInt;
+        return;
+    }
+
+    pstCxt->stStat.nBusyUs   += nUs;
+    pstCxt->bBusy             = TRUE32;
+    pstCxt->nPendInt          = nInt;
+    pstCxt->nBusyUntil        = FOE_GET_USEC() + nUs;
+    FOE_REG(pstCxt, nCtrlStat) |= FOE_CTRL_ONGO;
+}
+
+/**
+ * @brief           This function raises the interrupt once the device is ready
+ *
+ * @param[in]      *pstCxt : device context
+ *
+ * @return          none
+ *
+ */
+PRIVATE VOID
+_UpdateBusy(FOEDevCxt *pstCxt)
+{
+    if (pstCxt->bBusy == FALSE32)
+    {
+        return;
+    }
+
+    if ((INT32) (FOE_GET_USEC() - pstCxt->nBusyUntil) >= 0)
+    {
+        pstCxt->bBusy = FALSE32;
+        FOE_REG(pstCxt, nInt)      |= FOE_INT_READY | pstCxt->nPendInt;
+        FOE_REG(pstCxt, nCtrlStat) &= ~FOE_CTRL_ONGO;
+    }
+    else
+    {
+        pstCxt->stStat.nBusyPolls++;
+    }
+}
+
+/**
+ * @brief           This function charges the host bus time of a DataRAM transfer
+ *
+ * @param[in]      *pstCxt : device context
+ * @param[in]       nSize  : bytes transferred
+ *
+ * @return          none
+ *
+ */
+PRIVATE VOID
+_ChargeBus(FOEDevCxt *pstCxt,
+           UINT32     nSize)
+{
+    pstCxt->stStat.nTransBytes += nSize;
+
+    if (pstCxt->stConfig.nWordNs == 0)
+    {
+        return;
+    }
+
+    pstCxt->nTransNs += (nSize >> 1) * pstCxt->stConfig.nWordNs;
+    if (pstCxt->nTransNs >= 1000)
+    {
+        FOE_DELAY_USEC(pstCxt->nTransNs / 1000);
+        pstCxt->nTransNs %= 1000;
+    }
+}
+
+/**
+ * @brief           This function returns the DataRAM sectors selected by
+ * @n               the start buffer register
+ *
+ * @param[in]      *pstCxt  : device context
+ * @param[out]     *pnBuf   : DataRAM (0 or 1)
+ * @param[out]     *pnSct   : first sector in the DataRAM
+ * @param[out]     *pnCnt   : number of sectors
+ *
+ * @return          FALSE32 if BootRAM is selected
+ *
+ */
+PRIVATE BOOL32
+_GetBufSel(FOEDevCxt *pstCxt,
+           UINT32    *pnBuf,
+           UINT32    *pnSct,
+           UINT32    *pnCnt)
+{
+    UINT16      nStartBuf = FOE_REG(pstCxt, nStartBuf);
+    UINT32      nBSA      = (nStartBuf >> FOE_BSA_SHIFT) & 0xF;
+    UINT32      nBSC      = nStartBuf & (FOE_SCTS_PER_PG - 1);
+
+    if ((nBSA & FOE_BSA_DATARAM) == 0)
+    {
+        return FALSE32;
+    }
+
+    *pnBuf = (nBSA >> 2) & 1;
+    *pnSct = nBSA & (FOE_SCTS_PER_PG - 1);
+    *pnCnt = (nBSC == 0) ? FOE_SCTS_PER_PG : nBSC;
+    if (*pnSct + *pnCnt > FOE_SCTS_PER_PG)
+    {
+        *pnCnt = FOE_SCTS_PER_PG - *pnSct;
+    }
+
+    return TRUE32;
+}
+
+/**
+ * @brief           This function copies sectors of a page into DataRAM
+ *
+ * @param[in]      *pstCxt : device context
+ * @param[in]       nBlk   : block number
+ * @param[in]       nPg    : page offset
+ * @param[in]       nFSA   : first sector in the page
+ * @param[in]       nBuf   : DataRAM (0 or 1)
+ * @param[in]       nSct   : first sector in the DataRAM
+ * @param[in]       nCnt   : number of sectors
+ *
+ * @return          none
+ *
+ */
+PRIVATE VOID
+_Load(FOEDevCxt *pstCxt,
+      UINT32     nBlk,
+      UINT32     nPg,
+      UINT32     nFSA,
+      UINT32     nBuf,
+      UINT32     nSct,
+      UINT32     nCnt)
+{
+    UINT8      *pBlk  = _GetBlk(pstCxt, nBlk, FALSE32);
+    UINT8      *pMain = pstCxt->pRegs + FOE_REG_OFFSET(nDataMB00) +
+                        nBuf * FSR_FOE_MAIN_PER_PG + nSct * FOE_SCT_SIZE;
+    UINT8      *pSpare = pstCxt->pRegs + FOE_REG_OFFSET(nDataSB00) +
+                        nBuf * FSR_FOE_SPARE_PER_PG + nSct * FOE_SPARE_PER_SCT;
+    UINT8      *pPage;
+
+    if (pBlk == NULL)
+    {
+        FSR_OAM_MEMSET(pMain,  0xFF, nCnt * FOE_SCT_SIZE);
+        FSR_OAM_MEMSET(pSpare, 0xFF, nCnt * FOE_SPARE_PER_SCT);
+        return;
+    }
+
+    pPage = pBlk + nPg * FSR_FOE_RAW_PG_SIZE;
+    FSR_OAM_MEMCPY(pMain, pPage + nFSA * FOE_SCT_SIZE, nCnt * FOE_SCT_SIZE);
+    FSR_OAM_MEMCPY(pSpare, pPage + FSR_FOE_MAIN_PER_PG + nFSA * FOE_SPARE_PER_SCT,
+                   nCnt * FOE_SPARE_PER_SCT);
+}
+
+/**
+ * @brief           This function programs DataRAM sectors into a page
+ *
+ * @param[in]      *pstCxt : device context
+ * @param[in]       nBlk   : block number
+ * @param[in]       nPg    : page offset
+ * @param[in]       nFSA   : first sector in the page
+ * @param[in]       nBuf   : DataRAM (0 or 1)
+ * @param[in]       nSct   : first sector in the DataRAM
+ * @param[in]       nCnt   : number of sectors
+ *
+ * @return          TRUE32 on success, FALSE32 on a program error
+ *
+ */
+PRIVATE BOOL32
+_Program(FOEDevCxt *pstCxt,
+         UINT32     nBlk,
+         UINT32     nPg,
+         UINT32     nFSA,
+         UINT32     nBuf,
+         UINT32     nSct,
+         UINT32     nCnt)
+{
+    UINT8      *pMain = pstCxt->pRegs + FOE_REG_OFFSET(nDataMB00) +
+                        nBuf * FSR_FOE_MAIN_PER_PG + nSct * FOE_SCT_SIZE;
+    UINT8      *pSpare = pstCxt->pRegs + FOE_REG_OFFSET(nDataSB00) +
+                        nBuf * FSR_FOE_SPARE_PER_PG + nSct * FOE_SPARE_PER_SCT;
+    UINT8      *pBlk;
+    UINT8      *pDst;
+    UINT32      nIdx;
+
+    pstCxt->stStat.nPgms++;
+
+    if ((pstCxt->pBlkStat[nBlk] & FSR_LLD_BLK_STAT_MASK) != FSR_LLD_BLK_STAT_UNLOCKED)
+    {
+        pstCxt->stStat.nLockErrs++;
+        return FALSE32;
+    }
+
+    if (_Fail(pstCxt, nBlk) == TRUE32)
+    {
+        pstCxt->stStat.nPgmFails++;
+        return FALSE32;
+    }
+
+    pBlk = _GetBlk(pstCxt, nBlk, TRUE32);
+    if (pBlk == NULL)
+    {
+        pstCxt->stStat.nPgmFails++;
+        return FALSE32;
+    }
+
+    /* NAND program can only clear bits */
+    pDst = pBlk + nPg * FSR_FOE_RAW_PG_SIZE + nFSA * FOE_SCT_SIZE;
+    for (nIdx = 0; nIdx < nCnt * FOE_SCT_SIZE; nIdx++)
+    {
+        pDst[nIdx] &= pMain[nIdx];
+    }
+
+    pDst = pBlk + nPg * FSR_FOE_RAW_PG_SIZE + FSR_FOE_MAIN_PER_PG + nFSA * FOE_SPARE_PER_SCT;
+    for (nIdx = 0; nIdx < nCnt * FOE_SPARE_PER_SCT; nIdx++)
+    {
+        pDst[nIdx] &= pSpare[nIdx];
+    }
+
+    return TRUE32;
+}
+
+/**
+ * @brief           This function erases a block
+ *
+ * @param[in]      *pstCxt : device context
+ * @param[in]       nBlk   : block number
+ *
+ * @return          TRUE32 on success, FALSE32 on an erase error
+ *
+ */
+PRIVATE BOOL32
+_Erase(FOEDevCxt *pstCxt,
+       UINT32     nBlk)
+{
+    pstCxt->stStat.nErases++;
+
+    if ((pstCxt->bOTPMode == TRUE32) ||
+        ((pstCxt->pBlkStat[nBlk] & FSR_LLD_BLK_STAT_MASK) != FSR_LLD_BLK_STAT_UNLOCKED))
+    {
+        pstCxt->stStat.nLockErrs++;
+        return FALSE32;
+    }
+
+    if (_Fail(pstCxt, nBlk) == TRUE32)
+    {
+        pstCxt->stStat.nEraseFails++;
+        return FALSE32;
+    }
+
+    if (pstCxt->ppBlk[nBlk] != NULL)
+    {
+        FSR_OAM_Free(pstCxt->ppBlk[nBlk]);
+        pstCxt->ppBlk[nBlk] = NULL;
+        pstCxt->stStat.nAllocBlks--;
+    }
+
+    return TRUE32;
+}
+
+/**
+ * @brief           This function changes the lock state of a block
+ *
+ * @param[in]      *pstCxt : device context
+ * @param[in]       nBlk   : block number
+ * @param[in]       nCmd   : FOE_CMD_UNLOCK, FOE_CMD_LOCK or FOE_CMD_LOCK_TIGHT
+ *
+ * @return          TRUE32 on success, FALSE32 if the state can't be changed
+ *
+ */
+PRIVATE BOOL32
+_SetLock(FOEDevCxt *pstCxt,
+         UINT32     nBlk,
+         UINT16     nCmd)
+{
+    UINT8       nStat = pstCxt->pBlkStat[nBlk] & FSR_LLD_BLK_STAT_MASK;
+    UINT8       nNew;
+
+    if (nStat == FSR_LLD_BLK_STAT_LOCKED_TIGHT)
+    {
+        /* only a cold or warm reset releases lock-tight */
+        return FALSE32;
+    }
+
+    switch (nCmd)
+    {
+    case FOE_CMD_UNLOCK:
+        nNew = FSR_LLD_BLK_STAT_UNLOCKED;
+        break;
+    case FOE_CMD_LOCK:
+        nNew = FSR_LLD_BLK_STAT_LOCKED;
+        break;
+    default: /* FOE_CMD_LOCK_TIGHT */
+        if (nStat != FSR_LLD_BLK_STAT_LOCKED)
+        {
+            return FALSE32;
+        }
+        nNew = FSR_LLD_BLK_STAT_LOCKED_TIGHT;
+        break;
+    }
+
+    pstCxt->pBlkStat[nBlk] = (pstCxt->pBlkStat[nBlk] & ~FSR_LLD_BLK_STAT_MASK) | nNew;
+
+    return TRUE32;
+}
+
+/**
+ * @brief           This function executes a command written to the command register
+ *
+ * @param[in]      *pstCxt : device context
+ * @param[in]       nCmd   : command
+ *
+ * @return          none
+ *
+ */
+PRIVATE VOID
+_ExecCmd(FOEDevCxt *pstCxt,
+         UINT16     nCmd)
+{
+    const FOESpec  *pstSpec = pstCxt->pstSpec;
+    UINT16          nAddr8;
+    UINT32          nBlk;
+    UINT32          nPg;
+    UINT32          nFSA;
+    UINT32          nBuf;
+    UINT32          nSct;
+    UINT32          nCnt;
+    UINT32          nIdx;
+    UINT16          nCtrl   = 0;
+
+    /* the device accepts a new command only when it is ready */
+    while (pstCxt->bBusy == TRUE32)
+    {
+        _UpdateBusy(pstCxt);
+    }
+
+    nAddr8 = FOE_REG(pstCxt, nStartAddr8);
+    nBlk   = _CurBlk(pstCxt);
+    nPg    = (nAddr8 >> 2) & (FSR_FOE_PGS_PER_BLK - 1);
+    nFSA   = nAddr8 & (FOE_SCTS_PER_PG - 1);
+
+    FOE_REG(pstCxt, nEccStat) = 0;
+
+    switch (nCmd)
+    {
+    case FOE_CMD_LOAD:
+        pstCxt->stStat.nLoads++;
+        if (_GetBufSel(pstCxt, &nBuf, &nSct, &nCnt) == FALSE32)
+        {
+            nCtrl = FOE_CTRL_ERROR | FOE_CTRL_ERROR_CURR1;
+        }
+        else
+        {
+            _Load(pstCxt, nBlk, nPg, nFSA, nBuf, nSct, nCnt);
+
+            if (((FOE_REG(pstCxt, nSysConf1) & FOE_CONF1_ECC_OFF) == 0) &&
+                (pstCxt->pBlkStat[nBlk] & (FSR_FOE_FAULT_ECC << FOE_FAULT_SHIFT)))
+            {
+                FOE_REG(pstCxt, nEccStat) = FOE_ECC_UNCORRECTABLE;
+                pstCxt->stStat.nEccFails++;
+            }
+        }
+        FOE_REG(pstCxt, nCtrlStat) = nCtrl;
+        _StartBusy(pstCxt, pstSpec->nTLoadUs, FOE_INT_READ);
+        break;
+
+    case FOE_CMD_PROGRAM:
+        if ((_GetBufSel(pstCxt, &nBuf, &nSct, &nCnt) == FALSE32) ||
+            (_Program(pstCxt, nBlk, nPg, nFSA, nBuf, nSct, nCnt) == FALSE32))
+        {
+            nCtrl = FOE_CTRL_ERROR | FOE_CTRL_ERROR_CURR1;
+        }
+        FOE_REG(pstCxt, nCtrlStat) = nCtrl;
+        _StartBusy(pstCxt, pstSpec->nTProgUs, FOE_INT_WRITE);
+        break;
+
+    case FOE_CMD_2X_PROGRAM:
+    case FOE_CMD_2X_CACHEPGM:
+        /* the 1st plane comes from the selected DataRAM, the 2nd from the other one */
+        if ((pstSpec->nNumOfPlanes != 2) || (pstCxt->bOTPMode == TRUE32) ||
+            (_GetBufSel(pstCxt, &nBuf, &nSct, &nCnt) == FALSE32))
+        {
+            nCtrl = FOE_CTRL_ERROR | FOE_CTRL_ERROR_CURR1 | FOE_CTRL_ERROR_CURR2;
+        }
+        else
+        {
+            if (_Program(pstCxt, nBlk & ~1, nPg, nFSA, nBuf, nSct, nCnt) == FALSE32)
+            {
+                nCtrl |= FOE_CTRL_ERROR | FOE_CTRL_ERROR_CURR1;
+            }
+            if (_Program(pstCxt, nBlk | 1, nPg, nFSA, nBuf ^ 1, nSct, nCnt) == FALSE32)
+            {
+                nCtrl |= FOE_CTRL_ERROR | FOE_CTRL_ERROR_CURR2;
+            }
+        }
+        FOE_REG(pstCxt, nCtrlStat) = nCtrl;
+        _StartBusy(pstCxt, pstSpec->nTProgUs, FOE_INT_WRITE);
+        break;
+
+    case FOE_CMD_ERASE:
+        if (_Erase(pstCxt, nBlk) == FALSE32)
+        {
+            nCtrl = FOE_CTRL_ERROR | FOE_CTRL_ERROR_CURR1;
+        }
+        FOE_REG(pstCxt, nCtrlStat) = nCtrl;
+        _StartBusy(pstCxt, pstSpec->nTEraseUs, FOE_INT_ERASE);
+        break;
+
+    case FOE_CMD_UNLOCK:
+    case FOE_CMD_LOCK:
+    case FOE_CMD_LOCK_TIGHT:
+        nBlk = FOE_REG(pstCxt, nStartBlkAddr) & (pstSpec->nNumOfBlks - 1);
+        if (_SetLock(pstCxt, nBlk, nCmd) == FALSE32)
+        {
+            nCtrl = FOE_CTRL_ERROR;
+        }
+        FOE_REG(pstCxt, nCtrlStat) = nCtrl;
+        _StartBusy(pstCxt, 0, 0);
+        break;
+
+    case FOE_CMD_ALLBLK_UNLOCK:
+        if (pstCxt->bOTPMode == FALSE32)
+        {
+            for (nIdx = 0; nIdx < pstSpec->nNumOfBlks; nIdx++)
+            {
+                _SetLock(pstCxt, nIdx, FOE_CMD_UNLOCK);
+            }
+        }
+        FOE_REG(pstCxt, nCtrlStat) = 0;
+        _StartBusy(pstCxt, 0, 0);
+        break;
+
+    case FOE_CMD_OTPACCESS:
+        pstCxt->bOTPMode = TRUE32;
+        FOE_REG(pstCxt, nCtrlStat) = 0;
+        _StartBusy(pstCxt, 0, 0);
+        break;
+
+    case FOE_CMD_HOT_RESET:
+        FOE_REG(pstCxt, nSysConf1)   = FOE_CONF1_DEFAULT;
+        FOE_REG(pstCxt, nStartAddr1) = 0;
+        FOE_REG(pstCxt, nStartAddr2) = 0;
+        FOE_REG(pstCxt, nStartAddr8) = 0;
+        FOE_REG(pstCxt, nStartBuf)   = 0;
+        /* fall through */
+    case FOE_CMD_CORE_RESET:
+        pstCxt->bOTPMode = FALSE32;
+        FOE_REG(pstCxt, nCtrlStat) = 0;
+        _StartBusy(pstCxt, 0, FOE_INT_RESET);
+        break;
+
+    default:
+        FOE_REG(pstCxt, nCtrlStat) = FOE_CTRL_ERROR;
+        _StartBusy(pstCxt, 0, 0);
+        break;
+    }
+}
+
+/**
+ * @brief           This function creates an emulated device
+ *
+ * @param[in]       nDev       : Physical Device Number (0 ~ 7)
+ * @param[in]      *pstConfig  : device ID, latency model and fault rate
+ * @param[out]     *pnBaseAddr : address of the register window for the LLD
+ *
+ * @return          FSR_FOE_SUCCESS
+ * @return          FSR_FOE_INVALID_PARAM
+ * @return          FSR_FOE_UNSUPPORTED_DEVICE
+ * @return          FSR_FOE_MALLOC_FAIL
+ *
+ * @remark          all blocks start erased and locked, as after power on
+ *
+ */
+PUBLIC INT32
+FSR_FOE_Open(UINT32     nDev,
+             FOEConfig *pstConfig,
+             UINT32    *pnBaseAddr)
+{
+    FOEDevCxt      *pstCxt;
+    const FOESpec  *pstSpec;
+    UINT32          nBlks;
+
+    if ((nDev >= FOE_MAX_DEVS) || (pstConfig == NULL) || (pnBaseAddr == NULL))
+    {
+        return FSR_FOE_INVALID_PARAM;
+    }
+
+    if (gpstFOECxt[nDev] != NULL)
+    {
+        *pnBaseAddr = (UINT32) gpstFOECxt[nDev]->pRegs;
+        return FSR_FOE_SUCCESS;
+    }
+
+    for (pstSpec = &gstFOESpec[0]; pstSpec->nDID != 0; pstSpec++)
+    {
+        if (pstSpec->nDID == pstConfig->nDID)
+        {
+            break;
+        }
+    }
+
+    if ((pstSpec->nDID == 0) || (pstConfig->nDID & FOE_DID_DDP))
+    {
+        return FSR_FOE_UNSUPPORTED_DEVICE;
+    }
+
+    pstCxt = (FOEDevCxt *) FSR_OAM_Malloc(sizeof(FOEDevCxt));
+    if (pstCxt == NULL)
+    {
+        return FSR_FOE_MALLOC_FAIL;
+    }
+    FSR_OAM_MEMSET(pstCxt, 0x00, sizeof(FOEDevCxt));
+
+    /* the last block is the OTP block */
+    nBlks             = pstSpec->nNumOfBlks + 1;
+    pstCxt->pstSpec   = pstSpec;
+    pstCxt->stConfig  = *pstConfig;
+    pstCxt->nSeed     = 0x1234 + nDev;
+    pstCxt->pRegs     = (UINT8 *) FSR_OAM_Malloc(sizeof(OneNANDReg));
+    pstCxt->ppBlk     = (UINT8 **) FSR_OAM_Malloc(nBlks * sizeof(UINT8 *));
+    pstCxt->pBlkStat  = (UINT8 *) FSR_OAM_Malloc(nBlks);
+
+    if ((pstCxt->pRegs == NULL) || (pstCxt->ppBlk == NULL) || (pstCxt->pBlkStat == NULL))
+    {
+        if (pstCxt->pRegs != NULL)
+        {
+            FSR_OAM_Free(pstCxt->pRegs);
+        }
+        if (pstCxt->ppBlk != NULL)
+        {
+            FSR_OAM_Free(pstCxt->ppBlk);
+        }
+        if (pstCxt->pBlkStat != NULL)
+        {
+            FSR_OAM_Free(pstCxt->pBlkStat);
+        }
+        FSR_OAM_Free(pstCxt);
+        return FSR_FOE_MALLOC_FAIL;
+    }
+
+    FSR_OAM_MEMSET(pstCxt->ppBlk, 0x00, nBlks * sizeof(UINT8 *));
+    FSR_OAM_MEMSET(pstCxt->pBlkStat, FSR_LLD_BLK_STAT_LOCKED, nBlks);
+    pstCxt->pBlkStat[pstSpec->nNumOfBlks] = FSR_LLD_BLK_STAT_UNLOCKED;
+
+    /* BootRAM and DataRAM read 0xFF, registers hold their reset values */
+    FSR_OAM_MEMSET(pstCxt->pRegs, 0xFF, FOE_REG_OFFSET(nMID));
+    FSR_OAM_MEMSET(pstCxt->pRegs + FOE_REG_OFFSET(nMID), 0x00,
+                   sizeof(OneNANDReg) - FOE_REG_OFFSET(nMID));
+
+    FOE_REG(pstCxt, nMID)           = 0x00EC;
+    FOE_REG(pstCxt, nDID)           = (UINT16) pstSpec->nDID;
+    FOE_REG(pstCxt, nDataBufSize)   = 0x0800;
+    FOE_REG(pstCxt, nBootBufSize)   = 0x0200;
+    FOE_REG(pstCxt, nBufAmount)     = 0x0201;
+    FOE_REG(pstCxt, nSysConf1)      = FOE_CONF1_DEFAULT;
+    FOE_REG(pstCxt, nInt)           = FOE_INT_READY | FOE_INT_READ | FOE_INT_RESET;
+    FOE_REG(pstCxt, nWrProtectStat) = FSR_LLD_BLK_STAT_LOCKED;
+
+    pstCxt->stStat.nNumOfBlks   = pstSpec->nNumOfBlks;
+    pstCxt->stStat.nNumOfPlanes = pstSpec->nNumOfPlanes;
+
+    gpstFOECxt[nDev] = pstCxt;
+    *pnBaseAddr      = (UINT32) pstCxt->pRegs;
+
+    return FSR_FOE_SUCCESS;
+}
+
+/**
+ * @brief           This function destroys an emulated device and its contents
+ *
+ * @param[in]       nDev : Physical Device Number (0 ~ 7)
+ *
+ * @return          none
+ *
+ */
+PUBLIC VOID
+FSR_FOE_Close(UINT32 nDev)
+{
+    FOEDevCxt  *pstCxt;
+    UINT32      nBlk;
+
+    if ((nDev >= FOE_MAX_DEVS) || (gpstFOECxt[nDev] == NULL))
+    {
+        return;
+    }
+
+    pstCxt           = gpstFOECxt[nDev];
+    gpstFOECxt[nDev] = NULL;
+
+    for (nBlk = 0; nBlk <= pstCxt->pstSpec->nNumOfBlks; nBlk++)
+    {
+        if (pstCxt->ppBlk[nBlk] != NULL)
+        {
+            FSR_OAM_Free(pstCxt->ppBlk[nBlk]);
+        }
+    }
+
+    FSR_OAM_Free(pstCxt->ppBlk);
+    FSR_OAM_Free(pstCxt->pBlkStat);
+    FSR_OAM_Free(pstCxt->pRegs);
+    FSR_OAM_Free(pstCxt);
+}
+
+/**
+ * @brief           This function fills a page from a raw image
+ *
+ * @param[in]       nDev      : Physical Device Number (0 ~ 7)
+ * @param[in]       nPbn      : physical block number
+ * @param[in]       nPgOffset : page offset in the block
+ * @param[in]      *pRawPage  : 2048 bytes of main and 64 bytes of spare,
+ * @n                           spare in the DataRAM layout (nanddump -o)
+ *
+ * @return          FSR_FOE_SUCCESS
+ * @return          FSR_FOE_INVALID_PARAM
+ * @return          FSR_FOE_MALLOC_FAIL
+ *
+ * @remark          erased pages don't allocate their block
+ *
+ */
+PUBLIC INT32
+FSR_FOE_LoadPage(UINT32  nDev,
+                 UINT32  nPbn,
+                 UINT32  nPgOffset,
+                 UINT8  *pRawPage)
+{
+    FOEDevCxt  *pstCxt;
+    UINT8      *pBlk;
+    UINT32      nIdx;
+
+    if ((nDev >= FOE_MAX_DEVS) || (gpstFOECxt[nDev] == NULL) || (pRawPage == NULL))
+    {
+        return FSR_FOE_INVALID_PARAM;
+    }
+
+    pstCxt = gpstFOECxt[nDev];
+    if ((nPbn >= pstCxt->pstSpec->nNumOfBlks) || (nPgOffset >= FSR_FOE_PGS_PER_BLK))
+    {
+        return FSR_FOE_INVALID_PARAM;
+    }
+
+    pBlk = _GetBlk(pstCxt, nPbn, FALSE32);
+    if (pBlk == NULL)
+    {
+        for (nIdx = 0; nIdx < FSR_FOE_RAW_PG_SIZE; nIdx++)
+        {
+            if (pRawPage[nIdx] != 0xFF)
+            {
+                break;
+            }
+        }
+
+        if (nIdx == FSR_FOE_RAW_PG_SIZE)
+        {
+            return FSR_FOE_SUCCESS;
+        }
+
+        pBlk = _GetBlk(pstCxt, nPbn, TRUE32);
+        if (pBlk == NULL)
+        {
+            return FSR_FOE_MALLOC_FAIL;
+        }
+    }
+
+    FSR_OAM_MEMCPY(pBlk + nPgOffset * FSR_FOE_RAW_PG_SIZE, pRawPage, FSR_FOE_RAW_PG_SIZE);
+
+    return FSR_FOE_SUCCESS;
+}
+
+/**
+ * @brief           This function injects a fault into a block
+ *
+ * @param[in]       nDev   : Physical Device Number (0 ~ 7)
+ * @param[in]       nPbn   : physical block number
+ * @param[in]       nFault : FSR_FOE_FAULT_BAD, FSR_FOE_FAULT_WEAR, FSR_FOE_FAULT_ECC
+ *
+ * @return          FSR_FOE_SUCCESS
+ * @return          FSR_FOE_INVALID_PARAM
+ * @return          FSR_FOE_MALLOC_FAIL
+ *
+ * @remark          FSR_FOE_FAULT_BAD writes the factory bad mark,
+ * @n               so it has to be set after the image is loaded
+ *
+ */
+PUBLIC INT32
+FSR_FOE_SetFault(UINT32 nDev,
+                 UINT32 nPbn,
+                 UINT32 nFault)
+{
+    FOEDevCxt  *pstCxt;
+    UINT8      *pBlk;
+    UINT32      nPg;
+
+    if ((nDev >= FOE_MAX_DEVS) || (gpstFOECxt[nDev] == NULL))
+    {
+        return FSR_FOE_INVALID_PARAM;
+    }
+
+    pstCxt = gpstFOECxt[nDev];
+    if (nPbn >= pstCxt->pstSpec->nNumOfBlks)
+    {
+        return FSR_FOE_INVALID_PARAM;
+    }
+
+    if (nFault & FSR_FOE_FAULT_BAD)
+    {
+        pBlk = _GetBlk(pstCxt, nPbn, TRUE32);
+        if (pBlk == NULL)
+        {
+            return FSR_FOE_MALLOC_FAIL;
+        }
+
+        /* the 1st word of the spare of page 0 and 1 is the bad mark */
+        for (nPg = 0; nPg < FOE_BAD_MARK_PAGES; nPg++)
+        {
+            pBlk[nPg * FSR_FOE_RAW_PG_SIZE + FSR_FOE_MAIN_PER_PG]     = 0x00;
+            pBlk[nPg * FSR_FOE_RAW_PG_SIZE + FSR_FOE_MAIN_PER_PG + 1] = 0x00;
+        }
+    }
+
+    pstCxt->pBlkStat[nPbn] |= (UINT8) ((nFault & (FSR_FOE_FAULT_WEAR | FSR_FOE_FAULT_ECC))
+                                       << FOE_FAULT_SHIFT);
+
+    return FSR_FOE_SUCCESS;
+}
+
+/**
+ * @brief           This function returns the statistics of an emulated device
+ *
+ * @param[in]       nDev     : Physical Device Number (0 ~ 7)
+ * @param[out]     *pstStat  : statistics
+ *
+ * @return          FSR_FOE_SUCCESS
+ * @return          FSR_FOE_INVALID_PARAM
+ *
+ */
+PUBLIC INT32
+FSR_FOE_GetStat(UINT32   nDev,
+                FOEStat *pstStat)
+{
+    if ((nDev >= FOE_MAX_DEVS) || (gpstFOECxt[nDev] == NULL) || (pstStat == NULL))
+    {
+        return FSR_FOE_INVALID_PARAM;
+    }
+
+    FSR_OAM_MEMCPY(pstStat, &gpstFOECxt[nDev]->stStat, sizeof(FOEStat));
+
+    return FSR_FOE_SUCCESS;
+}
+
+/**
+ * @brief           This function emulates a 16 bit write to the OneNAND
+ *
+ * @param[in]       nAddr : address in the register window
+ * @param[in]       nDQ   : value
+ *
+ * @return          none
+ *
+ * @remark          a write to the command register executes the command
+ *
+ */
+PUBLIC VOID
+FSR_FOE_Write(UINT32 nAddr,
+              UINT16 nDQ)
+{
+    FOEDevCxt  *pstCxt;
+    UINT32      nOffset;
+
+    pstCxt = _FindDev(nAddr, &nOffset);
+    FSR_ASSERT(pstCxt != NULL);
+    if (pstCxt == NULL)
+    {
+        return;
+    }
+
+    *(volatile UINT16 *) (pstCxt->pRegs + nOffset) = nDQ;
+
+    if (nOffset == FOE_REG_OFFSET(nCmd))
+    {
+        _ExecCmd(pstCxt, nDQ);
+    }
+}
+
+/**
+ * @brief           This function emulates a 16 bit read from the OneNAND
+ *
+ * @param[in]       nAddr : address in the register window
+ *
+ * @return          value
+ *
+ */
+PUBLIC UINT16
+FSR_FOE_Read(UINT32 nAddr)
+{
+    FOEDevCxt  *pstCxt;
+    UINT32      nOffset;
+
+    pstCxt = _FindDev(nAddr, &nOffset);
+    FSR_ASSERT(pstCxt != NULL);
+    if (pstCxt == NULL)
+    {
+        return 0xFFFF;
+    }
+
+    if ((nOffset == FOE_REG_OFFSET(nInt)) || (nOffset == FOE_REG_OFFSET(nCtrlStat)))
+    {
+        _UpdateBusy(pstCxt);
+    }
+    else if (nOffset == FOE_REG_OFFSET(nWrProtectStat))
+    {
+        FOE_REG(pstCxt, nWrProtectStat) =
+            pstCxt->pBlkStat[_CurBlk(pstCxt)] & FSR_LLD_BLK_STAT_MASK;
+    }
+
+    return *(volatile UINT16 *) (pstCxt->pRegs + nOffset);
+}
+
+/**
+ * @brief           This function transfers data from the host to DataRAM
+ *
+ * @param[in]      *pDst  : DataRAM address
+ * @param[in]      *pSrc  : host buffer
+ * @param[in]       nSize : bytes to transfer
+ *
+ * @return          none
+ *
+ */
+PUBLIC VOID
+FSR_FOE_TransferToDataRAM(volatile VOID *pDst,
+                          VOID          *pSrc,
+                          UINT32         nSize)
+{
+    FOEDevCxt  *pstCxt;
+    UINT32      nOffset;
+
+    pstCxt = _FindDev((UINT32) pDst, &nOffset);
+    FSR_ASSERT(pstCxt != NULL);
+    if (pstCxt == NULL)
+    {
+        return;
+    }
+
+    FSR_OAM_MEMCPY((VOID *) pDst, pSrc, nSize);
+    _ChargeBus(pstCxt, nSize);
+}
+
+/**
+ * @brief           This function transfers data from DataRAM to the host
+ *
+ * @param[in]      *pDst  : host buffer
+ * @param[in]      *pSrc  : DataRAM address
+ * @param[in]       nSize : bytes to transfer
+ *
+ * @return          none
+ *
+ */
+PUBLIC VOID
+FSR_FOE_TransferFromDataRAM(VOID          *pDst,
+                            volatile VOID *pSrc,
+                            UINT32         nSize)
+{
+    FOEDevCxt  *pstCxt;
+    UINT32      nOffset;
+
+    pstCxt = _FindDev((UINT32) pSrc, &nOffset);
+    FSR_ASSERT(pstCxt != NULL);
+    if (pstCxt == NULL)
+    {
+        return;
+    }
+
+    FSR_OAM_MEMCPY(pDst, (VOID *) pSrc, nSize);
+    _ChargeBus(pstCxt, nSize);
+}
+
+/**
+ * @brief           This function fills DataRAM with a value
+ *
+ * @param[in]      *pDst  : DataRAM address
+ * @param[in]       nVal  : value
+ * @param[in]       nSize : bytes to fill
+ *
+ * @return          none
+ *
+ */
+PUBLIC VOID
+FSR_FOE_MemsetDataRAM(volatile VOID *pDst,
+                      UINT8          nVal,
+                      UINT32         nSize)
+{
+    FOEDevCxt  *pstCxt;
+    UINT32      nOffset;
+
+    pstCxt = _FindDev((UINT32) pDst, &nOffset);
+    FSR_ASSERT(pstCxt != NULL);
+    if (pstCxt == NULL)
+    {
+        return;
+    }
+
+    FSR_OAM_MEMSET((VOID *) pDst, nVal, nSize);
+    _ChargeBus(pstCxt, nSize);
+}
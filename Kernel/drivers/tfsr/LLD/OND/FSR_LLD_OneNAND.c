@@ -68,7 +68,7 @@
 #endif
 
 #if defined(FSR_ONENAND_EMULATOR)
-#include    "..\Inc\FSR_FOE_Interface.h"
+#include    "FSR_FOE_Interface.h"
 #endif /* #if defined(FSR_ONENAND_EMULATOR) */
 
 /*****************************************************************************/
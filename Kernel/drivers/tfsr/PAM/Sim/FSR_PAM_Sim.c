@@ -0,0 +1,502 @@
+/**
+ *   @mainpage   Flex Sector Remapper : LinuStoreIII_1.2.0_b038-FSR_1.2.1p1_b139_RTM
+ *
+ *   @section Intro
+ *       Flash Translation Layer for Flex-OneNAND and OneNAND
+ *
+ *    @section  Copyright
+ *---------------------------------------------------------------------------*
+ *                                                                           *
+ * Copyright (C) 2003-2010 Samsung Electronics                               *
+ * This program is free software; you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License version 2 as         *
+ * published by the Free Software Foundation.                                *
+ *                                                                           *
+ *---------------------------------------------------------------------------*
+ *
+ *     @section Description
+ *
+ */
+
+/**
+ * @file      FSR_PAM_Sim.c
+ * @brief     Platform Adaptation Module for the OneNAND emulator
+ * @remark
+ *            Volume 0 is a single OneNAND emulated in RAM by FOE
+ *            (LLD/FOE/FSR_FOE_OneNAND.c) and driven by the OneNAND LLD built
+ *            with FSR_ONENAND_EMULATOR. It lets BML and the block driver run
+ *            on boards or virtual machines without a OneNAND device.
+ *
+ *            The module parameters (tfsr.sim_*) select the device ID, the
+ *            latency model, injected faults and an optional raw image
+ *            (2048 bytes main + 64 bytes spare per page) to start from.
+ *            The image is only read; writes are lost at power off.
+ *
+ */
+
+#if defined(FSR_LINUX_OAM)
+#include    <linux/kernel.h>
+#include    <linux/module.h>
+#include    <linux/moduleparam.h>
+#include    <linux/fs.h>
+#include    <linux/err.h>
+#endif
+
+#include    "FSR.h"
+#include    "FSR_LLD_OneNAND.h"
+#include    "FSR_FOE_Interface.h"
+
+/*****************************************************************************/
+/* Local #defines                                                            */
+/*****************************************************************************/
+#define     FSR_SIM_DEV             (0)
+#define     FSR_SIM_MAX_FAULTS      (16)
+
+#define     DBG_PRINT(x)            FSR_DBG_PRINT(x)
+#define     RTL_PRINT(x)            FSR_RTL_PRINT(x)
+
+/*****************************************************************************/
+/* Static variables definitions                                              */
+/*****************************************************************************/
+PRIVATE FsrVolParm              gstFsrVolParm[FSR_MAX_VOLS];
+PRIVATE BOOL32                  gbPAMInit                   = FALSE32;
+
+#if defined(FSR_LINUX_OAM)
+PRIVATE UINT32  sim_did         = 0x0030;
+PRIVATE UINT32  sim_latency     = 100;
+PRIVATE UINT32  sim_word_ns     = 0;
+PRIVATE UINT32  sim_fail_rate   = 0;
+PRIVATE char   *sim_image       = NULL;
+PRIVATE INT32   sim_bad[FSR_SIM_MAX_FAULTS];
+PRIVATE INT32   sim_wear[FSR_SIM_MAX_FAULTS];
+PRIVATE INT32   sim_ecc[FSR_SIM_MAX_FAULTS];
+PRIVATE INT32   sim_nbad;
+PRIVATE INT32   sim_nwear;
+PRIVATE INT32   sim_necc;
+
+module_param(sim_did, uint, 0444);
+MODULE_PARM_DESC(sim_did, "OneNAND device ID to emulate (0x30, 0x34, 0x35, 0x40, 0x44)");
+module_param(sim_latency, uint, 0444);
+MODULE_PARM_DESC(sim_latency, "tR/tPROG/tBERS in percent of the datasheet, 0 for none");
+module_param(sim_word_ns, uint, 0444);
+MODULE_PARM_DESC(sim_word_ns, "bus time per 16 bit DataRAM access in ns");
+module_param(sim_fail_rate, uint, 0444);
+MODULE_PARM_DESC(sim_fail_rate, "1 out of N programs/erases fails, 0 for never");
+module_param(sim_image, charp, 0444);
+MODULE_PARM_DESC(sim_image, "raw image (2112 bytes per page) to load at init");
+module_param_array(sim_bad, int, &sim_nbad, 0444);
+MODULE_PARM_DESC(sim_bad, "blocks with a factory bad mark");
+module_param_array(sim_wear, int, &sim_nwear, 0444);
+MODULE_PARM_DESC(sim_wear, "blocks whose programs and erases fail");
+module_param_array(sim_ecc, int, &sim_necc, 0444);
+MODULE_PARM_DESC(sim_ecc, "blocks whose loads report uncorrectable ECC");
+#endif
+
+/*****************************************************************************/
+/* Function Implementation                                                   */
+/*****************************************************************************/
+
+#if defined(FSR_LINUX_OAM)
+/**
+ * @brief           This function loads a raw image into the emulated device
+ *
+ * @param[in]      *pPath      : image file
+ * @param[in]       nNumOfBlks : blocks of the device
+ *
+ * @return          none
+ *
+ * @remark          a short image leaves the remaining blocks erased
+ *
+ */
+PRIVATE VOID
+_LoadImage(const char *pPath,
+           UINT32      nNumOfBlks)
+{
+    struct file    *pFile;
+    UINT8          *pPage;
+    loff_t          nPos    = 0;
+    UINT32          nPbn;
+    UINT32          nPg;
+    UINT32          nPgs    = 0;
+
+    pFile = filp_open(pPath, O_RDONLY | O_LARGEFILE, 0);
+    if (IS_ERR(pFile))
+    {
+        RTL_PRINT((TEXT("[PAM:ERR]   can't open %s (%ld)\r\n"), pPath, PTR_ERR(pFile)));
+        return;
+    }
+
+    pPage = (UINT8 *) FSR_OAM_Malloc(FSR_FOE_RAW_PG_SIZE);
+    if (pPage == NULL)
+    {
+        filp_close(pFile, NULL);
+        return;
+    }
+
+    for (nPbn = 0; nPbn < nNumOfBlks; nPbn++)
+    {
+        for (nPg = 0; nPg < FSR_FOE_PGS_PER_BLK; nPg++)
+        {
+            if (kernel_read(pFile, nPos, (char *) pPage, FSR_FOE_RAW_PG_SIZE) != FSR_FOE_RAW_PG_SIZE)
+            {
+                goto out;
+            }
+            nPos += FSR_FOE_RAW_PG_SIZE;
+
+            if (FSR_FOE_LoadPage(FSR_SIM_DEV, nPbn, nPg, pPage) != FSR_FOE_SUCCESS)
+            {
+                RTL_PRINT((TEXT("[PAM:ERR]   out of memory loading %s\r\n"), pPath));
+                goto out;
+            }
+            nPgs++;
+        }
+    }
+
+out:
+    RTL_PRINT((TEXT("[PAM:   ]   %d pages loaded from %s\r\n"), nPgs, pPath));
+
+    FSR_OAM_Free(pPage);
+    filp_close(pFile, NULL);
+}
+#endif
+
+/**
+ * @brief           This function initializes PAM
+ *                  this function is called by FSR_BML_Init
+ *
+ * @return          FSR_PAM_SUCCESS
+ * @return          FSR_PAM_NAND_PROBE_FAILED
+ *
+ */
+PUBLIC INT32
+FSR_PAM_Init(VOID)
+{
+    INT32       nRe = FSR_PAM_SUCCESS;
+    FOEConfig   stConfig;
+    FOEStat     stStat;
+    UINT32      nBaseAddr;
+    INT32       nFoeRe;
+#if defined(FSR_LINUX_OAM)
+    INT32       nIdx;
+#endif
+    FSR_STACK_VAR;
+
+    FSR_STACK_END;
+
+    if (gbPAMInit == TRUE32)
+    {
+        return FSR_PAM_SUCCESS;
+    }
+
+    RTL_PRINT((TEXT("[PAM:   ] ++%s\r\n"), __FSR_FUNC__));
+
+    do
+    {
+        FSR_OAM_MEMSET(&stConfig, 0x00, sizeof(FOEConfig));
+#if defined(FSR_LINUX_OAM)
+        stConfig.nDID        = sim_did;
+        stConfig.nLatencyPct = sim_latency;
+        stConfig.nWordNs     = sim_word_ns;
+        stConfig.nFailRate   = sim_fail_rate;
+#else
+        stConfig.nDID        = 0x0030;
+        stConfig.nLatencyPct = 0;
+#endif
+
+        nFoeRe = FSR_FOE_Open(FSR_SIM_DEV, &stConfig, &nBaseAddr);
+        if (nFoeRe != FSR_FOE_SUCCESS)
+        {
+            RTL_PRINT((TEXT("[PAM:ERR]   can't emulate OneNAND nDID=0x%02x (%d)\r\n"),
+                    stConfig.nDID, nFoeRe));
+            nRe = FSR_PAM_NAND_PROBE_FAILED;
+            break;
+        }
+
+        FSR_FOE_GetStat(FSR_SIM_DEV, &stStat);
+
+#if defined(FSR_LINUX_OAM)
+        if (sim_image != NULL)
+        {
+            _LoadImage(sim_image, stStat.nNumOfBlks);
+        }
+
+        /* bad marks overwrite the image */
+        for (nIdx = 0; nIdx < sim_nbad; nIdx++)
+        {
+            FSR_FOE_SetFault(FSR_SIM_DEV, sim_bad[nIdx], FSR_FOE_FAULT_BAD);
+        }
+        for (nIdx = 0; nIdx < sim_nwear; nIdx++)
+        {
+            FSR_FOE_SetFault(FSR_SIM_DEV, sim_wear[nIdx], FSR_FOE_FAULT_WEAR);
+        }
+        for (nIdx = 0; nIdx < sim_necc; nIdx++)
+        {
+            FSR_FOE_SetFault(FSR_SIM_DEV, sim_ecc[nIdx], FSR_FOE_FAULT_ECC);
+        }
+#endif
+
+        RTL_PRINT((TEXT("[PAM:   ]   emulated OneNAND nDID=0x%02x : %d blocks, %d plane(s)\r\n"),
+                stConfig.nDID, stStat.nNumOfBlks, stStat.nNumOfPlanes));
+        RTL_PRINT((TEXT("[PAM:   ]   latency %d%%, %d ns/word, fail rate 1/%d\r\n"),
+                stConfig.nLatencyPct, stConfig.nWordNs, stConfig.nFailRate));
+
+        gstFsrVolParm[0].nBaseAddr[0] = nBaseAddr;
+        gstFsrVolParm[0].nBaseAddr[1] = FSR_PAM_NOT_MAPPED;
+        gstFsrVolParm[0].nIntID[0]    = FSR_INT_ID_NAND_0;
+        gstFsrVolParm[0].nIntID[1]    = FSR_INT_ID_NONE;
+        gstFsrVolParm[0].nDevsInVol   = 1;
+        gstFsrVolParm[0].bProcessorSynchronization = FALSE32;
+        gstFsrVolParm[0].pExInfo      = NULL;
+
+        gstFsrVolParm[1].nBaseAddr[0] = FSR_PAM_NOT_MAPPED;
+        gstFsrVolParm[1].nBaseAddr[1] = FSR_PAM_NOT_MAPPED;
+        gstFsrVolParm[1].nIntID[0]    = FSR_INT_ID_NONE;
+        gstFsrVolParm[1].nIntID[1]    = FSR_INT_ID_NONE;
+        gstFsrVolParm[1].nDevsInVol   = 0;
+        gstFsrVolParm[1].bProcessorSynchronization = FALSE32;
+        gstFsrVolParm[1].pExInfo      = NULL;
+
+        gbPAMInit = TRUE32;
+
+    } while (0);
+
+    RTL_PRINT((TEXT("[PAM:   ] --%s\r\n"), __FSR_FUNC__));
+
+    return nRe;
+}
+
+/**
+ * @brief           This function returns FSR volume parameter
+ *                  this function is called by FSR_BML_Init
+ *
+ * @param[in]       stVolParm[FSR_MAX_VOLS] : FsrVolParm data structure array
+ *
+ * @return          FSR_PAM_SUCCESS
+ * @return          FSR_PAM_NOT_INITIALIZED
+ *
+ */
+PUBLIC INT32
+FSR_PAM_GetPAParm(FsrVolParm stVolParm[FSR_MAX_VOLS])
+{
+    FSR_STACK_VAR;
+
+    FSR_STACK_END;
+
+    if (gbPAMInit == FALSE32)
+    {
+        return FSR_PAM_NOT_INITIALIZED;
+    }
+
+    FSR_OAM_MEMCPY(&(stVolParm[0]), &gstFsrVolParm[0], sizeof(FsrVolParm));
+    FSR_OAM_MEMCPY(&(stVolParm[1]), &gstFsrVolParm[1], sizeof(FsrVolParm));
+
+    return FSR_PAM_SUCCESS;
+}
+
+/**
+ * @brief           This function registers LLD function table
+ *                  this function is called by FSR_BML_Open
+ *
+ * @param[in]      *pstLFT[FSR_MAX_VOLS] : pointer to FSRLowFuncTable data structure
+ *
+ * @return          FSR_PAM_SUCCESS
+ * @return          FSR_PAM_NOT_INITIALIZED
+ *
+ * @remark          the OneNAND LLD runs on top of the emulator
+ *
+ */
+PUBLIC INT32
+FSR_PAM_RegLFT(FSRLowFuncTbl  *pstLFT[FSR_MAX_VOLS])
+{
+    UINT32  nVolIdx = 0;
+    FSR_STACK_VAR;
+
+    FSR_STACK_END;
+
+    if (gbPAMInit == FALSE32)
+    {
+        return FSR_PAM_NOT_INITIALIZED;
+    }
+
+    if (gstFsrVolParm[nVolIdx].nDevsInVol > 0)
+    {
+        pstLFT[nVolIdx]->LLD_Init               = FSR_OND_Init;
+        pstLFT[nVolIdx]->LLD_Open               = FSR_OND_Open;
+        pstLFT[nVolIdx]->LLD_Close              = FSR_OND_Close;
+        pstLFT[nVolIdx]->LLD_Erase              = FSR_OND_Erase;
+        pstLFT[nVolIdx]->LLD_ChkBadBlk          = FSR_OND_ChkBadBlk;
+        pstLFT[nVolIdx]->LLD_FlushOp            = FSR_OND_FlushOp;
+        pstLFT[nVolIdx]->LLD_GetDevSpec         = FSR_OND_GetDevSpec;
+        pstLFT[nVolIdx]->LLD_Read               = FSR_OND_Read;
+        pstLFT[nVolIdx]->LLD_ReadOptimal        = FSR_OND_ReadOptimal;
+        pstLFT[nVolIdx]->LLD_Write              = FSR_OND_Write;
+        pstLFT[nVolIdx]->LLD_CopyBack           = FSR_OND_CopyBack;
+        pstLFT[nVolIdx]->LLD_GetPrevOpData      = FSR_OND_GetPrevOpData;
+        pstLFT[nVolIdx]->LLD_IOCtl              = FSR_OND_IOCtl;
+        pstLFT[nVolIdx]->LLD_InitLLDStat        = FSR_OND_InitLLDStat;
+        pstLFT[nVolIdx]->LLD_GetStat            = FSR_OND_GetStat;
+        pstLFT[nVolIdx]->LLD_GetBlockInfo       = FSR_OND_GetBlockInfo;
+        pstLFT[nVolIdx]->LLD_GetNANDCtrllerInfo = FSR_OND_GetNANDCtrllerInfo;
+    }
+
+    return FSR_PAM_SUCCESS;
+}
+
+/**
+ * @brief           This function transfers data to NAND
+ *
+ * @param[in]      *pDst  : Destination array Pointer to be copied
+ * @param[in]      *pSrc  : Source data allocated Pointer
+ * @param[in]      *nSize : length to be transferred
+ *
+ * @return          none
+ *
+ * @remark          the emulated LLD moves DataRAM through FOE,
+ *                  this is only here for the other LLDs linked into tfsr
+ *
+ */
+PUBLIC VOID
+FSR_PAM_TransToNAND(volatile VOID *pDst,
+                    VOID          *pSrc,
+                    UINT32        nSize)
+{
+    FSR_OAM_MEMCPY((VOID *) pDst, pSrc, nSize);
+}
+
+/**
+ * @brief           This function transfers data from NAND
+ *
+ * @param[in]      *pDst  : Destination array Pointer to be copied
+ * @param[in]      *pSrc  : Source data allocated Pointer
+ * @param[in]      *nSize : length to be transferred
+ *
+ * @return          none
+ *
+ */
+PUBLIC VOID
+FSR_PAM_TransFromNAND(VOID          *pDst,
+                      volatile VOID *pSrc,
+                      UINT32         nSize)
+{
+    FSR_OAM_MEMCPY(pDst, (VOID *) pSrc, nSize);
+}
+
+/**
+ * @brief           This function initializes the specified logical interrupt.
+ *
+ * @param[in]       nLogIntId : Logical interrupt id
+ *
+ * @return          FSR_PAM_SUCCESS
+ *
+ * @remark          the emulator has no interrupt line, FSR polls
+ *
+ */
+PUBLIC INT32
+FSR_PAM_InitInt(UINT32 nLogIntId)
+{
+    return FSR_PAM_SUCCESS;
+}
+
+/**
+ * @brief           This function deinitializes the specified logical interrupt.
+ *
+ * @param[in]       nLogIntId : Logical interrupt id
+ *
+ * @return          FSR_PAM_SUCCESS
+ *
+ */
+PUBLIC INT32
+FSR_PAM_DeinitInt(UINT32 nLogIntId)
+{
+    return FSR_PAM_SUCCESS;
+}
+
+/**
+ * @brief           This function returns the physical interrupt ID from the logical interrupt ID
+ *
+ * @param[in]       nLogIntID : Logical interrupt id
+ *
+ * @return          physical interrupt ID
+ *
+ */
+PUBLIC UINT32
+FSR_PAM_GetPhyIntID(UINT32  nLogIntID)
+{
+    return 0;
+}
+
+/**
+ * @brief           This function enables the specified interrupt.
+ *
+ * @param[in]       nLogIntID : Logical interrupt id
+ *
+ * @return          FSR_PAM_SUCCESS
+ *
+ */
+PUBLIC INT32
+FSR_PAM_ClrNEnableInt(UINT32 nLogIntID)
+{
+    return FSR_PAM_SUCCESS;
+}
+
+/**
+ * @brief           This function disables the specified interrupt.
+ *
+ * @param[in]       nLogIntID : Logical interrupt id
+ *
+ * @return          FSR_PAM_SUCCESS
+ *
+ */
+PUBLIC INT32
+FSR_PAM_ClrNDisableInt(UINT32 nLogIntID)
+{
+    return FSR_PAM_SUCCESS;
+}
+
+/**
+ * @brief           This function creates spin lock for dual core.
+ *
+ * @param[out]     *pHandle : Handle of semaphore
+ * @param[in]       nLayer  : 0 : FSR_OAM_SM_TYPE_BDD
+ *                            0 : FSR_OAM_SM_TYPE_STL
+ *                            1 : FSR_OAM_SM_TYPE_BML
+ *                            2 : FSR_OAM_SM_TYPE_LLD
+ *
+ * @return          TRUE32
+ *
+ */
+PUBLIC BOOL32
+FSR_PAM_CreateSL(UINT32  *pHandle, UINT32  nLayer)
+{
+    return TRUE32;
+}
+
+/**
+ * @brief          This function acquires spin lock for dual core.
+ *
+ * @param[in]       nHandle : Handle of semaphore to be acquired
+ * @param[in]       nLayer  : layer of the lock
+ *
+ * @return          TRUE32
+ *
+ */
+PUBLIC BOOL32
+FSR_PAM_AcquireSL(UINT32  nHandle, UINT32  nLayer)
+{
+    return TRUE32;
+}
+
+/**
+ * @brief           This function releases spin lock for dual core.
+ *
+ * @param[in]       nHandle : Handle of semaphore to be released
+ * @param[in]       nLayer  : layer of the lock
+ *
+ * @return          TRUE32
+ *
+ */
+PUBLIC BOOL32
+FSR_PAM_ReleaseSL(UINT32  nHandle, UINT32  nLayer)
+{
+    return TRUE32;
+}
@@ -70,3 +70,44 @@ memcpy32 (VOID       *pDst,
         pDst32[nIdx] = pSrc32[nIdx];
     }
 }
+
+/**
+ * @brief           memcpy for DataRAM, 8 words per iteration
+ *
+ * @param[in]      *pDst  : word aligned destination
+ * @param[in]      *pSrc  : word aligned source
+ * @param[in]       nSize : bytes to copy, a multiple of 4
+ *
+ * @return          none
+ *
+ * @remark          C version of memcpy32_burst in FSR_PAM_asm.S
+ *
+ */
+PUBLIC VOID
+memcpy32_burst (VOID       *pDst,
+                VOID       *pSrc,
+                UINT32     nSize)
+{
+    UINT32  *pSrc32 = (UINT32 *) pSrc;
+    UINT32  *pDst32 = (UINT32 *) pDst;
+    UINT32   nSize32 = nSize / sizeof (UINT32);
+
+    for (; nSize32 >= 8; nSize32 -= 8)
+    {
+        pDst32[0] = pSrc32[0];
+        pDst32[1] = pSrc32[1];
+        pDst32[2] = pSrc32[2];
+        pDst32[3] = pSrc32[3];
+        pDst32[4] = pSrc32[4];
+        pDst32[5] = pSrc32[5];
+        pDst32[6] = pSrc32[6];
+        pDst32[7] = pSrc32[7];
+        pDst32 += 8;
+        pSrc32 += 8;
+    }
+
+    while (nSize32-- > 0)
+    {
+        *pDst32++ = *pSrc32++;
+    }
+}
@@ -36,6 +36,22 @@
  */
 
 //#include <stdlib.h>
+#if defined(FSR_LINUX_OAM)
+#include <linux/kernel.h>
+#include <linux/completion.h>
+#include <linux/dma-mapping.h>
+#include <linux/hardirq.h>
+#include <linux/hrtimer.h>
+#include <linux/irqflags.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#if defined(CONFIG_S3C_DMA_PL330)
+#include <mach/dma.h>
+#endif
+#endif
+
 #include "FSR.h"
 
 /*****************************************************************************/
@@ -118,10 +134,15 @@
         #define     FSR_ONENAND_PHY_BASE_ADDR       CONFIG_FSR_FLASH_PHYS_ADDR
     #endif
 
+    #if defined(CONFIG_S3C_DMA_PL330)
     /**< if FSR_ENABLE_WRITE_DMA is defined, write DMA is enabled */
-    #undef      FSR_ENABLE_WRITE_DMA
+    #define     FSR_ENABLE_WRITE_DMA
     /**< if FSR_ENABLE_READ_DMA is defined, read DMA is enabled */
+    #define     FSR_ENABLE_READ_DMA
+    #else
+    #undef      FSR_ENABLE_WRITE_DMA
     #undef      FSR_ENABLE_READ_DMA
+    #endif
 
 #else /* RTOS (such as Nucleus) or OSLess */
 
@@ -172,6 +193,22 @@
 #define     DBG_PRINT(x)            FSR_DBG_PRINT(x)
 #define     RTL_PRINT(x)            FSR_RTL_PRINT(x)
 
+#if defined(FSR_ENABLE_WRITE_DMA) || defined(FSR_ENABLE_READ_DMA)
+#define     FSR_PAM_USE_DMA
+#endif
+
+/* PL330 memory to memory channel for DataRAM transfers.
+ * M2M0~3 belong to the dmaengine front end, M2M7 to its benchmark. */
+#define     FSR_PAM_DMA_CH          DMACH_3D_M2M6
+/* one M2M burst is 16 beats of 4 bytes, DMA transfers are whole bursts */
+#define     FSR_PAM_DMA_ALIGN       (64)
+#define     FSR_PAM_DMA_TIMEOUT     (HZ / 10)
+#define     FSR_PAM_DMA_NEVER       (0xFFFFFFFF)
+
+/* self test : each size is transferred FSR_PAM_TEST_LOOPS times per path */
+#define     FSR_PAM_TEST_SIZE       (2048)
+#define     FSR_PAM_TEST_LOOPS      (64)
+
 
 /*****************************************************************************/
 /* Local typedefs                                                            */
@@ -186,6 +223,17 @@ PRIVATE BOOL32                  gbPAMInit                   = FALSE32;
 PRIVATE BOOL32                  gbUseWriteDMA               = FALSE32;
 PRIVATE BOOL32                  gbUseReadDMA                = FALSE32;
 PRIVATE UINT32                  gbFlexOneNAND[FSR_MAX_VOLS] = {FSR_OND_2K_PAGE, FSR_OND_2K_PAGE};
+#if defined(FSR_PAM_USE_DMA)
+PRIVATE UINT32                  gnONDVirBaseAddr            = 0;
+/* smallest transfer which goes through DMA, set by the self test */
+PRIVATE UINT32                  gnWriteDMAMinSize           = FSR_PAM_DMA_NEVER;
+PRIVATE UINT32                  gnReadDMAMinSize            = FSR_PAM_DMA_NEVER;
+PRIVATE struct completion       gstDMADone;
+PRIVATE INT32                   gnDMAResult;
+PRIVATE struct s3c2410_dma_client gstDMAClient = {
+    .name = "tfsr-pam",
+};
+#endif
 #if defined(FSR_ENABLE_ONENAND_LFT)
 PRIVATE volatile OneNANDReg     *gpOneNANDReg               = (volatile OneNANDReg *) 0;
 #elif defined(FSR_ENABLE_4K_ONENAND_LFT)
@@ -203,6 +251,9 @@ extern "C" {
 extern  VOID    memcpy32 (VOID       *pDst,
                           VOID       *pSrc,
                           UINT32     nSize);
+extern  VOID    memcpy32_burst (VOID       *pDst,
+                                VOID       *pSrc,
+                                UINT32     nSize);
 
 #if defined(FSR_WINCE_OAM)
 extern  UINT32  CheckMMU (VOID);
@@ -216,15 +267,353 @@ extern  UINT32  CheckMMU (VOID);
 /* Function Implementation                                                   */
 /*****************************************************************************/
 
+/**
+ * @brief           This function copies data between DataRAM and memory by CPU
+ *
+ * @param[in]      *pDst  : Destination
+ * @param[in]      *pSrc  : Source
+ * @param[in]       nLen  : length to be copied
+ *
+ * @return          none
+ *
+ * @remark          word aligned copies use 8 word LDM/STM bursts
+ *
+ */
 VOID
 FSR_PAM_Memcpy(VOID *pDst, VOID *pSrc, UINT32 nLen)
 {
+    if ((((UINT32) pDst | (UINT32) pSrc | nLen) & 0x03) == 0)
+    {
+        memcpy32_burst(pDst, pSrc, nLen);
+    }
+    else
+    {
+        memcpy32(pDst, pSrc, nLen);
+    }
+}
+
+#if defined(FSR_PAM_USE_DMA)
+/**
+ * @brief           PL330 callback at the end of a DataRAM transfer
+ *
+ */
+PRIVATE VOID
+_DMADone(struct s3c2410_dma_chan       *pChan,
+         VOID                          *pId,
+         INT32                          nSize,
+         enum s3c2410_dma_buffresult    eResult)
+{
+    gnDMAResult = (eResult == S3C2410_RES_OK) ? 0 : -EIO;
+    complete((struct completion *) pId);
+}
+
+/**
+ * @brief           This function requests the PL330 channel for DataRAM transfers
+ *
+ * @return          TRUE32 if the channel is ready
+ *
+ */
+PRIVATE BOOL32
+_InitDMA(VOID)
+{
+    if (s3c2410_dma_request(FSR_PAM_DMA_CH, &gstDMAClient, NULL) != 0)
+    {
+        RTL_PRINT((TEXT("[PAM:ERR]   can't get DMA channel %d\r\n"), FSR_PAM_DMA_CH));
+        return FALSE32;
+    }
 
+    init_completion(&gstDMADone);
+    s3c2410_dma_set_buffdone_fn(FSR_PAM_DMA_CH, _DMADone);
+    s3c2410_dma_config(FSR_PAM_DMA_CH, 4, 0);
+    s3c2410_dma_setflags(FSR_PAM_DMA_CH, S3C2410_DMAF_AUTOSTART);
 
-    memcpy32(pDst,pSrc,nLen);
-	
+    return TRUE32;
 }
 
+/**
+ * @brief           This function checks whether a transfer can use DMA
+ *
+ * @param[in]      *pMem     : memory side of the transfer
+ * @param[in]       nSize    : length to be transferred
+ * @param[in]       nMinSize : smallest transfer which is faster with DMA
+ * @param[in]       bRead    : TRUE32 if DMA writes pMem
+ *
+ * @return          TRUE32 if DMA can be used
+ *
+ * @remark          The memory has to be in the kernel linear mapping, i.e.
+ *                  physically contiguous (no vmalloc or kmap buffers).
+ *                  A buffer which DMA writes has to own its cache lines;
+ *                  invalidating a shared line would drop the neighbour's
+ *                  dirty data. Waiting for the DMA sleeps, so atomic
+ *                  callers copy by CPU.
+ *
+ */
+PRIVATE BOOL32
+_CanDMA(VOID   *pMem,
+        UINT32  nSize,
+        UINT32  nMinSize,
+        BOOL32  bRead)
+{
+    UINT32  nAlign = (bRead == TRUE32) ? L1_CACHE_BYTES - 1 : 0x03;
+
+    if ((nSize < nMinSize) || (nSize % FSR_PAM_DMA_ALIGN) != 0)
+    {
+        return FALSE32;
+    }
+
+    if (((UINT32) pMem & nAlign) != 0)
+    {
+        return FALSE32;
+    }
+
+    if (!virt_addr_valid(pMem) || !virt_addr_valid((UINT8 *) pMem + nSize - 1))
+    {
+        return FALSE32;
+    }
+
+    if (in_atomic() || irqs_disabled())
+    {
+        return FALSE32;
+    }
+
+    return TRUE32;
+}
+
+/**
+ * @brief           This function moves data between DataRAM and memory by DMA
+ *
+ * @param[in]      *pMem   : memory buffer
+ * @param[in]      *pNAND  : DataRAM address
+ * @param[in]       nSize  : length to be transferred
+ * @param[in]       bRead  : TRUE32 for DataRAM to memory
+ *
+ * @return          0 on success, negative errno otherwise
+ *
+ * @remark          BML serializes the calls with its volume lock
+ *
+ */
+PRIVATE INT32
+_TransDMA(VOID          *pMem,
+          volatile VOID *pNAND,
+          UINT32         nSize,
+          BOOL32         bRead)
+{
+    enum dma_data_direction eDir;
+    dma_addr_t  nMemPhys;
+    dma_addr_t  nNANDPhys;
+    INT32       nRe;
+
+    eDir      = (bRead == TRUE32) ? DMA_FROM_DEVICE : DMA_TO_DEVICE;
+    nNANDPhys = FSR_ONENAND_PHY_BASE_ADDR + ((UINT32) pNAND - gnONDVirBaseAddr);
+    nMemPhys  = dma_map_single(NULL, pMem, nSize, eDir);
+
+    INIT_COMPLETION(gstDMADone);
+    gnDMAResult = 0;
+
+    if (bRead == TRUE32)
+    {
+        s3c2410_dma_devconfig(FSR_PAM_DMA_CH, S3C_DMA_MEM2MEM, 0, nNANDPhys);
+        nRe = s3c2410_dma_enqueue(FSR_PAM_DMA_CH, &gstDMADone, nMemPhys, nSize);
+    }
+    else
+    {
+        s3c2410_dma_devconfig(FSR_PAM_DMA_CH, S3C_DMA_MEM2MEM, 0, nMemPhys);
+        nRe = s3c2410_dma_enqueue(FSR_PAM_DMA_CH, &gstDMADone, nNANDPhys, nSize);
+    }
+
+    if (nRe == 0)
+    {
+        if (wait_for_completion_timeout(&gstDMADone, FSR_PAM_DMA_TIMEOUT) == 0)
+        {
+            s3c2410_dma_ctrl(FSR_PAM_DMA_CH, S3C2410_DMAOP_FLUSH);
+            nRe = -ETIMEDOUT;
+        }
+        else
+        {
+            nRe = gnDMAResult;
+        }
+    }
+
+    dma_unmap_single(NULL, nMemPhys, nSize, eDir);
+
+    if (nRe != 0)
+    {
+        /* don't trust the channel any more, the caller copies by CPU */
+        RTL_PRINT((TEXT("[PAM:ERR]   DMA %s failed (%d), DMA disabled\r\n"),
+                (bRead == TRUE32) ? "read" : "write", nRe));
+        gbUseReadDMA  = FALSE32;
+        gbUseWriteDMA = FALSE32;
+    }
+
+    return nRe;
+}
+
+/**
+ * @brief           This function measures one transfer path
+ *
+ * @param[in]      *pMem   : memory buffer
+ * @param[in]      *pNAND  : DataRAM address
+ * @param[in]       nSize  : length of each transfer
+ * @param[in]       bRead  : TRUE32 for DataRAM to memory
+ * @param[in]       bDMA   : TRUE32 for DMA, FALSE32 for CPU
+ *
+ * @return          KB/s, 0 if a DMA transfer failed
+ *
+ */
+PRIVATE UINT32
+_MeasurePath(UINT8          *pMem,
+             volatile UINT8 *pNAND,
+             UINT32          nSize,
+             BOOL32          bRead,
+             BOOL32          bDMA)
+{
+    ktime_t     stStart;
+    s64         nUs;
+    UINT32      nLoop;
+
+    stStart = ktime_get();
+    for (nLoop = 0; nLoop < FSR_PAM_TEST_LOOPS; nLoop++)
+    {
+        if (bDMA == TRUE32)
+        {
+            if (_TransDMA(pMem, pNAND, nSize, bRead) != 0)
+            {
+                return 0;
+            }
+        }
+        else if (bRead == TRUE32)
+        {
+            FSR_PAM_Memcpy(pMem, (VOID *) pNAND, nSize);
+        }
+        else
+        {
+            FSR_PAM_Memcpy((VOID *) pNAND, pMem, nSize);
+        }
+    }
+    nUs = ktime_us_delta(ktime_get(), stStart);
+
+    return (UINT32) div64_u64((u64) nSize * FSR_PAM_TEST_LOOPS * 1000000ULL,
+                              (u64) max_t(s64, nUs, 1) * 1024);
+}
+
+/**
+ * @brief           This function picks the DataRAM transfer path at boot
+ *
+ * @return          none
+ *
+ * @remark          DataMB00 is scratch until the LLD opens the device.
+ *                  Each direction is first verified by DMA against CPU
+ *                  copies, then transfers of 512, 1024 and 2048 bytes are
+ *                  timed both ways; DMA is used from the smallest size at
+ *                  which it is faster. A direction whose DMA transfer fails
+ *                  or corrupts data stays on CPU copies.
+ *
+ */
+PRIVATE VOID
+_SelfTest(VOID)
+{
+    volatile UINT8 *pNAND = (volatile UINT8 *) &gpOneNANDReg->nDataMB00;
+    UINT8          *pBuf;
+    UINT8          *pRef;
+    UINT32          nSize;
+    UINT32          nIdx;
+    UINT32          nCpu;
+    UINT32          nDma;
+    BOOL32          bRead;
+    BOOL32          bOk;
+
+    pBuf = kmalloc(FSR_PAM_TEST_SIZE, GFP_KERNEL);
+    pRef = kmalloc(FSR_PAM_TEST_SIZE, GFP_KERNEL);
+    if ((pBuf == NULL) || (pRef == NULL))
+    {
+        kfree(pBuf);
+        kfree(pRef);
+        return;
+    }
+
+    for (nIdx = 0; nIdx < FSR_PAM_TEST_SIZE; nIdx++)
+    {
+        pRef[nIdx] = (UINT8) (nIdx * 7 + (nIdx >> 8));
+    }
+
+    for (bRead = FALSE32; bRead <= TRUE32; bRead++)
+    {
+        /* correctness : CPU -> DataRAM -> DMA, or DMA -> DataRAM -> CPU */
+        FSR_OAM_MEMSET(pBuf, 0x00, FSR_PAM_TEST_SIZE);
+        if (bRead == TRUE32)
+        {
+            FSR_PAM_Memcpy((VOID *) pNAND, pRef, FSR_PAM_TEST_SIZE);
+            bOk = (_TransDMA(pBuf, pNAND, FSR_PAM_TEST_SIZE, TRUE32) == 0);
+        }
+        else
+        {
+            FSR_OAM_MEMCPY(pBuf, pRef, FSR_PAM_TEST_SIZE);
+            bOk = (_TransDMA(pBuf, pNAND, FSR_PAM_TEST_SIZE, FALSE32) == 0);
+            FSR_PAM_Memcpy(pBuf, (VOID *) pNAND, FSR_PAM_TEST_SIZE);
+        }
+
+        if ((bOk == FALSE32) || (memcmp(pBuf, pRef, FSR_PAM_TEST_SIZE) != 0))
+        {
+            RTL_PRINT((TEXT("[PAM:ERR]   DMA %s self test failed, using CPU copies\r\n"),
+                    (bRead == TRUE32) ? "read" : "write"));
+            /* a failed transfer disables both directions */
+            if (bOk == FALSE32)
+            {
+                break;
+            }
+            continue;
+        }
+
+        for (nSize = 512; nSize <= FSR_PAM_TEST_SIZE; nSize <<= 1)
+        {
+            nCpu = _MeasurePath(pBuf, pNAND, nSize, bRead, FALSE32);
+            nDma = _MeasurePath(pBuf, pNAND, nSize, bRead, TRUE32);
+
+            RTL_PRINT((TEXT("[PAM:   ]   %s %4d bytes : cpu %6d KB/s, dma %6d KB/s\r\n"),
+                    (bRead == TRUE32) ? "read " : "write", nSize, nCpu, nDma));
+
+            if (nDma > nCpu)
+            {
+                if (bRead == TRUE32)
+                {
+                    gnReadDMAMinSize  = nSize;
+                }
+                else
+                {
+                    gnWriteDMAMinSize = nSize;
+                }
+                break;
+            }
+        }
+    }
+
+    if ((gbUseReadDMA == FALSE32) || (gbUseWriteDMA == FALSE32))
+    {
+        /* a DMA transfer failed during the test */
+        gnReadDMAMinSize  = FSR_PAM_DMA_NEVER;
+        gnWriteDMAMinSize = FSR_PAM_DMA_NEVER;
+    }
+
+    if (gnReadDMAMinSize == FSR_PAM_DMA_NEVER)
+    {
+        gbUseReadDMA  = FALSE32;
+    }
+    if (gnWriteDMAMinSize == FSR_PAM_DMA_NEVER)
+    {
+        gbUseWriteDMA = FALSE32;
+    }
+
+    RTL_PRINT((TEXT("[PAM:   ]   read DMA %s (>= %d), write DMA %s (>= %d)\r\n"),
+            gbUseReadDMA  ? "on" : "off", gnReadDMAMinSize,
+            gbUseWriteDMA ? "on" : "off", gnWriteDMAMinSize));
+
+    FSR_OAM_MEMSET((VOID *) pNAND, 0xFF, FSR_PAM_TEST_SIZE);
+
+    kfree(pBuf);
+    kfree(pRef);
+}
+#endif /* #if defined(FSR_PAM_USE_DMA) */
+
 
 
 /**
@@ -330,6 +719,20 @@ FSR_PAM_Init(VOID)
                     gpOneNANDReg->nMID, gpOneNANDReg->nDID));
         }
 
+#if defined(FSR_PAM_USE_DMA)
+        gnONDVirBaseAddr = nONDVirBaseAddr;
+        if (((gbUseReadDMA == TRUE32) || (gbUseWriteDMA == TRUE32)) &&
+            (_InitDMA() == TRUE32))
+        {
+            _SelfTest();
+        }
+        else
+        {
+            gbUseReadDMA  = FALSE32;
+            gbUseWriteDMA = FALSE32;
+        }
+#endif
+
         gstFsrVolParm[0].nBaseAddr[0] = nONDVirBaseAddr;
         gstFsrVolParm[0].nBaseAddr[1] = FSR_PAM_NOT_MAPPED;
         gstFsrVolParm[0].nIntID[0]    = FSR_INT_ID_NAND_0;
@@ -604,6 +1007,15 @@ FSR_PAM_TransToNAND(volatile VOID *pDst,
     FSR_ASSERT(((UINT32) pDst & 0x03) == 0x00000000);
     FSR_ASSERT(nSize > sizeof(UINT32));
 
+#if defined(FSR_PAM_USE_DMA)
+    if ((gbUseWriteDMA == TRUE32) &&
+        (_CanDMA(pSrc, nSize, gnWriteDMAMinSize, FALSE32) == TRUE32) &&
+        (_TransDMA(pSrc, pDst, nSize, FALSE32) == 0))
+    {
+        return;
+    }
+#endif
+
 	FSR_PAM_Memcpy((VOID *)pDst, (VOID *)pSrc, nSize);
 	   
 }
@@ -638,6 +1050,15 @@ FSR_PAM_TransFromNAND(VOID          *pDst,
     FSR_ASSERT(((UINT32) pDst & 0x03) == 0x00000000);
     FSR_ASSERT(nSize > sizeof(UINT32));
 
+#if defined(FSR_PAM_USE_DMA)
+    if ((gbUseReadDMA == TRUE32) &&
+        (_CanDMA(pDst, nSize, gnReadDMAMinSize, TRUE32) == TRUE32) &&
+        (_TransDMA(pDst, pSrc, nSize, TRUE32) == 0))
+    {
+        return;
+    }
+#endif
+
 	FSR_PAM_Memcpy((VOID *)pDst, (VOID *)pSrc, nSize);
 }
 
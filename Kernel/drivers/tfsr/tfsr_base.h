@@ -232,6 +232,19 @@ static inline unsigned int fsr_stl_page_size(stl_info_t *ssp)
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 0)
 #include <linux/blkdev.h>
 
+/* read statistics of one BML block device */
+struct fsr_dev_stats
+{
+	unsigned long		reqs;
+	unsigned long		sectors;
+	unsigned long		coalesced;	/* requests read through the bounce buffer */
+	unsigned long		calls;		/* FSR_BML_Read/ReadScts calls */
+	unsigned long		subpage;	/* FSR_BML_ReadScts calls */
+	unsigned long		errors;
+	unsigned long long	total_us;
+	unsigned long		max_us;
+};
+
 struct fsr_dev 
 {
 	struct request		*req;        
@@ -242,6 +255,7 @@ struct fsr_dev
 	struct gendisk		*gd;
 	int			dev_id;
 	struct scatterlist	*sg;
+	struct fsr_dev_stats	stats;
 };
 #else
 /* Kernel 2.4 */
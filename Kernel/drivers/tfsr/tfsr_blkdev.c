@@ -20,6 +20,10 @@
 #include <linux/fs.h>
 #include <linux/version.h>
 #include <linux/proc_fs.h>
+#include <linux/ktime.h>
+#include <linux/hrtimer.h>
+#include <linux/math64.h>
+#include <linux/scatterlist.h>
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 15)
 #include <linux/platform_device.h>
 #else
@@ -27,6 +31,9 @@
 #endif
 
 #include "tfsr_base.h"
+#ifdef CONFIG_TINY_FSR_SIM
+#include "FSR_FOE_Interface.h"
+#endif
 
 #define DEVICE_NAME             "tfsr"
 #define MAJOR_NR                BLK_DEVICE_TINY_FSR
@@ -37,6 +44,8 @@
 static DECLARE_MUTEX(bml_list_mutex);
 static LIST_HEAD(bml_list);
 
+static struct proc_dir_entry *bml_proc_dir;
+
 #ifdef CONFIG_PM
 #include <linux/pm.h>
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 15)
@@ -52,6 +61,292 @@ EXPORT_SYMBOL(bml_module_resume);
 
 #endif /* end of CONFIG_PM */
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
+/**
+ * One bounce buffer shared by all partitions. A request made of several
+ * segments is read with a single FSR_BML_Read() into it, so the LLD can
+ * pipeline the pages (superload, multi-plane), and then copied out.
+ */
+#define BML_MAX_REQ_SECTORS     256
+#define BML_BOUNCE_ORDER        get_order(BML_MAX_REQ_SECTORS << SECTOR_BITS)
+
+static u8 *bml_bounce;
+static DECLARE_MUTEX(bml_bounce_sem);
+
+/**
+ * read sectors through BML, whole pages in one call
+ * @param volume        : device number
+ * @param n1stVpn       : first virtual page of the partition
+ * @param sector        : first sector, relative to the partition
+ * @param nsect         : number of sectors
+ * @param buf           : destination
+ * @param st            : statistics of the partition
+ * @return              0 on success, -EIO on failure
+ *
+ * Only a leading and a trailing partial page go through FSR_BML_ReadScts()
+ */
+static int bml_read_range(u32 volume, u32 n1stVpn, unsigned long sector,
+		unsigned long nsect, u8 *buf, struct fsr_dev_stats *st)
+{
+	FSRVolSpec *vs = fsr_get_vol_spec(volume);
+	u32 spp = vs->nSctsPerPg;
+	u32 spp_shift = ffs(spp) - 1;
+	u32 spp_mask = spp - 1;
+	u32 n;
+	int ret = FSR_BML_SUCCESS;
+
+	/* leading partial page */
+	if (sector & spp_mask)
+	{
+		n = min_t(u32, nsect, spp - (sector & spp_mask));
+		ret = FSR_BML_ReadScts(volume, n1stVpn + (sector >> spp_shift),
+				sector & spp_mask, n, buf, NULL, FSR_BML_FLAG_ECC_ON);
+		st->calls++;
+		st->subpage++;
+		if (ret != FSR_BML_SUCCESS)
+		{
+			goto out;
+		}
+		sector += n;
+		nsect -= n;
+		buf += n << SECTOR_BITS;
+	}
+
+	/* whole pages */
+	n = nsect & ~spp_mask;
+	if (n)
+	{
+		ret = FSR_BML_Read(volume, n1stVpn + (sector >> spp_shift),
+				n >> spp_shift, buf, NULL, FSR_BML_FLAG_ECC_ON);
+		st->calls++;
+		if (ret != FSR_BML_SUCCESS)
+		{
+			goto out;
+		}
+		sector += n;
+		nsect -= n;
+		buf += n << SECTOR_BITS;
+	}
+
+	/* trailing partial page */
+	if (nsect)
+	{
+		ret = FSR_BML_ReadScts(volume, n1stVpn + (sector >> spp_shift),
+				0, nsect, buf, NULL, FSR_BML_FLAG_ECC_ON);
+		st->calls++;
+		st->subpage++;
+	}
+
+out:
+	if (ret != FSR_BML_SUCCESS)
+	{
+		ERRPRINTK("TINY: transfer error = %X\n", ret);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/**
+ * transfer a whole request from BML to buffer cache
+ * @param dev           : fsr block device
+ * @param req           : request description
+ * @return              0 on success, otherwise on error
+ */
+static int bml_transfer(struct fsr_dev *dev, struct request *req)
+{
+	u32 minor, volume, partno, n1stVpn = 0, nPgsPerUnit = 0;
+	unsigned long sector, nsect;
+	struct scatterlist *sg;
+	struct fsr_dev_stats *st = &dev->stats;
+	int i, nsg, ret = 0;
+
+	minor = dev->gd->first_minor;
+	volume = fsr_vol(minor);
+	partno = fsr_part(minor);
+
+	DEBUG(DL3,"TINY[I]: volume(%d), partno(%d)\n", volume, partno);
+
+	if (!blk_fs_request(req) || rq_data_dir(req) != READ)
+	{
+		ERRPRINTK("Unknown request 0x%x\n", (u32) rq_data_dir(req));
+		return -EINVAL;
+	}
+
+	if (!fsr_is_whole_dev(partno))
+	{
+		if (FSR_BML_GetVirUnitInfo(volume,
+			fsr_part_start(fsr_get_part_spec(volume), partno),
+			&n1stVpn, &nPgsPerUnit) != FSR_BML_SUCCESS)
+		{
+			ERRPRINTK("FSR_BML_GetVirUnitInfo FAIL\n");
+			return -EIO;
+		}
+	}
+
+	sector = blk_rq_pos(req);
+	nsect = blk_rq_sectors(req);
+	nsg = blk_rq_map_sg(dev->queue, req, dev->sg);
+
+	if (nsg > 1 && bml_bounce && nsect <= BML_MAX_REQ_SECTORS &&
+	    !down_trylock(&bml_bounce_sem))
+	{
+		u8 *buf = bml_bounce;
+
+		ret = bml_read_range(volume, n1stVpn, sector, nsect, buf, st);
+		if (!ret)
+		{
+			for_each_sg(dev->sg, sg, nsg, i)
+			{
+				memcpy(sg_virt(sg), buf, sg->length);
+				buf += sg->length;
+			}
+		}
+		up(&bml_bounce_sem);
+		st->coalesced++;
+	}
+	else
+	{
+		for_each_sg(dev->sg, sg, nsg, i)
+		{
+			ret = bml_read_range(volume, n1stVpn, sector,
+					sg->length >> SECTOR_BITS, sg_virt(sg), st);
+			if (ret)
+			{
+				break;
+			}
+			sector += sg->length >> SECTOR_BITS;
+		}
+	}
+
+	DEBUG(DL3,"TINY[O]: volume(%d), partno(%d)\n", volume, partno);
+
+	return ret;
+}
+
+/**
+ * request function which is do read/write sector
+ * @param rq    : request queue which is created by blk_init_queue()
+ * @return              none
+ *
+ * Each request is completed as a whole by one bml_transfer()
+ */
+static void bml_request(struct request_queue *rq)
+{
+	struct request *req;
+	struct fsr_dev *dev;
+	struct fsr_dev_stats *st;
+	ktime_t start;
+	unsigned long us;
+	int error;
+
+	DEBUG(DL3,"TINY[I]\n");
+
+	dev = rq->queuedata;
+	if (dev->req)
+		return;
+
+	st = &dev->stats;
+
+	while ((dev->req = req = blk_fetch_request(rq)) != NULL)
+	{
+		spin_unlock_irq(rq->queue_lock);
+
+		start = ktime_get();
+		error = bml_transfer(dev, req);
+		us = (unsigned long) ktime_us_delta(ktime_get(), start);
+
+		st->reqs++;
+		st->sectors += blk_rq_sectors(req);
+		st->total_us += us;
+		if (us > st->max_us)
+		{
+			st->max_us = us;
+		}
+		if (error)
+		{
+			st->errors++;
+		}
+
+		spin_lock_irq(rq->queue_lock);
+		__blk_end_request_all(req, error);
+	}
+
+	DEBUG(DL3,"TINY[O]\n");
+}
+
+/**
+ * show per-partition read statistics in /proc/tinyFSR/bml_stats
+ */
+static int bml_stats_read_proc(char *page, char **start, off_t off,
+		int count, int *eof, void *data)
+{
+	struct fsr_dev *dev;
+	struct fsr_dev_stats *st;
+	unsigned long long kbps;
+	int len;
+
+	len = snprintf(page, count, "%-12s %8s %10s %8s %7s %7s %8s %8s %7s %6s\n",
+			"disk", "reqs", "sectors", "KB/s", "avg_us", "max_us",
+			"coalesc", "calls", "subpg", "errors");
+
+	down(&bml_list_mutex);
+	list_for_each_entry(dev, &bml_list, list)
+	{
+		st = &dev->stats;
+		kbps = st->total_us ?
+			div64_u64((u64) st->sectors * 500000, st->total_us) : 0;
+		len += snprintf(page + len, count - len,
+			"%-12s %8lu %10lu %8llu %7lu %7lu %8lu %8lu %7lu %6lu\n",
+			dev->gd->disk_name, st->reqs, st->sectors, kbps,
+			st->reqs ? (unsigned long) div64_u64(st->total_us, st->reqs) : 0,
+			st->max_us, st->coalesced, st->calls, st->subpage,
+			st->errors);
+		if (len >= count)
+		{
+			len = count;
+			break;
+		}
+	}
+	up(&bml_list_mutex);
+
+	*eof = 1;
+	return len;
+}
+
+#ifdef CONFIG_TINY_FSR_SIM
+/**
+ * show the counters of the emulated OneNAND in /proc/tinyFSR/foe_stats
+ */
+static int foe_stats_read_proc(char *page, char **start, off_t off,
+		int count, int *eof, void *data)
+{
+	FOEStat st;
+	int len;
+
+	*eof = 1;
+	if (FSR_FOE_GetStat(0, &st) != FSR_FOE_SUCCESS)
+		return 0;
+
+	len = snprintf(page, count,
+		"blocks      %u (%u plane)\n"
+		"allocated   %u\n"
+		"loads       %u\n"
+		"programs    %u (%u failed)\n"
+		"erases      %u (%u failed)\n"
+		"ecc_errors  %u\n"
+		"lock_errors %u\n"
+		"busy_us     %u (%u polls)\n"
+		"transferred %u\n",
+		st.nNumOfBlks, st.nNumOfPlanes, st.nAllocBlks, st.nLoads,
+		st.nPgms, st.nPgmFails, st.nErases, st.nEraseFails,
+		st.nEccFails, st.nLockErrs, st.nBusyUs, st.nBusyPolls,
+		st.nTransBytes);
+
+	return min(len, count);
+}
+#endif
+#else
 /**
  * transger data from BML to buffer cache
  * @param volume        : device number
@@ -61,11 +356,7 @@ EXPORT_SYMBOL(bml_module_resume);
  *
  * It will erase a block before it do write the data
  */
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
-static int bml_transfer(u32 volume, u32 partno, const struct request *req, u32 data_len)
-#else
 static int bml_transfer(u32 volume, u32 partno, const struct request *req)
-#endif
 {
 	unsigned long sector, nsect;
 	char *buf;
@@ -81,13 +372,8 @@ static int bml_transfer(u32 volume, u32 partno, const struct request *req)
 		return 0;
 	}
 
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
-	sector = blk_rq_pos(req);
-	nsect = data_len >> 9;
-#else
 	sector = req->sector;
 	nsect = req->current_nr_sectors;
-#endif
 	buf = req->buffer;
 	
 	vs = fsr_get_vol_spec(volume);
@@ -156,10 +442,6 @@ static void bml_request(struct request_queue *rq)
 	int ret;
 #endif
 	int trans_ret;
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
-	int error = 0;
-	u32 len = 0;
-#endif
 
 	FSRVolSpec *vs;
 
@@ -169,11 +451,7 @@ static void bml_request(struct request_queue *rq)
 	if (dev->req)
 		return;
 
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
-	while ((dev->req = req = blk_peek_request(rq)) != NULL)
-#else
 	while ((dev->req = req = elv_next_request(rq)) != NULL) 
-#endif
 	{
 		spin_unlock_irq(rq->queue_lock);
 		
@@ -185,23 +463,6 @@ static void bml_request(struct request_queue *rq)
 		
 		DEBUG(DL3,"TINY[I]: volume(%d), partno(%d)\n", volume, partno);
 
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
-		len = blk_rq_cur_bytes(req);
-		if (!( blk_rq_pos(req) & spp_mask) && ( blk_rq_cur_sectors(req) != blk_rq_sectors(req)))
-		{
-			blk_rq_map_sg(rq, req, dev->sg);
-			if (!((dev->sg->length >> SECTOR_BITS) & 0x7))
-			{
-				len = dev->sg->length;
-			}
-			if (len > blk_rq_bytes(req))
-			{
-				len = blk_rq_bytes(req);
-			}
-
-		}
-		trans_ret = bml_transfer(volume, partno, req, len);
-#else
 		if (!(req->sector & spp_mask) && (req->current_nr_sectors != req->nr_sectors))
 		{
 			blk_rq_map_sg(rq, req, dev->sg);
@@ -215,23 +476,9 @@ static void bml_request(struct request_queue *rq)
 			}
 		}
 		trans_ret = bml_transfer(volume, partno, req);
-#endif
 		
 		spin_lock_irq(rq->queue_lock);
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
-		if (trans_ret)
-		{
-			error = 0;
-		} else
-		{
-			error = -EIO;
-		}
-		/* don't need to check if request is finished */
-		if (blk_rq_sectors(req) <= (len >> 9))
-			list_del_init(&req->queuelist);
-		__blk_end_request(req, error, len);
-
-#elif LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 25)
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 25)
 		req->hard_cur_sectors = req->current_nr_sectors;
 		end_request(req, trans_ret);
 #else	
@@ -253,6 +500,7 @@ static void bml_request(struct request_queue *rq)
 
 	DEBUG(DL3,"TINY[O]\n");
 }
+#endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31) */
 
 /**
  * add each partitions as disk
@@ -287,6 +535,10 @@ static int bml_add_disk(u32 volume, u32 partno)
 	dev->queue = blk_init_queue(bml_request, &dev->lock);
 	dev->queue->queuedata = dev;
 	dev->req = NULL;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
+	/* keep requests page aligned and within the bounce buffer */
+	blk_queue_max_sectors(dev->queue, BML_MAX_REQ_SECTORS);
+#endif
 
 	/* alloc scatterlist */
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
@@ -581,6 +833,15 @@ int __init bml_blkdev_init(void)
 		return -EAGAIN;
 	}
 	
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
+	/* without it every segment is read on its own */
+	bml_bounce = (u8 *) __get_free_pages(GFP_KERNEL, BML_BOUNCE_ORDER);
+	if (!bml_bounce)
+	{
+		ERRPRINTK("TinyFSR: no bounce buffer, reads are not coalesced\n");
+	}
+#endif
+
 	if (bml_blkdev_create()) 
 	{
 		unregister_blkdev(MAJOR_NR, DEVICE_NAME);
@@ -611,6 +872,19 @@ int __init bml_blkdev_init(void)
 		return -ENODEV;
 	}
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
+	bml_proc_dir = proc_mkdir(TINYFSR_PROC_DIR, NULL);
+	if (bml_proc_dir)
+	{
+		create_proc_read_entry("bml_stats", S_IRUGO, bml_proc_dir,
+				bml_stats_read_proc, NULL);
+#ifdef CONFIG_TINY_FSR_SIM
+		create_proc_read_entry("foe_stats", S_IRUGO, bml_proc_dir,
+				foe_stats_read_proc, NULL);
+#endif
+	}
+#endif
+
 	DEBUG(DL3,"TINY[O]\n");
 
 	return 0;
@@ -635,6 +909,17 @@ void __exit bml_blkdev_exit(void)
 		}
 	}
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
+	if (bml_proc_dir)
+	{
+		remove_proc_entry("bml_stats", bml_proc_dir);
+#ifdef CONFIG_TINY_FSR_SIM
+		remove_proc_entry("foe_stats", bml_proc_dir);
+#endif
+		remove_proc_entry(TINYFSR_PROC_DIR, NULL);
+	}
+#endif
+
 	platform_device_unregister(&tfsr_device);
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 15)
         platform_driver_unregister(&tfsr_driver);
@@ -643,6 +928,13 @@ void __exit bml_blkdev_exit(void)
 #endif
 	bml_blkdev_free();
 	unregister_blkdev(MAJOR_NR, DEVICE_NAME);
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
+	if (bml_bounce)
+	{
+		free_pages((unsigned long) bml_bounce, BML_BOUNCE_ORDER);
+	}
+#endif
 }
 
 MODULE_LICENSE("GPL");
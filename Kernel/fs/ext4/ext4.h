@@ -799,6 +799,12 @@ struct ext4_inode_info {
 	 */
 	tid_t i_sync_tid;
 	tid_t i_datasync_tid;
+
+	/*
+	 * Last transaction which changed the inode in a way a fast commit
+	 * cannot describe; see ext4_fc_mark_ineligible().
+	 */
+	tid_t i_fc_ineligible_tid;
 };
 
 /*
@@ -840,6 +846,7 @@ struct ext4_inode_info {
 #define EXT4_MOUNT_QUOTA		0x80000 /* Some quota option set */
 #define EXT4_MOUNT_USRQUOTA		0x100000 /* "old" user quota */
 #define EXT4_MOUNT_GRPQUOTA		0x200000 /* "old" group quota */
+#define EXT4_MOUNT_FAST_COMMIT		0x400000 /* fsync by fast commits */
 #define EXT4_MOUNT_JOURNAL_CHECKSUM	0x800000 /* Journal checksums */
 #define EXT4_MOUNT_JOURNAL_ASYNC_COMMIT	0x1000000 /* Journal Async Commit */
 #define EXT4_MOUNT_I_VERSION            0x2000000 /* i_version support */
@@ -1482,6 +1489,7 @@ extern void ext4_htree_free_dir_info(struct dir_private_info *p);
 
 /* fsync.c */
 extern int ext4_sync_file(struct file *, struct dentry *, int);
+extern int ext4_fc_replay(journal_t *, void *, int);
 
 /* hash.c */
 extern int ext4fs_dirhash(const char *name, int len, struct
@@ -271,6 +271,21 @@ static inline void ext4_update_inode_fsync_trans(handle_t *handle,
 	}
 }
 
+/*
+ * A fast commit only logs the on-disk inode, so it can not describe a
+ * transaction which also changed block maps, bitmaps, directories, the
+ * orphan list, xattr blocks or quota for the inode.  Every such change
+ * marks the inode, and fsync falls back to a full commit until the
+ * transaction holding the change has committed.
+ */
+static inline void ext4_fc_mark_ineligible(handle_t *handle,
+					   struct inode *inode)
+{
+	if (ext4_handle_valid(handle))
+		EXT4_I(inode)->i_fc_ineligible_tid =
+			handle->h_transaction->t_tid;
+}
+
 /* super.c */
 int ext4_force_commit(struct super_block *sb);
 
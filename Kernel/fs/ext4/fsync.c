@@ -28,6 +28,7 @@
 #include <linux/writeback.h>
 #include <linux/jbd2.h>
 #include <linux/blkdev.h>
+#include <linux/slab.h>
 
 #include "ext4.h"
 #include "ext4_jbd2.h"
@@ -57,6 +58,141 @@ static void ext4_sync_parent(struct inode *inode)
 	}
 }
 
+/*
+ * Fast commit record: a copy of the on-disk inode.
+ */
+struct ext4_fc_inode {
+	__le32	fc_ino;
+	__le16	fc_len;		/* bytes of raw inode that follow */
+	__le16	fc_pad;
+};
+
+/*
+ * If the running transaction changed nothing but the on-disk inode of
+ * @inode (size, times, mode) and the data in blocks it already owned,
+ * log a copy of the inode in a fast commit block instead of committing
+ * the whole transaction.  This is what SQLite does on every transaction:
+ * overwrite pages of the database in place and fsync.
+ *
+ * Returns -EAGAIN when a full commit is needed.
+ */
+static int ext4_fc_commit(struct inode *inode, tid_t commit_tid)
+{
+	struct super_block *sb = inode->i_sb;
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	journal_t *journal = EXT4_SB(sb)->s_journal;
+	int size = EXT4_INODE_SIZE(sb);
+	struct ext4_fc_inode *fc;
+	struct ext4_iloc iloc;
+	int ret;
+
+	if (!S_ISREG(inode->i_mode) ||
+	    !tid_gt(commit_tid, ei->i_fc_ineligible_tid))
+		return -EAGAIN;
+
+	/*
+	 * The caller only started the data writeout.  It has to be on
+	 * disk before the record that makes it visible: the fast commit
+	 * block is written with a barrier, but that does not cover the
+	 * fs device if the journal is external.
+	 */
+	ret = filemap_fdatawait(inode->i_mapping);
+	if (ret)
+		return ret;
+	if (journal->j_fs_dev != journal->j_dev &&
+	    (journal->j_flags & JBD2_BARRIER))
+		blkdev_issue_flush(sb->s_bdev, NULL);
+
+	fc = kmalloc(sizeof(*fc) + size, GFP_NOFS);
+	if (!fc)
+		return -EAGAIN;
+	ret = ext4_get_inode_loc(inode, &iloc);
+	if (ret)
+		goto out;
+
+	down_read(&ei->i_data_sem);
+	fc->fc_ino = cpu_to_le32(inode->i_ino);
+	fc->fc_len = cpu_to_le16(size);
+	fc->fc_pad = 0;
+	memcpy(fc + 1, ext4_raw_inode(&iloc), size);
+	up_read(&ei->i_data_sem);
+	brelse(iloc.bh);
+
+	/*
+	 * Writeback may have allocated blocks for the inode meanwhile; it
+	 * marks the inode before it changes the block map.
+	 */
+	smp_rmb();
+	if (!tid_gt(commit_tid, ei->i_fc_ineligible_tid)) {
+		ret = -EAGAIN;
+		goto out;
+	}
+
+	ret = jbd2_journal_fc_commit(journal, commit_tid, fc,
+				     sizeof(*fc) + size);
+out:
+	kfree(fc);
+	return ret;
+}
+
+/*
+ * Has @tid already committed?  An fsync then needs no commit at all, fast
+ * or full, and is not counted as either.
+ */
+static int ext4_tid_committed(journal_t *journal, tid_t tid)
+{
+	int ret;
+
+	spin_lock(&journal->j_state_lock);
+	ret = tid_geq(journal->j_commit_sequence, tid);
+	spin_unlock(&journal->j_state_lock);
+	return ret;
+}
+
+/*
+ * Called by the journal recovery for each fast commit record which
+ * follows the last committed transaction: put the inode copy back into
+ * the inode table.
+ */
+int ext4_fc_replay(journal_t *journal, void *data, int len)
+{
+	struct super_block *sb = journal->j_private;
+	struct ext4_fc_inode *fc = data;
+	struct ext4_group_desc *gdp;
+	struct buffer_head *bh;
+	unsigned long ino, offset;
+	ext4_group_t group;
+	ext4_fsblk_t block;
+	int size;
+
+	if (len < sizeof(*fc))
+		return -EINVAL;
+	ino = le32_to_cpu(fc->fc_ino);
+	size = le16_to_cpu(fc->fc_len);
+	if (ino < EXT4_FIRST_INO(sb) ||
+	    ino > le32_to_cpu(EXT4_SB(sb)->s_es->s_inodes_count) ||
+	    size != EXT4_INODE_SIZE(sb) || len < sizeof(*fc) + size)
+		return -EINVAL;
+
+	group = (ino - 1) / EXT4_INODES_PER_GROUP(sb);
+	offset = ((ino - 1) % EXT4_INODES_PER_GROUP(sb)) * size;
+	gdp = ext4_get_group_desc(sb, group, NULL);
+	if (!gdp)
+		return -EIO;
+	block = ext4_inode_table(sb, gdp) +
+		(offset >> EXT4_BLOCK_SIZE_BITS(sb));
+
+	bh = sb_bread(sb, block);
+	if (!bh)
+		return -EIO;
+	lock_buffer(bh);
+	memcpy(bh->b_data + (offset & (sb->s_blocksize - 1)), fc + 1, size);
+	unlock_buffer(bh);
+	mark_buffer_dirty(bh);
+	brelse(bh);
+	return 0;
+}
+
 /*
  * akpm: A new design for ext4_sync_file().
  *
@@ -115,6 +251,14 @@ int ext4_sync_file(struct file *file, struct dentry *dentry, int datasync)
 		return ext4_force_commit(inode->i_sb);
 
 	commit_tid = datasync ? ei->i_datasync_tid : ei->i_sync_tid;
+	if (test_opt(inode->i_sb, FAST_COMMIT) &&
+	    !ext4_tid_committed(journal, commit_tid)) {
+		ret = ext4_fc_commit(inode, commit_tid);
+		if (ret != -EAGAIN)
+			return ret;
+		jbd2_journal_fc_fallback(journal);
+		ret = 0;
+	}
 	if (jbd2_log_start_commit(journal, commit_tid)) {
 		/*
 		 * When the journal is on a different device than the
@@ -1024,6 +1024,7 @@ got:
 
 	ei->i_state_flags = 0;
 	ext4_set_inode_state(inode, EXT4_STATE_NEW);
+	ext4_fc_mark_ineligible(handle, inode);
 
 	ei->i_extra_isize = EXT4_SB(sb)->s_want_extra_isize;
 
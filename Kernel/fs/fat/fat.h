@@ -6,6 +6,7 @@
 #include <linux/nls.h>
 #include <linux/fs.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 #include <linux/msdos_fs.h>
 
 /*
@@ -43,6 +44,7 @@ struct fat_mount_options {
 		 flush:1,	  /* write things quickly */
 		 nocase:1,	  /* Does this need case conversion? 0=need case conversion*/
 		 usefree:1,	  /* Use free_clusters for FAT32 */
+		 nofreemap:1,	  /* Don't build the free cluster bitmap */
 		 tz_utc:1,	  /* Filesystem timestamps are in UTC */
 		 rodir:1;	  /* allow ATTR_RO for directory */
 };
@@ -70,6 +72,10 @@ struct msdos_sb_info {
 	unsigned int prev_free;      /* previously allocated cluster number */
 	unsigned int free_clusters;  /* -1 if undefined */
 	unsigned int free_clus_valid; /* is free_clusters valid? */
+	unsigned long *free_map;     /* bit set for each cluster in use */
+	unsigned int free_map_valid; /* is free_map complete? */
+	unsigned int free_map_stop;  /* stop building free_map */
+	struct work_struct free_map_work; /* builds free_map */
 	struct fat_mount_options options;
 	struct nls_table *nls_disk;  /* Codepage used on disk */
 	struct nls_table *nls_io;    /* Charset used for input and display */
@@ -296,6 +302,11 @@ extern int fat_alloc_clusters(struct inode *inode, int *cluster,
 			      int nr_cluster);
 extern int fat_free_clusters(struct inode *inode, int cluster);
 extern int fat_count_free_clusters(struct super_block *sb);
+extern void fat_free_map_start(struct super_block *sb);
+extern void fat_free_map_wait(struct super_block *sb);
+extern void fat_free_map_stop(struct super_block *sb);
+extern void fat_free_map_init(void);
+extern void fat_free_map_destroy(void);
 
 /* fat/file.c */
 extern int fat_generic_ioctl(struct inode *inode, struct file *filp,
@@ -7,6 +7,8 @@
 #include <linux/fs.h>
 #include <linux/msdos_fs.h>
 #include <linux/blkdev.h>
+#include <linux/vmalloc.h>
+#include <linux/sched.h>
 #include "fat.h"
 
 struct fatent_operations {
@@ -452,6 +454,118 @@ static void fat_collect_bhs(struct buffer_head **bhs, int *nr_bhs,
 	}
 }
 
+/*
+ * Returns the first free cluster at or after @start, wrapping around to
+ * FAT_START_ENT, or -1 if there is none.
+ */
+static int fat_map_next_free(struct msdos_sb_info *sbi, int start)
+{
+	int entry;
+
+	if (start < FAT_START_ENT || start >= sbi->max_cluster)
+		start = FAT_START_ENT;
+	entry = find_next_zero_bit(sbi->free_map, sbi->max_cluster, start);
+	if (entry < sbi->max_cluster)
+		return entry;
+	entry = find_next_zero_bit(sbi->free_map, start, FAT_START_ENT);
+	if (entry < start)
+		return entry;
+	return -1;
+}
+
+/*
+ * Returns the start of the first run of @nr free clusters at or after
+ * @start, wrapping around.  If there is no such run, falls back to the
+ * first free cluster.
+ */
+static int fat_map_find(struct msdos_sb_info *sbi, int start, int nr)
+{
+	int pos, end, limit, pass;
+
+	if (start < FAT_START_ENT || start >= sbi->max_cluster)
+		start = FAT_START_ENT;
+	pos = start;
+	limit = sbi->max_cluster;
+	for (pass = 0; pass < 2; pass++) {
+		while (pos < limit) {
+			pos = find_next_zero_bit(sbi->free_map, limit, pos);
+			if (pos >= limit)
+				break;
+			end = find_next_bit(sbi->free_map, sbi->max_cluster,
+					    pos);
+			if (end - pos >= nr)
+				return pos;
+			pos = end;
+		}
+		pos = FAT_START_ENT;
+		limit = start;
+	}
+	return fat_map_next_free(sbi, start);
+}
+
+/*
+ * fat_alloc_clusters() with the free cluster bitmap: no FAT blocks are
+ * read to find the free entries, and the clusters are taken from a run
+ * of free clusters when there is one.  Called with fat_lock held.
+ */
+static int fat_map_alloc(struct inode *inode, int *cluster, int nr_cluster,
+			 struct buffer_head **bhs, int *nr_bhs, int *idx_clus)
+{
+	struct super_block *sb = inode->i_sb;
+	struct msdos_sb_info *sbi = MSDOS_SB(sb);
+	struct fatent_operations *ops = sbi->fatent_ops;
+	struct fat_entry fatent, prev_ent;
+	int entry, err = 0;
+
+	fatent_init(&prev_ent);
+	fatent_init(&fatent);
+	entry = fat_map_find(sbi, sbi->prev_free + 1, nr_cluster);
+	while (*idx_clus < nr_cluster) {
+		if (entry < 0) {
+			sbi->free_clusters = 0;
+			sbi->free_clus_valid = 1;
+			sb->s_dirt = 1;
+			err = -ENOSPC;
+			break;
+		}
+		err = fat_ent_read(inode, &fatent, entry);
+		if (err < 0)
+			break;
+		if (err != FAT_ENT_FREE) {
+			fat_fs_error(sb, "%s: free cluster bitmap is out of "
+				     "sync (entry 0x%08x)", __func__, entry);
+			err = -EIO;
+			break;
+		}
+		err = 0;
+
+		/* make the cluster chain */
+		ops->ent_put(&fatent, FAT_ENT_EOF);
+		if (prev_ent.nr_bhs)
+			ops->ent_put(&prev_ent, entry);
+
+		fat_collect_bhs(bhs, nr_bhs, &fatent);
+
+		__set_bit(entry, sbi->free_map);
+		sbi->prev_free = entry;
+		if (sbi->free_clusters != -1)
+			sbi->free_clusters--;
+		sb->s_dirt = 1;
+
+		cluster[*idx_clus] = entry;
+		(*idx_clus)++;
+
+		/*
+		 * fat_collect_bhs() gets ref-count of bhs,
+		 * so we can still use the prev_ent.
+		 */
+		prev_ent = fatent;
+		entry = fat_map_next_free(sbi, entry + 1);
+	}
+	fatent_brelse(&fatent);
+	return err;
+}
+
 int fat_alloc_clusters(struct inode *inode, int *cluster, int nr_cluster)
 {
 	struct super_block *sb = inode->i_sb;
@@ -471,9 +585,15 @@ int fat_alloc_clusters(struct inode *inode, int *cluster, int nr_cluster)
 	}
 
 	err = nr_bhs = idx_clus = 0;
+	fatent_init(&fatent);
+	if (sbi->free_map_valid) {
+		err = fat_map_alloc(inode, cluster, nr_cluster, bhs, &nr_bhs,
+				    &idx_clus);
+		goto out;
+	}
+
 	count = FAT_START_ENT;
 	fatent_init(&prev_ent);
-	fatent_init(&fatent);
 	fatent_set_entry(&fatent, sbi->prev_free + 1);
 	while (count < sbi->max_cluster) {
 		if (fatent.entry >= sbi->max_cluster)
@@ -495,6 +615,8 @@ int fat_alloc_clusters(struct inode *inode, int *cluster, int nr_cluster)
 
 				fat_collect_bhs(bhs, &nr_bhs, &fatent);
 
+				if (sbi->free_map)
+					__set_bit(entry, sbi->free_map);
 				sbi->prev_free = entry;
 				if (sbi->free_clusters != -1)
 					sbi->free_clusters--;
@@ -579,6 +701,8 @@ int fat_free_clusters(struct inode *inode, int cluster)
 		}
 
 		ops->ent_put(&fatent, FAT_ENT_FREE);
+		if (sbi->free_map)
+			__clear_bit(fatent.entry, sbi->free_map);
 		if (sbi->free_clusters != -1) {
 			sbi->free_clusters++;
 			sb->s_dirt = 1;
@@ -677,3 +801,116 @@ out:
 	unlock_fat(sbi);
 	return err;
 }
+
+/*
+ * The free cluster bitmap is built in the background after mount, one
+ * FAT block at a time under fat_lock, so that allocations can go on
+ * meanwhile.  fat_alloc_clusters() and fat_free_clusters() keep the bits
+ * in sync from the start: a block the builder has not reached yet is
+ * read from the FAT anyway.  Once complete, it also gives the count of
+ * free clusters, so statfs() does not have to walk the FAT again.
+ */
+static struct workqueue_struct *fat_map_wq;
+
+static void fat_free_map_build(struct work_struct *work)
+{
+	struct msdos_sb_info *sbi =
+		container_of(work, struct msdos_sb_info, free_map_work);
+	struct super_block *sb = sbi->fat_inode->i_sb;
+	struct fatent_operations *ops = sbi->fatent_ops;
+	struct fat_entry fatent;
+	unsigned long reada_blocks, reada_mask, cur_block;
+
+	reada_blocks = FAT_READA_SIZE >> sb->s_blocksize_bits;
+	reada_mask = reada_blocks - 1;
+	cur_block = 0;
+
+	fatent_init(&fatent);
+	fatent_set_entry(&fatent, FAT_START_ENT);
+	while (fatent.entry < sbi->max_cluster) {
+		if (sbi->free_map_stop)
+			goto out;
+
+		/* readahead of fat blocks */
+		if ((cur_block & reada_mask) == 0) {
+			unsigned long rest = sbi->fat_length - cur_block;
+			fat_ent_reada(sb, &fatent, min(reada_blocks, rest));
+		}
+		cur_block++;
+
+		lock_fat(sbi);
+		if (fat_ent_read_block(sb, &fatent)) {
+			unlock_fat(sbi);
+			goto out;
+		}
+		do {
+			if (ops->ent_get(&fatent) == FAT_ENT_FREE)
+				__clear_bit(fatent.entry, sbi->free_map);
+			else
+				__set_bit(fatent.entry, sbi->free_map);
+		} while (fat_ent_next(sbi, &fatent));
+		unlock_fat(sbi);
+
+		cond_resched();
+	}
+
+	lock_fat(sbi);
+	__set_bit(0, sbi->free_map);
+	__set_bit(1, sbi->free_map);
+	sbi->free_clusters = sbi->max_cluster -
+		bitmap_weight(sbi->free_map, sbi->max_cluster);
+	sbi->free_clus_valid = 1;
+	sbi->free_map_valid = 1;
+	sb->s_dirt = 1;
+	unlock_fat(sbi);
+out:
+	fatent_brelse(&fatent);
+}
+
+void fat_free_map_start(struct super_block *sb)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(sb);
+
+	INIT_WORK(&sbi->free_map_work, fat_free_map_build);
+	if (!fat_map_wq || sbi->options.nofreemap)
+		return;
+	sbi->free_map = vmalloc(BITS_TO_LONGS(sbi->max_cluster) *
+				sizeof(unsigned long));
+	if (!sbi->free_map)
+		return;
+	queue_work(fat_map_wq, &sbi->free_map_work);
+}
+
+/* Wait for the free cluster bitmap, and so the count, to be built. */
+void fat_free_map_wait(struct super_block *sb)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(sb);
+
+	if (sbi->free_map && !sbi->free_map_valid)
+		flush_work(&sbi->free_map_work);
+}
+
+void fat_free_map_stop(struct super_block *sb)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(sb);
+
+	if (!sbi->free_map)
+		return;
+	sbi->free_map_stop = 1;
+	cancel_work_sync(&sbi->free_map_work);
+	vfree(sbi->free_map);
+	sbi->free_map = NULL;
+	sbi->free_map_valid = 0;
+}
+
+void __init fat_free_map_init(void)
+{
+	/* Not fatal: allocations just scan the FAT without it */
+	fat_map_wq = create_singlethread_workqueue("fat_map");
+}
+
+void fat_free_map_destroy(void)
+{
+	if (fat_map_wq)
+		destroy_workqueue(fat_map_wq);
+}
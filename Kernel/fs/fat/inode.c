@@ -467,6 +467,8 @@ static void fat_put_super(struct super_block *sb)
 {
 	struct msdos_sb_info *sbi = MSDOS_SB(sb);
 
+	fat_free_map_stop(sb);
+
 	lock_kernel();
 
 	if (sb->s_dirt)
@@ -545,6 +547,8 @@ static int fat_statfs(struct dentry *dentry, struct kstatfs *buf)
 	u64 id = huge_encode_dev(sb->s_bdev->bd_dev);
 
 	/* If the count of free cluster is still unknown, counts it here. */
+	if (sbi->free_clusters == -1 || !sbi->free_clus_valid)
+		fat_free_map_wait(sb);
 	if (sbi->free_clusters == -1 || !sbi->free_clus_valid) {
 		int err = fat_count_free_clusters(dentry->d_sb);
 		if (err)
@@ -827,6 +831,8 @@ static int fat_show_options(struct seq_file *m, struct vfsmount *mnt)
 		seq_printf(m, ",check=%c", opts->name_check);
 	if (opts->usefree)
 		seq_puts(m, ",usefree");
+	if (opts->nofreemap)
+		seq_puts(m, ",nofreemap");
 	if (opts->quiet)
 		seq_puts(m, ",quiet");
 	if (opts->showexec)
@@ -871,7 +877,7 @@ enum {
 	Opt_shortname_winnt, Opt_shortname_mixed, Opt_utf8_no, Opt_utf8_yes,
 	Opt_uni_xl_no, Opt_uni_xl_yes, Opt_nonumtail_no, Opt_nonumtail_yes,
 	Opt_obsolate, Opt_flush, Opt_tz_utc, Opt_rodir, Opt_err_cont,
-	Opt_err_panic, Opt_err_ro, Opt_err,
+	Opt_err_panic, Opt_err_ro, Opt_nofreemap, Opt_err,
 };
 
 static const match_table_t fat_tokens = {
@@ -889,6 +895,7 @@ static const match_table_t fat_tokens = {
 	{Opt_allow_utime, "allow_utime=%o"},
 	{Opt_codepage, "codepage=%u"},
 	{Opt_usefree, "usefree"},
+	{Opt_nofreemap, "nofreemap"},
 	{Opt_nocase, "nocase"},
 	{Opt_quiet, "quiet"},
 	{Opt_showexec, "showexec"},
@@ -978,6 +985,7 @@ static int parse_options(char *options, int is_vfat, int silent, int *debug,
 	opts->utf8 = opts->unicode_xlate = 0;
 	opts->numtail = 1;
 	opts->usefree = opts->nocase = 0;
+	opts->nofreemap = 0;
 	opts->tz_utc = 0;
 	opts->errors = FAT_ERRORS_RO;
 	*debug = 0;
@@ -1010,6 +1018,9 @@ static int parse_options(char *options, int is_vfat, int silent, int *debug,
 		case Opt_usefree:
 			opts->usefree = 1;
 			break;
+		case Opt_nofreemap:
+			opts->nofreemap = 1;
+			break;
 		case Opt_nocase:
 			if (!is_vfat)
 				opts->nocase = 1;
@@ -1482,6 +1493,8 @@ int fat_fill_super(struct super_block *sb, void *data, int silent,
 		goto out_fail;
 	}
 
+	fat_free_map_start(sb);
+
 	return 0;
 
 out_invalid:
@@ -1570,6 +1583,8 @@ static int __init init_fat_fs(void)
 	if (err)
 		goto failed;
 
+	fat_free_map_init();
+
 	return 0;
 
 failed:
@@ -1579,6 +1594,7 @@ failed:
 
 static void __exit exit_fat_fs(void)
 {
+	fat_free_map_destroy();
 	fat_cache_destroy();
 	fat_destroy_inodecache();
 }
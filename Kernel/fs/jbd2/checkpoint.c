@@ -485,7 +485,11 @@ int jbd2_cleanup_journal_tail(journal_t *journal)
 		blocknr = transaction->t_log_start;
 	} else if ((transaction = journal->j_running_transaction) != NULL) {
 		first_tid = transaction->t_tid;
-		blocknr = journal->j_head;
+		if (journal->j_fc_blocks &&
+		    journal->j_fc_tid == transaction->t_tid)
+			blocknr = journal->j_fc_first;
+		else
+			blocknr = journal->j_head;
 	} else {
 		first_tid = journal->j_transaction_sequence;
 		blocknr = journal->j_head;
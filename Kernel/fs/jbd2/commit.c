@@ -207,6 +207,163 @@ retry:
 	return ret;
 }
 
+/*
+ * Called under j_state_lock: wait until no fast commit block is being
+ * written.
+ */
+static void jbd2_wait_fc_locked(journal_t *journal)
+{
+	while (journal->j_flags & JBD2_FAST_COMMIT_ONGOING) {
+		DEFINE_WAIT(wait);
+
+		prepare_to_wait(&journal->j_wait_fc, &wait,
+				TASK_UNINTERRUPTIBLE);
+		spin_unlock(&journal->j_state_lock);
+		schedule();
+		finish_wait(&journal->j_wait_fc, &wait);
+		spin_lock(&journal->j_state_lock);
+	}
+}
+
+/**
+ * int jbd2_journal_fc_commit() - write a fast commit record
+ * @journal: journal to write to
+ * @tid: running transaction the record belongs to
+ * @data: filesystem defined record
+ * @len: length of the record
+ *
+ * Write one fast commit block carrying @data and wait for it to reach
+ * the disk, instead of committing @tid.  The block only goes ahead of
+ * the next descriptor of @tid in the log; if the system crashes before
+ * @tid commits, jbd2_journal_recover() hands @data to ->j_fc_replay()
+ * after replaying the committed transactions.  The filesystem must make
+ * sure the record describes a self contained change that is consistent
+ * with the last committed transaction.
+ *
+ * The first fast commit block written sets JBD2_FEATURE_INCOMPAT_INLOG_FC
+ * in the journal superblock, and the superblock is on disk before the
+ * block is, so that tools which do not know the block type refuse the
+ * log instead of dropping the record.
+ *
+ * Returns -EAGAIN if the caller has to fall back to a full commit: @tid
+ * is no longer running, the previous transaction is still committing,
+ * the log is short of space or @tid already holds JBD2_FC_MAX_BLOCKS
+ * fast commit blocks.  Successful fast commits are counted in the
+ * journal statistics; the caller counts its fallbacks with
+ * jbd2_journal_fc_fallback().
+ */
+int jbd2_journal_fc_commit(journal_t *journal, tid_t tid,
+			   const void *data, int len)
+{
+	transaction_t *transaction;
+	struct journal_head *descriptor;
+	jbd2_journal_fc_header_t *header;
+	struct buffer_head *bh;
+	int barrier_done = 0;
+	int ret = -EAGAIN;
+
+	spin_lock(&journal->j_state_lock);
+	jbd2_wait_fc_locked(journal);
+	transaction = journal->j_running_transaction;
+	if (!jbd2_journal_check_available_features(journal, 0, 0,
+				JBD2_FEATURE_INCOMPAT_INLOG_FC) ||
+	    (journal->j_flags & (JBD2_ABORT | JBD2_FLUSHED)) ||
+	    journal->j_committing_transaction ||
+	    !transaction || transaction->t_tid != tid ||
+	    transaction->t_state != T_RUNNING ||
+	    len > journal->j_blocksize - (int)sizeof(*header) ||
+	    (journal->j_fc_blocks && journal->j_fc_tid == tid &&
+	     journal->j_fc_blocks >= JBD2_FC_MAX_BLOCKS) ||
+	    __jbd2_log_space_left(journal) <
+	    transaction->t_outstanding_credits + JBD2_FC_MAX_BLOCKS) {
+		spin_unlock(&journal->j_state_lock);
+		goto out;
+	}
+	if (!journal->j_fc_blocks || journal->j_fc_tid != tid) {
+		journal->j_fc_tid = tid;
+		journal->j_fc_first = journal->j_head;
+		journal->j_fc_blocks = 0;
+	}
+	journal->j_fc_blocks++;
+	journal->j_flags |= JBD2_FAST_COMMIT_ONGOING;
+	spin_unlock(&journal->j_state_lock);
+
+	/* Fast commits are serialized by JBD2_FAST_COMMIT_ONGOING */
+	if (!JBD2_HAS_INCOMPAT_FEATURE(journal,
+				       JBD2_FEATURE_INCOMPAT_INLOG_FC)) {
+		jbd2_journal_set_features(journal, 0, 0,
+					  JBD2_FEATURE_INCOMPAT_INLOG_FC);
+		jbd2_journal_update_superblock(journal, 1);
+	}
+
+	/*
+	 * From here on the block is part of the log of @tid: if it cannot
+	 * be written, neither can the commit.
+	 */
+	descriptor = jbd2_journal_get_descriptor_buffer(journal);
+	if (!descriptor) {
+		ret = -EIO;
+		jbd2_journal_abort(journal, ret);
+		goto done;
+	}
+	bh = jh2bh(descriptor);
+
+	header = (jbd2_journal_fc_header_t *)bh->b_data;
+	header->fc_header.h_magic = cpu_to_be32(JBD2_MAGIC_NUMBER);
+	header->fc_header.h_blocktype = cpu_to_be32(JBD2_FC_BLOCK);
+	header->fc_header.h_sequence = cpu_to_be32(tid);
+	header->fc_len = cpu_to_be32(len);
+	memcpy(header + 1, data, len);
+	header->fc_crc = cpu_to_be32(crc32_be(~0, bh->b_data,
+					      journal->j_blocksize));
+
+	JBUFFER_TRACE(descriptor, "submit fast commit block");
+	lock_buffer(bh);
+	clear_buffer_dirty(bh);
+	set_buffer_uptodate(bh);
+	bh->b_end_io = journal_end_buffer_io_sync;
+
+	/* The data the record refers to has to be on disk first */
+	if (journal->j_flags & JBD2_BARRIER) {
+		set_buffer_ordered(bh);
+		barrier_done = 1;
+	}
+	submit_bh(WRITE_SYNC_PLUG, bh);
+	if (barrier_done)
+		clear_buffer_ordered(bh);
+
+	ret = journal_wait_on_commit_record(journal, bh);
+	if (ret)
+		jbd2_journal_abort(journal, ret);
+
+done:
+	spin_lock(&journal->j_state_lock);
+	journal->j_flags &= ~JBD2_FAST_COMMIT_ONGOING;
+	spin_unlock(&journal->j_state_lock);
+	wake_up(&journal->j_wait_fc);
+out:
+	if (!ret) {
+		spin_lock(&journal->j_history_lock);
+		journal->j_stats.ts_fc_commits++;
+		spin_unlock(&journal->j_history_lock);
+	}
+	return ret;
+}
+
+/**
+ * void jbd2_journal_fc_fallback() - count a full commit instead of a fast one
+ * @journal: journal of the commit
+ *
+ * Called by the filesystem when a sync which needed a commit could not
+ * use jbd2_journal_fc_commit(), whatever the reason.
+ */
+void jbd2_journal_fc_fallback(journal_t *journal)
+{
+	spin_lock(&journal->j_history_lock);
+	journal->j_stats.ts_fc_fallbacks++;
+	spin_unlock(&journal->j_history_lock);
+}
+
 /*
  * write the filemap data using writepage() address_space_operations.
  * We don't do block allocation here even for delalloc. We don't
@@ -401,6 +558,7 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 			commit_transaction->t_tid);
 
 	spin_lock(&journal->j_state_lock);
+	jbd2_wait_fc_locked(journal);
 	commit_transaction->t_state = T_LOCKED;
 
 	/*
@@ -495,7 +653,13 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 	journal->j_committing_transaction = commit_transaction;
 	journal->j_running_transaction = NULL;
 	start_time = ktime_get();
-	commit_transaction->t_log_start = journal->j_head;
+	/* The log of the transaction starts at its fast commit blocks */
+	if (journal->j_fc_blocks &&
+	    journal->j_fc_tid == commit_transaction->t_tid)
+		commit_transaction->t_log_start = journal->j_fc_first;
+	else
+		commit_transaction->t_log_start = journal->j_head;
+	journal->j_fc_blocks = 0;
 	wake_up(&journal->j_wait_transaction_locked);
 	spin_unlock(&journal->j_state_lock);
 
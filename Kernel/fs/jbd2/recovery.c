@@ -36,6 +36,10 @@ struct recovery_info
 	int		nr_replays;
 	int		nr_revokes;
 	int		nr_revoke_hits;
+
+	/* Fast commit blocks following the last commit block */
+	unsigned long	fc_blocks[JBD2_FC_MAX_BLOCKS];
+	int		nr_fc;
 };
 
 enum passtype {PASS_SCAN, PASS_REVOKE, PASS_REPLAY};
@@ -43,6 +47,8 @@ static int do_one_pass(journal_t *journal,
 				struct recovery_info *info, enum passtype pass);
 static int scan_revoke_records(journal_t *, struct buffer_head *,
 				tid_t, struct recovery_info *);
+static int fc_block_valid(journal_t *, struct buffer_head *);
+static int replay_fc_blocks(journal_t *, struct recovery_info *);
 
 #ifdef __KERNEL__
 
@@ -251,12 +257,15 @@ int jbd2_journal_recover(journal_t *journal)
 		err = do_one_pass(journal, &info, PASS_REVOKE);
 	if (!err)
 		err = do_one_pass(journal, &info, PASS_REPLAY);
+	if (!err && info.nr_fc)
+		err = replay_fc_blocks(journal, &info);
 
 	jbd_debug(1, "JBD: recovery, exit status %d, "
 		  "recovered transactions %u to %u\n",
 		  err, info.start_transaction, info.end_transaction);
-	jbd_debug(1, "JBD: Replayed %d and revoked %d/%d blocks\n",
-		  info.nr_replays, info.nr_revoke_hits, info.nr_revokes);
+	jbd_debug(1, "JBD: Replayed %d and revoked %d/%d blocks, "
+		  "%d fast commits\n", info.nr_replays, info.nr_revoke_hits,
+		  info.nr_revokes, info.nr_fc);
 
 	/* Restart the log at the next transaction ID, thus invalidating
 	 * any existing commit records in the log. */
@@ -656,6 +665,31 @@ static int do_one_pass(journal_t *journal,
 			}
 			brelse(bh);
 			next_commit_ID++;
+			if (pass == PASS_SCAN)
+				info->nr_fc = 0;
+			continue;
+
+		case JBD2_FC_BLOCK:
+			/* Fast commit blocks are collected in PASS_SCAN
+			 * and replayed once the passes are done, if no
+			 * commit block follows them.  A torn one marks
+			 * the end of the log. */
+			if (pass != PASS_SCAN) {
+				brelse(bh);
+				continue;
+			}
+			if (!fc_block_valid(journal, bh) ||
+			    info->nr_fc >= JBD2_FC_MAX_BLOCKS) {
+				brelse(bh);
+				goto done;
+			}
+			if (next_log_block == journal->j_first)
+				info->fc_blocks[info->nr_fc++] =
+					journal->j_last - 1;
+			else
+				info->fc_blocks[info->nr_fc++] =
+					next_log_block - 1;
+			brelse(bh);
 			continue;
 
 		case JBD2_REVOKE_BLOCK:
@@ -711,6 +745,69 @@ static int do_one_pass(journal_t *journal,
 }
 
 
+/* Check the checksum and length of a fast commit block. */
+
+static int fc_block_valid(journal_t *journal, struct buffer_head *bh)
+{
+	jbd2_journal_fc_header_t *header;
+	int off = offsetof(jbd2_journal_fc_header_t, fc_len);
+	__be32 zero = 0;
+	__u32 crc;
+	int len;
+
+	header = (jbd2_journal_fc_header_t *) bh->b_data;
+	len = be32_to_cpu(header->fc_len);
+	if (len < 0 || len > journal->j_blocksize - (int)sizeof(*header))
+		return 0;
+
+	/* The checksum was computed with fc_crc zeroed */
+	crc = crc32_be(~0, bh->b_data, off - sizeof(zero));
+	crc = crc32_be(crc, (void *)&zero, sizeof(zero));
+	crc = crc32_be(crc, bh->b_data + off, journal->j_blocksize - off);
+	return crc == be32_to_cpu(header->fc_crc);
+}
+
+/*
+ * Hand the records of the fast commit blocks found after the last commit
+ * block to the filesystem, in log order.
+ */
+
+static int replay_fc_blocks(journal_t *journal, struct recovery_info *info)
+{
+	jbd2_journal_fc_header_t *header;
+	struct buffer_head *bh;
+	int i, err;
+
+	if (!journal->j_fc_replay) {
+		printk(KERN_ERR "JBD: %d fast commit blocks but no "
+		       "replay function\n", info->nr_fc);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < info->nr_fc; i++) {
+		err = jread(&bh, journal, info->fc_blocks[i]);
+		if (err)
+			return err;
+
+		header = (jbd2_journal_fc_header_t *) bh->b_data;
+		if (be32_to_cpu(header->fc_header.h_sequence) !=
+		    info->end_transaction || !fc_block_valid(journal, bh)) {
+			brelse(bh);
+			break;
+		}
+
+		err = journal->j_fc_replay(journal, header + 1,
+					   be32_to_cpu(header->fc_len));
+		brelse(bh);
+		if (err) {
+			printk(KERN_ERR "JBD: error %d replaying fast commit "
+			       "block %lu\n", err, info->fc_blocks[i]);
+			return err;
+		}
+	}
+	return 0;
+}
+
 /* Scan a revoke record, marking all blocks mentioned as revoked. */
 
 static int scan_revoke_records(journal_t *journal, struct buffer_head *bh,
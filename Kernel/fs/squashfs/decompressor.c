@@ -0,0 +1,270 @@
+/*
+ * Squashfs - a compressed read only filesystem for Linux
+ *
+ * Copyright (c) 2002, 2003, 2004, 2005, 2006, 2007, 2008, 2009
+ * Phillip Lougher <phillip@lougher.demon.co.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * decompressor.c
+ */
+
+/*
+ * This file looks up the decompressor of a filesystem and manages the
+ * pool of decompressor streams of a mounted filesystem.
+ *
+ * Each reader takes a stream from the pool for the duration of one
+ * block decompression, so several blocks can be decompressed at the
+ * same time.  The pool holds at most one stream per online CPU (more
+ * would only add memory, there's nobody to run them); the first stream
+ * is allocated at mount time and the others when readers find the pool
+ * empty.  Readers that find the pool empty and full sleep until a
+ * stream is returned.
+ */
+
+#include <linux/types.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/list.h>
+#include <linux/wait.h>
+#include <linux/sched.h>
+#include <linux/ktime.h>
+#include <linux/buffer_head.h>
+
+#include "squashfs_fs.h"
+#include "squashfs_fs_sb.h"
+#include "squashfs_fs_i.h"
+#include "decompressor.h"
+#include "squashfs.h"
+
+static const struct squashfs_decompressor squashfs_lzma_unsupported_comp_ops = {
+	NULL, NULL, NULL, LZMA_COMPRESSION, "lzma", 0
+};
+
+#ifndef CONFIG_SQUASHFS_LZO
+static const struct squashfs_decompressor squashfs_lzo_comp_ops = {
+	NULL, NULL, NULL, LZO_COMPRESSION, "lzo", 0
+};
+#endif
+
+static const struct squashfs_decompressor squashfs_unknown_comp_ops = {
+	NULL, NULL, NULL, 0, "unknown", 0
+};
+
+static const struct squashfs_decompressor *decompressor[] = {
+	&squashfs_zlib_comp_ops,
+	&squashfs_lzma_unsupported_comp_ops,
+	&squashfs_lzo_comp_ops,
+	&squashfs_unknown_comp_ops
+};
+
+
+const struct squashfs_decompressor *squashfs_lookup_decompressor(int id)
+{
+	int i;
+
+	for (i = 0; decompressor[i]->id; i++)
+		if (id == decompressor[i]->id)
+			break;
+
+	return decompressor[i];
+}
+
+
+struct squashfs_stream {
+	spinlock_t		lock;
+	wait_queue_head_t	wait;
+	struct list_head	idle;
+	int			avail;
+	int			max;
+};
+
+struct decomp_stream {
+	void			*stream;
+	struct list_head	list;
+};
+
+
+static struct decomp_stream *alloc_stream(struct squashfs_sb_info *msblk)
+{
+	struct decomp_stream *ds = kmalloc(sizeof(*ds), GFP_KERNEL);
+
+	if (ds == NULL)
+		return NULL;
+
+	ds->stream = squashfs_decompressor_init(msblk);
+	if (ds->stream == NULL) {
+		kfree(ds);
+		return NULL;
+	}
+
+	return ds;
+}
+
+
+int squashfs_decompressor_create(struct squashfs_sb_info *msblk)
+{
+	struct squashfs_stream *pool;
+	struct decomp_stream *ds;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (pool == NULL)
+		return -ENOMEM;
+
+	spin_lock_init(&pool->lock);
+	init_waitqueue_head(&pool->wait);
+	INIT_LIST_HEAD(&pool->idle);
+	pool->max = num_online_cpus();
+
+	ds = alloc_stream(msblk);
+	if (ds == NULL) {
+		kfree(pool);
+		return -ENOMEM;
+	}
+	list_add(&ds->list, &pool->idle);
+	pool->avail = 1;
+
+	msblk->stream = pool;
+	return 0;
+}
+
+
+void squashfs_decompressor_destroy(struct squashfs_sb_info *msblk)
+{
+	struct squashfs_stream *pool = msblk->stream;
+	struct decomp_stream *ds, *next;
+
+	if (pool == NULL)
+		return;
+
+	list_for_each_entry_safe(ds, next, &pool->idle, list) {
+		list_del(&ds->list);
+		squashfs_decompressor_free(msblk, ds->stream);
+		kfree(ds);
+	}
+
+	kfree(pool);
+	msblk->stream = NULL;
+}
+
+
+static struct decomp_stream *get_stream(struct squashfs_sb_info *msblk)
+{
+	struct squashfs_stream *pool = msblk->stream;
+	struct decomp_stream *ds;
+
+	while (1) {
+		spin_lock(&pool->lock);
+		if (!list_empty(&pool->idle)) {
+			ds = list_entry(pool->idle.next, struct decomp_stream,
+				list);
+			list_del(&ds->list);
+			spin_unlock(&pool->lock);
+			return ds;
+		}
+
+		if (pool->avail < pool->max) {
+			pool->avail++;
+			spin_unlock(&pool->lock);
+
+			ds = alloc_stream(msblk);
+			if (ds)
+				return ds;
+
+			/*
+			 * Out of memory, wait for one of the streams we
+			 * already have, there's always at least one.
+			 */
+			spin_lock(&pool->lock);
+			pool->avail--;
+		}
+
+		msblk->stats.waits++;
+		spin_unlock(&pool->lock);
+
+		wait_event(pool->wait, !list_empty(&pool->idle));
+	}
+}
+
+
+static void put_stream(struct squashfs_sb_info *msblk,
+	struct decomp_stream *ds, int length, int res, s64 ns)
+{
+	struct squashfs_stream *pool = msblk->stream;
+
+	spin_lock(&pool->lock);
+	list_add(&ds->list, &pool->idle);
+	if (res >= 0) {
+		msblk->stats.blocks++;
+		msblk->stats.bytes_in += length;
+		msblk->stats.bytes_out += res;
+		msblk->stats.decomp_ns += ns;
+	}
+	spin_unlock(&pool->lock);
+
+	wake_up(&pool->wait);
+}
+
+
+/*
+ * Decompress length bytes starting at offset of the b buffer heads into
+ * the pages of buffer, using a stream from the pool.  Returns the number
+ * of bytes decompressed or a negative error.
+ */
+int squashfs_decompress(struct squashfs_sb_info *msblk, void **buffer,
+	struct buffer_head **bh, int b, int offset, int length, int srclength,
+	int pages)
+{
+	struct decomp_stream *ds = get_stream(msblk);
+	ktime_t start = ktime_get();
+	int res;
+
+	res = msblk->decompressor->decompress(msblk, ds->stream, buffer, bh, b,
+		offset, length, srclength, pages);
+
+	put_stream(msblk, ds, length, res,
+		ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+	return res;
+}
+
+
+void squashfs_stat_readpage(struct squashfs_sb_info *msblk, int direct)
+{
+	spin_lock(&msblk->stream->lock);
+	if (direct)
+		msblk->stats.direct_blocks++;
+	else
+		msblk->stats.cached_blocks++;
+	spin_unlock(&msblk->stream->lock);
+}
+
+
+void squashfs_stats_get(struct squashfs_sb_info *msblk,
+	struct squashfs_stats *stats, int *streams)
+{
+	spin_lock(&msblk->stream->lock);
+	*stats = msblk->stats;
+	*streams = msblk->stream->avail;
+	spin_unlock(&msblk->stream->lock);
+}
+
+
+void squashfs_stats_clear(struct squashfs_sb_info *msblk)
+{
+	spin_lock(&msblk->stream->lock);
+	memset(&msblk->stats, 0, sizeof(msblk->stats));
+	spin_unlock(&msblk->stream->lock);
+}
@@ -47,7 +47,6 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
-#include <linux/zlib.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -372,11 +371,105 @@ static int read_blocklist(struct inode *inode, int index, u64 *block)
 }
 
 
+/*
+ * Decompress a datablock straight into the page cache pages it covers,
+ * instead of decompressing it into the read_page cache and copying it
+ * out.  This needs every page of the block (up to the end of file) to
+ * be grabbed and not uptodate, otherwise -EAGAIN is returned and the
+ * caller falls back to the read_page cache.  On success target_page is
+ * uptodate and unlocked, on error it is left locked for the caller.
+ */
+static int squashfs_readpage_direct(struct page *target_page, u64 block,
+	int bsize, int expected)
+{
+	struct inode *inode = target_page->mapping->host;
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	int mask = (1 << (msblk->block_log - PAGE_CACHE_SHIFT)) - 1;
+	int start_index = target_page->index & ~mask;
+	int end_index = start_index | mask;
+	int file_end = (i_size_read(inode) - 1) >> PAGE_CACHE_SHIFT;
+	int i, n, pages, res = -ENOMEM;
+	struct page **page;
+	void **pageaddr;
+
+	if (end_index > file_end)
+		end_index = file_end;
+	pages = end_index - start_index + 1;
+
+	page = kmalloc(pages * sizeof(*page), GFP_KERNEL);
+	pageaddr = kmalloc(pages * sizeof(*pageaddr), GFP_KERNEL);
+	if (page == NULL || pageaddr == NULL) {
+		kfree(page);
+		kfree(pageaddr);
+		return -EAGAIN;
+	}
+
+	for (i = 0, n = start_index; n <= end_index; i++, n++) {
+		if (n == target_page->index) {
+			page[i] = target_page;
+			continue;
+		}
+
+		page[i] = grab_cache_page_nowait(target_page->mapping, n);
+		if (page[i] == NULL || PageUptodate(page[i])) {
+			if (page[i]) {
+				unlock_page(page[i]);
+				page_cache_release(page[i]);
+			}
+			pages = i;
+			res = -EAGAIN;
+			goto release;
+		}
+	}
+
+	for (i = 0; i < pages; i++)
+		pageaddr[i] = kmap(page[i]);
+
+	/* the page array is cut short at EOF, so is the block */
+	res = squashfs_read_data(inode->i_sb, pageaddr, block, bsize, NULL,
+		pages << PAGE_CACHE_SHIFT, pages);
+	if (res >= 0 && res != expected) {
+		ERROR("Unable to read page, block %llx, size %x, got %d "
+			"bytes, expected %d\n", block, bsize, res, expected);
+		res = -EIO;
+	}
+
+	for (i = 0; i < pages; i++) {
+		if (res >= 0 && expected < (i + 1) * PAGE_CACHE_SIZE) {
+			n = max_t(int, expected - i * PAGE_CACHE_SIZE, 0);
+			memset(pageaddr[i] + n, 0, PAGE_CACHE_SIZE - n);
+		}
+		kunmap(page[i]);
+		flush_dcache_page(page[i]);
+		if (res >= 0)
+			SetPageUptodate(page[i]);
+	}
+
+	if (res >= 0)
+		res = 0;
+
+release:
+	for (i = 0; i < pages; i++) {
+		if (page[i] == target_page) {
+			if (res == 0)
+				unlock_page(page[i]);
+			continue;
+		}
+		unlock_page(page[i]);
+		page_cache_release(page[i]);
+	}
+
+	kfree(page);
+	kfree(pageaddr);
+	return res;
+}
+
+
 static int squashfs_readpage(struct file *file, struct page *page)
 {
 	struct inode *inode = page->mapping->host;
 	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
-	int bytes, i, offset = 0, sparse = 0;
+	int bytes, i, res, offset = 0, sparse = 0;
 	struct squashfs_cache_entry *buffer = NULL;
 	void *pageaddr;
 
@@ -410,9 +503,22 @@ static int squashfs_readpage(struct file *file, struct page *page)
 				 msblk->block_size;
 			sparse = 1;
 		} else {
+			bytes = index == file_end ?
+				(i_size_read(inode) & (msblk->block_size - 1)) :
+				 msblk->block_size;
+
 			/*
-			 * Read and decompress datablock.
+			 * Read and decompress datablock, straight into the
+			 * page cache if possible.
 			 */
+			res = squashfs_readpage_direct(page, block, bsize,
+				bytes);
+			squashfs_stat_readpage(msblk, res != -EAGAIN);
+			if (res == 0)
+				return 0;
+			if (res != -EAGAIN)
+				goto error_out;
+
 			buffer = squashfs_get_datablock(inode->i_sb,
 								block, bsize);
 			if (buffer->error) {
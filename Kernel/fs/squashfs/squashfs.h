@@ -51,6 +51,15 @@ extern struct squashfs_cache_entry *squashfs_get_datablock(struct super_block *,
 				u64, int);
 extern int squashfs_read_table(struct super_block *, void *, u64, int);
 
+/* decompressor.c */
+extern const struct squashfs_decompressor *squashfs_lookup_decompressor(int);
+extern int squashfs_decompressor_create(struct squashfs_sb_info *);
+extern void squashfs_decompressor_destroy(struct squashfs_sb_info *);
+extern void squashfs_stat_readpage(struct squashfs_sb_info *, int);
+extern void squashfs_stats_get(struct squashfs_sb_info *,
+				struct squashfs_stats *, int *);
+extern void squashfs_stats_clear(struct squashfs_sb_info *);
+
 /* export.c */
 extern __le64 *squashfs_read_inode_lookup_table(struct super_block *, u64,
 				unsigned int);
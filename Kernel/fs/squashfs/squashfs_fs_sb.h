@@ -51,6 +51,16 @@ struct squashfs_cache_entry {
 	void			**data;
 };
 
+struct squashfs_stats {
+	unsigned long		blocks;
+	unsigned long		waits;
+	u64			bytes_in;
+	u64			bytes_out;
+	u64			decomp_ns;
+	unsigned long		direct_blocks;
+	unsigned long		cached_blocks;
+};
+
 struct squashfs_sb_info {
 	int			devblksize;
 	int			devblksize_log2;
@@ -61,10 +71,12 @@ struct squashfs_sb_info {
 	__le64			*id_table;
 	__le64			*fragment_index;
 	unsigned int		*fragment_index_2;
-	struct mutex		read_data_mutex;
 	struct mutex		meta_index_mutex;
 	struct meta_index	*meta_index;
-	z_stream		stream;
+	const struct squashfs_decompressor *decompressor;
+	struct squashfs_stream	*stream;
+	struct squashfs_stats	stats;
+	struct dentry		*debugfs;
 	__le64			*inode_lookup_table;
 	u64			inode_table;
 	u64			directory_table;
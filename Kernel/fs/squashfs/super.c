@@ -35,37 +35,97 @@
 #include <linux/pagemap.h>
 #include <linux/init.h>
 #include <linux/module.h>
-#include <linux/zlib.h>
 #include <linux/magic.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
 #include "squashfs_fs_i.h"
 #include "squashfs.h"
+#include "decompressor.h"
 
 static struct file_system_type squashfs_fs_type;
 static const struct super_operations squashfs_super_ops;
 
-static int supported_squashfs_filesystem(short major, short minor, short comp)
+static struct dentry *squashfs_debugfs;
+
+static const struct squashfs_decompressor *supported_squashfs_filesystem(short
+	major, short minor, short id)
 {
+	const struct squashfs_decompressor *decompressor;
+
 	if (major < SQUASHFS_MAJOR) {
 		ERROR("Major/Minor mismatch, older Squashfs %d.%d "
 			"filesystems are unsupported\n", major, minor);
-		return -EINVAL;
+		return NULL;
 	} else if (major > SQUASHFS_MAJOR || minor > SQUASHFS_MINOR) {
 		ERROR("Major/Minor mismatch, trying to mount newer "
 			"%d.%d filesystem\n", major, minor);
 		ERROR("Please update your kernel\n");
-		return -EINVAL;
+		return NULL;
 	}
 
-	if (comp != ZLIB_COMPRESSION)
-		return -EINVAL;
+	decompressor = squashfs_lookup_decompressor(id);
+	if (!decompressor->supported) {
+		ERROR("Filesystem uses \"%s\" compression. This is not "
+			"supported\n", decompressor->name);
+		return NULL;
+	}
+
+	return decompressor;
+}
+
+
+static int squashfs_stats_show(struct seq_file *m, void *unused)
+{
+	struct squashfs_sb_info *msblk = m->private;
+	struct squashfs_stats stats;
+	int streams;
+
+	squashfs_stats_get(msblk, &stats, &streams);
+
+	seq_printf(m, "compression:    %s\n", msblk->decompressor->name);
+	seq_printf(m, "streams:        %d\n", streams);
+	seq_printf(m, "blocks:         %lu\n", stats.blocks);
+	seq_printf(m, "bytes_in:       %llu\n", stats.bytes_in);
+	seq_printf(m, "bytes_out:      %llu\n", stats.bytes_out);
+	seq_printf(m, "decompress_us:  %llu\n", div_u64(stats.decomp_ns, 1000));
+	seq_printf(m, "stream_waits:   %lu\n", stats.waits);
+	seq_printf(m, "direct_blocks:  %lu\n", stats.direct_blocks);
+	seq_printf(m, "cached_blocks:  %lu\n", stats.cached_blocks);
 
 	return 0;
 }
 
 
+static int squashfs_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, squashfs_stats_show, inode->i_private);
+}
+
+
+static ssize_t squashfs_stats_write(struct file *file, const char __user *buf,
+	size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+
+	squashfs_stats_clear(m->private);
+
+	return count;
+}
+
+
+static const struct file_operations squashfs_stats_fops = {
+	.open		= squashfs_stats_open,
+	.read		= seq_read,
+	.write		= squashfs_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+
 static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 {
 	struct squashfs_sb_info *msblk;
@@ -87,13 +147,6 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 	}
 	msblk = sb->s_fs_info;
 
-	msblk->stream.workspace = kmalloc(zlib_inflate_workspacesize(),
-		GFP_KERNEL);
-	if (msblk->stream.workspace == NULL) {
-		ERROR("Failed to allocate zlib workspace\n");
-		goto failure;
-	}
-
 	sblk = kzalloc(sizeof(*sblk), GFP_KERNEL);
 	if (sblk == NULL) {
 		ERROR("Failed to allocate squashfs_super_block\n");
@@ -103,7 +156,6 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 	msblk->devblksize = sb_min_blocksize(sb, BLOCK_SIZE);
 	msblk->devblksize_log2 = ffz(~msblk->devblksize);
 
-	mutex_init(&msblk->read_data_mutex);
 	mutex_init(&msblk->meta_index_mutex);
 
 	/*
@@ -131,14 +183,14 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 	}
 
 	/* Check the MAJOR & MINOR versions and compression type */
-	err = supported_squashfs_filesystem(le16_to_cpu(sblk->s_major),
+	err = -EINVAL;
+	msblk->decompressor = supported_squashfs_filesystem(
+			le16_to_cpu(sblk->s_major),
 			le16_to_cpu(sblk->s_minor),
 			le16_to_cpu(sblk->compression));
-	if (err < 0)
+	if (msblk->decompressor == NULL)
 		goto failed_mount;
 
-	err = -EINVAL;
-
 	/*
 	 * Check if there's xattrs in the filesystem.  These are not
 	 * supported in this version, so warn that they will be ignored.
@@ -203,6 +255,13 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 	sb->s_flags |= MS_RDONLY;
 	sb->s_op = &squashfs_super_ops;
 
+	err = squashfs_decompressor_create(msblk);
+	if (err) {
+		ERROR("Failed to allocate %s decompressor\n",
+			msblk->decompressor->name);
+		goto failed_mount;
+	}
+
 	err = -ENOMEM;
 
 	msblk->block_cache = squashfs_cache_init("metadata",
@@ -284,6 +343,11 @@ allocate_root:
 		goto failed_mount;
 	}
 
+	if (squashfs_debugfs)
+		msblk->debugfs = debugfs_create_file(bdevname(sb->s_bdev, b),
+			S_IRUGO | S_IWUSR, squashfs_debugfs, msblk,
+			&squashfs_stats_fops);
+
 	TRACE("Leaving squashfs_fill_super\n");
 	kfree(sblk);
 	return 0;
@@ -295,14 +359,13 @@ failed_mount:
 	kfree(msblk->inode_lookup_table);
 	kfree(msblk->fragment_index);
 	kfree(msblk->id_table);
-	kfree(msblk->stream.workspace);
+	squashfs_decompressor_destroy(msblk);
 	kfree(sb->s_fs_info);
 	sb->s_fs_info = NULL;
 	kfree(sblk);
 	return err;
 
 failure:
-	kfree(msblk->stream.workspace);
 	kfree(sb->s_fs_info);
 	sb->s_fs_info = NULL;
 	return -ENOMEM;
@@ -343,13 +406,14 @@ static void squashfs_put_super(struct super_block *sb)
 
 	if (sb->s_fs_info) {
 		struct squashfs_sb_info *sbi = sb->s_fs_info;
+		debugfs_remove(sbi->debugfs);
 		squashfs_cache_delete(sbi->block_cache);
 		squashfs_cache_delete(sbi->fragment_cache);
 		squashfs_cache_delete(sbi->read_page);
 		kfree(sbi->id_table);
 		kfree(sbi->fragment_index);
 		kfree(sbi->meta_index);
-		kfree(sbi->stream.workspace);
+		squashfs_decompressor_destroy(sbi);
 		kfree(sb->s_fs_info);
 		sb->s_fs_info = NULL;
 	}
@@ -407,6 +471,8 @@ static int __init init_squashfs_fs(void)
 		return err;
 	}
 
+	squashfs_debugfs = debugfs_create_dir("squashfs", NULL);
+
 	printk(KERN_INFO "squashfs: version 4.0 (2009/01/31) "
 		"Phillip Lougher\n");
 
@@ -417,6 +483,7 @@ static int __init init_squashfs_fs(void)
 static void __exit exit_squashfs_fs(void)
 {
 	unregister_filesystem(&squashfs_fs_type);
+	debugfs_remove(squashfs_debugfs);
 	destroy_inodecache();
 }
 
@@ -136,6 +136,7 @@ typedef struct journal_s	journal_t;	/* Journal control structure */
 #define JBD2_SUPERBLOCK_V1	3
 #define JBD2_SUPERBLOCK_V2	4
 #define JBD2_REVOKE_BLOCK	5
+#define JBD2_FC_BLOCK		6
 
 /*
  * Standard header for all descriptor blocks:
@@ -198,6 +199,26 @@ typedef struct jbd2_journal_revoke_header_s
 	__be32		 r_count;	/* Count of bytes used in the block */
 } jbd2_journal_revoke_header_t;
 
+/*
+ * The fast commit block: carries an opaque, filesystem defined record
+ * which is handed back to the filesystem after the last committed
+ * transaction has been replayed.  h_sequence is the tid of the running
+ * transaction the record was written in.  fc_crc is the crc32_be of the
+ * whole block with fc_crc itself zeroed.
+ */
+typedef struct jbd2_journal_fc_header_s
+{
+	journal_header_t fc_header;
+	__be32		 fc_crc;	/* Checksum of the block */
+	__be32		 fc_len;	/* Count of bytes used after the header */
+} jbd2_journal_fc_header_t;
+
+/*
+ * Maximum number of fast commit blocks in one transaction.  When it is
+ * reached the filesystem has to fall back to a full commit.
+ */
+#define JBD2_FC_MAX_BLOCKS	16
+
 
 /* Definitions for the journal tag flags word: */
 #define JBD2_FLAG_ESCAPE		1	/* on-disk block is escaped */
@@ -269,13 +290,23 @@ typedef struct journal_superblock_s
 #define JBD2_FEATURE_INCOMPAT_REVOKE		0x00000001
 #define JBD2_FEATURE_INCOMPAT_64BIT		0x00000002
 #define JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT	0x00000004
+/*
+ * In-log fast commits: JBD2_FC_BLOCK blocks may follow the last commit
+ * block in the main log, see jbd2_journal_fc_commit().  This is not the
+ * mainline FAST_COMMIT feature (0x20), which keeps its records in a
+ * separate area at the end of the journal; the bit is one mainline does
+ * not assign.  It is only set when the first fast commit block is
+ * written and is dropped again once the log is empty.
+ */
+#define JBD2_FEATURE_INCOMPAT_INLOG_FC		0x80000000
 
 /* Features known to this kernel version: */
 #define JBD2_KNOWN_COMPAT_FEATURES	JBD2_FEATURE_COMPAT_CHECKSUM
 #define JBD2_KNOWN_ROCOMPAT_FEATURES	0
 #define JBD2_KNOWN_INCOMPAT_FEATURES	(JBD2_FEATURE_INCOMPAT_REVOKE | \
 					JBD2_FEATURE_INCOMPAT_64BIT | \
-					JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT)
+					JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT | \
+					JBD2_FEATURE_INCOMPAT_INLOG_FC)
 
 #ifdef __KERNEL__
 
@@ -676,6 +707,8 @@ struct transaction_run_stats_s {
 
 struct transaction_stats_s {
 	unsigned long		ts_tid;
+	unsigned long		ts_fc_commits;
+	unsigned long		ts_fc_fallbacks;
 	struct transaction_run_stats_s run;
 };
 
@@ -757,6 +790,11 @@ jbd2_time_diff(unsigned long start, unsigned long end)
  * @j_history_lock: Protect the transactions statistics history
  * @j_proc_entry: procfs entry for the jbd statistics directory
  * @j_stats: Overall statistics
+ * @j_fc_tid: Transaction the fast commit blocks at j_fc_first belong to
+ * @j_fc_first: First fast commit block of transaction j_fc_tid
+ * @j_fc_blocks: Number of fast commit blocks written for j_fc_tid
+ * @j_wait_fc: Wait queue to wait for a fast commit to complete
+ * @j_fc_replay: Called for each fast commit record found during recovery
  * @j_private: An opaque pointer to fs-private information.
  */
 
@@ -989,6 +1027,23 @@ struct journal_s
 	/* Failed journal commit ID */
 	unsigned int		j_failed_commit;
 
+	/*
+	 * Fast commit blocks written for the running transaction: its tid,
+	 * the first block and how many there are. [j_state_lock]
+	 */
+	tid_t			j_fc_tid;
+	unsigned long		j_fc_first;
+	int			j_fc_blocks;
+
+	/* Wait queue to wait for a fast commit to complete */
+	wait_queue_head_t	j_wait_fc;
+
+	/*
+	 * Called by jbd2_journal_recover() for each fast commit record of
+	 * the transaction following the last committed one.
+	 */
+	int			(*j_fc_replay)(journal_t *, void *, int);
+
 	/*
 	 * An opaque pointer to fs-private information.  ext3 puts its
 	 * superblock pointer here
@@ -1008,6 +1063,8 @@ struct journal_s
 #define JBD2_ABORT_ON_SYNCDATA_ERR	0x040	/* Abort the journal on file
 						 * data write error in ordered
 						 * mode */
+#define JBD2_FAST_COMMIT_ONGOING	0x080	/* A fast commit block is
+						 * being written */
 
 /*
  * Function declarations for the journaling transaction and buffer
@@ -1199,6 +1256,9 @@ extern void	jbd2_journal_switch_revoke_table(journal_t *journal);
 
 int __jbd2_log_space_left(journal_t *); /* Called with journal locked */
 int jbd2_log_start_commit(journal_t *journal, tid_t tid);
+void jbd2_journal_fc_fallback(journal_t *journal);
+int jbd2_journal_fc_commit(journal_t *journal, tid_t tid,
+			   const void *data, int len);
 int __jbd2_log_start_commit(journal_t *journal, tid_t tid);
 int jbd2_journal_start_commit(journal_t *journal, tid_t *tid);
 int jbd2_journal_force_commit_nested(journal_t *journal);
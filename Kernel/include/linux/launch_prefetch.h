@@ -0,0 +1,52 @@
+#ifndef _LINUX_LAUNCH_PREFETCH_H
+#define _LINUX_LAUNCH_PREFETCH_H
+/*
+ * Application launch page cache prefetcher: records the file pages a
+ * process reads from disk while it starts, and reads them ahead the
+ * next time a process of that name starts.  See
+ * Documentation/vm/launch-prefetch.txt.
+ */
+
+#include <linux/fs.h>
+#include <linux/sched.h>
+
+#ifdef CONFIG_LAUNCH_PREFETCH
+
+extern atomic_t launch_prefetch_recording;
+extern int launch_prefetch_ready;
+
+extern void __launch_prefetch_record(struct file *file, pgoff_t index);
+extern void __launch_prefetch_launch(struct task_struct *tsk);
+
+/*
+ * Called for each page cache page allocated to be read from disk on
+ * behalf of the current process.
+ */
+static inline void launch_prefetch_record(struct file *file, pgoff_t index)
+{
+	if (unlikely(atomic_read(&launch_prefetch_recording)) && file)
+		__launch_prefetch_record(file, index);
+}
+
+/*
+ * Called when a task gets a new name, at exec or from PR_SET_NAME.
+ */
+static inline void launch_prefetch_launch(struct task_struct *tsk)
+{
+	if (launch_prefetch_ready && thread_group_leader(tsk))
+		__launch_prefetch_launch(tsk);
+}
+
+#else
+
+static inline void launch_prefetch_record(struct file *file, pgoff_t index)
+{
+}
+
+static inline void launch_prefetch_launch(struct task_struct *tsk)
+{
+}
+
+#endif /* CONFIG_LAUNCH_PREFETCH */
+
+#endif /* _LINUX_LAUNCH_PREFETCH_H */
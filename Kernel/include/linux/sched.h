@@ -1160,6 +1160,7 @@ struct sched_entity {
 
 #ifdef CONFIG_SCHEDSTATS
 	u64			wait_start;
+	u64			wakeup_start;
 	u64			wait_max;
 	u64			wait_count;
 	u64			wait_sum;
@@ -2534,6 +2535,8 @@ extern void sched_move_task(struct task_struct *tsk);
 #ifdef CONFIG_FAIR_GROUP_SCHED
 extern int sched_group_set_shares(struct task_group *tg, unsigned long shares);
 extern unsigned long sched_group_shares(struct task_group *tg);
+extern int sched_group_set_latency(struct task_group *tg, u64 latency);
+extern u64 sched_group_latency(struct task_group *tg);
 #endif
 #ifdef CONFIG_RT_GROUP_SCHED
 extern int sched_group_set_rt_runtime(struct task_group *tg,
@@ -0,0 +1,96 @@
+/*
+ * include/linux/sensor_batch.h - Sensor sample batching
+ *
+ * Sensor drivers push timestamped samples into per-sensor FIFOs and the
+ * sensor service drains all of them from /dev/sensor_batch, many samples
+ * per read().  A maximum report latency lets readers sleep until either the
+ * oldest queued sample is that old or one of the FIFOs is nearly full.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _LINUX_SENSOR_BATCH_H
+#define _LINUX_SENSOR_BATCH_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define SENSOR_BATCH_MAX_SENSORS	16
+#define SENSOR_BATCH_MAX_VALUES		5
+#define SENSOR_BATCH_NAME_LEN		32
+
+/* Sensor flags */
+#define SENSOR_BATCH_F_WAKEUP		(1 << 0)	/* never delay samples */
+
+/* One sample as returned by read(), 32 bytes */
+struct sensor_batch_sample {
+	__s64	timestamp;		/* CLOCK_MONOTONIC, ns */
+	__u8	sensor;			/* id from SENSOR_BATCH_IOC_GET_INFO */
+	__u8	nvalues;
+	__u16	reserved;
+	__s32	value[SENSOR_BATCH_MAX_VALUES];
+};
+
+struct sensor_batch_info {
+	__u32	id;			/* in: 0 .. SENSOR_BATCH_MAX_SENSORS-1 */
+	char	name[SENSOR_BATCH_NAME_LEN];
+	__u32	flags;
+	__u32	fifo_size;
+	__u32	enabled;
+	__u32	queued;
+	__u32	dropped;		/* overwritten before being read */
+};
+
+struct sensor_batch_enable {
+	__u32	id;
+	__u32	enable;
+};
+
+#define SENSOR_BATCH_IOC_MAGIC		'B'
+#define SENSOR_BATCH_IOC_GET_INFO	_IOWR(SENSOR_BATCH_IOC_MAGIC, 1, struct sensor_batch_info)
+#define SENSOR_BATCH_IOC_ENABLE		_IOW(SENSOR_BATCH_IOC_MAGIC, 2, struct sensor_batch_enable)
+#define SENSOR_BATCH_IOC_SET_LATENCY	_IOW(SENSOR_BATCH_IOC_MAGIC, 3, __u32)	/* ms */
+#define SENSOR_BATCH_IOC_FLUSH		_IO(SENSOR_BATCH_IOC_MAGIC, 4)
+
+#ifdef __KERNEL__
+
+struct sensor_batch {
+	const char		*name;
+	unsigned int		flags;
+	unsigned int		fifo_size;	/* samples, rounded up to 2^n */
+	unsigned int		nvalues;
+
+	/* private to the batching core */
+	int			id;
+	bool			enabled;
+	unsigned int		head;
+	unsigned int		tail;
+	unsigned int		dropped;
+	struct sensor_batch_sample *fifo;
+};
+
+#ifdef CONFIG_SENSOR_BATCH
+extern int sensor_batch_register(struct sensor_batch *sb);
+extern void sensor_batch_unregister(struct sensor_batch *sb);
+extern bool sensor_batch_push(struct sensor_batch *sb, const s32 *values);
+#else
+static inline int sensor_batch_register(struct sensor_batch *sb)
+{
+	return 0;
+}
+
+static inline void sensor_batch_unregister(struct sensor_batch *sb)
+{
+}
+
+static inline bool sensor_batch_push(struct sensor_batch *sb, const s32 *values)
+{
+	return false;
+}
+#endif
+
+#endif /* __KERNEL__ */
+
+#endif /* _LINUX_SENSOR_BATCH_H */
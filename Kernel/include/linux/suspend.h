@@ -149,6 +149,45 @@ static inline void suspend_set_ops(struct platform_suspend_ops *ops) {}
 static inline int pm_suspend(suspend_state_t state) { return -ENOSYS; }
 #endif /* !CONFIG_SUSPEND */
 
+/* What a suspend_prof_record() entry timed */
+enum suspend_prof_kind {
+	SUSPEND_PROF_PHASE,
+	SUSPEND_PROF_DEV_SUSPEND,
+	SUSPEND_PROF_DEV_SUSPEND_NOIRQ,
+	SUSPEND_PROF_DEV_RESUME_NOIRQ,
+	SUSPEND_PROF_DEV_RESUME,
+	SUSPEND_PROF_EARLY_SUSPEND,
+	SUSPEND_PROF_LATE_RESUME,
+	SUSPEND_PROF_NR_KINDS
+};
+
+#ifdef CONFIG_PM_SUSPEND_PROFILE
+/**
+ * suspend_prof_now - timestamp to pass to suspend_prof_record()
+ *
+ * Based on sched_clock(), so it is usable with interrupts and
+ * timekeeping suspended.
+ */
+extern u64 suspend_prof_now(void);
+
+/**
+ * suspend_prof_record - log one step of the current suspend cycle
+ * @kind: enum suspend_prof_kind
+ * @name: device, handler or phase name
+ * @start: suspend_prof_now() taken when the step began
+ */
+extern void suspend_prof_record(int kind, const char *name, u64 start);
+extern void suspend_prof_record_fn(int kind, void *fn, u64 start);
+extern void suspend_prof_end(int error);
+extern void suspend_prof_print_last(void);
+#else /* !CONFIG_PM_SUSPEND_PROFILE */
+static inline u64 suspend_prof_now(void) { return 0; }
+static inline void suspend_prof_record(int kind, const char *name, u64 start) {}
+static inline void suspend_prof_record_fn(int kind, void *fn, u64 start) {}
+static inline void suspend_prof_end(int error) {}
+static inline void suspend_prof_print_last(void) {}
+#endif /* !CONFIG_PM_SUSPEND_PROFILE */
+
 /* struct pbe is used for creating lists of pages that should be restored
  * atomically during the resume from disk, because the page frames they have
  * occupied before the suspend are in use.
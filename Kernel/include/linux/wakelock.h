@@ -18,6 +18,7 @@
 
 #include <linux/list.h>
 #include <linux/ktime.h>
+#include <linux/rbtree.h>
 
 /* A wake_lock prevents the system from entering suspend or other low power
  * states when active. If the type is set to WAKE_LOCK_SUSPEND, the wake_lock
@@ -35,6 +36,7 @@ enum {
 struct wake_lock {
 #ifdef CONFIG_HAS_WAKELOCK
 	struct list_head    link;
+	struct rb_node      node;	/* active with timeout, by expires */
 	int                 flags;
 	const char         *name;
 	unsigned long       expires;
@@ -43,6 +45,7 @@ struct wake_lock {
 		int             count;
 		int             expire_count;
 		int             wakeup_count;
+		int             wakeup_irq;
 		ktime_t         total_time;
 		ktime_t         prevent_suspend_time;
 		ktime_t         max_time;
@@ -52,6 +55,54 @@ struct wake_lock {
 #endif
 };
 
+/* Binary stats, read from /proc/wakelocks_bin: one header, nr_locks
+ * wake_lock_stats_entry records, then nr_irqs wake_lock_stats_irq records.
+ * Times are in nanoseconds.  Readers should step over records using the
+ * sizes in the header, which only ever grow.
+ */
+#define WAKE_LOCK_STATS_MAGIC		0x534c4b57	/* "WKLS" */
+#define WAKE_LOCK_STATS_VERSION		1
+#define WAKE_LOCK_STATS_NAME_LEN	32
+
+#define WAKE_LOCK_STATS_ACTIVE		(1U << 0)
+#define WAKE_LOCK_STATS_AUTO_EXPIRE	(1U << 1)
+
+struct wake_lock_stats_header {
+	__u32	magic;
+	__u16	version;
+	__u16	header_size;
+	__u16	entry_size;
+	__u16	irq_size;
+	__u32	nr_locks;
+	__u32	nr_irqs;
+	__u32	reserved;
+	__s64	now;
+};
+
+struct wake_lock_stats_entry {
+	char	name[WAKE_LOCK_STATS_NAME_LEN];
+	__u32	flags;
+	__u32	count;
+	__u32	expire_count;
+	__u32	wakeup_count;
+	__s32	wakeup_irq;	/* last wakeup attributed, -1 if unknown */
+	__u32	reserved;
+	__s64	active_since;
+	__s64	total_time;
+	__s64	sleep_time;
+	__s64	max_time;
+	__s64	last_change;
+};
+
+/* Wakeup source (IRQ, -1 if the platform could not tell) and the wake
+ * lock it caused to be taken first after resume.
+ */
+struct wake_lock_stats_irq {
+	__s32	irq;
+	__u32	count;
+	char	name[WAKE_LOCK_STATS_NAME_LEN];
+};
+
 #ifdef CONFIG_HAS_WAKELOCK
 
 void wake_lock_init(struct wake_lock *lock, int type, const char *name);
@@ -75,6 +126,15 @@ long has_wake_lock(int type);
 
 int has_audio_wake_lock(void);
 
+#ifdef CONFIG_WAKELOCK_STAT
+/* Called by the platform, with interrupts off, once it has decoded which
+ * interrupt woke the system.  The next wake lock taken is charged to it.
+ */
+void wake_lock_wakeup_irq(int irq);
+#else
+static inline void wake_lock_wakeup_irq(int irq) {}
+#endif
+
 #else
 
 static inline void wake_lock_init(struct wake_lock *lock, int type,
@@ -86,6 +146,7 @@ static inline void wake_unlock(struct wake_lock *lock) {}
 
 static inline int wake_lock_active(struct wake_lock *lock) { return 0; }
 static inline long has_wake_lock(int type) { return 0; }
+static inline void wake_lock_wakeup_irq(int irq) {}
 
 #endif
 
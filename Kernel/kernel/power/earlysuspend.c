@@ -88,6 +88,7 @@ static void early_suspend(struct work_struct *work)
 	struct early_suspend *pos;
 	unsigned long irqflags;
 	int abort = 0;
+	u64 t0;
 
 	mutex_lock(&early_suspend_lock);
 	spin_lock_irqsave(&state_lock, irqflags);
@@ -107,15 +108,21 @@ static void early_suspend(struct work_struct *work)
 	if (debug_mask & DEBUG_SUSPEND)
 		pr_info("early_suspend: call handlers\n");
 	list_for_each_entry(pos, &early_suspend_handlers, link) {
-		if (pos->suspend != NULL)
+		if (pos->suspend != NULL) {
+			t0 = suspend_prof_now();
 			pos->suspend(pos);
+			suspend_prof_record_fn(SUSPEND_PROF_EARLY_SUSPEND,
+					       pos->suspend, t0);
+		}
 	}
 	mutex_unlock(&early_suspend_lock);
 
 	if (debug_mask & DEBUG_SUSPEND)
 		pr_info("early_suspend: sync\n");
 
+	t0 = suspend_prof_now();
 	sys_sync();
+	suspend_prof_record(SUSPEND_PROF_PHASE, "early_sync", t0);
 
 #if defined (CONFIG_S5P64XX_LPAUDIO) || defined(CONFIG_SND_S5P_RP)
 	if (has_audio_wake_lock()) {
@@ -144,6 +151,7 @@ static void late_resume(struct work_struct *work)
 	struct early_suspend *pos;
 	unsigned long irqflags;
 	int abort = 0;
+	u64 t0;
 
 	mutex_lock(&early_suspend_lock);
 	spin_lock_irqsave(&state_lock, irqflags);
@@ -161,8 +169,14 @@ static void late_resume(struct work_struct *work)
 	if (debug_mask & DEBUG_SUSPEND)
 		pr_info("late_resume: call handlers\n");
 	list_for_each_entry_reverse(pos, &early_suspend_handlers, link)
-		if (pos->resume != NULL)
+		if (pos->resume != NULL) {
+			t0 = suspend_prof_now();
 			pos->resume(pos);
+			suspend_prof_record_fn(SUSPEND_PROF_LATE_RESUME,
+					       pos->resume, t0);
+		}
+	/* screen back on without having slept: close that cycle too */
+	suspend_prof_end(-ECANCELED);
 	if (debug_mask & DEBUG_SUSPEND)
 		pr_info("late_resume: done\n");
 
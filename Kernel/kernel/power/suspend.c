@@ -131,6 +131,7 @@ static char userspace_governor[CPUFREQ_NAME_LEN] = "userspace";
 static int suspend_enter(suspend_state_t state)
 {
 	int error;
+	u64 t0;
 
 #ifdef CONFIG_CPU_FREQ
 	dvfs_set_max_freq_lock();
@@ -163,11 +164,15 @@ static int suspend_enter(suspend_state_t state)
 	arch_suspend_disable_irqs();
 	BUG_ON(!irqs_disabled());
 
+	t0 = suspend_prof_now();
 	error = sysdev_suspend(PMSG_SUSPEND);
+	suspend_prof_record(SUSPEND_PROF_PHASE, "sysdev_suspend", t0);
 	if (!error) {
 		if (!suspend_test(TEST_CORE))
 			error = suspend_ops->enter(state);
+		t0 = suspend_prof_now();
 		sysdev_resume();
+		suspend_prof_record(SUSPEND_PROF_PHASE, "sysdev_resume", t0);
 	}
 
 	arch_suspend_enable_irqs();
@@ -201,6 +206,7 @@ static int suspend_enter(suspend_state_t state)
 int suspend_devices_and_enter(suspend_state_t state)
 {
 	int error;
+	u64 t0;
 
 	if (!suspend_ops)
 		return -ENOSYS;
@@ -212,7 +218,9 @@ int suspend_devices_and_enter(suspend_state_t state)
 	}
 	suspend_console();
 	suspend_test_start();
+	t0 = suspend_prof_now();
 	error = dpm_suspend_start(PMSG_SUSPEND);
+	suspend_prof_record(SUSPEND_PROF_PHASE, "dpm_suspend", t0);
 	if (error) {
 		printk(KERN_ERR "PM: Some devices failed to suspend\n");
 		goto Recover_platform;
@@ -225,7 +233,9 @@ int suspend_devices_and_enter(suspend_state_t state)
 
  Resume_devices:
 	suspend_test_start();
+	t0 = suspend_prof_now();
 	dpm_resume_end(PMSG_RESUME);
+	suspend_prof_record(SUSPEND_PROF_PHASE, "dpm_resume", t0);
 	suspend_test_finish("resume devices");
 	resume_console();
  Close:
@@ -266,6 +276,7 @@ static void suspend_finish(void)
 int enter_state(suspend_state_t state)
 {
 	int error;
+	u64 t0;
 
 	if (!valid_state(state))
 		return -ENODEV;
@@ -274,11 +285,15 @@ int enter_state(suspend_state_t state)
 		return -EBUSY;
 
 	printk(KERN_INFO "PM: Syncing filesystems ... ");
+	t0 = suspend_prof_now();
 	sys_sync();
+	suspend_prof_record(SUSPEND_PROF_PHASE, "sync", t0);
 	printk("done.\n");
 
 	pr_debug("PM: Preparing system for %s sleep\n", pm_states[state]);
+	t0 = suspend_prof_now();
 	error = suspend_prepare();
+	suspend_prof_record(SUSPEND_PROF_PHASE, "freeze", t0);
 	if (error)
 		goto Unlock;
 
@@ -291,8 +306,11 @@ int enter_state(suspend_state_t state)
 
  Finish:
 	pr_debug("PM: Finishing wakeup.\n");
+	t0 = suspend_prof_now();
 	suspend_finish();
+	suspend_prof_record(SUSPEND_PROF_PHASE, "thaw", t0);
  Unlock:
+	suspend_prof_end(error);
 	mutex_unlock(&pm_mutex);
 	return error;
 }
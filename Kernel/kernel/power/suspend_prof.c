@@ -0,0 +1,224 @@
+/*
+ * kernel/power/suspend_prof.c - Suspend/resume latency profiler.
+ *
+ * Every step of a suspend cycle that is worth blaming (device callbacks,
+ * early suspend and late resume handlers, the wait for wake locks, the
+ * generic and platform sleep phases) is timed and logged into a per-cycle
+ * table.  The last CONFIG_PM_SUSPEND_PROFILE_CYCLES tables are kept and
+ * shown in debugfs as "suspend_profile".
+ *
+ * A cycle is opened by the first step recorded after the previous one was
+ * closed (normally the early suspend handlers or the wake lock wait), and
+ * closed when enter_state() returns.  Late resume handlers run once the
+ * screen comes back, so they are added to the newest cycle.
+ *
+ * This file is released under the GPLv2.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/suspend.h>
+#include <linux/time.h>
+
+#define PROF_CYCLES	CONFIG_PM_SUSPEND_PROFILE_CYCLES
+#define PROF_ENTRIES	64
+#define PROF_NAME_LEN	24
+
+struct prof_entry {
+	char		name[PROF_NAME_LEN];
+	u32		at_ms;		/* start, relative to the cycle */
+	u32		usecs;
+	u8		kind;
+};
+
+struct prof_cycle {
+	unsigned int	seq;
+	unsigned long	start_sec;	/* wall clock, for matching logs */
+	u64		start_ns;	/* suspend_prof_now() */
+	int		error;
+	unsigned int	nr;
+	unsigned int	dropped;	/* faster entries pushed out */
+	struct prof_entry entries[PROF_ENTRIES];
+};
+
+static const char *const prof_kind_names[SUSPEND_PROF_NR_KINDS] = {
+	[SUSPEND_PROF_PHASE]		= "phase",
+	[SUSPEND_PROF_DEV_SUSPEND]	= "suspend",
+	[SUSPEND_PROF_DEV_SUSPEND_NOIRQ] = "suspend_noirq",
+	[SUSPEND_PROF_DEV_RESUME_NOIRQ]	= "resume_noirq",
+	[SUSPEND_PROF_DEV_RESUME]	= "resume",
+	[SUSPEND_PROF_EARLY_SUSPEND]	= "early_suspend",
+	[SUSPEND_PROF_LATE_RESUME]	= "late_resume",
+};
+
+static struct prof_cycle prof_cycles[PROF_CYCLES];
+static unsigned int prof_seq;		/* cycles opened so far */
+static struct prof_cycle *prof_cur;	/* open cycle, if any */
+static DEFINE_SPINLOCK(prof_lock);
+
+u64 suspend_prof_now(void)
+{
+	return sched_clock();
+}
+
+static struct prof_cycle *prof_open(u64 start)
+{
+	struct prof_cycle *c = &prof_cycles[prof_seq % PROF_CYCLES];
+
+	memset(c, 0, sizeof(*c));
+	c->seq = ++prof_seq;
+	c->start_sec = get_seconds();
+	c->start_ns = start;
+	prof_cur = c;
+
+	return c;
+}
+
+static u32 prof_clamp(u64 v)
+{
+	return v > UINT_MAX ? UINT_MAX : (u32)v;
+}
+
+void suspend_prof_record(int kind, const char *name, u64 start)
+{
+	struct prof_cycle *c;
+	struct prof_entry *e;
+	unsigned long flags;
+	u64 now = suspend_prof_now();
+	u64 usecs, at;
+	unsigned int i;
+
+	usecs = now > start ? now - start : 0;
+	do_div(usecs, NSEC_PER_USEC);
+
+	spin_lock_irqsave(&prof_lock, flags);
+
+	if (kind == SUSPEND_PROF_LATE_RESUME)
+		c = prof_seq ? &prof_cycles[(prof_seq - 1) % PROF_CYCLES] : NULL;
+	else
+		c = prof_cur ? prof_cur : prof_open(start);
+	if (!c)
+		goto out;
+
+	if (c->nr < PROF_ENTRIES) {
+		e = &c->entries[c->nr++];
+	} else {
+		/* Table full: keep the slowest entries */
+		e = &c->entries[0];
+		for (i = 1; i < PROF_ENTRIES; i++)
+			if (c->entries[i].usecs < e->usecs)
+				e = &c->entries[i];
+		c->dropped++;
+		if (e->usecs >= usecs)
+			goto out;
+	}
+
+	at = start > c->start_ns ? start - c->start_ns : 0;
+	do_div(at, NSEC_PER_MSEC);
+
+	strlcpy(e->name, name, sizeof(e->name));
+	e->kind = kind;
+	e->at_ms = prof_clamp(at);
+	e->usecs = prof_clamp(usecs);
+out:
+	spin_unlock_irqrestore(&prof_lock, flags);
+}
+EXPORT_SYMBOL_GPL(suspend_prof_record);
+
+void suspend_prof_record_fn(int kind, void *fn, u64 start)
+{
+	char name[PROF_NAME_LEN];
+
+	snprintf(name, sizeof(name), "%pf", fn);
+	suspend_prof_record(kind, name, start);
+}
+EXPORT_SYMBOL_GPL(suspend_prof_record_fn);
+
+/**
+ * suspend_prof_end - close the open cycle, if any
+ * @error: result of the suspend attempt
+ */
+void suspend_prof_end(int error)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&prof_lock, flags);
+	if (prof_cur) {
+		prof_cur->error = error;
+		prof_cur = NULL;
+	}
+	spin_unlock_irqrestore(&prof_lock, flags);
+}
+
+#define prof_out(s, fmt, args...)			\
+	do {						\
+		if (s)					\
+			seq_printf(s, fmt, ## args);	\
+		else					\
+			printk(KERN_INFO fmt, ## args);	\
+	} while (0)
+
+static void prof_show_cycle(struct seq_file *s, struct prof_cycle *c)
+{
+	struct prof_entry *e;
+
+	prof_out(s, "cycle %u: start %lu result %d entries %u dropped %u%s\n",
+		 c->seq, c->start_sec, c->error, c->nr, c->dropped,
+		 c == prof_cur ? " (open)" : "");
+	prof_out(s, "  %-14s %10s %10s  %s\n", "kind", "at_ms", "usecs", "name");
+	for (e = c->entries; e < c->entries + c->nr; e++)
+		prof_out(s, "  %-14s %10u %10u  %s\n", prof_kind_names[e->kind],
+			 e->at_ms, e->usecs, e->name);
+}
+
+/**
+ * suspend_prof_print_last - dump the newest cycle to the kernel log
+ */
+void suspend_prof_print_last(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&prof_lock, flags);
+	if (prof_seq)
+		prof_show_cycle(NULL, &prof_cycles[(prof_seq - 1) % PROF_CYCLES]);
+	spin_unlock_irqrestore(&prof_lock, flags);
+}
+
+static int suspend_prof_show(struct seq_file *s, void *unused)
+{
+	unsigned long flags;
+	unsigned int seq;
+
+	spin_lock_irqsave(&prof_lock, flags);
+	seq = prof_seq > PROF_CYCLES ? prof_seq - PROF_CYCLES : 0;
+	for (; seq < prof_seq; seq++)
+		prof_show_cycle(s, &prof_cycles[seq % PROF_CYCLES]);
+	spin_unlock_irqrestore(&prof_lock, flags);
+
+	return 0;
+}
+
+static int suspend_prof_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, suspend_prof_show, NULL);
+}
+
+static const struct file_operations suspend_prof_fops = {
+	.open		= suspend_prof_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init suspend_prof_init(void)
+{
+	debugfs_create_file("suspend_profile", S_IRUGO, NULL, NULL,
+			    &suspend_prof_fops);
+	return 0;
+}
+late_initcall(suspend_prof_init);
@@ -43,19 +43,94 @@ module_param_named(debug_mask, debug_mask, int, S_IRUGO | S_IWUSR | S_IWGRP);
 #define WAKE_LOCK_AUTO_EXPIRE            (1U << 10)
 #define WAKE_LOCK_PREVENTING_SUSPEND     (1U << 11)
 
+/* Active locks without a timeout sit on a list; those with one are kept
+ * in an rbtree ordered by expiry, with both ends cached, so that "any
+ * held", "next to expire" and "last to expire" are all O(1).
+ */
+struct wake_lock_queue {
+	struct list_head	untimed;
+	struct rb_root		timed;
+	struct rb_node		*first;
+	struct rb_node		*last;
+};
+
 static DEFINE_SPINLOCK(list_lock);
 static LIST_HEAD(inactive_locks);
-static struct list_head active_wake_locks[WAKE_LOCK_TYPE_COUNT];
+static struct wake_lock_queue active_wake_locks[WAKE_LOCK_TYPE_COUNT];
 static int current_event_num;
 struct workqueue_struct *suspend_work_queue;
 struct wake_lock main_wake_lock;
 suspend_state_t requested_suspend_state = PM_SUSPEND_MEM;
 static struct wake_lock unknown_wakeup;
+static u64 suspend_wait_start;	/* main lock dropped or last resume */
+
+#define timed_lock(n)	rb_entry(n, struct wake_lock, node)
+
+/* Caller must acquire the list_lock spinlock */
+static void add_active_lock(int type, struct wake_lock *lock)
+{
+	struct wake_lock_queue *q = &active_wake_locks[type];
+	struct rb_node **p = &q->timed.rb_node;
+	struct rb_node *parent = NULL;
+	int leftmost = 1, rightmost = 1;
+
+	if (!(lock->flags & WAKE_LOCK_AUTO_EXPIRE)) {
+		list_add(&lock->link, &q->untimed);
+		return;
+	}
+	while (*p) {
+		parent = *p;
+		if (time_before(lock->expires, timed_lock(parent)->expires)) {
+			p = &parent->rb_left;
+			rightmost = 0;
+		} else {
+			p = &parent->rb_right;
+			leftmost = 0;
+		}
+	}
+	rb_link_node(&lock->node, parent, p);
+	rb_insert_color(&lock->node, &q->timed);
+	if (leftmost)
+		q->first = &lock->node;
+	if (rightmost)
+		q->last = &lock->node;
+}
+
+/* Caller must acquire the list_lock spinlock, lock must be active */
+static void del_active_lock(int type, struct wake_lock *lock)
+{
+	struct wake_lock_queue *q = &active_wake_locks[type];
+
+	if (!(lock->flags & WAKE_LOCK_AUTO_EXPIRE)) {
+		list_del(&lock->link);
+		return;
+	}
+	if (q->first == &lock->node)
+		q->first = rb_next(&lock->node);
+	if (q->last == &lock->node)
+		q->last = rb_prev(&lock->node);
+	rb_erase(&lock->node, &q->timed);
+}
+
+/* Take lock off whichever list or tree it is on */
+static void unlink_lock(struct wake_lock *lock)
+{
+	if (lock->flags & WAKE_LOCK_ACTIVE)
+		del_active_lock(lock->flags & WAKE_LOCK_TYPE_MASK, lock);
+	else
+		list_del(&lock->link);
+}
 
 #ifdef CONFIG_WAKELOCK_STAT
 static struct wake_lock deleted_wake_locks;
 static ktime_t last_sleep_time_update;
 static int wait_for_wakeup;
+static int wakeup_irq = -1;
+static int nr_wake_locks;
+
+#define WAKEUP_IRQ_SLOTS	16
+static struct wake_lock_stats_irq wakeup_irqs[WAKEUP_IRQ_SLOTS];
+static int nr_wakeup_irqs;
 
 int get_expired_time(struct wake_lock *lock, ktime_t *expire_time)
 {
@@ -84,7 +159,8 @@ int get_expired_time(struct wake_lock *lock, ktime_t *expire_time)
 }
 
 
-static int print_lock_stat(struct seq_file *m, struct wake_lock *lock)
+static void get_lock_stat(struct wake_lock *lock,
+			  struct wake_lock_stats_entry *e)
 {
 	int lock_count = lock->stat.count;
 	int expire_count = lock->stat.expire_count;
@@ -112,36 +188,146 @@ static int print_lock_stat(struct seq_file *m, struct wake_lock *lock)
 			max_time = add_time;
 	}
 
-	return seq_printf(m,
-		     "\"%s\"\t%d\t%d\t%d\t%lld\t%lld\t%lld\t%lld\t%lld\n",
-		     lock->name, lock_count, expire_count,
-		     lock->stat.wakeup_count, ktime_to_ns(active_time),
-		     ktime_to_ns(total_time),
-		     ktime_to_ns(prevent_suspend_time), ktime_to_ns(max_time),
-		     ktime_to_ns(lock->stat.last_time));
+	e->flags = 0;
+	if (lock->flags & WAKE_LOCK_ACTIVE)
+		e->flags |= WAKE_LOCK_STATS_ACTIVE;
+	if (lock->flags & WAKE_LOCK_AUTO_EXPIRE)
+		e->flags |= WAKE_LOCK_STATS_AUTO_EXPIRE;
+	e->count = lock_count;
+	e->expire_count = expire_count;
+	e->wakeup_count = lock->stat.wakeup_count;
+	e->wakeup_irq = lock->stat.wakeup_irq;
+	e->reserved = 0;
+	e->active_since = ktime_to_ns(active_time);
+	e->total_time = ktime_to_ns(total_time);
+	e->sleep_time = ktime_to_ns(prevent_suspend_time);
+	e->max_time = ktime_to_ns(max_time);
+	e->last_change = ktime_to_ns(lock->stat.last_time);
 }
 
-static int wakelock_stats_show(struct seq_file *m, void *unused)
+static void print_lock_stat(struct seq_file *m, struct wake_lock *lock)
+{
+	struct wake_lock_stats_entry e;
+
+	get_lock_stat(lock, &e);
+	seq_printf(m, "\"%s\"\t%u\t%u\t%u\t%lld\t%lld\t%lld\t%lld\t%lld\n",
+		   lock->name, e.count, e.expire_count, e.wakeup_count,
+		   e.active_since, e.total_time, e.sleep_time, e.max_time,
+		   e.last_change);
+}
+
+static void write_lock_stat(struct seq_file *m, struct wake_lock *lock)
+{
+	struct wake_lock_stats_entry e;
+
+	memset(e.name, 0, sizeof(e.name));
+	strlcpy(e.name, lock->name, sizeof(e.name));
+	get_lock_stat(lock, &e);
+	seq_write(m, &e, sizeof(e));
+}
+
+/* Caller must acquire the list_lock spinlock */
+static void for_each_wake_lock(struct seq_file *m,
+			       void (*fn)(struct seq_file *, struct wake_lock *))
 {
-	unsigned long irqflags;
 	struct wake_lock *lock;
-	int ret;
+	struct rb_node *n;
 	int type;
 
-	spin_lock_irqsave(&list_lock, irqflags);
-
-	ret = seq_puts(m, "name\tcount\texpire_count\twake_count\tactive_since"
-			"\ttotal_time\tsleep_time\tmax_time\tlast_change\n");
 	list_for_each_entry(lock, &inactive_locks, link)
-		ret = print_lock_stat(m, lock);
+		fn(m, lock);
 	for (type = 0; type < WAKE_LOCK_TYPE_COUNT; type++) {
-		list_for_each_entry(lock, &active_wake_locks[type], link)
-			ret = print_lock_stat(m, lock);
+		list_for_each_entry(lock, &active_wake_locks[type].untimed, link)
+			fn(m, lock);
+		for (n = active_wake_locks[type].first; n; n = rb_next(n))
+			fn(m, timed_lock(n));
 	}
+}
+
+static int wakelock_stats_show(struct seq_file *m, void *unused)
+{
+	unsigned long irqflags;
+
+	spin_lock_irqsave(&list_lock, irqflags);
+
+	seq_puts(m, "name\tcount\texpire_count\twake_count\tactive_since"
+			"\ttotal_time\tsleep_time\tmax_time\tlast_change\n");
+	for_each_wake_lock(m, print_lock_stat);
+	spin_unlock_irqrestore(&list_lock, irqflags);
+	return 0;
+}
+
+static int wakelock_stats_bin_show(struct seq_file *m, void *unused)
+{
+	struct wake_lock_stats_header h;
+	unsigned long irqflags;
+
+	memset(&h, 0, sizeof(h));
+	h.magic = WAKE_LOCK_STATS_MAGIC;
+	h.version = WAKE_LOCK_STATS_VERSION;
+	h.header_size = sizeof(h);
+	h.entry_size = sizeof(struct wake_lock_stats_entry);
+	h.irq_size = sizeof(struct wake_lock_stats_irq);
+
+	spin_lock_irqsave(&list_lock, irqflags);
+	h.nr_locks = nr_wake_locks;
+	h.nr_irqs = nr_wakeup_irqs;
+	h.now = ktime_to_ns(ktime_get());
+	seq_write(m, &h, sizeof(h));
+	for_each_wake_lock(m, write_lock_stat);
+	seq_write(m, wakeup_irqs, nr_wakeup_irqs * sizeof(wakeup_irqs[0]));
+	spin_unlock_irqrestore(&list_lock, irqflags);
+	return 0;
+}
+
+static int wakeup_irqs_show(struct seq_file *m, void *unused)
+{
+	unsigned long irqflags;
+	int i;
+
+	spin_lock_irqsave(&list_lock, irqflags);
+	seq_puts(m, "irq\tcount\tname\n");
+	for (i = 0; i < nr_wakeup_irqs; i++)
+		seq_printf(m, "%d\t%u\t\"%s\"\n", wakeup_irqs[i].irq,
+			   wakeup_irqs[i].count, wakeup_irqs[i].name);
 	spin_unlock_irqrestore(&list_lock, irqflags);
 	return 0;
 }
 
+void wake_lock_wakeup_irq(int irq)
+{
+	unsigned long irqflags;
+
+	spin_lock_irqsave(&list_lock, irqflags);
+	if (wait_for_wakeup)
+		wakeup_irq = irq;
+	spin_unlock_irqrestore(&list_lock, irqflags);
+}
+EXPORT_SYMBOL(wake_lock_wakeup_irq);
+
+/* Charge a wakeup to (irq, lock); the least hit pair gives way when full */
+static void account_wakeup_irq_locked(int irq, struct wake_lock *lock)
+{
+	struct wake_lock_stats_irq *w, *victim = wakeup_irqs;
+
+	lock->stat.wakeup_irq = irq;
+	for (w = wakeup_irqs; w < wakeup_irqs + nr_wakeup_irqs; w++) {
+		if (w->irq == irq && !strncmp(w->name, lock->name,
+					      sizeof(w->name) - 1)) {
+			w->count++;
+			return;
+		}
+		if (w->count < victim->count)
+			victim = w;
+	}
+	if (nr_wakeup_irqs < WAKEUP_IRQ_SLOTS)
+		victim = &wakeup_irqs[nr_wakeup_irqs++];
+	victim->irq = irq;
+	victim->count = 1;
+	memset(victim->name, 0, sizeof(victim->name));
+	strlcpy(victim->name, lock->name, sizeof(victim->name));
+}
+
 static void wake_unlock_stat_locked(struct wake_lock *lock, int expired)
 {
 	ktime_t duration;
@@ -168,29 +354,40 @@ static void wake_unlock_stat_locked(struct wake_lock *lock, int expired)
 	}
 }
 
+static void update_sleep_wait_stat_locked(struct wake_lock *lock, int done,
+					  ktime_t elapsed)
+{
+	ktime_t etime, add;
+	int expired;
+
+	expired = get_expired_time(lock, &etime);
+	if (lock->flags & WAKE_LOCK_PREVENTING_SUSPEND) {
+		if (expired)
+			add = ktime_sub(etime, last_sleep_time_update);
+		else
+			add = elapsed;
+		lock->stat.prevent_suspend_time = ktime_add(
+			lock->stat.prevent_suspend_time, add);
+	}
+	if (done || expired)
+		lock->flags &= ~WAKE_LOCK_PREVENTING_SUSPEND;
+	else
+		lock->flags |= WAKE_LOCK_PREVENTING_SUSPEND;
+}
+
 static void update_sleep_wait_stats_locked(int done)
 {
+	struct wake_lock_queue *q = &active_wake_locks[WAKE_LOCK_SUSPEND];
 	struct wake_lock *lock;
-	ktime_t now, etime, elapsed, add;
-	int expired;
+	struct rb_node *n;
+	ktime_t now, elapsed;
 
 	now = ktime_get();
 	elapsed = ktime_sub(now, last_sleep_time_update);
-	list_for_each_entry(lock, &active_wake_locks[WAKE_LOCK_SUSPEND], link) {
-		expired = get_expired_time(lock, &etime);
-		if (lock->flags & WAKE_LOCK_PREVENTING_SUSPEND) {
-			if (expired)
-				add = ktime_sub(etime, last_sleep_time_update);
-			else
-				add = elapsed;
-			lock->stat.prevent_suspend_time = ktime_add(
-				lock->stat.prevent_suspend_time, add);
-		}
-		if (done || expired)
-			lock->flags &= ~WAKE_LOCK_PREVENTING_SUSPEND;
-		else
-			lock->flags |= WAKE_LOCK_PREVENTING_SUSPEND;
-	}
+	list_for_each_entry(lock, &q->untimed, link)
+		update_sleep_wait_stat_locked(lock, done, elapsed);
+	for (n = q->first; n; n = rb_next(n))
+		update_sleep_wait_stat_locked(timed_lock(n), done, elapsed);
 	last_sleep_time_update = now;
 }
 #endif
@@ -201,8 +398,8 @@ static void expire_wake_lock(struct wake_lock *lock)
 #ifdef CONFIG_WAKELOCK_STAT
 	wake_unlock_stat_locked(lock, 1);
 #endif
+	del_active_lock(lock->flags & WAKE_LOCK_TYPE_MASK, lock);
 	lock->flags &= ~(WAKE_LOCK_ACTIVE | WAKE_LOCK_AUTO_EXPIRE);
-	list_del(&lock->link);
 	list_add(&lock->link, &inactive_locks);
 	if (debug_mask & (DEBUG_WAKE_LOCK | DEBUG_EXPIRE))
 		pr_info("expired wake lock %s\n", lock->name);
@@ -211,43 +408,50 @@ static void expire_wake_lock(struct wake_lock *lock)
 /* Caller must acquire the list_lock spinlock */
 static void print_active_locks(int type)
 {
+	struct wake_lock_queue *q = &active_wake_locks[type];
 	struct wake_lock *lock;
+	struct rb_node *n;
 	bool print_expired = true;
 
 	BUG_ON(type >= WAKE_LOCK_TYPE_COUNT);
-	list_for_each_entry(lock, &active_wake_locks[type], link) {
-		if (lock->flags & WAKE_LOCK_AUTO_EXPIRE) {
-			long timeout = lock->expires - jiffies;
-			if (timeout > 0)
-				pr_info("active wake lock %s, time left %ld\n",
-					lock->name, timeout);
-			else if (print_expired)
-				pr_info("wake lock %s, expired\n", lock->name);
-		} else {
-			pr_info("active wake lock %s\n", lock->name);
-			if (!debug_mask & DEBUG_EXPIRE)
-				print_expired = false;
-		}
+	list_for_each_entry(lock, &q->untimed, link) {
+		pr_info("active wake lock %s\n", lock->name);
+		if (!debug_mask & DEBUG_EXPIRE)
+			print_expired = false;
+	}
+	for (n = q->first; n; n = rb_next(n)) {
+		long timeout;
+
+		lock = timed_lock(n);
+		timeout = lock->expires - jiffies;
+		if (timeout > 0)
+			pr_info("active wake lock %s, time left %ld\n",
+				lock->name, timeout);
+		else if (print_expired)
+			pr_info("wake lock %s, expired\n", lock->name);
 	}
 }
 
+/* Expired locks are always at the front of the tree, so retiring them
+ * costs nothing when there are none.
+ */
 static long has_wake_lock_locked(int type)
 {
-	struct wake_lock *lock, *n;
-	long max_timeout = 0;
+	struct wake_lock_queue *q = &active_wake_locks[type];
+	struct wake_lock *lock;
 
 	BUG_ON(type >= WAKE_LOCK_TYPE_COUNT);
-	list_for_each_entry_safe(lock, n, &active_wake_locks[type], link) {
-		if (lock->flags & WAKE_LOCK_AUTO_EXPIRE) {
-			long timeout = lock->expires - jiffies;
-			if (timeout <= 0)
-				expire_wake_lock(lock);
-			else if (timeout > max_timeout)
-				max_timeout = timeout;
-		} else
-			return -1;
+	while (q->first) {
+		lock = timed_lock(q->first);
+		if ((long)(lock->expires - jiffies) > 0)
+			break;
+		expire_wake_lock(lock);
 	}
-	return max_timeout;
+	if (!list_empty(&q->untimed))
+		return -1;
+	if (!q->last)
+		return 0;
+	return timed_lock(q->last)->expires - jiffies;
 }
 
 long has_wake_lock(int type)
@@ -289,11 +493,19 @@ static void suspend(struct work_struct *work)
 	} 
 #endif /* CONFIG_SVNET_WHITELIST */
 
+	if (suspend_wait_start)
+		suspend_prof_record(SUSPEND_PROF_PHASE, "wakelock_wait",
+				    suspend_wait_start);
+
 	entry_event_num = current_event_num;
+	suspend_wait_start = suspend_prof_now();
 	sys_sync();
+	suspend_prof_record(SUSPEND_PROF_PHASE, "wakelock_sync",
+			    suspend_wait_start);
 	if (debug_mask & DEBUG_SUSPEND)
 		pr_info("suspend: enter suspend\n");
 	ret = pm_suspend(requested_suspend_state);
+	suspend_wait_start = suspend_prof_now();
 	if (debug_mask & DEBUG_EXIT_SUSPEND) {
 		struct timespec ts;
 		struct rtc_time tm;
@@ -312,6 +524,33 @@ static void suspend(struct work_struct *work)
 }
 static DECLARE_WORK(suspend_work, suspend);
 
+static void expire_wake_locks(unsigned long data);
+static DEFINE_TIMER(expire_timer, expire_wake_locks, 0, 0);
+
+/* Caller must acquire the list_lock spinlock.  has_lock is the result of
+ * has_wake_lock_locked(WAKE_LOCK_SUSPEND).  The timer only runs while
+ * nothing but timed locks is held, and then fires at the next expiry.
+ */
+static void update_expire_timer_locked(const char *who, long has_lock)
+{
+	struct wake_lock_queue *q = &active_wake_locks[WAKE_LOCK_SUSPEND];
+
+	if (has_lock > 0) {
+		unsigned long next = timed_lock(q->first)->expires;
+
+		if (debug_mask & DEBUG_EXPIRE)
+			pr_info("%s, start expire timer, %ld\n",
+				who, (long)(next - jiffies));
+		mod_timer(&expire_timer, next);
+	} else {
+		if (del_timer(&expire_timer))
+			if (debug_mask & DEBUG_EXPIRE)
+				pr_info("%s, stop expire timer\n", who);
+		if (has_lock == 0)
+			queue_work(suspend_work_queue, &suspend_work);
+	}
+}
+
 static void expire_wake_locks(unsigned long data)
 {
 	long has_lock;
@@ -324,11 +563,9 @@ static void expire_wake_locks(unsigned long data)
 	has_lock = has_wake_lock_locked(WAKE_LOCK_SUSPEND);
 	if (debug_mask & DEBUG_EXPIRE)
 		pr_info("expire_wake_locks: done, has_lock %ld\n", has_lock);
-	if (has_lock == 0)
-		queue_work(suspend_work_queue, &suspend_work);
+	update_expire_timer_locked("expire_wake_locks", has_lock);
 	spin_unlock_irqrestore(&list_lock, irqflags);
 }
-static DEFINE_TIMER(expire_timer, expire_wake_locks, 0, 0);
 
 static int power_suspend_late(struct device *dev)
 {
@@ -367,6 +604,7 @@ void wake_lock_init(struct wake_lock *lock, int type, const char *name)
 	lock->stat.count = 0;
 	lock->stat.expire_count = 0;
 	lock->stat.wakeup_count = 0;
+	lock->stat.wakeup_irq = -1;
 	lock->stat.total_time = ktime_set(0, 0);
 	lock->stat.prevent_suspend_time = ktime_set(0, 0);
 	lock->stat.max_time = ktime_set(0, 0);
@@ -375,8 +613,12 @@ void wake_lock_init(struct wake_lock *lock, int type, const char *name)
 	lock->flags = (type & WAKE_LOCK_TYPE_MASK) | WAKE_LOCK_INITIALIZED;
 
 	INIT_LIST_HEAD(&lock->link);
+	RB_CLEAR_NODE(&lock->node);
 	spin_lock_irqsave(&list_lock, irqflags);
 	list_add(&lock->link, &inactive_locks);
+#ifdef CONFIG_WAKELOCK_STAT
+	nr_wake_locks++;
+#endif
 	spin_unlock_irqrestore(&list_lock, irqflags);
 }
 EXPORT_SYMBOL(wake_lock_init);
@@ -389,6 +631,7 @@ void wake_lock_destroy(struct wake_lock *lock)
 	spin_lock_irqsave(&list_lock, irqflags);
 	lock->flags &= ~WAKE_LOCK_INITIALIZED;
 #ifdef CONFIG_WAKELOCK_STAT
+	nr_wake_locks--;
 	if (lock->stat.count) {
 		deleted_wake_locks.stat.count += lock->stat.count;
 		deleted_wake_locks.stat.expire_count += lock->stat.expire_count;
@@ -403,7 +646,7 @@ void wake_lock_destroy(struct wake_lock *lock)
 				  lock->stat.max_time);
 	}
 #endif
-	list_del(&lock->link);
+	unlink_lock(lock);
 	spin_unlock_irqrestore(&list_lock, irqflags);
 }
 EXPORT_SYMBOL(wake_lock_destroy);
@@ -422,9 +665,12 @@ static void wake_lock_internal(
 #ifdef CONFIG_WAKELOCK_STAT
 	if (type == WAKE_LOCK_SUSPEND && wait_for_wakeup) {
 		if (debug_mask & DEBUG_WAKEUP)
-			pr_info("wakeup wake lock: %s\n", lock->name);
+			pr_info("wakeup wake lock: %s, irq %d\n",
+				lock->name, wakeup_irq);
 		wait_for_wakeup = 0;
 		lock->stat.wakeup_count++;
+		account_wakeup_irq_locked(wakeup_irq, lock);
+		wakeup_irq = -1;
 	}
 	if ((lock->flags & WAKE_LOCK_AUTO_EXPIRE) &&
 	    (long)(lock->expires - jiffies) <= 0) {
@@ -432,13 +678,13 @@ static void wake_lock_internal(
 		lock->stat.last_time = ktime_get();
 	}
 #endif
+	unlink_lock(lock);
 	if (!(lock->flags & WAKE_LOCK_ACTIVE)) {
 		lock->flags |= WAKE_LOCK_ACTIVE;
 #ifdef CONFIG_WAKELOCK_STAT
 		lock->stat.last_time = ktime_get();
 #endif
 	}
-	list_del(&lock->link);
 	if (has_timeout) {
 		if (debug_mask & DEBUG_WAKE_LOCK)
 			pr_info("wake_lock: %s, type %d, timeout %ld.%03lu\n",
@@ -446,16 +692,17 @@ static void wake_lock_internal(
 				(timeout % HZ) * MSEC_PER_SEC / HZ);
 		lock->expires = jiffies + timeout;
 		lock->flags |= WAKE_LOCK_AUTO_EXPIRE;
-		list_add_tail(&lock->link, &active_wake_locks[type]);
 	} else {
 		if (debug_mask & DEBUG_WAKE_LOCK)
 			pr_info("wake_lock: %s, type %d\n", lock->name, type);
 		lock->expires = LONG_MAX;
 		lock->flags &= ~WAKE_LOCK_AUTO_EXPIRE;
-		list_add(&lock->link, &active_wake_locks[type]);
 	}
+	add_active_lock(type, lock);
 	if (type == WAKE_LOCK_SUSPEND) {
 		current_event_num++;
+		if (lock == &main_wake_lock)
+			suspend_wait_start = 0;
 #ifdef CONFIG_WAKELOCK_STAT
 		if (lock == &main_wake_lock)
 			update_sleep_wait_stats_locked(1);
@@ -466,19 +713,7 @@ static void wake_lock_internal(
 			expire_in = has_wake_lock_locked(type);
 		else
 			expire_in = -1;
-		if (expire_in > 0) {
-			if (debug_mask & DEBUG_EXPIRE)
-				pr_info("wake_lock: %s, start expire timer, "
-					"%ld\n", lock->name, expire_in);
-			mod_timer(&expire_timer, jiffies + expire_in);
-		} else {
-			if (del_timer(&expire_timer))
-				if (debug_mask & DEBUG_EXPIRE)
-					pr_info("wake_lock: %s, stop expire timer\n",
-						lock->name);
-			if (expire_in == 0)
-				queue_work(suspend_work_queue, &suspend_work);
-		}
+		update_expire_timer_locked(lock->name, expire_in);
 	}
 	spin_unlock_irqrestore(&list_lock, irqflags);
 }
@@ -506,25 +741,14 @@ void wake_unlock(struct wake_lock *lock)
 #endif
 	if (debug_mask & DEBUG_WAKE_LOCK)
 		pr_info("wake_unlock: %s\n", lock->name);
+	unlink_lock(lock);
 	lock->flags &= ~(WAKE_LOCK_ACTIVE | WAKE_LOCK_AUTO_EXPIRE);
-	list_del(&lock->link);
 	list_add(&lock->link, &inactive_locks);
 	if (type == WAKE_LOCK_SUSPEND) {
 		long has_lock = has_wake_lock_locked(type);
-		if (has_lock > 0) {
-			if (debug_mask & DEBUG_EXPIRE)
-				pr_info("wake_unlock: %s, start expire timer, "
-					"%ld\n", lock->name, has_lock);
-			mod_timer(&expire_timer, jiffies + has_lock);
-		} else {
-			if (del_timer(&expire_timer))
-				if (debug_mask & DEBUG_EXPIRE)
-					pr_info("wake_unlock: %s, stop expire "
-						"timer\n", lock->name);
-			if (has_lock == 0)
-				queue_work(suspend_work_queue, &suspend_work);
-		}
+		update_expire_timer_locked(lock->name, has_lock);
 		if (lock == &main_wake_lock) {
+			suspend_wait_start = suspend_prof_now();
 			if (debug_mask & DEBUG_SUSPEND)
 				print_active_locks(WAKE_LOCK_SUSPEND);
 #ifdef CONFIG_WAKELOCK_STAT
@@ -547,27 +771,26 @@ static int has_wake_lock_internal(const char *name)
 {
 	int ret = 0;
 	unsigned long irqflags;
-	struct wake_lock *lock, *n;
+	struct wake_lock_queue *q = &active_wake_locks[WAKE_LOCK_SUSPEND];
+	struct wake_lock *lock;
+	struct rb_node *n;
 
 	spin_lock_irqsave(&list_lock, irqflags);
-	list_for_each_entry_safe(lock, n, &active_wake_locks[WAKE_LOCK_SUSPEND], link) {
-		if (lock->flags & WAKE_LOCK_AUTO_EXPIRE) {
-			long timeout = lock->expires - jiffies;
-			if (timeout > 0) {
-				if (strcmp(lock->name, name) == 0) {
-					ret = 1;
-					spin_unlock_irqrestore(&list_lock, irqflags);
-					return ret;
-				}
-			}
-		} else {
-			if (strcmp(lock->name, name) == 0) {
-				ret = 1;
-				spin_unlock_irqrestore(&list_lock, irqflags);
-				return ret;
-			}
+	list_for_each_entry(lock, &q->untimed, link) {
+		if (strcmp(lock->name, name) == 0) {
+			ret = 1;
+			goto out;
 		}
 	}
+	for (n = q->first; n; n = rb_next(n)) {
+		lock = timed_lock(n);
+		if ((long)(lock->expires - jiffies) > 0 &&
+		    strcmp(lock->name, name) == 0) {
+			ret = 1;
+			goto out;
+		}
+	}
+out:
 	spin_unlock_irqrestore(&list_lock, irqflags);
 	return ret;
 }
@@ -597,13 +820,43 @@ static const struct file_operations wakelock_stats_fops = {
 	.release = single_release,
 };
 
+#ifdef CONFIG_WAKELOCK_STAT
+static int wakelock_stats_bin_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wakelock_stats_bin_show, NULL);
+}
+
+static const struct file_operations wakelock_stats_bin_fops = {
+	.owner = THIS_MODULE,
+	.open = wakelock_stats_bin_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int wakeup_irqs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wakeup_irqs_show, NULL);
+}
+
+static const struct file_operations wakeup_irqs_fops = {
+	.owner = THIS_MODULE,
+	.open = wakeup_irqs_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+#endif
+
 static int __init wakelocks_init(void)
 {
 	int ret;
 	int i;
 
-	for (i = 0; i < ARRAY_SIZE(active_wake_locks); i++)
-		INIT_LIST_HEAD(&active_wake_locks[i]);
+	for (i = 0; i < ARRAY_SIZE(active_wake_locks); i++) {
+		INIT_LIST_HEAD(&active_wake_locks[i].untimed);
+		active_wake_locks[i].timed = RB_ROOT;
+	}
 
 #ifdef CONFIG_WAKELOCK_STAT
 	wake_lock_init(&deleted_wake_locks, WAKE_LOCK_SUSPEND,
@@ -632,6 +885,8 @@ static int __init wakelocks_init(void)
 
 #ifdef CONFIG_WAKELOCK_STAT
 	proc_create("wakelocks", S_IRUGO, NULL, &wakelock_stats_fops);
+	proc_create("wakelocks_bin", S_IRUGO, NULL, &wakelock_stats_bin_fops);
+	proc_create("wakeup_irqs", S_IRUGO, NULL, &wakeup_irqs_fops);
 #endif
 
 	return 0;
@@ -652,6 +907,8 @@ err_platform_device_register:
 static void  __exit wakelocks_exit(void)
 {
 #ifdef CONFIG_WAKELOCK_STAT
+	remove_proc_entry("wakeup_irqs", NULL);
+	remove_proc_entry("wakelocks_bin", NULL);
 	remove_proc_entry("wakelocks", NULL);
 #endif
 	destroy_workqueue(suspend_work_queue);
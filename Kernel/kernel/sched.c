@@ -258,6 +258,8 @@ struct task_group {
 	/* runqueue "owned" by this group on each cpu */
 	struct cfs_rq **cfs_rq;
 	unsigned long shares;
+	/* wakeup latency target in ns, 0 to inherit the parent's */
+	u64 latency;
 #endif
 
 #ifdef CONFIG_RT_GROUP_SCHED
@@ -389,6 +391,12 @@ static inline struct task_group *task_group(struct task_struct *p)
 
 #endif	/* CONFIG_GROUP_SCHED */
 
+/*
+ * Wakeup to run latency histogram: bucket 0 counts latencies below
+ * 1024ns, bucket n those below 1024ns << n, the last one the rest.
+ */
+#define SCHED_LAT_HIST_BUCKETS	20
+
 /* CFS-related fields in a runqueue */
 struct cfs_rq {
 	struct load_weight load;
@@ -411,6 +419,10 @@ struct cfs_rq {
 
 	unsigned int nr_spread_over;
 
+#ifdef CONFIG_SCHEDSTATS
+	unsigned long lat_hist[SCHED_LAT_HIST_BUCKETS];
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	struct rq *rq;	/* cpu runqueue to which this cfs_rq is attached */
 
@@ -10220,6 +10232,27 @@ unsigned long sched_group_shares(struct task_group *tg)
 {
 	return tg->shares;
 }
+
+/*
+ * A group's latency target scales the wakeup granularity and the
+ * slices of its entities relative to sysctl_sched_latency.
+ */
+#define MIN_LATENCY_NS	100000ULL
+#define MAX_LATENCY_NS	1000000000ULL
+
+int sched_group_set_latency(struct task_group *tg, u64 latency)
+{
+	if (latency && (latency < MIN_LATENCY_NS || latency > MAX_LATENCY_NS))
+		return -EINVAL;
+
+	tg->latency = latency;
+	return 0;
+}
+
+u64 sched_group_latency(struct task_group *tg)
+{
+	return tg->latency;
+}
 #endif
 
 #ifdef CONFIG_RT_GROUP_SCHED
@@ -10609,6 +10642,51 @@ static u64 cpu_shares_read_u64(struct cgroup *cgrp, struct cftype *cft)
 
 	return (u64) tg->shares;
 }
+
+static int cpu_latency_write_u64(struct cgroup *cgrp, struct cftype *cftype,
+				 u64 latency)
+{
+	return sched_group_set_latency(cgroup_tg(cgrp), latency);
+}
+
+static u64 cpu_latency_read_u64(struct cgroup *cgrp, struct cftype *cft)
+{
+	return sched_group_latency(cgroup_tg(cgrp));
+}
+
+#ifdef CONFIG_SCHEDSTATS
+static int cpu_latency_hist_show(struct cgroup *cgrp, struct cftype *cft,
+				 struct cgroup_map_cb *cb)
+{
+	struct task_group *tg = cgroup_tg(cgrp);
+	unsigned long count;
+	char key[24];
+	int i, cpu;
+
+	for (i = 0; i < SCHED_LAT_HIST_BUCKETS; i++) {
+		count = 0;
+		for_each_possible_cpu(cpu)
+			count += tg->cfs_rq[cpu]->lat_hist[i];
+		if (i == SCHED_LAT_HIST_BUCKETS - 1)
+			strcpy(key, "inf");
+		else
+			snprintf(key, sizeof(key), "%lu", 1024UL << i);
+		cb->fill(cb, key, count);
+	}
+	return 0;
+}
+
+static int cpu_latency_hist_reset(struct cgroup *cgrp, unsigned int event)
+{
+	struct task_group *tg = cgroup_tg(cgrp);
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(tg->cfs_rq[cpu]->lat_hist, 0,
+		       sizeof(tg->cfs_rq[cpu]->lat_hist));
+	return 0;
+}
+#endif /* CONFIG_SCHEDSTATS */
 #endif /* CONFIG_FAIR_GROUP_SCHED */
 
 #ifdef CONFIG_RT_GROUP_SCHED
@@ -10642,6 +10720,18 @@ static struct cftype cpu_files[] = {
 		.read_u64 = cpu_shares_read_u64,
 		.write_u64 = cpu_shares_write_u64,
 	},
+	{
+		.name = "latency_ns",
+		.read_u64 = cpu_latency_read_u64,
+		.write_u64 = cpu_latency_write_u64,
+	},
+#ifdef CONFIG_SCHEDSTATS
+	{
+		.name = "latency_hist",
+		.read_map = cpu_latency_hist_show,
+		.trigger = cpu_latency_hist_reset,
+	},
+#endif
 #endif
 #ifdef CONFIG_RT_GROUP_SCHED
 	{
@@ -435,6 +435,43 @@ static u64 __sched_period(unsigned long nr_running)
 	return period;
 }
 
+#ifdef CONFIG_FAIR_GROUP_SCHED
+/*
+ * The latency target of the group an entity is, or runs a task of;
+ * groups without one inherit it from their parent.
+ */
+static u64 entity_latency(struct sched_entity *se)
+{
+	struct task_group *tg = entity_is_task(se) ? cfs_rq_of(se)->tg :
+						     group_cfs_rq(se)->tg;
+
+	for (; tg; tg = tg->parent) {
+		if (tg->latency)
+			return tg->latency;
+	}
+	return sysctl_sched_latency;
+}
+
+/*
+ * Scale a time derived from sysctl_sched_latency to the latency target
+ * of se's group.
+ */
+static u64 latency_scale(u64 delta, struct sched_entity *se)
+{
+	u64 latency = entity_latency(se);
+
+	if (likely(latency == sysctl_sched_latency))
+		return delta;
+
+	return div64_u64(delta * latency, sysctl_sched_latency);
+}
+#else
+static inline u64 latency_scale(u64 delta, struct sched_entity *se)
+{
+	return delta;
+}
+#endif
+
 /*
  * We calculate the wall-time slice from the period by taking a part
  * proportional to the weight.
@@ -443,7 +480,8 @@ static u64 __sched_period(unsigned long nr_running)
  */
 static u64 sched_slice(struct cfs_rq *cfs_rq, struct sched_entity *se)
 {
-	u64 slice = __sched_period(cfs_rq->nr_running + !se->on_rq);
+	u64 slice = latency_scale(__sched_period(cfs_rq->nr_running +
+						 !se->on_rq), se);
 
 	for_each_sched_entity(se) {
 		struct load_weight *load;
@@ -569,6 +607,38 @@ update_stats_dequeue(struct cfs_rq *cfs_rq, struct sched_entity *se)
 		update_stats_wait_end(cfs_rq, se);
 }
 
+/*
+ * A task is woken up - start timing its wakeup to run latency:
+ */
+static inline void
+update_stats_wakeup_start(struct cfs_rq *cfs_rq, struct sched_entity *se)
+{
+#ifdef CONFIG_SCHEDSTATS
+	if (entity_is_task(se))
+		se->wakeup_start = rq_of(cfs_rq)->clock;
+#endif
+}
+
+/*
+ * A woken task gets to run - account its latency to its group:
+ */
+static inline void
+update_stats_wakeup_end(struct cfs_rq *cfs_rq, struct sched_entity *se)
+{
+#ifdef CONFIG_SCHEDSTATS
+	s64 delta;
+
+	if (!entity_is_task(se) || !se->wakeup_start)
+		return;
+
+	/* the wakeup may have been stamped by another cpu's clock */
+	delta = max_t(s64, rq_of(cfs_rq)->clock - se->wakeup_start, 0);
+	se->wakeup_start = 0;
+	cfs_rq->lat_hist[min(fls64(delta >> 10),
+			     SCHED_LAT_HIST_BUCKETS - 1)]++;
+#endif
+}
+
 /*
  * We are picking a new current task - update its stats:
  */
@@ -755,6 +825,7 @@ enqueue_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int wakeup)
 	if (wakeup) {
 		place_entity(cfs_rq, se, 0);
 		enqueue_sleeper(cfs_rq, se);
+		update_stats_wakeup_start(cfs_rq, se);
 	}
 
 	update_stats_enqueue(cfs_rq, se);
@@ -863,6 +934,7 @@ set_next_entity(struct cfs_rq *cfs_rq, struct sched_entity *se)
 	}
 
 	update_stats_curr_start(cfs_rq, se);
+	update_stats_wakeup_end(cfs_rq, se);
 	cfs_rq->curr = se;
 #ifdef CONFIG_SCHEDSTATS
 	/*
@@ -1548,6 +1620,12 @@ wakeup_gran(struct sched_entity *curr, struct sched_entity *se)
 	if (cfs_rq_of(curr)->curr && sched_feat(ADAPTIVE_GRAN))
 		gran = adaptive_gran(curr, se);
 
+	/*
+	 * Entities of groups with a shorter latency target preempt
+	 * sooner, those with a longer one later.
+	 */
+	gran = latency_scale(gran, se);
+
 	/*
 	 * Since its curr running now, convert the gran from real-time
 	 * to virtual-time in his units.
@@ -34,6 +34,7 @@
 #include <linux/hardirq.h> /* for BUG_ON(!in_atomic()) only */
 #include <linux/memcontrol.h>
 #include <linux/mm_inline.h> /* for page_is_file_cache() */
+#include <linux/launch_prefetch.h>
 #include "internal.h"
 
 /*
@@ -1179,6 +1180,7 @@ no_cached_page:
 			desc->error = error;
 			goto out;
 		}
+		launch_prefetch_record(filp, index);
 		goto readpage;
 	}
 
@@ -1402,8 +1404,10 @@ static int page_cache_read(struct file *file, pgoff_t offset)
 			return -ENOMEM;
 
 		ret = add_to_page_cache_lru(page, mapping, offset, GFP_KERNEL);
-		if (ret == 0)
+		if (ret == 0) {
+			launch_prefetch_record(file, offset);
 			ret = mapping->a_ops->readpage(file, page);
+		}
 		else if (ret == -EEXIST)
 			ret = 0; /* losing race to add is OK */
 
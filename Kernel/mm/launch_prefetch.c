@@ -0,0 +1,801 @@
+/*
+ * mm/launch_prefetch.c - application launch page cache prefetcher
+ *
+ * A cold application launch spends much of its time in major faults and
+ * reads of its own binaries, libraries and data files, issued one
+ * readpage or small readahead window at a time and each waited for
+ * before the next is known.  The set and order of those reads is much
+ * the same from one launch to the next.
+ *
+ * A trace is armed for a process name.  The next process to get that
+ * name, at exec or from PR_SET_NAME (which is how zygote children get
+ * theirs), is recorded for a while.  comm only holds 15 characters, and
+ * many package names share their first 15, so the name is taken from
+ * argv[0] when it starts with comm: Android's setArgV0 rewrites argv[0]
+ * before it sets the name.  Names of exactly 15 characters may be
+ * truncated ones and are refused.  While recording, every page cache
+ * page allocated to be read on its behalf is appended to the trace as a
+ * (file, start, nr) extent, merging consecutive pages.  Later launches under the same
+ * name replay the trace from a workqueue, opening each file by path and
+ * issuing readahead for the extents in recorded order, so that most of
+ * the reads are in flight or done before the process asks for them.
+ *
+ * Control is through debugfs, launch_prefetch/control and
+ * launch_prefetch/traces; see Documentation/vm/launch-prefetch.txt.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/mm.h>
+#include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mutex.h>
+#include <linux/list.h>
+#include <linux/ctype.h>
+#include <linux/ktime.h>
+#include <linux/jiffies.h>
+#include <linux/workqueue.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/launch_prefetch.h>
+
+#define LP_MAX_TRACES		32
+#define LP_MAX_FILES		512
+#define LP_MAX_EXTENTS		8192
+#define LP_MAX_EXTENT_PAGES	0xffff
+#define LP_RECORD_SECS		10
+#define LP_REPLAY_GAP		4	/* merge extents this close on replay */
+#define LP_MAX_LOAD		(1 << 20)
+#define LP_NAME_LEN		128
+
+enum lp_state {
+	LP_ARMED,		/* waiting for a launch to record */
+	LP_RECORDING,
+	LP_READY,		/* replayed on launch */
+};
+
+static const char *const lp_state_names[] = {
+	"armed", "recording", "ready",
+};
+
+struct lp_file {
+	dev_t			dev;	/* identify the file while recording */
+	unsigned long		ino;
+	char			*path;
+};
+
+struct lp_extent {
+	u32			start;
+	u16			file;
+	u16			nr;
+};
+
+struct lp_trace {
+	struct list_head	list;
+	char			name[LP_NAME_LEN];
+	enum lp_state		state;
+
+	pid_t			tgid;		/* process being recorded */
+	unsigned long		deadline;
+	unsigned int		record_secs;
+	int			last_file;
+
+	struct lp_file		*files;
+	int			nr_files;
+	struct lp_extent	*ext;
+	int			nr_ext;
+	unsigned long		pages;
+
+	struct work_struct	work;
+	int			replaying;
+	ktime_t			launched;
+	unsigned long		replays;
+	unsigned long		replay_pages;
+	unsigned long		replay_errors;
+	s64			last_replay_us;
+};
+
+atomic_t launch_prefetch_recording = ATOMIC_INIT(0);
+int launch_prefetch_ready;
+
+static LIST_HEAD(lp_traces);
+static int lp_nr_traces;
+static DEFINE_MUTEX(lp_mutex);
+static struct workqueue_struct *lp_wq;
+
+static void lp_replay_work(struct work_struct *work);
+
+static struct lp_trace *lp_find(const char *name)
+{
+	struct lp_trace *t;
+
+	list_for_each_entry(t, &lp_traces, list)
+		if (!strcmp(t->name, name))
+			return t;
+
+	return NULL;
+}
+
+/*
+ * A name of TASK_COMM_LEN - 1 characters may be a truncated comm shared
+ * by several applications, so no trace is keyed by one.
+ */
+static int lp_name_valid(const char *name)
+{
+	return *name && strlen(name) != TASK_COMM_LEN - 1;
+}
+
+/*
+ * The full name of a launch: argv[0], or its last path component, if it
+ * starts with comm, else comm.  During exec argv is not set up yet, and
+ * comm is then the binary's name.
+ */
+static void lp_launch_name(struct task_struct *tsk, char *name)
+{
+	struct mm_struct *mm;
+	char comm[TASK_COMM_LEN];
+	char *base;
+	int len = 0;
+
+	get_task_comm(comm, tsk);
+	strlcpy(name, comm, LP_NAME_LEN);
+
+	mm = get_task_mm(tsk);
+	if (!mm)
+		return;
+	if (mm->arg_start && mm->arg_end > mm->arg_start)
+		len = access_process_vm(tsk, mm->arg_start, name,
+					min_t(unsigned long, LP_NAME_LEN - 1,
+					      mm->arg_end - mm->arg_start), 0);
+	mmput(mm);
+
+	name[max(len, 0)] = '\0';
+	base = strrchr(name, '/');
+	if (base && !strncmp(base + 1, comm, strlen(comm)))
+		memmove(name, base + 1, strlen(base + 1) + 1);
+	else if (strncmp(name, comm, strlen(comm)))
+		strlcpy(name, comm, LP_NAME_LEN);
+}
+
+static struct lp_trace *lp_alloc(const char *name)
+{
+	struct lp_trace *t;
+
+	if (lp_nr_traces >= LP_MAX_TRACES)
+		return NULL;
+
+	t = kzalloc(sizeof(*t), GFP_KERNEL);
+	if (!t)
+		return NULL;
+
+	t->files = vmalloc(LP_MAX_FILES * sizeof(*t->files));
+	t->ext = vmalloc(LP_MAX_EXTENTS * sizeof(*t->ext));
+	if (!t->files || !t->ext) {
+		vfree(t->files);
+		vfree(t->ext);
+		kfree(t);
+		return NULL;
+	}
+
+	strlcpy(t->name, name, LP_NAME_LEN);
+	t->state = LP_ARMED;
+	t->record_secs = LP_RECORD_SECS;
+	t->last_file = -1;
+	INIT_WORK(&t->work, lp_replay_work);
+	list_add_tail(&t->list, &lp_traces);
+	lp_nr_traces++;
+	launch_prefetch_ready++;
+
+	return t;
+}
+
+static void lp_reset(struct lp_trace *t)
+{
+	int i;
+
+	for (i = 0; i < t->nr_files; i++)
+		kfree(t->files[i].path);
+	t->nr_files = 0;
+	t->nr_ext = 0;
+	t->pages = 0;
+	t->last_file = -1;
+}
+
+static void lp_set_state(struct lp_trace *t, enum lp_state state)
+{
+	if (t->state == LP_RECORDING)
+		atomic_dec(&launch_prefetch_recording);
+	else
+		launch_prefetch_ready--;
+
+	t->state = state;
+
+	if (t->state == LP_RECORDING)
+		atomic_inc(&launch_prefetch_recording);
+	else
+		launch_prefetch_ready++;
+}
+
+static void lp_free(struct lp_trace *t)
+{
+	if (t->state == LP_RECORDING)
+		atomic_dec(&launch_prefetch_recording);
+	else
+		launch_prefetch_ready--;
+
+	list_del(&t->list);
+	lp_nr_traces--;
+	lp_reset(t);
+	vfree(t->files);
+	vfree(t->ext);
+	kfree(t);
+}
+
+/* A recording ends at its deadline, or when the trace is full */
+static void lp_stop(struct lp_trace *t)
+{
+	if (t->state != LP_RECORDING)
+		return;
+
+	/* nothing was read: keep waiting for a launch that reads */
+	lp_set_state(t, t->nr_ext ? LP_READY : LP_ARMED);
+}
+
+static void lp_expire(void)
+{
+	struct lp_trace *t;
+
+	list_for_each_entry(t, &lp_traces, list)
+		if (t->state == LP_RECORDING &&
+		    time_after(jiffies, t->deadline))
+			lp_stop(t);
+}
+
+static int lp_add_file(struct lp_trace *t, struct file *file)
+{
+	struct inode *inode = file->f_mapping->host;
+	char *buf, *path;
+	int i;
+
+	if (t->last_file >= 0 &&
+	    t->files[t->last_file].ino == inode->i_ino &&
+	    t->files[t->last_file].dev == inode->i_sb->s_dev)
+		return t->last_file;
+
+	for (i = 0; i < t->nr_files; i++)
+		if (t->files[i].ino == inode->i_ino &&
+		    t->files[i].dev == inode->i_sb->s_dev)
+			return t->last_file = i;
+
+	if (t->nr_files >= LP_MAX_FILES)
+		return -ENOSPC;
+
+	/* called from readahead and page faults, so no fs recursion */
+	buf = (char *)__get_free_page(GFP_NOFS);
+	if (!buf)
+		return -ENOMEM;
+
+	path = d_path(&file->f_path, buf, PAGE_SIZE);
+	if (IS_ERR(path)) {
+		free_page((unsigned long)buf);
+		return PTR_ERR(path);
+	}
+
+	t->files[i].path = kstrdup(path, GFP_NOFS);
+	free_page((unsigned long)buf);
+	if (!t->files[i].path)
+		return -ENOMEM;
+
+	t->files[i].dev = inode->i_sb->s_dev;
+	t->files[i].ino = inode->i_ino;
+	t->nr_files++;
+
+	return t->last_file = i;
+}
+
+static void lp_add(struct lp_trace *t, struct file *file, pgoff_t index)
+{
+	struct lp_extent *e;
+	int f;
+
+	/* the replay of this trace reads by u32 page index */
+	if (index > (u32)~0)
+		return;
+
+	f = lp_add_file(t, file);
+	if (f == -ENOSPC) {
+		lp_stop(t);
+		return;
+	}
+	if (f < 0)
+		return;
+
+	t->pages++;
+
+	if (t->nr_ext) {
+		e = &t->ext[t->nr_ext - 1];
+		if (e->file == f && index >= e->start &&
+		    index < e->start + e->nr)
+			return;
+		if (e->file == f && index == e->start + e->nr &&
+		    e->nr < LP_MAX_EXTENT_PAGES) {
+			e->nr++;
+			return;
+		}
+	}
+
+	e = &t->ext[t->nr_ext++];
+	e->file = f;
+	e->start = index;
+	e->nr = 1;
+
+	if (t->nr_ext == LP_MAX_EXTENTS)
+		lp_stop(t);
+}
+
+void __launch_prefetch_record(struct file *file, pgoff_t index)
+{
+	struct lp_trace *t;
+
+	if (!S_ISREG(file->f_mapping->host->i_mode))
+		return;
+
+	mutex_lock(&lp_mutex);
+	list_for_each_entry(t, &lp_traces, list) {
+		if (t->state != LP_RECORDING || t->tgid != current->tgid)
+			continue;
+		if (time_after(jiffies, t->deadline))
+			lp_stop(t);
+		else
+			lp_add(t, file, index);
+		break;
+	}
+	mutex_unlock(&lp_mutex);
+}
+
+void __launch_prefetch_launch(struct task_struct *tsk)
+{
+	struct lp_trace *t;
+	char *name;
+
+	name = kmalloc(LP_NAME_LEN, GFP_KERNEL);
+	if (!name)
+		return;
+	lp_launch_name(tsk, name);
+
+	mutex_lock(&lp_mutex);
+	lp_expire();
+
+	t = lp_name_valid(name) ? lp_find(name) : NULL;
+	if (!t)
+		goto out;
+
+	switch (t->state) {
+	case LP_ARMED:
+		lp_reset(t);
+		t->tgid = tsk->tgid;
+		t->deadline = jiffies + t->record_secs * HZ;
+		lp_set_state(t, LP_RECORDING);
+		break;
+	case LP_READY:
+		if (t->replaying)
+			break;
+		t->replaying = 1;
+		t->launched = ktime_get();
+		queue_work(lp_wq, &t->work);
+		break;
+	default:
+		break;
+	}
+out:
+	mutex_unlock(&lp_mutex);
+	kfree(name);
+}
+
+/*
+ * The trace is not changed while it is being replayed: recording,
+ * loading and deleting it all fail with -EBUSY until replaying is clear.
+ */
+static void lp_replay_work(struct work_struct *work)
+{
+	struct lp_trace *t = container_of(work, struct lp_trace, work);
+	struct file **filp;
+	unsigned long pages = 0, errors = 0;
+	int i, j;
+
+	filp = kcalloc(t->nr_files, sizeof(*filp), GFP_KERNEL);
+	if (!filp) {
+		errors++;
+		goto out;
+	}
+
+	for (i = 0; i < t->nr_ext; i = j) {
+		struct lp_extent *e = &t->ext[i];
+		unsigned long start = e->start, end = e->start + e->nr;
+		struct file *f;
+
+		/* merge the following extents of the same file that are close */
+		for (j = i + 1; j < t->nr_ext; j++) {
+			struct lp_extent *n = &t->ext[j];
+
+			if (n->file != e->file || n->start < start ||
+			    n->start > end + LP_REPLAY_GAP)
+				break;
+			end = max_t(unsigned long, end, n->start + n->nr);
+		}
+
+		f = filp[e->file];
+		if (!f) {
+			f = filp_open(t->files[e->file].path,
+				      O_RDONLY | O_LARGEFILE, 0);
+			filp[e->file] = f;
+			if (IS_ERR(f))
+				errors++;
+		}
+		if (IS_ERR(f))
+			continue;
+
+		if (force_page_cache_readahead(f->f_mapping, f, start,
+					       end - start))
+			errors++;
+		else
+			pages += end - start;
+	}
+
+	for (i = 0; i < t->nr_files; i++)
+		if (filp[i] && !IS_ERR(filp[i]))
+			fput(filp[i]);
+	kfree(filp);
+
+out:
+	mutex_lock(&lp_mutex);
+	t->replays++;
+	t->replay_pages += pages;
+	t->replay_errors += errors;
+	t->last_replay_us = ktime_to_us(ktime_sub(ktime_get(), t->launched));
+	t->replaying = 0;
+	mutex_unlock(&lp_mutex);
+}
+
+/*
+ * control: one line per trace when read; takes these commands:
+ *
+ *	record <name> [seconds]	record the next launch of <name>
+ *	stop <name>		end a recording now
+ *	replay <name>		replay a trace now
+ *	delete <name>		drop a trace
+ *	clear			drop all traces that are not being replayed
+ */
+static int lp_control_show(struct seq_file *m, void *unused)
+{
+	struct lp_trace *t;
+
+	mutex_lock(&lp_mutex);
+	lp_expire();
+	seq_printf(m, "%-24s %-9s %5s %7s %7s %7s %10s %6s %9s\n",
+		   "name", "state", "files", "extents", "pages", "replays",
+		   "rpl_pages", "errors", "last_us");
+	list_for_each_entry(t, &lp_traces, list)
+		seq_printf(m, "%-24s %-9s %5d %7d %7lu %7lu %10lu %6lu %9lld\n",
+			   t->name, t->replaying ? "replaying" :
+			   lp_state_names[t->state], t->nr_files, t->nr_ext,
+			   t->pages, t->replays, t->replay_pages,
+			   t->replay_errors, t->last_replay_us);
+	mutex_unlock(&lp_mutex);
+
+	return 0;
+}
+
+static int lp_control_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lp_control_show, NULL);
+}
+
+static int lp_command(char *cmd, char *name, unsigned int secs)
+{
+	struct lp_trace *t, *next;
+
+	if (!strcmp(cmd, "clear")) {
+		list_for_each_entry_safe(t, next, &lp_traces, list)
+			if (!t->replaying)
+				lp_free(t);
+		return 0;
+	}
+
+	if (!lp_name_valid(name))
+		return -EINVAL;
+	t = lp_find(name);
+
+	if (!strcmp(cmd, "record")) {
+		if (!t)
+			t = lp_alloc(name);
+		if (!t)
+			return -ENOMEM;
+		if (t->replaying)
+			return -EBUSY;
+		if (t->state != LP_ARMED)
+			lp_set_state(t, LP_ARMED);
+		if (secs)
+			t->record_secs = secs;
+		return 0;
+	}
+
+	if (!t)
+		return -ENOENT;
+
+	if (!strcmp(cmd, "stop")) {
+		lp_stop(t);
+	} else if (!strcmp(cmd, "replay")) {
+		if (t->state != LP_READY || t->replaying)
+			return -EBUSY;
+		t->replaying = 1;
+		t->launched = ktime_get();
+		queue_work(lp_wq, &t->work);
+	} else if (!strcmp(cmd, "delete")) {
+		if (t->replaying)
+			return -EBUSY;
+		lp_free(t);
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static ssize_t lp_control_write(struct file *file, const char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	char buf[LP_NAME_LEN + 32], cmd[16], name[LP_NAME_LEN];
+	unsigned int secs = 0;
+	int ret;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	name[0] = '\0';
+	if (sscanf(buf, "%15s %127s %u", cmd, name, &secs) < 1)
+		return -EINVAL;
+
+	mutex_lock(&lp_mutex);
+	lp_expire();
+	ret = lp_command(cmd, name, secs);
+	mutex_unlock(&lp_mutex);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations lp_control_fops = {
+	.open		= lp_control_open,
+	.read		= seq_read,
+	.write		= lp_control_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/*
+ * traces: the ready traces as text, to be saved by userspace and
+ * written back after a reboot:
+ *
+ *	trace <name>
+ *	file <path>
+ *	ext <file> <start> <pages>
+ *	...
+ *
+ * Files are numbered from 0 in the order they are listed.  Writing
+ * replaces the traces of the names written; it is parsed when the file
+ * is closed.
+ */
+static int lp_traces_show(struct seq_file *m, void *unused)
+{
+	struct lp_trace *t;
+	int i;
+
+	mutex_lock(&lp_mutex);
+	lp_expire();
+	list_for_each_entry(t, &lp_traces, list) {
+		if (t->state != LP_READY)
+			continue;
+		seq_printf(m, "trace %s\n", t->name);
+		for (i = 0; i < t->nr_files; i++)
+			seq_printf(m, "file %s\n", t->files[i].path);
+		for (i = 0; i < t->nr_ext; i++)
+			seq_printf(m, "ext %u %u %u\n", t->ext[i].file,
+				   t->ext[i].start, t->ext[i].nr);
+	}
+	mutex_unlock(&lp_mutex);
+
+	return 0;
+}
+
+struct lp_load {
+	char	*buf;
+	size_t	len;
+};
+
+static int lp_traces_open(struct inode *inode, struct file *file)
+{
+	struct lp_load *load;
+
+	if (!(file->f_mode & FMODE_WRITE))
+		return single_open(file, lp_traces_show, NULL);
+
+	load = kzalloc(sizeof(*load), GFP_KERNEL);
+	if (!load)
+		return -ENOMEM;
+	load->buf = vmalloc(LP_MAX_LOAD);
+	if (!load->buf) {
+		kfree(load);
+		return -ENOMEM;
+	}
+	file->private_data = load;
+
+	return 0;
+}
+
+static ssize_t lp_traces_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	struct lp_load *load = file->private_data;
+
+	if (count > LP_MAX_LOAD - 1 - load->len)
+		return -EFBIG;
+	if (copy_from_user(load->buf + load->len, ubuf, count))
+		return -EFAULT;
+	load->len += count;
+
+	return count;
+}
+
+/* parse one line of a trace being loaded into t */
+static int lp_load_line(struct lp_trace *t, char *line)
+{
+	unsigned int f, start, nr;
+	char *path;
+
+	if (!strncmp(line, "file ", 5)) {
+		path = strstrip(line + 5);
+		if (t->nr_files >= LP_MAX_FILES || *path != '/')
+			return -EINVAL;
+		t->files[t->nr_files].path = kstrdup(path, GFP_KERNEL);
+		if (!t->files[t->nr_files].path)
+			return -ENOMEM;
+		t->nr_files++;
+		return 0;
+	}
+
+	if (sscanf(line, "ext %u %u %u", &f, &start, &nr) == 3) {
+		if (t->nr_ext >= LP_MAX_EXTENTS || f >= t->nr_files ||
+		    !nr || nr > LP_MAX_EXTENT_PAGES)
+			return -EINVAL;
+		t->ext[t->nr_ext].file = f;
+		t->ext[t->nr_ext].start = start;
+		t->ext[t->nr_ext].nr = nr;
+		t->nr_ext++;
+		t->pages += nr;
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+/* a loaded trace is ready to replay, one that failed to load records */
+static void lp_loaded(struct lp_trace *t, int ret)
+{
+	if (ret)
+		lp_reset(t);
+	lp_set_state(t, t->nr_ext ? LP_READY : LP_ARMED);
+}
+
+/* all under lp_mutex, so nothing sees a trace half loaded */
+static int lp_load(char *buf)
+{
+	struct lp_trace *t = NULL;
+	char *line, name[LP_NAME_LEN];
+	int ret = 0;
+
+	mutex_lock(&lp_mutex);
+	while ((line = strsep(&buf, "\n")) != NULL && !ret) {
+		line = strstrip(line);
+		if (!*line)
+			continue;
+
+		if (sscanf(line, "trace %127s", name) == 1) {
+			if (t)
+				lp_loaded(t, 0);
+			t = NULL;
+			if (!lp_name_valid(name)) {
+				ret = -EINVAL;
+				continue;
+			}
+			t = lp_find(name);
+			if (!t)
+				t = lp_alloc(name);
+			if (!t) {
+				ret = -ENOMEM;
+			} else if (t->replaying) {
+				t = NULL;
+				ret = -EBUSY;
+			} else {
+				lp_reset(t);
+			}
+			continue;
+		}
+
+		if (!t)
+			ret = -EINVAL;
+		else
+			ret = lp_load_line(t, line);
+	}
+
+	if (t)
+		lp_loaded(t, ret);
+	mutex_unlock(&lp_mutex);
+
+	return ret;
+}
+
+static int lp_traces_release(struct inode *inode, struct file *file)
+{
+	struct lp_load *load;
+	int ret;
+
+	if (!(file->f_mode & FMODE_WRITE))
+		return single_release(inode, file);
+
+	load = file->private_data;
+	load->buf[load->len] = '\0';
+	ret = lp_load(load->buf);
+	if (ret)
+		printk(KERN_WARNING "launch_prefetch: loading traces failed "
+		       "(%d)\n", ret);
+
+	vfree(load->buf);
+	kfree(load);
+
+	return ret;
+}
+
+static ssize_t lp_traces_read(struct file *file, char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	if (file->f_mode & FMODE_WRITE)
+		return -EINVAL;
+
+	return seq_read(file, buf, count, ppos);
+}
+
+static const struct file_operations lp_traces_fops = {
+	.open		= lp_traces_open,
+	.read		= lp_traces_read,
+	.write		= lp_traces_write,
+	.llseek		= no_llseek,
+	.release	= lp_traces_release,
+};
+
+static int __init launch_prefetch_init(void)
+{
+	struct dentry *dir;
+
+	lp_wq = create_singlethread_workqueue("lprefetch");
+	if (!lp_wq)
+		return -ENOMEM;
+
+	dir = debugfs_create_dir("launch_prefetch", NULL);
+	if (!dir || IS_ERR(dir))
+		return 0;
+
+	debugfs_create_file("control", S_IRUGO | S_IWUSR, dir, NULL,
+			    &lp_control_fops);
+	debugfs_create_file("traces", S_IRUSR | S_IWUSR, dir, NULL,
+			    &lp_traces_fops);
+
+	return 0;
+}
+late_initcall(launch_prefetch_init);
@@ -18,6 +18,7 @@
 #include <linux/pagevec.h>
 #include <linux/migrate.h>
 #include <linux/page_cgroup.h>
+#include <linux/log2.h>
 
 #include <asm/pgtable.h>
 
@@ -132,6 +133,11 @@ void __delete_from_swap_cache(struct page *page)
 	radix_tree_delete(&swapper_space.page_tree, page_private(page));
 	set_page_private(page, 0);
 	ClearPageSwapCache(page);
+	if (PageReadahead(page)) {
+		/* read ahead and never looked up */
+		ClearPageReadahead(page);
+		__count_vm_event(SWAP_RA_MISS);
+	}
 	total_swapcache_pages--;
 	__dec_zone_page_state(page, NR_FILE_PAGES);
 	INC_CACHE_INFO(del_total);
@@ -262,8 +268,16 @@ struct page * lookup_swap_cache(swp_entry_t entry)
 
 	page = find_get_page(&swapper_space, entry.val);
 
-	if (page)
+	if (page) {
 		INC_CACHE_INFO(find_success);
+		if (unlikely(TestClearPageReadahead(page))) {
+			struct swap_info_struct *si;
+
+			si = get_swap_info_struct(swp_type(entry));
+			atomic_inc(&si->ra_hits);
+			count_vm_event(SWAP_RA_HIT);
+		}
+	}
 
 	INC_CACHE_INFO(find_total);
 	return page;
@@ -274,9 +288,12 @@ struct page * lookup_swap_cache(swp_entry_t entry)
  * and reading the disk if it is not already cached.
  * A failure return means that either the page allocation failed or that
  * the swap entry is no longer in use.
+ * A page read for readahead is marked PG_readahead, so lookup_swap_cache()
+ * can tell whether it was needed.
  */
-struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
-			struct vm_area_struct *vma, unsigned long addr)
+static struct page *__read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
+			struct vm_area_struct *vma, unsigned long addr,
+			int readahead)
 {
 	struct page *found_page, *new_page = NULL;
 	int err;
@@ -329,6 +346,10 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 			/*
 			 * Initiate read into locked page and return.
 			 */
+			if (readahead) {
+				SetPageReadahead(new_page);
+				count_vm_event(SWAP_RA);
+			}
 			lru_cache_add_anon(new_page);
 			swap_readpage(new_page);
 			return new_page;
@@ -348,6 +369,55 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 	return found_page;
 }
 
+struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
+			struct vm_area_struct *vma, unsigned long addr)
+{
+	return __read_swap_cache_async(entry, gfp_mask, vma, addr, 0);
+}
+
+/*
+ * Size the readahead window of a swap fault from the swap device's
+ * recent readahead hits.  With no hits, only read ahead when this fault
+ * is next to the previous one.
+ *
+ * A seeking device reads the window for about the price of its first
+ * page, so the window is not shrunk faster than by half per fault.  On
+ * a device that completes reads synchronously (zram) each extra page
+ * costs as much as the faulting one, so the window follows the hits.
+ */
+static unsigned int swapin_nr_pages(struct swap_info_struct *si,
+				    unsigned long offset)
+{
+	unsigned int hits, pages, max_pages, last_ra;
+
+	max_pages = 1 << ACCESS_ONCE(page_cluster);
+	if (max_pages <= 1)
+		return 1;
+
+	hits = atomic_xchg(&si->ra_hits, 0);
+	pages = hits + 2;
+	if (pages == 2) {
+		if (offset != si->ra_prev_offset + 1 &&
+		    offset != si->ra_prev_offset - 1)
+			pages = 1;
+	} else {
+		pages = roundup_pow_of_two(max(pages, 4U));
+	}
+	si->ra_prev_offset = offset;
+
+	if (pages > max_pages)
+		pages = max_pages;
+
+	if (!(si->flags & SWP_SYNCIO)) {
+		last_ra = si->ra_pages / 2;
+		if (pages < last_ra)
+			pages = last_ra;
+	}
+	si->ra_pages = pages;
+
+	return pages;
+}
+
 /**
  * swapin_readahead - swap in pages in hope we need them soon
  * @entry: swap entry of this memory
@@ -358,9 +428,11 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
  * Returns the struct page for entry and addr, after queueing swapin.
  *
  * Primitive swap readahead code. We simply read an aligned block of
- * (1 << page_cluster) entries in the swap area. This method is chosen
+ * up to (1 << page_cluster) entries in the swap area. This method is chosen
  * because it doesn't cost us any seek time.  We also make sure to queue
  * the 'original' request together with the readahead ones...
+ * The block shrinks when the pages read ahead are not used, see
+ * swapin_nr_pages().
  *
  * This has been extended to use the NUMA policies from the mm triggering
  * the readahead.
@@ -370,10 +442,12 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 			struct vm_area_struct *vma, unsigned long addr)
 {
+	struct swap_info_struct *si = get_swap_info_struct(swp_type(entry));
 	int nr_pages;
 	struct page *page;
 	unsigned long offset;
 	unsigned long end_offset;
+	unsigned long target = swp_offset(entry);
 
 	/*
 	 * Get starting offset for readaround, and number of pages to read.
@@ -382,11 +456,12 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 	 * more likely that neighbouring swap pages came from the same node:
 	 * so use the same "addr" to choose the same node for each swap read.
 	 */
-	nr_pages = valid_swaphandles(entry, &offset);
+	nr_pages = valid_swaphandles(entry, &offset,
+				     ilog2(swapin_nr_pages(si, target)));
 	for (end_offset = offset + nr_pages; offset < end_offset; offset++) {
 		/* Ok, do the async read-ahead now */
-		page = read_swap_cache_async(swp_entry(swp_type(entry), offset),
-						gfp_mask, vma, addr);
+		page = __read_swap_cache_async(swp_entry(swp_type(entry), offset),
+					gfp_mask, vma, addr, offset != target);
 		if (!page)
 			break;
 		page_cache_release(page);
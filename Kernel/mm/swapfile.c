@@ -1979,6 +1979,8 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 			p->flags |= SWP_SOLIDSTATE;
 			p->cluster_next = 1 + (random32() % p->highest_bit);
 		}
+		if (blk_queue_syncio(bdev_get_queue(p->bdev)))
+			p->flags |= SWP_SYNCIO;
 		if (discard_swap(p) == 0)
 			p->flags |= SWP_DISCARDABLE;
 	}
@@ -1992,15 +1994,19 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 		p->prio = --least_priority;
 	p->swap_map = swap_map;
 	p->flags |= SWP_WRITEOK;
+	atomic_set(&p->ra_hits, 0);
+	p->ra_pages = 0;
+	p->ra_prev_offset = 0;
 	nr_swap_pages += nr_good_pages;
 	total_swap_pages += nr_good_pages;
 
 	printk(KERN_INFO "Adding %uk swap on %s.  "
-			"Priority:%d extents:%d across:%lluk %s%s\n",
+			"Priority:%d extents:%d across:%lluk %s%s%s\n",
 		nr_good_pages<<(PAGE_SHIFT-10), name, p->prio,
 		nr_extents, (unsigned long long)span<<(PAGE_SHIFT-10),
 		(p->flags & SWP_SOLIDSTATE) ? "SS" : "",
-		(p->flags & SWP_DISCARDABLE) ? "D" : "");
+		(p->flags & SWP_DISCARDABLE) ? "D" : "",
+		(p->flags & SWP_SYNCIO) ? "Y" : "");
 
 	/* insert swap space into swap_list: */
 	prev = -1;
@@ -2168,13 +2174,16 @@ get_swap_info_struct(unsigned type)
 }
 
 /*
+ * Find the in-use slots of the aligned block of (1 << our_page_cluster)
+ * slots around entry.
+ *
  * swap_lock prevents swap_map being freed. Don't grab an extra
  * reference on the swaphandle, it doesn't matter if it becomes unused.
  */
-int valid_swaphandles(swp_entry_t entry, unsigned long *offset)
+int valid_swaphandles(swp_entry_t entry, unsigned long *offset,
+		      int our_page_cluster)
 {
 	struct swap_info_struct *si;
-	int our_page_cluster = page_cluster;
 	pgoff_t target, toff;
 	pgoff_t base, end;
 	int nr_pages = 0;
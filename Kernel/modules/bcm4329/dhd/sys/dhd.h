@@ -146,6 +146,8 @@ typedef struct dhd_pub {
 	/* Last error return */
 	int bcmerror;
 	uint tickcnt;
+	uint wd_ms;		/* Current watchdog period, backs off while idle */
+	uint wd_rate;		/* Watchdog wakeups per second (x100) */
 
 	/* Last error from dongle */
 	int dongle_error;
@@ -354,6 +356,9 @@ extern int wl_iw_send_priv_event(struct net_device *dev, char *flag);
 /* Watchdog timer interval */
 extern uint dhd_watchdog_ms;
 
+/* Longest watchdog interval when idle */
+extern uint dhd_watchdog_idle_ms;
+
 #if defined(DHD_DEBUG)
 /* Console output poll interval */
 extern uint dhd_console_ms;
@@ -90,4 +90,7 @@ extern void *dhd_bus_pub(struct dhd_bus *bus);
 extern void *dhd_bus_txq(struct dhd_bus *bus);
 extern uint dhd_bus_hdrlen(struct dhd_bus *bus);
 
+/* TRUE if the bus polls the dongle from the watchdog */
+extern bool dhd_bus_polling(struct dhd_bus *bus);
+
 #endif /* _dhd_bus_h_ */
@@ -257,6 +257,9 @@ typedef struct dhd_info {
 	wait_queue_head_t ioctl_resp_wait;
 	struct timer_list timer;
 	bool wd_timer_valid;
+	ulong wd_pkts;		/* tx+rx packet count at the last watchdog tick */
+	ulong wd_win_start;	/* Start of the wakeup rate window (jiffies) */
+	uint wd_win_ticks;	/* Watchdog ticks in the current window */
 	struct tasklet_struct tasklet;
 	spinlock_t	sdlock;
 	spinlock_t	txqlock;
@@ -321,6 +324,10 @@ module_param(dhd_sysioc, uint, 0);
 uint dhd_watchdog_ms = 10;
 module_param(dhd_watchdog_ms, uint, 0);
 
+/* Longest watchdog interval once the link goes idle, 0 keeps the interval fixed */
+uint dhd_watchdog_idle_ms = 2000;
+module_param(dhd_watchdog_idle_ms, uint, 0);
+
 #ifdef DHD_DEBUG
 /* Console poll interval */
 uint dhd_console_ms = 0;
@@ -1357,6 +1364,39 @@ dhd_get_stats(struct net_device *net)
 	return &ifp->stats;
 }
 
+/*
+ * Re-arm the watchdog for its next tick. The period stays at dhd_watchdog_ms
+ * while packets move and doubles on every idle tick up to dhd_watchdog_idle_ms;
+ * dhd_os_wd_timer() brings it back to the short period on bus activity.
+ * The bus polls the dongle from the watchdog in polling mode (dhd_poll or the
+ * "pollrate" iovar), so never back off there.
+ */
+static void
+dhd_watchdog_rearm(dhd_info_t *dhd)
+{
+	dhd_pub_t *dhdp = &dhd->pub;
+	ulong pkts = dhdp->tx_packets + dhdp->rx_packets;
+	ulong now = jiffies;
+
+	/* Wakeup rate over windows of at least one second */
+	dhd->wd_win_ticks++;
+	if (time_after_eq(now, dhd->wd_win_start + HZ)) {
+		dhdp->wd_rate = dhd->wd_win_ticks * 100 * HZ / (now - dhd->wd_win_start);
+		dhd->wd_win_start = now;
+		dhd->wd_win_ticks = 0;
+	}
+
+	if (pkts != dhd->wd_pkts || !dhd_watchdog_idle_ms ||
+	    (dhdp->bus && dhd_bus_polling(dhdp->bus)))
+		dhdp->wd_ms = dhd_watchdog_ms;
+	else if (dhdp->wd_ms < dhd_watchdog_idle_ms)
+		dhdp->wd_ms = MIN(dhdp->wd_ms * 2, dhd_watchdog_idle_ms);
+	dhd->wd_pkts = pkts;
+
+	if (dhd->wd_timer_valid)
+		mod_timer(&dhd->timer, jiffies + msecs_to_jiffies(dhdp->wd_ms));
+}
+
 static int
 dhd_watchdog_thread(void *data)
 {
@@ -1388,8 +1428,7 @@ dhd_watchdog_thread(void *data)
 			dhd->pub.tickcnt++;
 
 			/* Reschedule the watchdog */
-			if (dhd->wd_timer_valid)
-				mod_timer(&dhd->timer, jiffies + dhd_watchdog_ms * HZ / 1000);
+			dhd_watchdog_rearm(dhd);
 
 			dhd_os_wake_unlock(&dhd->pub);
 		}
@@ -1418,8 +1457,7 @@ dhd_watchdog(ulong data)
 	dhd->pub.tickcnt++;
 
 	/* Reschedule the watchdog */
-	if (dhd->wd_timer_valid)
-		mod_timer(&dhd->timer, jiffies + dhd_watchdog_ms * HZ / 1000);
+	dhd_watchdog_rearm(dhd);
 	dhd_os_wake_unlock(&dhd->pub);
 }
 
@@ -2679,8 +2717,17 @@ dhd_os_wd_timer(void *bus, uint wdtick)
 	if (wdtick) {
 		dhd_watchdog_ms = (uint)wdtick;
 
+		/* Restart the wakeup rate window when the timer starts */
+		if (!dhd->wd_timer_valid) {
+			dhd->wd_win_start = jiffies;
+			dhd->wd_win_ticks = 0;
+		}
+
+		/* Bus activity: drop any idle back-off */
+		pub->wd_ms = dhd_watchdog_ms;
+
 		/* Re arm the timer, at last watchdog period */
-		mod_timer(&dhd->timer, jiffies + dhd_watchdog_ms * HZ / 1000);
+		mod_timer(&dhd->timer, jiffies + msecs_to_jiffies(dhd_watchdog_ms));
 
 		dhd->wd_timer_valid = TRUE;
 		save_dhd_watchdog_ms = wdtick;
@@ -142,7 +142,7 @@
  * bufpool was present for gspi bus.
  */
 #define PKTFREE2()		if ((bus->bus != SPI_BUS) || bus->usebufpool) \
-					PKTFREE(bus->dhd->osh, pkt, FALSE);
+					dhdsdio_pktfree(bus, pkt, FALSE);
 DHD_SPINWAIT_SLEEP_INIT(sdioh_spinwait_sleep);
 extern int dhdcdc_set_ioctl(dhd_pub_t *dhd, int ifidx, uint cmd, void *buf, uint len);
 
@@ -248,6 +248,12 @@ typedef struct dhd_bus {
 	/* Field to decide if rx of control frames happen in rxbuf or lb-pool */
 	bool		usebufpool;
 
+	void		*rxpool;		/* Recycled rx frame buffers */
+	uint		rxpool_hits;		/* Rx buffers taken from the pool */
+	uint		rxpool_misses;		/* Rx buffers that fell back to PKTGET */
+	uint		rxpool_recycled;	/* Freed buffers returned to the pool */
+	uint		rxpool_refilled;	/* Fresh buffers added after rx */
+
 #ifdef SDTEST
 	/* external loopback */
 	bool		ext_loop;
@@ -365,6 +371,49 @@ extern void bcmsdh_enable_hw_oob_intr(void *sdh, bool enable);
 		PKTSETLEN((osh), (p), (len));				\
 	} while (0)
 
+/* Rx pool buffers hold any non-glom frame, pre-aligned to DHD_SDALIGN so
+ * PKTALIGN has nothing to pull; pool depth follows dhd_rxbound, the most
+ * frames one dpc pass reads.  Frames passed up never come back, so the
+ * dpc refills the pool once a pass is done with the bus.
+ */
+#define DHD_RXPOOL_BUFSZ	(MAX_RX_DATASZ + DHD_SDALIGN)
+
+static void *
+dhdsdio_pktget(dhd_bus_t *bus, uint len)
+{
+	void *pkt;
+
+	if (bus->rxpool && (pkt = PKTPOOLGET(bus->dhd->osh, bus->rxpool, len))) {
+		bus->rxpool_hits++;
+		return pkt;
+	}
+
+	bus->rxpool_misses++;
+	return PKTGET(bus->dhd->osh, len, FALSE);
+}
+
+/* Free a packet (chain), recycling what the pool will take */
+static void
+dhdsdio_pktfree(dhd_bus_t *bus, void *pkt, bool send)
+{
+	osl_t *osh = bus->dhd->osh;
+	void *next;
+
+	if (!bus->rxpool) {
+		PKTFREE(osh, pkt, send);
+		return;
+	}
+
+	for (; pkt; pkt = next) {
+		next = PKTNEXT(osh, pkt);
+		PKTSETNEXT(osh, pkt, NULL);
+		if (PKTPOOLADD(osh, bus->rxpool, pkt) == BCME_OK)
+			bus->rxpool_recycled++;
+		else
+			PKTFREE(osh, pkt, send);
+	}
+}
+
 /* Limit on rounding up frames */
 static const uint max_roundup = 512;
 
@@ -1031,7 +1080,7 @@ done:
 	dhd_os_sdlock(bus->dhd);
 
 	if (free_pkt)
-		PKTFREE(osh, pkt, TRUE);
+		dhdsdio_pktfree(bus, pkt, TRUE);
 
 	return ret;
 }
@@ -1509,6 +1558,14 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	bcm_bprintf(strbuf, "f2rx (hdrs/data) %d (%d/%d), f2tx %d f1regs %d\n",
 	            (bus->f2rxhdrs + bus->f2rxdata), bus->f2rxhdrs, bus->f2rxdata,
 	            bus->f2txdata, bus->f1regdata);
+	bcm_bprintf(strbuf, "rxpool %d/%d hits %d misses %d recycled %d refilled %d",
+	            bus->rxpool ? PKTPOOLAVAIL(bus->dhd->osh, bus->rxpool) : 0,
+	            bus->rxpool ? PKTPOOLLEN(bus->dhd->osh, bus->rxpool) : 0,
+	            bus->rxpool_hits, bus->rxpool_misses, bus->rxpool_recycled,
+	            bus->rxpool_refilled);
+	dhd_dump_pct(strbuf, ", hit pct", (100 * bus->rxpool_hits),
+	             (bus->rxpool_hits + bus->rxpool_misses));
+	bcm_bprintf(strbuf, "\n");
 	{
 		dhd_dump_pct(strbuf, "\nRx: pkts/f2rd", bus->dhd->rx_packets,
 		             (bus->f2rxhdrs + bus->f2rxdata));
@@ -1573,6 +1630,8 @@ dhd_bus_clearcounts(dhd_pub_t *dhdp)
 	bus->tx_sderrs = bus->fc_rcvd = bus->fc_xoff = bus->fc_xon = 0;
 	bus->rxglomfail = bus->rxglomframes = bus->rxglompkts = 0;
 	bus->f2rxhdrs = bus->f2rxdata = bus->f2txdata = bus->f1regdata = 0;
+	bus->rxpool_hits = bus->rxpool_misses = bus->rxpool_recycled = 0;
+	bus->rxpool_refilled = 0;
 }
 
 #ifdef SDTEST
@@ -2756,10 +2815,10 @@ dhd_bus_stop(struct dhd_bus *bus, bool enforce_mutex)
 
 	/* Clear any held glomming stuff */
 	if (bus->glomd)
-		PKTFREE(osh, bus->glomd, FALSE);
+		dhdsdio_pktfree(bus, bus->glomd, FALSE);
 
 	if (bus->glom)
-		PKTFREE(osh, bus->glom, FALSE);
+		dhdsdio_pktfree(bus, bus->glom, FALSE);
 
 	bus->glom = bus->glomd = NULL;
 
@@ -3100,7 +3159,7 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 			}
 
 			/* Allocate/chain packet for next subframe */
-			if ((pnext = PKTGET(osh, sublen + DHD_SDALIGN, FALSE)) == NULL) {
+			if ((pnext = dhdsdio_pktget(bus, sublen + DHD_SDALIGN)) == NULL) {
 				DHD_ERROR(("%s: PKTGET failed, num %d len %d\n",
 				           __FUNCTION__, num, sublen));
 				break;
@@ -3134,13 +3193,13 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 			pfirst = pnext = NULL;
 		} else {
 			if (pfirst)
-				PKTFREE(osh, pfirst, FALSE);
+				dhdsdio_pktfree(bus, pfirst, FALSE);
 			bus->glom = NULL;
 			num = 0;
 		}
 
 		/* Done with descriptor packet */
-		PKTFREE(osh, bus->glomd, FALSE);
+		dhdsdio_pktfree(bus, bus->glomd, FALSE);
 		bus->glomd = NULL;
 		bus->nextlen = 0;
 
@@ -3201,7 +3260,7 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 				bus->glomerr = 0;
 				dhdsdio_rxfail(bus, TRUE, FALSE);
 				dhd_os_sdlock_rxq(bus->dhd);
-				PKTFREE(osh, bus->glom, FALSE);
+				dhdsdio_pktfree(bus, bus->glom, FALSE);
 				dhd_os_sdunlock_rxq(bus->dhd);
 				bus->rxglomfail++;
 				bus->glom = NULL;
@@ -3323,7 +3382,7 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 				bus->glomerr = 0;
 				dhdsdio_rxfail(bus, TRUE, FALSE);
 				dhd_os_sdlock_rxq(bus->dhd);
-				PKTFREE(osh, bus->glom, FALSE);
+				dhdsdio_pktfree(bus, bus->glom, FALSE);
 				dhd_os_sdunlock_rxq(bus->dhd);
 				bus->rxglomfail++;
 				bus->glom = NULL;
@@ -3371,7 +3430,7 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 			PKTPULL(osh, pfirst, doff);
 
 			if (PKTLEN(osh, pfirst) == 0) {
-				PKTFREE(bus->dhd->osh, pfirst, FALSE);
+				dhdsdio_pktfree(bus, pfirst, FALSE);
 				if (plast) {
 					PKTSETNEXT(osh, plast, pnext);
 				} else {
@@ -3382,7 +3441,7 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 			} else if (dhd_prot_hdrpull(bus->dhd, &ifidx, pfirst) != 0) {
 				DHD_ERROR(("%s: rx protocol error\n", __FUNCTION__));
 				bus->dhd->rx_errors++;
-				PKTFREE(osh, pfirst, FALSE);
+				dhdsdio_pktfree(bus, pfirst, FALSE);
 				if (plast) {
 					PKTSETNEXT(osh, plast, pnext);
 				} else {
@@ -3511,7 +3570,7 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 			 */
 			/* Allocate a packet buffer */
 			dhd_os_sdlock_rxq(bus->dhd);
-			if (!(pkt = PKTGET(osh, rdlen + DHD_SDALIGN, FALSE))) {
+			if (!(pkt = dhdsdio_pktget(bus, rdlen + DHD_SDALIGN))) {
 				if (bus->bus == SPI_BUS) {
 					bus->usebufpool = FALSE;
 					bus->rxctl = bus->rxbuf;
@@ -3571,7 +3630,7 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 				if (sdret < 0) {
 					DHD_ERROR(("%s (nextlen): read %d bytes failed: %d\n",
 					   __FUNCTION__, rdlen, sdret));
-					PKTFREE(bus->dhd->osh, pkt, FALSE);
+					dhdsdio_pktfree(bus, pkt, FALSE);
 					bus->dhd->rx_errors++;
 					dhd_os_sdunlock_rxq(bus->dhd);
 					/* Force retry w/normal header read.  Don't attemp NAK for
@@ -3706,7 +3765,7 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 					dhdsdio_read_control(bus, rxbuf, len, doff);
 					if (bus->usebufpool) {
 						dhd_os_sdlock_rxq(bus->dhd);
-						PKTFREE(bus->dhd->osh, pkt, FALSE);
+						dhdsdio_pktfree(bus, pkt, FALSE);
 						dhd_os_sdunlock_rxq(bus->dhd);
 					}
 					continue;
@@ -3885,7 +3944,7 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 		}
 
 		dhd_os_sdlock_rxq(bus->dhd);
-		if (!(pkt = PKTGET(osh, (rdlen + firstread + DHD_SDALIGN), FALSE))) {
+		if (!(pkt = dhdsdio_pktget(bus, (rdlen + firstread + DHD_SDALIGN)))) {
 			/* Give up on data, request rtx of events */
 			DHD_ERROR(("%s: PKTGET failed: rdlen %d chan %d\n",
 			           __FUNCTION__, rdlen, chan));
@@ -3914,7 +3973,7 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 			           ((chan == SDPCM_EVENT_CHANNEL) ? "event" :
 			            ((chan == SDPCM_DATA_CHANNEL) ? "data" : "test")), sdret));
 			dhd_os_sdlock_rxq(bus->dhd);
-			PKTFREE(bus->dhd->osh, pkt, FALSE);
+			dhdsdio_pktfree(bus, pkt, FALSE);
 			dhd_os_sdunlock_rxq(bus->dhd);
 			bus->dhd->rx_errors++;
 			dhdsdio_rxfail(bus, TRUE, RETRYCHAN(chan));
@@ -3967,13 +4026,13 @@ deliver:
 
 		if (PKTLEN(osh, pkt) == 0) {
 			dhd_os_sdlock_rxq(bus->dhd);
-			PKTFREE(bus->dhd->osh, pkt, FALSE);
+			dhdsdio_pktfree(bus, pkt, FALSE);
 			dhd_os_sdunlock_rxq(bus->dhd);
 			continue;
 		} else if (dhd_prot_hdrpull(bus->dhd, &ifidx, pkt) != 0) {
 			DHD_ERROR(("%s: rx protocol error\n", __FUNCTION__));
 			dhd_os_sdlock_rxq(bus->dhd);
-			PKTFREE(bus->dhd->osh, pkt, FALSE);
+			dhdsdio_pktfree(bus, pkt, FALSE);
 			dhd_os_sdunlock_rxq(bus->dhd);
 			bus->dhd->rx_errors++;
 			continue;
@@ -4297,6 +4356,9 @@ clkwait:
 		resched = TRUE;
 	}
 
+	/* Replace the rx buffers this pass handed up, off the read path */
+	if (bus->rxpool && bus->dhd->busstate != DHD_BUS_DOWN)
+		bus->rxpool_refilled += PKTPOOLFILL(bus->dhd->osh, bus->rxpool);
 
 	bus->dpc_sched = resched;
 
@@ -4670,7 +4732,7 @@ dhd_bus_watchdog(dhd_pub_t *dhdp)
 #ifdef DHD_DEBUG
 	/* Poll for console output periodically */
 	if (dhdp->busstate == DHD_BUS_DATA && dhd_console_ms != 0) {
-		bus->console.count += dhd_watchdog_ms;
+		bus->console.count += dhdp->wd_ms;
 		if (bus->console.count >= dhd_console_ms) {
 			bus->console.count -= dhd_console_ms;
 			/* Make sure backplane clock is on */
@@ -5174,6 +5236,10 @@ dhdsdio_probe_malloc(dhd_bus_t *bus, osl_t *osh, void *sdh)
 	else
 		bus->dataptr = bus->databuf;
 
+	/* Rx buffer pool; running without one just costs allocations */
+	if (!(bus->rxpool = PKTPOOLINIT(osh, dhd_rxbound, DHD_RXPOOL_BUFSZ, DHD_SDALIGN)))
+		DHD_ERROR(("%s: rx buffer pool of %d failed\n", __FUNCTION__, dhd_rxbound));
+
 	return TRUE;
 
 fail:
@@ -5339,6 +5405,11 @@ dhdsdio_release_malloc(dhd_bus_t *bus, osl_t *osh)
 #endif
 		bus->databuf = NULL;
 	}
+
+	if (bus->rxpool) {
+		PKTPOOLDEINIT(osh, bus->rxpool);
+		bus->rxpool = NULL;
+	}
 }
 
 
@@ -5787,6 +5858,12 @@ dhd_bus_hdrlen(struct dhd_bus *bus)
 	return SDPCM_HDRLEN;
 }
 
+bool
+dhd_bus_polling(struct dhd_bus *bus)
+{
+	return bus->poll;
+}
+
 int
 dhd_bus_devreset(dhd_pub_t *dhdp, uint8 flag)
 {
@@ -0,0 +1,569 @@
+/*
+ * DHD stand-in SDIO bus
+ *
+ * Replaces dhd_sdio.c and the bcmsdh layer when built with DHD_FAKE_SDIO,
+ * so the host side of the driver (watchdog, DPC, wakelocks, netdev) runs
+ * without a dongle. Control requests are answered locally, tx frames are
+ * consumed, and rx traffic is generated in bursts separated by idle gaps.
+ * The backplane clock is modelled the way dhdsdio_clkctl() drives it, so
+ * the watchdog sees the same re-arm calls as on real hardware.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <typedefs.h>
+#include <osl.h>
+#include <bcmsdh.h>
+#include <bcmsdbus.h>
+
+#include <bcmdefs.h>
+#include <bcmutils.h>
+#include <bcmendian.h>
+#include <bcmdevs.h>
+#include <bcmcdc.h>
+#include <wlioctl.h>
+
+#include <proto/ethernet.h>
+
+#include <linux/module.h>
+#include <linux/timer.h>
+
+#include <dngl_stats.h>
+#include <dhd.h>
+#include <dhd_bus.h>
+#include <dhd_proto.h>
+#include <dhd_dbg.h>
+
+/* Rx frame interval while a burst is running */
+uint fake_sdio_rx_ms = 5;
+module_param(fake_sdio_rx_ms, uint, 0);
+
+/* Burst length and the idle gap that follows it, 0 idle means continuous */
+uint fake_sdio_burst_ms = 500;
+module_param(fake_sdio_burst_ms, uint, 0);
+uint fake_sdio_idle_ms = 10000;
+module_param(fake_sdio_idle_ms, uint, 0);
+
+/* Payload length of generated rx frames */
+uint fake_sdio_rx_len = 256;
+module_param(fake_sdio_rx_len, uint, 0);
+
+/* Tx/Rx bounds, kept for the module parameters in dhd_linux.c */
+uint dhd_txbound = 20;
+uint dhd_rxbound = 50;
+int dhd_dongle_memsize;
+
+#define DHD_BUS			SDIO_BUS
+#define PRIOMASK		7
+
+#define FAKE_SDIO_ETHERTYPE	0x88b5	/* IEEE 802 local experimental */
+#define FAKE_SDIO_CTL_MAX	(sizeof(cdc_ioctl_t) + WLC_IOCTL_MAXLEN)
+
+static const uint8 fake_sdio_mac[ETHER_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x00, 0x43, 0x29 };
+
+typedef struct dhd_bus {
+	dhd_pub_t	*dhd;
+	osl_t		*osh;
+	struct pktq	txq;
+
+	/* Control response waiting for dhd_bus_rxctl() */
+	uchar		*rxctl;
+	uint		rxlen;
+
+	/* Backplane clock model */
+	bool		clk_on;
+	bool		activity;
+	uint		idlecount;
+
+	/* Traffic generator */
+	struct timer_list timer;
+	ulong		burst_end;
+	uint		rxpend;
+	bool		running;
+
+	/* Counters */
+	uint		intrcount;
+	uint		dpc_count;
+	uint		wd_count;
+	uint		clk_up;
+	uint		clk_down;
+	uint		txframes;
+	uint		rxframes;
+	uint		rxnobuf;
+	uint		ctlframes;
+} dhd_bus_t;
+
+static dhd_bus_t *fake_bus;
+
+/* Same side effects as dhdsdio_clkctl(bus, CLK_AVAIL, ...) */
+static void
+fake_sdio_clk_avail(dhd_bus_t *bus)
+{
+	if (!bus->clk_on) {
+		bus->clk_on = TRUE;
+		bus->clk_up++;
+	}
+	dhd_os_wd_timer(bus->dhd, dhd_watchdog_ms);
+	bus->activity = TRUE;
+}
+
+static void
+fake_sdio_intr(ulong data)
+{
+	dhd_bus_t *bus = (dhd_bus_t *)data;
+	ulong now = jiffies;
+
+	if (!bus->running)
+		return;
+
+	if (time_before(now, bus->burst_end) || !fake_sdio_idle_ms) {
+		bus->rxpend++;
+		bus->intrcount++;
+		dhd_sched_dpc(bus->dhd);
+		mod_timer(&bus->timer, now + msecs_to_jiffies(MAX(fake_sdio_rx_ms, 1)));
+	} else {
+		/* Burst over: stay silent for the idle gap, then start another */
+		bus->burst_end = now + msecs_to_jiffies(fake_sdio_idle_ms + fake_sdio_burst_ms);
+		mod_timer(&bus->timer, now + msecs_to_jiffies(fake_sdio_idle_ms));
+	}
+}
+
+static void *
+fake_sdio_rxframe(dhd_bus_t *bus)
+{
+	osl_t *osh = bus->osh;
+	struct ether_header *eh;
+	void *pkt;
+	uint len = ETHER_HDR_LEN + fake_sdio_rx_len;
+
+	if (!(pkt = PKTGET(osh, len, FALSE))) {
+		bus->rxnobuf++;
+		return NULL;
+	}
+
+	eh = (struct ether_header *)PKTDATA(osh, pkt);
+	memset(eh->ether_dhost, 0xff, ETHER_ADDR_LEN);
+	bcopy(fake_sdio_mac, eh->ether_shost, ETHER_ADDR_LEN);
+	eh->ether_type = hton16(FAKE_SDIO_ETHERTYPE);
+	bzero(&eh[1], fake_sdio_rx_len);
+
+	return pkt;
+}
+
+int
+dhd_bus_txdata(struct dhd_bus *bus, void *pkt)
+{
+	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
+
+	dhd_os_sdlock(bus->dhd);
+	fake_sdio_clk_avail(bus);
+	bus->txframes++;
+	dhd_os_sdunlock(bus->dhd);
+
+	dhd_txcomplete(bus->dhd, pkt, TRUE);
+	PKTFREE(bus->osh, pkt, TRUE);
+
+	return 0;
+}
+
+int
+dhd_bus_txctl(struct dhd_bus *bus, uchar *msg, uint msglen)
+{
+	cdc_ioctl_t *ioc;
+	uchar *buf;
+	uint len, buflen;
+
+	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
+
+	if (bus->dhd->dongle_reset)
+		return -EIO;
+
+	len = MIN(msglen, FAKE_SDIO_CTL_MAX);
+	if (len < sizeof(cdc_ioctl_t))
+		return -EINVAL;
+
+	dhd_os_sdlock(bus->dhd);
+	fake_sdio_clk_avail(bus);
+
+	/* Echo the request; the response carries the same id */
+	bcopy(msg, bus->rxctl, len);
+	ioc = (cdc_ioctl_t *)bus->rxctl;
+	buf = (uchar *)&ioc[1];
+	buflen = len - sizeof(cdc_ioctl_t);
+
+	if (!(ltoh32(ioc->flags) & CDCF_IOC_SET)) {
+		if (ltoh32(ioc->cmd) == WLC_GET_VAR && buflen >= sizeof("cur_etheraddr") &&
+		    !strcmp((char *)buf, "cur_etheraddr")) {
+			bzero(buf, buflen);
+			bcopy(fake_sdio_mac, buf, ETHER_ADDR_LEN);
+		} else {
+			bzero(buf, buflen);
+		}
+	}
+	ioc->status = 0;
+
+	bus->rxlen = len;
+	bus->ctlframes++;
+	dhd_os_sdunlock(bus->dhd);
+
+	bus->dhd->tx_ctlpkts++;
+	dhd_os_ioctl_resp_wake(bus->dhd);
+
+	return 0;
+}
+
+int
+dhd_bus_rxctl(struct dhd_bus *bus, uchar *msg, uint msglen)
+{
+	int timeleft;
+	uint rxlen;
+	bool pending;
+
+	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
+
+	if (bus->dhd->dongle_reset)
+		return -EIO;
+
+	timeleft = dhd_os_ioctl_resp_wait(bus->dhd, &bus->rxlen, &pending);
+
+	dhd_os_sdlock(bus->dhd);
+	rxlen = bus->rxlen;
+	bcopy(bus->rxctl, msg, MIN(msglen, rxlen));
+	bus->rxlen = 0;
+	dhd_os_sdunlock(bus->dhd);
+
+	if (!rxlen) {
+		bus->dhd->rx_ctlerrs++;
+		if (pending == TRUE)
+			return -ERESTARTSYS;
+		return -ETIMEDOUT;
+	}
+
+	bus->dhd->rx_ctlpkts++;
+	return (int)rxlen;
+}
+
+bool
+dhd_bus_dpc(struct dhd_bus *bus)
+{
+	void *pkt;
+	uint n;
+
+	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
+
+	if (bus->dhd->busstate != DHD_BUS_DATA)
+		return FALSE;
+
+	dhd_os_sdlock(bus->dhd);
+	bus->dpc_count++;
+	fake_sdio_clk_avail(bus);
+	n = MIN(bus->rxpend, dhd_rxbound);
+	bus->rxpend -= n;
+	dhd_os_sdunlock(bus->dhd);
+
+	while (n--) {
+		if (!(pkt = fake_sdio_rxframe(bus)))
+			break;
+		bus->rxframes++;
+		dhd_rx_frame(bus->dhd, 0, pkt, 1);
+	}
+
+	return bus->rxpend != 0;
+}
+
+bool
+dhd_bus_watchdog(dhd_pub_t *dhdp)
+{
+	dhd_bus_t *bus = dhdp->bus;
+
+	DHD_TIMER(("%s: Enter\n", __FUNCTION__));
+
+	if (dhdp->dongle_reset)
+		return FALSE;
+
+	dhd_os_sdlock(dhdp);
+	bus->wd_count++;
+
+	/* Same idle clock-down rule as dhd_sdio.c */
+	if ((dhd_idletime > 0) && bus->clk_on) {
+		if (++bus->idlecount >= (uint)dhd_idletime) {
+			bus->idlecount = 0;
+			if (bus->activity) {
+				bus->activity = FALSE;
+				bus->clk_on = FALSE;
+				bus->clk_down++;
+			}
+		}
+	}
+	dhd_os_sdunlock(dhdp);
+
+	return FALSE;
+}
+
+int
+dhd_bus_init(dhd_pub_t *dhdp, bool enforce_mutex)
+{
+	dhd_bus_t *bus = dhdp->bus;
+
+	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
+
+	if (enforce_mutex)
+		dhd_os_sdlock(dhdp);
+
+	fake_sdio_clk_avail(bus);
+	dhdp->busstate = DHD_BUS_DATA;
+
+	bus->running = TRUE;
+	bus->burst_end = jiffies + msecs_to_jiffies(fake_sdio_burst_ms);
+	mod_timer(&bus->timer, jiffies + msecs_to_jiffies(MAX(fake_sdio_rx_ms, 1)));
+
+	if (enforce_mutex)
+		dhd_os_sdunlock(dhdp);
+
+	return 0;
+}
+
+void
+dhd_bus_stop(struct dhd_bus *bus, bool enforce_mutex)
+{
+	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
+
+	if (enforce_mutex)
+		dhd_os_sdlock(bus->dhd);
+
+	bus->running = FALSE;
+	bus->dhd->busstate = DHD_BUS_DOWN;
+	bus->rxpend = 0;
+	bus->rxlen = 0;
+	bus->clk_on = FALSE;
+
+	if (enforce_mutex)
+		dhd_os_sdunlock(bus->dhd);
+
+	del_timer_sync(&bus->timer);
+}
+
+bool
+dhd_bus_download_firmware(struct dhd_bus *bus, osl_t *osh, char *fw_path, char *nv_path)
+{
+	/* Nothing to download; the bus is loaded as soon as it exists */
+	bus->dhd->busstate = DHD_BUS_LOAD;
+	return TRUE;
+}
+
+int
+dhd_bus_devreset(dhd_pub_t *dhdp, uint8 flag)
+{
+	dhd_bus_t *bus = dhdp->bus;
+
+	if (flag == TRUE) {
+		if (dhdp->dongle_reset)
+			return BCME_SDIO_ERROR;
+
+		dhd_os_sdlock(dhdp);
+		dhd_bus_stop(bus, FALSE);
+		dhdp->dongle_reset = TRUE;
+		dhdp->up = FALSE;
+		dhd_os_sdunlock(dhdp);
+	} else {
+		if (!dhdp->dongle_reset)
+			return BCME_NOTDOWN;
+
+		dhd_os_sdlock(dhdp);
+		dhdp->dongle_reset = FALSE;
+		dhdp->up = TRUE;
+		dhdp->busstate = DHD_BUS_LOAD;
+		dhd_bus_init(dhdp, FALSE);
+		dhd_os_sdunlock(dhdp);
+	}
+
+	return 0;
+}
+
+int
+dhd_bus_iovar_op(dhd_pub_t *dhdp, const char *name,
+                 void *params, int plen, void *arg, int len, bool set)
+{
+	return BCME_UNSUPPORTED;
+}
+
+void
+dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
+{
+	dhd_bus_t *bus = dhdp->bus;
+
+	bcm_bprintf(strbuf, "Fake SDIO bus: rx %dms burst %dms idle %dms\n",
+	            fake_sdio_rx_ms, fake_sdio_burst_ms, fake_sdio_idle_ms);
+	bcm_bprintf(strbuf, "intrcount %d dpc %d watchdog %d rxpend %d\n",
+	            bus->intrcount, bus->dpc_count, bus->wd_count, bus->rxpend);
+	bcm_bprintf(strbuf, "txframes %d rxframes %d rxnobuf %d ctlframes %d\n",
+	            bus->txframes, bus->rxframes, bus->rxnobuf, bus->ctlframes);
+	bcm_bprintf(strbuf, "clk_on %d activity %d clk_up %d clk_down %d\n",
+	            bus->clk_on, bus->activity, bus->clk_up, bus->clk_down);
+}
+
+void
+dhd_bus_clearcounts(dhd_pub_t *dhdp)
+{
+	dhd_bus_t *bus = dhdp->bus;
+
+	bus->intrcount = bus->dpc_count = bus->wd_count = 0;
+	bus->txframes = bus->rxframes = bus->rxnobuf = bus->ctlframes = 0;
+	bus->clk_up = bus->clk_down = 0;
+}
+
+#ifdef DHD_DEBUG
+int
+dhd_bus_console_in(dhd_pub_t *dhdp, uchar *msg, uint msglen)
+{
+	return BCME_UNSUPPORTED;
+}
+#endif /* DHD_DEBUG */
+
+uint
+dhd_bus_chip(struct dhd_bus *bus)
+{
+	return BCM4329_CHIP_ID;
+}
+
+void
+dhd_bus_set_nvram_params(struct dhd_bus * bus, const char *nvram_params)
+{
+}
+
+void *
+dhd_bus_pub(struct dhd_bus *bus)
+{
+	return bus->dhd;
+}
+
+void *
+dhd_bus_txq(struct dhd_bus *bus)
+{
+	return &bus->txq;
+}
+
+uint
+dhd_bus_hdrlen(struct dhd_bus *bus)
+{
+	return 0;
+}
+
+bool
+dhd_bus_polling(struct dhd_bus *bus)
+{
+	return FALSE;
+}
+
+static void
+fake_sdio_release(dhd_bus_t *bus)
+{
+	osl_t *osh = bus->osh;
+
+	if (bus->dhd)
+		dhd_detach(bus->dhd);
+	if (bus->rxctl)
+		MFREE(osh, bus->rxctl, FAKE_SDIO_CTL_MAX);
+	MFREE(osh, bus, sizeof(dhd_bus_t));
+	dhd_osl_detach(osh);
+}
+
+/* No device to wait for: attach the bus straight away, as dhdsdio_probe() would */
+int
+dhd_bus_register(void)
+{
+	osl_t *osh;
+	dhd_bus_t *bus;
+
+	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
+
+	if (!(osh = dhd_osl_attach(NULL, DHD_BUS)))
+		return -ENOMEM;
+
+	if (!(bus = MALLOC(osh, sizeof(dhd_bus_t)))) {
+		dhd_osl_detach(osh);
+		return -ENOMEM;
+	}
+	bzero(bus, sizeof(dhd_bus_t));
+	bus->osh = osh;
+	pktq_init(&bus->txq, (PRIOMASK + 1), 256);
+	init_timer(&bus->timer);
+	bus->timer.data = (ulong)bus;
+	bus->timer.function = fake_sdio_intr;
+
+	if (!(bus->rxctl = MALLOC(osh, FAKE_SDIO_CTL_MAX)))
+		goto fail;
+
+	if (!(bus->dhd = dhd_attach(osh, bus, 0)))
+		goto fail;
+
+	if (dhd_bus_start(bus->dhd) != 0) {
+		DHD_ERROR(("%s: dhd_bus_start failed\n", __FUNCTION__));
+		goto fail;
+	}
+
+	if (dhd_net_attach(bus->dhd, 0) != 0) {
+		DHD_ERROR(("%s: Net attach failed!!\n", __FUNCTION__));
+		goto fail;
+	}
+
+	fake_bus = bus;
+	return 0;
+
+fail:
+	fake_sdio_release(bus);
+	return -ENODEV;
+}
+
+void
+dhd_bus_unregister(void)
+{
+	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
+
+	if (fake_bus) {
+		fake_sdio_release(fake_bus);
+		fake_bus = NULL;
+	}
+}
+
+/* bcmsdh/sdioh entry points referenced outside the bus module */
+uint8
+bcmsdh_cfg_read(void *sdh, uint func, uint32 addr, int *err)
+{
+	if (err)
+		*err = 0;
+	return 0;
+}
+
+void
+bcmsdh_cfg_write(void *sdh, uint func, uint32 addr, uint8 data, int *err)
+{
+	if (err)
+		*err = 0;
+}
+
+int
+bcmsdh_intr_enable(void *sdh)
+{
+	return 0;
+}
+
+int
+sdioh_start(sdioh_info_t *si, int stage)
+{
+	return 0;
+}
+
+int
+sdioh_stop(sdioh_info_t *si)
+{
+	return 0;
+}
+
+int
+sdioh_mmc_irq(int irq)
+{
+	return 0;
+}
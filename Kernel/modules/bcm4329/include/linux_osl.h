@@ -251,10 +251,13 @@ extern void osl_dma_unmap(osl_t *osh, uint pa, uint size, int direction);
 #define PKTALLOCED(osh)			((osl_pubinfo_t *)(osh))->pktalloced
 #define PKTSETPOOL(osh, skb, x, y)	do {} while (0)
 #define PKTPOOL(osh, skb)		FALSE
-#define PKTPOOLLEN(osh, pktp)		(0)
-#define PKTPOOLAVAIL(osh, pktp)		(0)
-#define PKTPOOLADD(osh, pktp, p)	BCME_ERROR
-#define PKTPOOLGET(osh, pktp)		NULL
+#define PKTPOOLINIT(osh, n, sz, align)	osl_pktpool_init((osh), (n), (sz), (align))
+#define PKTPOOLDEINIT(osh, pktp)	osl_pktpool_deinit((osh), (pktp))
+#define PKTPOOLFILL(osh, pktp)		osl_pktpool_fill((osh), (pktp))
+#define PKTPOOLLEN(osh, pktp)		osl_pktpool_len(pktp)
+#define PKTPOOLAVAIL(osh, pktp)		osl_pktpool_avail(pktp)
+#define PKTPOOLADD(osh, pktp, p)	osl_pktpool_add((osh), (pktp), (p))
+#define PKTPOOLGET(osh, pktp, len)	osl_pktpool_get((osh), (pktp), (len))
 #define PKTLIST_DUMP(osh, buf)
 
 extern void *osl_pktget(osl_t *osh, uint len);
@@ -263,6 +266,14 @@ extern void *osl_pktget_static(osl_t *osh, uint len);
 extern void osl_pktfree_static(osl_t *osh, void *skb, bool send);
 extern void *osl_pktdup(osl_t *osh, void *skb);
 
+extern void *osl_pktpool_init(osl_t *osh, uint n, uint bufsz, uint align);
+extern void osl_pktpool_deinit(osl_t *osh, void *pktp);
+extern uint osl_pktpool_fill(osl_t *osh, void *pktp);
+extern uint osl_pktpool_len(void *pktp);
+extern uint osl_pktpool_avail(void *pktp);
+extern int osl_pktpool_add(osl_t *osh, void *pktp, void *p);
+extern void *osl_pktpool_get(osl_t *osh, void *pktp, uint len);
+
 
 
 static INLINE void *
@@ -620,3 +620,115 @@ osl_pktdup(osl_t *osh, void *skb)
 	osh->pub.pktalloced++;
 	return (p);
 }
+
+
+typedef struct osl_pktpool {
+	struct sk_buff_head q;
+	uint	maxlen;
+	uint	bufsz;
+	uint	align;
+} osl_pktpool_t;
+
+static void
+osl_pktpool_align(osl_pktpool_t *pktp, struct sk_buff *skb)
+{
+	uint pad;
+
+	if ((pad = (uintptr)skb->data % pktp->align))
+		skb_reserve(skb, pktp->align - pad);
+}
+
+void *
+osl_pktpool_init(osl_t *osh, uint n, uint bufsz, uint align)
+{
+	osl_pktpool_t *pktp;
+
+	if ((pktp = kmalloc(sizeof(osl_pktpool_t), GFP_KERNEL)) == NULL)
+		return NULL;
+
+	skb_queue_head_init(&pktp->q);
+	pktp->maxlen = n;
+	pktp->bufsz = bufsz;
+	pktp->align = align ? align : 1;
+
+	osl_pktpool_fill(osh, pktp);
+
+	return pktp;
+}
+
+/* Top the pool up with fresh buffers; returns how many were added */
+uint
+osl_pktpool_fill(osl_t *osh, void *p)
+{
+	osl_pktpool_t *pktp = (osl_pktpool_t *)p;
+	struct sk_buff *skb;
+	uint n = 0;
+
+	while (skb_queue_len(&pktp->q) < pktp->maxlen) {
+		if ((skb = dev_alloc_skb(pktp->bufsz + pktp->align)) == NULL)
+			break;
+		osl_pktpool_align(pktp, skb);
+		skb_queue_tail(&pktp->q, skb);
+		n++;
+	}
+
+	return n;
+}
+
+void
+osl_pktpool_deinit(osl_t *osh, void *p)
+{
+	osl_pktpool_t *pktp = (osl_pktpool_t *)p;
+
+	if (pktp == NULL)
+		return;
+
+	skb_queue_purge(&pktp->q);
+	kfree(pktp);
+}
+
+uint
+osl_pktpool_len(void *p)
+{
+	return ((osl_pktpool_t *)p)->maxlen;
+}
+
+uint
+osl_pktpool_avail(void *p)
+{
+	return skb_queue_len(&((osl_pktpool_t *)p)->q);
+}
+
+int
+osl_pktpool_add(osl_t *osh, void *p, void *pkt)
+{
+	osl_pktpool_t *pktp = (osl_pktpool_t *)p;
+	struct sk_buff *skb = (struct sk_buff *)pkt;
+
+	if (skb->next || in_irq() || skb_queue_len(&pktp->q) >= pktp->maxlen)
+		return BCME_ERROR;
+
+	if (!skb_recycle_check(skb, pktp->bufsz + pktp->align))
+		return BCME_ERROR;
+
+	osl_pktpool_align(pktp, skb);
+	skb_queue_tail(&pktp->q, skb);
+	osh->pub.pktalloced--;
+
+	return BCME_OK;
+}
+
+void *
+osl_pktpool_get(osl_t *osh, void *p, uint len)
+{
+	osl_pktpool_t *pktp = (osl_pktpool_t *)p;
+	struct sk_buff *skb;
+
+	if (len > pktp->bufsz || (skb = skb_dequeue(&pktp->q)) == NULL)
+		return NULL;
+
+	skb_put(skb, len);
+	osh->pub.pktalloced++;
+
+	return ((void *) skb);
+}
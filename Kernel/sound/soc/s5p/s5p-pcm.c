@@ -16,15 +16,18 @@
  */
 
 #include <linux/module.h>
+#include <linux/moduleparam.h>
 #include <linux/init.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
 #include <linux/dma-mapping.h>
+#include <linux/math64.h>
 
 #include <sound/core.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
 #include <sound/soc.h>
+#include <sound/info.h>
 
 #include <asm/dma.h>
 #include <asm/io.h>
@@ -37,9 +40,22 @@
 
 struct s5p_pcm_pdata s3c_pcm_pdat;
 
+/*
+ * In low latency mode the PL330 loops over the whole buffer on its own and
+ * only interrupts at period ends, so periods of a few ms cost no reloads.
+ * Pause and resume are not offered then: a ring always restarts from the
+ * beginning of the buffer.  LPAUDIO playback is queued by the i2s driver,
+ * not by s5p_pcm_load(), and never runs as a ring.
+ */
+static int lowlatency;
+module_param(lowlatency, bool, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(lowlatency, "let the DMA loop over the buffer, for short periods");
+
 struct s5p_runtime_data {
 	spinlock_t lock;
 	int state;
+	int lowlatency;
+	int ring;
 	unsigned int dma_limit;
 	unsigned int dma_period;
 	unsigned int dma_size;
@@ -49,6 +65,20 @@ struct s5p_runtime_data {
 	struct s5p_pcm_dma_params *params;
 };
 
+/* Per direction counters, shown in /proc/asound/cardN/s5p-pcm */
+struct s5p_pcm_stats {
+	int ring;
+	unsigned int period_us;
+	unsigned int buffer_us;
+	unsigned long periods;		/* period interrupts served */
+	unsigned long missed;		/* periods covered by a later interrupt */
+	unsigned long xruns;
+	unsigned int late_max_us;	/* DMA progress past the period end */
+	unsigned long long late_total_us;
+};
+
+static struct s5p_pcm_stats s5p_pcm_stats[2];
+
 static struct s5p_i2s_pdata *s3ci2s_func = NULL;
 
 extern unsigned int ring_buf_index;
@@ -80,6 +110,114 @@ static void s5p_pcm_enqueue(struct snd_pcm_substream *substream)
 	prtd->dma_pos = pos;
 }
 
+static unsigned int s5p_pcm_frames_to_us(struct snd_pcm_runtime *runtime,
+					 snd_pcm_uframes_t frames)
+{
+	return div_u64((u64)frames * USEC_PER_SEC, runtime->rate);
+}
+
+/* s5p_pcm_hwpos
+ *
+ * byte offset of the DMA in the buffer, from the PL330 address registers
+ * while the stream runs and from the last completed period otherwise.
+ */
+static unsigned long s5p_pcm_hwpos(struct snd_pcm_substream *substream)
+{
+	struct s5p_runtime_data *prtd = substream->runtime->private_data;
+	dma_addr_t src, dst, pos;
+
+	if (!(prtd->state & ST_RUNNING) || !prtd->params ||
+	    s3c2410_dma_getposition(prtd->params->channel, &src, &dst))
+		return prtd->dma_pos - prtd->dma_start;
+
+	pos = substream->stream == SNDRV_PCM_STREAM_PLAYBACK ? src : dst;
+	if (pos < prtd->dma_start || pos >= prtd->dma_end)
+		return prtd->dma_pos - prtd->dma_start;
+
+	return pos - prtd->dma_start;
+}
+
+/* s5p_pcm_ring_done
+ *
+ * period interrupt from a looping DMA.  The interrupt may be served late
+ * enough to cover several periods, so the hardware position decides how
+ * far the stream went.
+ */
+static void s5p_pcm_ring_done(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct s5p_runtime_data *prtd = runtime->private_data;
+	struct s5p_pcm_stats *st = &s5p_pcm_stats[substream->stream];
+	unsigned long total = prtd->dma_end - prtd->dma_start;
+	unsigned long hw, last, done, late;
+	unsigned int late_us;
+
+	spin_lock(&prtd->lock);
+
+	hw = s5p_pcm_hwpos(substream);
+	late = hw % prtd->dma_period;
+	last = prtd->dma_pos - prtd->dma_start;
+	done = (hw - late + total - last) % total / prtd->dma_period;
+
+	if (done == 0) {
+		/* already accounted for by a late interrupt */
+		spin_unlock(&prtd->lock);
+		return;
+	}
+
+	prtd->dma_pos = prtd->dma_start + hw - late;
+
+	st->periods++;
+	st->missed += done - 1;
+	late_us = s5p_pcm_frames_to_us(runtime, bytes_to_frames(runtime, late));
+	st->late_total_us += late_us;
+	if (late_us > st->late_max_us)
+		st->late_max_us = late_us;
+
+	spin_unlock(&prtd->lock);
+
+	snd_pcm_period_elapsed(substream);
+}
+
+/* s5p_pcm_load
+ *
+ * hand the prepared buffer to the dma system, as a ring in low latency
+ * mode and one period at a time otherwise or when the ring cannot be
+ * encoded (periods too long, or not a whole number of bursts).
+ */
+static void s5p_pcm_load(struct snd_pcm_substream *substream)
+{
+	struct s5p_runtime_data *prtd = substream->runtime->private_data;
+
+	if (prtd->ring &&
+	    s3c2410_dma_enqueue_ring(prtd->params->channel, substream,
+				     prtd->dma_start, prtd->dma_end - prtd->dma_start,
+				     prtd->dma_period)) {
+		printk(KERN_INFO "%s: %u byte periods need queueing\n",
+		       __FUNCTION__, prtd->dma_period);
+		prtd->ring = 0;
+	}
+
+	s5p_pcm_stats[substream->stream].ring = prtd->ring;
+
+	if (!prtd->ring)
+		s5p_pcm_enqueue(substream);
+}
+
+/* s5p_pcm_can_ring
+ *
+ * whether the stream may use ring mode, i.e. low latency mode is on and
+ * s5p_pcm_load() is what enqueues its buffer.
+ */
+static int s5p_pcm_can_ring(struct snd_pcm_substream *substream)
+{
+#ifdef CONFIG_S5P64XX_LPAUDIO
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+		return 0;
+#endif /* CONFIG_S5P64XX_LPAUDIO */
+	return lowlatency;
+}
+
 static void s5p_audio_buffdone(struct s3c2410_dma_chan *channel,
 				void *dev_id, int size,
 				enum s3c2410_dma_buffresult result)
@@ -96,6 +234,13 @@ static void s5p_audio_buffdone(struct s3c2410_dma_chan *channel,
 		return;
 
 	prtd = substream->runtime->private_data;
+
+	if (prtd->ring) {
+		s5p_pcm_ring_done(substream);
+		return;
+	}
+
+	s5p_pcm_stats[substream->stream].periods++;
 	
 	/* By Jung */
 	prtd->dma_pos += prtd->dma_period;
@@ -221,12 +366,19 @@ static int s5p_pcm_hw_params(struct snd_pcm_substream *substream,
 		runtime->dma_bytes = totbytes;
 
 		spin_lock_irq(&prtd->lock);
+		prtd->ring = prtd->lowlatency;
 		prtd->dma_limit = runtime->hw.periods_min;
 		prtd->dma_period = params_period_bytes(params);
 		prtd->dma_start = runtime->dma_addr;
 		prtd->dma_pos = prtd->dma_start;
 		prtd->dma_end = prtd->dma_start + totbytes;
 		spin_unlock_irq(&prtd->lock);
+
+	s5p_pcm_stats[substream->stream].period_us =
+		s5p_pcm_frames_to_us(runtime, params_period_size(params));
+	s5p_pcm_stats[substream->stream].buffer_us =
+		s5p_pcm_frames_to_us(runtime, params_buffer_size(params));
+
 	printk("DmaAddr=@%x Total=%lubytes PrdSz=%u #Prds=%u, dmaEnd 0x%x\n",
 				runtime->dma_addr, totbytes, params_period_bytes(params), periods, prtd->dma_end);
 	
@@ -274,6 +426,9 @@ static int s5p_pcm_prepare(struct snd_pcm_substream *substream)
 	
 	prtd->dma_pos = prtd->dma_start;
 
+	if (substream->runtime->status->state == SNDRV_PCM_STATE_XRUN)
+		s5p_pcm_stats[substream->stream].xruns++;
+
 #ifdef CONFIG_S5P64XX_LPAUDIO
 	/* By Jung */
 	if(substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
@@ -282,11 +437,11 @@ static int s5p_pcm_prepare(struct snd_pcm_substream *substream)
 	}
 	else {
 		s3c2410_dma_ctrl(prtd->params->channel, S3C2410_DMAOP_FLUSH);
-		s5p_pcm_enqueue(substream);
+		s5p_pcm_load(substream);
 	}
 #else
 	s3c2410_dma_ctrl(prtd->params->channel, S3C2410_DMAOP_FLUSH);
-		s5p_pcm_enqueue(substream);
+	s5p_pcm_load(substream);
 #endif
 
 	return 0;
@@ -352,8 +507,7 @@ static snd_pcm_uframes_t
 
 	spin_lock(&prtd->lock);
 
-	/* By Jung */
-	res = prtd->dma_pos - prtd->dma_start;
+	res = s5p_pcm_hwpos(substream);
 
 	spin_unlock(&prtd->lock);
 	
@@ -412,6 +566,10 @@ static int s5p_pcm_open(struct snd_pcm_substream *substream)
 
 	spin_lock_init(&prtd->lock);
 
+	prtd->lowlatency = s5p_pcm_can_ring(substream);
+	if (prtd->lowlatency)
+		runtime->hw.info &= ~(SNDRV_PCM_INFO_PAUSE | SNDRV_PCM_INFO_RESUME);
+
 	runtime->private_data = prtd;
 
 	return 0;
@@ -540,9 +698,37 @@ static void s5p_pcm_free_dma_buffers(struct snd_pcm *pcm)
 
 static u64 s5p_pcm_dmamask = DMA_32BIT_MASK;
 
+static void s5p_pcm_proc_read(struct snd_info_entry *entry,
+			      struct snd_info_buffer *buffer)
+{
+	struct s5p_pcm_stats *st;
+	unsigned long long avg;
+	int stream;
+
+	for (stream = SNDRV_PCM_STREAM_PLAYBACK; stream <= SNDRV_PCM_STREAM_CAPTURE; stream++) {
+		st = &s5p_pcm_stats[stream];
+		avg = st->late_total_us;
+		if (st->ring && st->periods)
+			do_div(avg, st->periods);
+		else
+			avg = 0;
+
+		snd_iprintf(buffer, "%s:\n", stream ? "capture" : "playback");
+		snd_iprintf(buffer, "  mode\t\t%s\n", st->ring ? "ring" : "queue");
+		snd_iprintf(buffer, "  period_us\t%u\n", st->period_us);
+		snd_iprintf(buffer, "  buffer_us\t%u\n", st->buffer_us);
+		snd_iprintf(buffer, "  periods\t%lu\n", st->periods);
+		snd_iprintf(buffer, "  missed\t%lu\n", st->missed);
+		snd_iprintf(buffer, "  xruns\t\t%lu\n", st->xruns);
+		snd_iprintf(buffer, "  late_avg_us\t%llu\n", avg);
+		snd_iprintf(buffer, "  late_max_us\t%u\n", st->late_max_us);
+	}
+}
+
 static int s5p_pcm_new(struct snd_card *card, 
 	struct snd_soc_dai *dai, struct snd_pcm *pcm)
 {
+	struct snd_info_entry *entry;
 	int ret = 0;
 
 	s5pdbg("Entered %s\n", __FUNCTION__);
@@ -565,6 +751,9 @@ static int s5p_pcm_new(struct snd_card *card,
 		if (ret)
 			goto out;
 	}
+
+	if (!snd_card_proc_new(card, "s5p-pcm", &entry))
+		snd_info_set_text_ops(entry, NULL, s5p_pcm_proc_read);
  out:
 	return ret;
 }